@@ -0,0 +1,80 @@
+//
+//  Benchmark.h
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OBPKit/OBPMetrics.h>
+
+
+
+@class OBPSession;
+@class MockOBPServer;
+
+
+
+/// Run block count times (after a short warm-up), print the rate achieved under the given label, and return it.
+static inline double BenchmarkRate(NSString* label, NSUInteger count, void (^block)(NSUInteger i))
+{
+	NSUInteger		i;
+	double			t0, t;
+
+	for (i = 0; i < MIN(count / 10, 1000); i++)
+		@autoreleasepool { block(i); }
+	t0 = OBPMonotonicTime();
+	for (i = 0; i < count; i++)
+		@autoreleasepool { block(i); }
+	t = OBPMonotonicTime() - t0;
+	printf("  %-48s %12.0f /s  (%lu in %.3fs)\n", [label UTF8String], count / t, (unsigned long)count, t);
+	return count / t;
+}
+
+
+
+/// Run the main run loop, so that main queue handlers are called, until done returns YES or timeout seconds have passed. \returns NO on timeout.
+static inline BOOL BenchmarkRunUntil(BOOL (^done)(void), NSTimeInterval timeout)
+{
+	double deadline = OBPMonotonicTime() + timeout;
+	while (!done())
+	{
+		if (OBPMonotonicTime() > deadline)
+			return NO;
+		@autoreleasepool {
+			[[NSRunLoop mainRunLoop] runMode: NSDefaultRunLoopMode beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.01]];
+		}
+	}
+	return YES;
+}
+
+
+
+/// Resource use over a measured interval.
+typedef struct BenchmarkUsage {
+	double		seconds;
+	uint64_t	allocations;	// number of malloc calls made by all threads
+	double		peakMB;			// process high-water mark of resident memory so far
+} BenchmarkUsage;
+
+void BenchmarkUsageBegin(void); ///< Start measuring time and counting allocations.
+BenchmarkUsage BenchmarkUsageEnd(void); ///< Stop counting and return what was used since BenchmarkUsageBegin().
+double BenchmarkPercentile(double* values, NSUInteger count, double percentile); ///< Sort values in place and return the given percentile, e.g. 99.
+NSInteger BenchmarkIntegerOption(NSString* name, NSInteger defaultValue); ///< Return the value of a -name value command line option, or defaultValue if absent.
+
+
+
+// Suites; each returns zero on success
+int BenchmarkSigning(NSUInteger count);
+int BenchmarkSession(NSUInteger count);
+int BenchmarkDates(NSUInteger count);
+int BenchmarkURLStrings(NSUInteger count);
+int BenchmarkURLCodec(NSUInteger count);
+int BenchmarkCredentialCrypt(NSUInteger count);
+int BenchmarkJSONDecode(NSUInteger count);
+int BenchmarkPoller(NSUInteger count);
+
+void BenchmarkPrepareServerInfo(void); ///< Keep OBPServerInfo credentials in memory instead of the keychain; call before any use of OBPServerInfo.
+OBPSession* BenchmarkValidDirectLoginSession(MockOBPServer* server); ///< Return a session with the started server, validated by DirectLogin, or nil if validation failed. Pass it to BenchmarkEndSession() when done.
+void BenchmarkEndSession(OBPSession* session); ///< Remove the session and its server entry.
@@ -0,0 +1,77 @@
+//
+//  Benchmark.m
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "Benchmark.h"
+// sdk
+#include <malloc/malloc.h>
+#include <sys/resource.h>
+#include <stdatomic.h>
+
+
+
+// libmalloc calls malloc_logger, when set, for every allocation and free; it is the hook used by the allocation instruments
+typedef void (BenchmarkMallocLogger)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t skipFrames);
+extern BenchmarkMallocLogger* malloc_logger;
+
+#define kMallocLogTypeAllocate	2
+
+
+
+static _Atomic uint64_t		sAllocations;
+static double				sStarted;
+
+
+
+static void BenchmarkCountAllocation(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t skipFrames)
+{
+	if (type & kMallocLogTypeAllocate)
+		atomic_fetch_add_explicit(&sAllocations, 1, memory_order_relaxed);
+}
+
+void BenchmarkUsageBegin(void)
+{
+	atomic_store(&sAllocations, 0);
+	malloc_logger = BenchmarkCountAllocation;
+	sStarted = OBPMonotonicTime();
+}
+
+BenchmarkUsage BenchmarkUsageEnd(void)
+{
+	BenchmarkUsage		usage;
+	struct rusage		ru;
+
+	usage.seconds = OBPMonotonicTime() - sStarted;
+	malloc_logger = NULL;
+	usage.allocations = atomic_load(&sAllocations);
+	getrusage(RUSAGE_SELF, &ru);
+	usage.peakMB = ru.ru_maxrss / (1024.0 * 1024.0); // ...bytes on macOS
+	return usage;
+}
+
+static int BenchmarkCompareDoubles(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return x < y ? -1 : x > y;
+}
+
+double BenchmarkPercentile(double* values, NSUInteger count, double percentile)
+{
+	NSUInteger i;
+	if (!count)
+		return 0;
+	qsort(values, count, sizeof(double), BenchmarkCompareDoubles);
+	i = (NSUInteger)ceil(percentile / 100 * count);
+	return values[MIN(count, MAX(1, i)) - 1];
+}
+
+NSInteger BenchmarkIntegerOption(NSString* name, NSInteger defaultValue)
+{
+	// Command line options of the form -name value arrive in the argument domain of the user defaults
+	id value = [[NSUserDefaults standardUserDefaults] objectForKey: name];
+	return [value respondsToSelector: @selector(integerValue)] ? [value integerValue] : defaultValue;
+}
@@ -0,0 +1,268 @@
+//
+//  MicroBenchmarks.m
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <CommonCrypto/CommonCrypto.h>
+#import <OBPKit/OBPKit.h>
+#import "Benchmark.h"
+#import "MockOBPServer.h"
+
+
+
+int BenchmarkDates(NSUInteger count)
+{
+	NSDate*				date = [NSDate dateWithTimeIntervalSinceReferenceDate: 500000000.0];
+	NSString*			string = [OBPDateFormatter stringFromDate: date];
+	NSMutableArray*		strings = [NSMutableArray array];
+	NSUInteger			i, n = 64;
+
+	for (i = 0; i < n; i++)
+		[strings addObject: [OBPDateFormatter stringFromDate: [date dateByAddingTimeInterval: i * 86400.0 + i]]];
+
+	BenchmarkRate(@"+[OBPDateFormatter stringFromDate:]", count,
+		^(NSUInteger i) {
+			(void)[OBPDateFormatter stringFromDate: [date dateByAddingTimeInterval: i]];
+		});
+	BenchmarkRate(@"+[OBPDateFormatter dateFromString:]", count,
+		^(NSUInteger i) {
+			(void)[OBPDateFormatter dateFromString: strings[i % n]];
+		});
+	BenchmarkRate(@"+[OBPDateFormatter datesFromStrings:] (x64)", count / n,
+		^(NSUInteger i) {
+			(void)[OBPDateFormatter datesFromStrings: strings];
+		});
+
+	if (![[OBPDateFormatter dateFromString: string] isEqualToDate: date])
+	{
+		fprintf(stderr, "  round trip failed for %s\n", [string UTF8String]);
+		return 1;
+	}
+	return 0;
+}
+
+int BenchmarkURLStrings(NSUInteger count)
+{
+	NSString*			value = @"Caffè & Crème: 50% off! (today only) ~ a/b?c=d";
+	NSString*			base = @"https://apisandbox.openbankproject.com/obp/v2.1.0";
+	NSDictionary*		params = @{@"oauth_token" : @"LRKK5OTWBB1ERKFR1PXGFB0YO2BNFHZGK5D5XNCS", @"oauth_verifier" : @"53124", @"note" : value};
+	NSString*			query = [@"" stringByAppendingURLQueryParams: params];
+
+	if ([query hasPrefix: @"?"])
+		query = [query substringFromIndex: 1];
+
+	BenchmarkRate(@"-stringByAddingPercentEncodingForAllRFC3986...", count,
+		^(NSUInteger i) {
+			(void)[value stringByAddingPercentEncodingForAllRFC3986ReservedCharachters];
+		});
+	BenchmarkRate(@"-stringByAppendingURLQueryParams:", count / 4,
+		^(NSUInteger i) {
+			(void)[base stringByAppendingURLQueryParams: params];
+		});
+	BenchmarkRate(@"-extractURLQueryParams", count / 4,
+		^(NSUInteger i) {
+			(void)[query extractURLQueryParams];
+		});
+	BenchmarkRate(@"-stringForURLByAppendingPath:", count,
+		^(NSUInteger i) {
+			(void)[base stringForURLByAppendingPath: @"/banks/rbs/accounts/main/owner/transactions"];
+		});
+	return 0;
+}
+
+static NSString* BenchmarkOneShotEncrypt(OBPProvideCryptParamsBlock provideParams, NSString* credential)
+{
+	// What each call of the crypt blocks made by OBPServerInfo used to do: fetch params, then CCCrypt
+	uint8_t				keyStore[kOBPClientCredentialMaxCryptKeyLen * 2] = {0};
+	uint8_t				ivStore[kOBPClientCredentialMaxCryptBlockLen * 2] = {0};
+	uint8_t				buf[256] = {0};
+	OBPCryptParams		params = {kOBPClientCredentialCryptAlg, 0, kOBPClientCredentialCryptKeyLen, kOBPClientCredentialCryptBlockLen, keyStore, ivStore};
+	NSData*				data = [credential dataUsingEncoding: NSUTF8StringEncoding];
+	size_t				inputLen, outputLen = 0;
+
+	provideParams(&params, sizeof(keyStore), sizeof(ivStore));
+	memcpy(buf, [data bytes], [data length]);
+	inputLen = ([data length] + params.blockSize - 1) / params.blockSize * params.blockSize;
+	CCCrypt(kCCEncrypt, params.algorithm, params.options, params.key, params.keySize, params.iv, buf, inputLen, buf, sizeof(buf), &outputLen);
+	return [[NSData dataWithBytes: buf length: outputLen] base64EncodedStringWithOptions: 0];
+}
+
+static BOOL BenchmarkCheckAuthenticatedCryptor(OBPCredentialCryptor* cryptor, OBPCredentialCryptor* legacyCryptor, NSString* credential)
+{
+	// Altered or downgraded credentials must be refused, and failures must never hand back the credential in the clear
+	NSString*			encrypted = [cryptor encryptCredential: credential];
+	NSString*			legacy = [legacyCryptor encryptCredential: credential];
+	NSString*			unencodable = [NSString stringWithFormat: @"%@%C", credential, (unichar)0xD800]; // ...a lone surrogate has no UTF-8 form
+	NSString*			prefix = @"v1:";
+	NSData*				data = [[NSData alloc] initWithBase64EncodedString: [encrypted substringFromIndex: MIN([prefix length], [encrypted length])] options: 0];
+	NSMutableData*		altered;
+	NSString*			decrypted;
+	NSUInteger			i;
+	BOOL				ok = YES;
+
+	if (![encrypted hasPrefix: prefix] || !data || !legacy)
+	{
+		fprintf(stderr, "  authenticated or default encryption failed\n");
+		return NO;
+	}
+	for (i = 0; i < [data length]; i++)
+	{
+		// Every byte is covered: initialisation vector, cipher text and tag
+		altered = [data mutableCopy];
+		((uint8_t*)[altered mutableBytes])[i] ^= 0x01;
+		decrypted = [cryptor decryptCredential: [prefix stringByAppendingString: [altered base64EncodedStringWithOptions: 0]]];
+		if ([decrypted length])
+		{
+			fprintf(stderr, "  credential with byte %lu flipped was accepted\n", (unsigned long)i);
+			ok = NO;
+			break;
+		}
+	}
+	if ([cryptor decryptCredential: legacy])
+	{
+		fprintf(stderr, "  default format credential was accepted in authenticated mode\n");
+		ok = NO;
+	}
+	if (![[cryptor decryptLegacyCredential: legacy] isEqualToString: credential])
+	{
+		fprintf(stderr, "  default format credential could not be read for conversion\n");
+		ok = NO;
+	}
+	if (![cryptor.encryptBlock(unencodable) isEqualToString: @""])
+	{
+		fprintf(stderr, "  encryptBlock did not return an empty string on failure\n");
+		ok = NO;
+	}
+	return ok;
+}
+
+int BenchmarkCredentialCrypt(NSUInteger count)
+{
+	NSString*					credential = @"x1bkqhiqkjdeiyccrqlzagbshnrxlf3oeuk5plw5";
+	OBPProvideCryptParamsBlock	provideDES =
+		^(OBPCryptParams* ioParams, size_t maxKeySize, size_t maxIVSize) {
+			memset(ioParams->key, 0x5a, ioParams->keySize);
+			memset(ioParams->iv, 0xa5, ioParams->blockSize);
+		};
+	OBPProvideCryptParamsBlock	provideAES =
+		^(OBPCryptParams* ioParams, size_t maxKeySize, size_t maxIVSize) {
+			ioParams->algorithm = kCCAlgorithmAES128;
+			ioParams->options = kCCOptionPKCS7Padding;
+			ioParams->keySize = kCCKeySizeAES128;
+			ioParams->blockSize = kCCBlockSizeAES128;
+			memset(ioParams->key, 0x5a, ioParams->keySize);
+			memset(ioParams->iv, 0xa5, ioParams->blockSize);
+		};
+	NSArray<OBPCredentialCryptor*>*	cryptors = @[
+		[[OBPCredentialCryptor alloc] initWithParamsProvider: provideDES authenticated: NO],
+		[[OBPCredentialCryptor alloc] initWithParamsProvider: provideAES authenticated: NO],
+		[[OBPCredentialCryptor alloc] initWithParamsProvider: provideAES authenticated: YES],
+	];
+	NSArray<NSString*>*			names = @[@"default", @"AES128", @"authenticated"];
+	NSMutableArray<NSString*>*	batch = [NSMutableArray array];
+	NSUInteger					i, batchSize = 100;
+	int							result = 0;
+
+	if (!BenchmarkCheckAuthenticatedCryptor(cryptors[2], cryptors[1], credential))
+		return 1;
+
+	for (i = 0; i < batchSize; i++)
+		[batch addObject: [credential stringByAppendingFormat: @"-%lu", (unsigned long)i]];
+
+	BenchmarkRate(@"encrypt credential (default, one-shot CCCrypt)", count / 4,
+		^(NSUInteger i) {
+			(void)BenchmarkOneShotEncrypt(provideDES, credential);
+		});
+	if (![BenchmarkOneShotEncrypt(provideDES, credential) isEqualToString: [cryptors[0] encryptCredential: credential]])
+	{
+		fprintf(stderr, "  default format differs from one-shot CCCrypt\n");
+		result = 1;
+	}
+
+	for (i = 0; i < [cryptors count]; i++)
+	{
+		OBPCredentialCryptor*	cryptor = cryptors[i];
+		NSString*				encrypted = [cryptor encryptCredential: credential];
+		NSArray*				encryptedBatch = [cryptor encryptCredentials: batch];
+
+		BenchmarkRate([NSString stringWithFormat: @"encrypt credential (%@)", names[i]], count / 4,
+			^(NSUInteger i) {
+				(void)[cryptor encryptCredential: credential];
+			});
+		BenchmarkRate([NSString stringWithFormat: @"decrypt credential (%@)", names[i]], count / 4,
+			^(NSUInteger i) {
+				(void)[cryptor decryptCredential: encrypted];
+			});
+		BenchmarkRate([NSString stringWithFormat: @"decrypt x%lu in batch (%@)", (unsigned long)batchSize, names[i]], count / 4 / batchSize,
+			^(NSUInteger i) {
+				(void)[cryptor decryptCredentials: encryptedBatch];
+			});
+		if (![[cryptor decryptCredential: encrypted] isEqualToString: credential]
+		 || ![[cryptor decryptCredentials: encryptedBatch] isEqualToArray: batch])
+		{
+			fprintf(stderr, "  round trip failed (%s)\n", [names[i] UTF8String]);
+			result = 1;
+		}
+	}
+	return result;
+}
+
+int BenchmarkJSONDecode(NSUInteger count)
+{
+	NSUInteger			elements = 50;
+	NSData*				data = [MockOBPServer transactionsJSONForAccount: @"bank-0-account-0" offset: 0 count: elements padding: (NSUInteger)BenchmarkIntegerOption(@"padding", 0)];
+	id					object = [NSJSONSerialization JSONObjectWithData: data options: 0 error: NULL];
+	NSUInteger			pages = MAX(1, count / elements / 10);
+	double				rate;
+	BenchmarkUsage		usage;
+	NSUInteger			i;
+
+	printf("  page of %lu transactions, %lu bytes\n", (unsigned long)elements, (unsigned long)[data length]);
+	rate = BenchmarkRate(@"NSJSONSerialization", pages,
+		^(NSUInteger i) {
+			(void)[NSJSONSerialization JSONObjectWithData: data options: 0 error: NULL];
+		});
+	printf("  %-48s %12.0f elements/s\n", "", rate * elements);
+	rate = BenchmarkRate(@"-[OBPModelDecoder decodeJSONObject:] (OBPTransaction)", pages,
+		^(NSUInteger i) {
+			(void)[[OBPModelDecoder new] decodeJSONObject: object modelClass: [OBPTransaction class] error: NULL];
+		});
+	printf("  %-48s %12.0f elements/s\n", "", rate * elements);
+	rate = BenchmarkRate(@"OBPJSONStreamParser (16KB pieces)", pages,
+		^(NSUInteger i) {
+			OBPJSONStreamParser* parser = [[OBPJSONStreamParser alloc] initWithElementsKey: @"transactions" elementHandler: ^(id element, BOOL* stop){}];
+			NSUInteger offset;
+			for (offset = 0; offset < [data length]; offset += 16384)
+				[parser parseData: [data subdataWithRange: NSMakeRange(offset, MIN(16384, [data length] - offset))]];
+			[parser finish];
+		});
+	printf("  %-48s %12.0f elements/s\n", "", rate * elements);
+
+	BenchmarkUsageBegin();
+	for (i = 0; i < pages; i++)
+	@autoreleasepool {
+		(void)[[OBPModelDecoder new] decodeJSONObject: [NSJSONSerialization JSONObjectWithData: data options: 0 error: NULL] modelClass: [OBPTransaction class] error: NULL];
+	}
+	usage = BenchmarkUsageEnd();
+	printf("  %-48s %12.1f allocs/element, peak %.1f MB\n", "deserialize and decode", (double)usage.allocations / (pages * elements), usage.peakMB);
+
+	__block NSUInteger streamed = 0;
+	OBPJSONStreamParser* parser = [[OBPJSONStreamParser alloc] initWithElementsKey: @"transactions" elementHandler: ^(id element, BOOL* stop){streamed++;}];
+	for (i = 0; i < [data length]; i += 7)
+		[parser parseData: [data subdataWithRange: NSMakeRange(i, MIN(7, [data length] - i))]];
+	if (![parser finish] || streamed != elements)
+	{
+		fprintf(stderr, "  streamed unexpected number of transactions\n");
+		return 1;
+	}
+	if ([[[OBPModelDecoder new] decodeJSONObject: object modelClass: [OBPTransaction class] error: NULL] count] != elements)
+	{
+		fprintf(stderr, "  decoded unexpected number of transactions\n");
+		return 1;
+	}
+	return 0;
+}
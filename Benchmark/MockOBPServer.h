@@ -0,0 +1,50 @@
+//
+//  MockOBPServer.h
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+/**	A MockOBPServer instance is a stand-in OBP API server listening on the loopback interface, so that OBPSession and OBPMarshal can be driven without a network or real credentials.
+
+	It serves:
+
+	-	the OAuth1 endpoints /oauth/initiate, /oauth/authorize (which redirects straight to the callback with a verifier) and /oauth/token;
+	-	the DirectLogin endpoint /my/logins/direct;
+	-	under /obp/<version>: banks, the accounts of a bank (and my/accounts), single accounts, and the transactions of an account, paged by the obp_limit and obp_offset headers.
+
+	When consumerSecret is set, OAuth1 signatures are verified independently of OAuthCore and OBPOAuth1Signer. Responses are delayed by latency, to stand in for a real network and server, and each transaction can be padded to enlarge the payload. Configure the instance before calling -start.
+*/
+@interface MockOBPServer : NSObject
+@property (nonatomic) NSTimeInterval latency; ///< Seconds to wait before sending each response. Default 0.
+@property (nonatomic) NSUInteger bankCount; ///< Default 3.
+@property (nonatomic) NSUInteger accountsPerBank; ///< Default 4.
+@property (nonatomic) NSUInteger transactionCount; ///< Number of transactions in each account. Default 1000.
+@property (nonatomic) NSUInteger payloadPadding; ///< Number of extra bytes in the description of each transaction. Default 0.
+@property (nonatomic, copy, nullable) NSString* consumerSecret; ///< When set, the signature of each request with an OAuth1 Authorization header is checked against this client secret and the secret of the token it names, and a request with a bad signature is refused with status 401. Default nil.
+
+@property (nonatomic, readonly) uint16_t port; ///< The port listened on, once started.
+@property (nonatomic, readonly) NSString* APIServer; ///< e.g. http://127.0.0.1:53122
+@property (nonatomic, readonly) NSString* APIBase; ///< e.g. http://127.0.0.1:53122/obp/v2.1.0
+@property (readonly) NSUInteger requestCount; ///< Number of requests answered so far.
+@property (readonly) NSUInteger signatureFailures; ///< Number of requests refused so far for a bad OAuth1 signature.
+
+- (BOOL)start; ///< Start listening on an unused port. \returns NO if the socket could not be set up.
+- (void)stop; ///< Stop listening and close all connections.
+
++ (BOOL)verifyOAuthAuthorization:(NSString*)authorization method:(NSString*)method URL:(NSURL*)url formBody:(nullable NSData*)formBody consumerSecret:(NSString*)consumerSecret tokenSecret:(nullable NSString*)tokenSecret; ///< Check the signature in an OAuth1 Authorization header (HMAC-SHA1 or HMAC-SHA256) as a server would, by building the signature base string afresh from the request as RFC 5849 describes.
++ (NSData*)transactionsJSONForAccount:(NSString*)accountID offset:(NSUInteger)offset count:(NSUInteger)count padding:(NSUInteger)padding; ///< Return the body of a transactions response, as served, for decoding benchmarks.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
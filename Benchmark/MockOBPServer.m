@@ -0,0 +1,599 @@
+//
+//  MockOBPServer.m
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "MockOBPServer.h"
+// sdk
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <CommonCrypto/CommonHMAC.h>
+
+
+
+#define kMockOBPAPIVersion		@"v2.1.0"
+
+
+
+static NSString* MockOBPPercentEncoded(NSString* s)
+{
+	static NSCharacterSet*	sUnreserved;
+	static dispatch_once_t	once;
+	dispatch_once(&once, ^{sUnreserved = [NSCharacterSet characterSetWithCharactersInString: @"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-._~"];});
+	return [s stringByAddingPercentEncodingWithAllowedCharacters: sUnreserved] ?: @"";
+}
+
+static void MockOBPAddFormParameters(NSMutableArray<NSArray<NSString*>*>* params, NSString* form)
+{
+	NSString*	item;
+	NSString*	name;
+	NSString*	value;
+	NSRange		equals;
+
+	for (item in [form componentsSeparatedByString: @"&"])
+	{
+		if (![item length])
+			continue;
+		equals = [item rangeOfString: @"="];
+		name = equals.length ? [item substringToIndex: equals.location] : item;
+		value = equals.length ? [item substringFromIndex: NSMaxRange(equals)] : @"";
+		[params addObject: @[[name stringByRemovingPercentEncoding] ?: name, [value stringByRemovingPercentEncoding] ?: value]];
+	}
+}
+
+
+
+@interface MockOBPResponse : NSObject
+{
+@public
+	NSInteger		_status;
+	NSString*		_contentType;
+	NSString*		_location;
+	NSData*			_body;
+}
+@end
+@implementation MockOBPResponse
++ (instancetype)status:(NSInteger)status type:(NSString*)type body:(NSData*)body
+{
+	MockOBPResponse* r = [[self alloc] init];
+	r->_status = status;
+	r->_contentType = type;
+	r->_body = body ?: [NSData data];
+	return r;
+}
++ (instancetype)JSON:(id)object status:(NSInteger)status
+{
+	return [self status: status type: @"application/json" body: [NSJSONSerialization dataWithJSONObject: object options: 0 error: NULL]];
+}
++ (instancetype)form:(NSString*)form
+{
+	return [self status: 200 type: @"application/x-www-form-urlencoded" body: [form dataUsingEncoding: NSUTF8StringEncoding]];
+}
+@end
+
+
+
+@interface MockOBPServer ()
+- (MockOBPResponse*)responseForMethod:(NSString*)method target:(NSString*)target headers:(NSDictionary<NSString*,NSString*>*)headers body:(NSData*)body;
+- (void)connectionClosed:(id)connection;
+@end
+
+
+
+#pragma mark -
+@interface MockOBPConnection : NSObject
+@end
+@implementation MockOBPConnection
+{
+	MockOBPServer __weak*	_server;
+	int						_fd;
+	dispatch_queue_t		_queue;
+	dispatch_source_t		_readSource;
+	NSMutableData*			_buffer;
+	BOOL					_busy;			// a response is pending; requests are answered in order
+	BOOL					_closed;
+}
+- (instancetype)initWithServer:(MockOBPServer*)server fd:(int)fd
+{
+	if (nil == (self = [super init]))
+		return nil;
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	_server = server;
+	_fd = fd;
+	_buffer = [NSMutableData data];
+	_queue = dispatch_queue_create("MockOBPConnection", DISPATCH_QUEUE_SERIAL);
+	_readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+	dispatch_source_set_event_handler(_readSource, ^{[self readAvailable];});
+	dispatch_source_set_cancel_handler(_readSource, ^{close(fd);});
+	dispatch_resume(_readSource);
+	return self;
+}
+- (void)close
+{
+	dispatch_async(_queue, ^{[self closeNow];});
+}
+- (void)closeNow
+{
+	if (_closed)
+		return;
+	_closed = YES;
+	dispatch_source_cancel(_readSource);
+	[_server connectionClosed: self];
+}
+- (void)readAvailable
+{
+	uint8_t		buf[16384];
+	ssize_t		n = read(_fd, buf, sizeof(buf));
+	if (n <= 0)
+		{[self closeNow]; return;}
+	[_buffer appendBytes: buf length: (NSUInteger)n];
+	[self processBuffer];
+}
+- (void)processBuffer
+{
+	static NSData*		sEndOfHead;
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{sEndOfHead = [NSData dataWithBytes: "\r\n\r\n" length: 4];});
+
+	NSRange				end;
+	NSString*			head;
+	NSArray<NSString*>*	lines;
+	NSArray<NSString*>*	requestLine;
+	NSMutableDictionary*headers;
+	NSString*			line;
+	NSRange				colon;
+	NSUInteger			total, i;
+	NSData*				body;
+	MockOBPResponse*	response;
+	BOOL				closeAfter;
+
+	while (!_busy && !_closed)
+	{
+		end = [_buffer rangeOfData: sEndOfHead options: 0 range: NSMakeRange(0, [_buffer length])];
+		if (!end.length)
+			return;
+		head = [[NSString alloc] initWithBytes: [_buffer bytes] length: end.location encoding: NSISOLatin1StringEncoding];
+		lines = [head componentsSeparatedByString: @"\r\n"];
+		requestLine = [lines[0] componentsSeparatedByString: @" "];
+		headers = [NSMutableDictionary dictionary];
+		for (i = 1; i < [lines count]; i++)
+		{
+			line = lines[i];
+			if ((colon = [line rangeOfString: @":"]).length)
+				headers[[[line substringToIndex: colon.location] lowercaseString]] = [[line substringFromIndex: NSMaxRange(colon)] stringByTrimmingCharactersInSet: [NSCharacterSet whitespaceCharacterSet]];
+		}
+		total = NSMaxRange(end) + (NSUInteger)MAX(0, [headers[@"content-length"] integerValue]);
+		if ([_buffer length] < total)
+			return;
+		body = [_buffer subdataWithRange: NSMakeRange(NSMaxRange(end), total - NSMaxRange(end))];
+		[_buffer replaceBytesInRange: NSMakeRange(0, total) withBytes: NULL length: 0];
+
+		if ([requestLine count] < 3)
+			{[self closeNow]; return;}
+		response = [_server responseForMethod: requestLine[0] target: requestLine[1] headers: headers body: body];
+		closeAfter = NSOrderedSame == [headers[@"connection"] caseInsensitiveCompare: @"close"];
+		_busy = YES;
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_server.latency * NSEC_PER_SEC)), _queue, ^{
+			[self send: response];
+			self->_busy = NO;
+			if (closeAfter)
+				[self closeNow];
+			else
+				[self processBuffer];
+		});
+	}
+}
+- (void)send:(MockOBPResponse*)response
+{
+	NSMutableData*		md;
+	NSString*			head;
+	const uint8_t*		p;
+	size_t				remaining;
+	ssize_t				n;
+
+	if (_closed)
+		return;
+	head = [NSString stringWithFormat: @"HTTP/1.1 %ld %@\r\nContent-Type: %@\r\nContent-Length: %lu\r\nConnection: keep-alive\r\n%@\r\n",
+				(long)response->_status, [[NSHTTPURLResponse localizedStringForStatusCode: response->_status] capitalizedString],
+				response->_contentType, (unsigned long)[response->_body length],
+				response->_location ? [NSString stringWithFormat: @"Location: %@\r\n", response->_location] : @""];
+	md = [[head dataUsingEncoding: NSISOLatin1StringEncoding] mutableCopy];
+	[md appendData: response->_body];
+
+	for (p = [md bytes], remaining = [md length]; remaining; p += n, remaining -= (size_t)n)
+	{
+		n = write(_fd, p, remaining);
+		if (n < 0 && errno == EINTR)
+			n = 0;
+		else
+		if (n <= 0)
+			{[self closeNow]; return;}
+	}
+}
+@end
+
+
+
+#pragma mark -
+@implementation MockOBPServer
+{
+	int											_listenFD;
+	dispatch_queue_t							_queue;			// serialises the state below
+	dispatch_source_t							_acceptSource;
+	NSMutableSet<MockOBPConnection*>*			_connections;
+	NSString*									_callback;		// from the last /oauth/initiate
+	NSCache<NSString*,NSData*>*					_pages;
+	NSUInteger									_requestCount;
+	NSUInteger									_signatureFailures;
+}
+- (instancetype)init
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_listenFD = -1;
+	_queue = dispatch_queue_create("MockOBPServer", DISPATCH_QUEUE_SERIAL);
+	_connections = [NSMutableSet set];
+	_pages = [[NSCache alloc] init];
+	_bankCount = 3;
+	_accountsPerBank = 4;
+	_transactionCount = 1000;
+	return self;
+}
+- (BOOL)start
+{
+	struct sockaddr_in	addr = {0};
+	socklen_t			len = sizeof(addr);
+	int					on = 1;
+	int					fd;
+
+	if (_listenFD >= 0)
+		return YES;
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+		return NO;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	addr.sin_len = sizeof(addr);
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+	 || listen(fd, 64) < 0
+	 || getsockname(fd, (struct sockaddr*)&addr, &len) < 0)
+	{
+		close(fd);
+		return NO;
+	}
+	_listenFD = fd;
+	_port = ntohs(addr.sin_port);
+	_APIServer = [NSString stringWithFormat: @"http://127.0.0.1:%u", (unsigned)_port];
+	_APIBase = [_APIServer stringByAppendingString: @"/obp/" kMockOBPAPIVersion];
+
+	_acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+	dispatch_source_set_event_handler(_acceptSource, ^{
+		int client = accept(fd, NULL, NULL);
+		if (client >= 0)
+			[self->_connections addObject: [[MockOBPConnection alloc] initWithServer: self fd: client]];
+	});
+	dispatch_source_set_cancel_handler(_acceptSource, ^{close(fd);});
+	dispatch_resume(_acceptSource);
+	return YES;
+}
+- (void)stop
+{
+	if (_listenFD < 0)
+		return;
+	_listenFD = -1;
+	dispatch_source_cancel(_acceptSource);
+	dispatch_sync(_queue, ^{
+		for (MockOBPConnection* connection in [self->_connections copy])
+			[connection close];
+	});
+}
+- (void)connectionClosed:(MockOBPConnection*)connection
+{
+	dispatch_async(_queue, ^{[self->_connections removeObject: connection];});
+}
+- (NSUInteger)requestCount
+{
+	@synchronized (self) {
+		return _requestCount;
+	}
+}
+- (NSUInteger)signatureFailures
+{
+	@synchronized (self) {
+		return _signatureFailures;
+	}
+}
+#pragma mark -
++ (BOOL)verifyOAuthAuthorization:(NSString*)authorization method:(NSString*)method URL:(NSURL*)url formBody:(NSData*)formBody consumerSecret:(NSString*)consumerSecret tokenSecret:(NSString*)tokenSecret
+{
+	NSMutableArray<NSArray<NSString*>*>*	params = [NSMutableArray array];
+	NSMutableArray<NSString*>*				normalised = [NSMutableArray array];
+	NSArray<NSString*>*						pair;
+	NSString*								item;
+	NSString*								name;
+	NSString*								value;
+	NSString*								signature = nil;
+	NSString*								signatureMethod = nil;
+	NSString*								base;
+	NSData*									key;
+	NSData*									text;
+	NSRange									equals;
+	uint8_t									digest[CC_SHA256_DIGEST_LENGTH];
+	size_t									digestLength;
+
+	if (![authorization hasPrefix: @"OAuth "])
+		return NO;
+
+	// Header parameters, name="value", except the signature itself and the realm
+	for (item in [[authorization substringFromIndex: 6] componentsSeparatedByString: @","])
+	{
+		item = [item stringByTrimmingCharactersInSet: [NSCharacterSet whitespaceCharacterSet]];
+		equals = [item rangeOfString: @"="];
+		if (!equals.length || ![item hasSuffix: @"\""] || [item characterAtIndex: NSMaxRange(equals)] != '"')
+			return NO;
+		name = [item substringToIndex: equals.location];
+		value = [[item substringWithRange: NSMakeRange(NSMaxRange(equals) + 1, [item length] - NSMaxRange(equals) - 2)] stringByRemovingPercentEncoding];
+		if (!value)
+			return NO;
+		if ([name isEqualToString: @"oauth_signature"])
+			signature = value;
+		else
+		if (![name isEqualToString: @"realm"])
+		{
+			if ([name isEqualToString: @"oauth_signature_method"])
+				signatureMethod = value;
+			[params addObject: @[name, value]];
+		}
+	}
+	if (!signature)
+		return NO;
+
+	// Query and form parameters
+	if ([url query])
+		MockOBPAddFormParameters(params, [url query]);
+	if ([formBody length])
+		MockOBPAddFormParameters(params, [[NSString alloc] initWithData: formBody encoding: NSUTF8StringEncoding] ?: @"");
+
+	// Signature base string
+	for (pair in params)
+		[normalised addObject: [NSString stringWithFormat: @"%@=%@", MockOBPPercentEncoded(pair[0]), MockOBPPercentEncoded(pair[1])]];
+	[normalised sortUsingSelector: @selector(compare:)];
+	base = [NSString stringWithFormat: @"%@&%@&%@",
+				MockOBPPercentEncoded([method uppercaseString]),
+				MockOBPPercentEncoded([NSString stringWithFormat: @"%@://%@%@%@", [[url scheme] lowercaseString], [[url host] lowercaseString], [url port] ? [@":" stringByAppendingString: [[url port] stringValue]] : @"", [url path]]),
+				MockOBPPercentEncoded([normalised componentsJoinedByString: @"&"])];
+
+	key = [[NSString stringWithFormat: @"%@&%@", MockOBPPercentEncoded(consumerSecret), MockOBPPercentEncoded(tokenSecret ?: @"")] dataUsingEncoding: NSUTF8StringEncoding];
+	text = [base dataUsingEncoding: NSUTF8StringEncoding];
+	if ([signatureMethod isEqualToString: @"HMAC-SHA256"])
+		CCHmac(kCCHmacAlgSHA256, [key bytes], [key length], [text bytes], [text length], digest), digestLength = CC_SHA256_DIGEST_LENGTH;
+	else
+	if ([signatureMethod isEqualToString: @"HMAC-SHA1"])
+		CCHmac(kCCHmacAlgSHA1, [key bytes], [key length], [text bytes], [text length], digest), digestLength = CC_SHA1_DIGEST_LENGTH;
+	else
+		return NO;
+
+	return [signature isEqualToString: [[NSData dataWithBytes: digest length: digestLength] base64EncodedStringWithOptions: 0]];
+}
+- (BOOL)verifyOAuthAuthorization:(NSString*)authorization method:(NSString*)method target:(NSString*)target headers:(NSDictionary<NSString*,NSString*>*)headers body:(NSData*)body
+{
+	// Only the tokens this server issues are known
+	NSDictionary*	tokenSecrets = @{@"request-token" : @"request-secret", @"access-token" : @"access-secret"};
+	NSString*		tokenSecret = nil;
+	NSRange			r;
+
+	if ((r = [authorization rangeOfString: @"oauth_token=\""]).length)
+	{
+		NSString* token = [authorization substringFromIndex: NSMaxRange(r)];
+		token = [[token substringToIndex: [token rangeOfString: @"\""].location] stringByRemovingPercentEncoding];
+		if (nil == (tokenSecret = tokenSecrets[token ?: @""]))
+			return NO;
+	}
+	return [[self class] verifyOAuthAuthorization: authorization
+										   method: method
+											  URL: [NSURL URLWithString: [NSString stringWithFormat: @"http://%@%@", headers[@"host"] ?: @"", target]]
+										 formBody: [headers[@"content-type"] hasPrefix: @"application/x-www-form-urlencoded"] ? body : nil
+								   consumerSecret: _consumerSecret
+									  tokenSecret: tokenSecret];
+}
+- (MockOBPResponse*)responseForMethod:(NSString*)method target:(NSString*)target headers:(NSDictionary<NSString*,NSString*>*)headers body:(NSData*)body
+{
+	NSURLComponents*		components = [NSURLComponents componentsWithString: target];
+	NSString*				path = components.path ?: @"";
+	NSString*				authorization = headers[@"authorization"] ?: @"";
+	NSMutableArray*			parts;
+	NSString*				token;
+	NSRange					r;
+	NSUInteger				limit, offset;
+
+	@synchronized (self) {
+		_requestCount++;
+	}
+
+	// Signatures, when asked to check them
+	if (_consumerSecret && [authorization hasPrefix: @"OAuth "]
+	 && ![self verifyOAuthAuthorization: authorization method: method target: target headers: headers body: body])
+	{
+		@synchronized (self) {
+			_signatureFailures++;
+		}
+		return [MockOBPResponse JSON: @{@"error" : @"Invalid OAuth signature"} status: 401];
+	}
+
+	// OAuth1
+	if ([path isEqualToString: @"/oauth/initiate"])
+	{
+		if ((r = [authorization rangeOfString: @"oauth_callback=\""]).length)
+		{
+			NSString* s = [authorization substringFromIndex: NSMaxRange(r)];
+			s = [s substringToIndex: [s rangeOfString: @"\""].location];
+			@synchronized (self) {
+				_callback = [s stringByRemovingPercentEncoding];
+			}
+		}
+		return [MockOBPResponse form: @"oauth_token=request-token&oauth_token_secret=request-secret&oauth_callback_confirmed=true"];
+	}
+	if ([path isEqualToString: @"/oauth/authorize"])
+	{
+		// ...the user authorises at once
+		MockOBPResponse* response = [MockOBPResponse status: 302 type: @"text/plain" body: nil];
+		for (NSURLQueryItem* item in components.queryItems)
+			if ([item.name isEqualToString: @"oauth_token"])
+				token = item.value;
+		@synchronized (self) {
+			response->_location = [NSString stringWithFormat: @"%@?oauth_token=%@&oauth_verifier=benchmark-verifier", _callback, token];
+		}
+		return response;
+	}
+	if ([path isEqualToString: @"/oauth/token"])
+		return [MockOBPResponse form: @"oauth_token=access-token&oauth_token_secret=access-secret"];
+
+	// DirectLogin
+	if ([path isEqualToString: @"/my/logins/direct"])
+	{
+		if (![authorization hasPrefix: @"DirectLogin "])
+			return [MockOBPResponse JSON: @{@"error" : @"Missing DirectLogin header"} status: 401];
+		return [MockOBPResponse JSON: @{@"token" : @"direct-login-token"} status: 200];
+	}
+
+	// API
+	parts = [[path componentsSeparatedByString: @"/"] mutableCopy];
+	[parts removeObject: @""];
+	if ([parts count] < 2 || ![parts[0] isEqualToString: @"obp"])
+		return [MockOBPResponse JSON: @{@"error" : @"Not found"} status: 404];
+	[parts removeObjectsInRange: NSMakeRange(0, 2)];
+
+	if ([parts isEqual: @[@"banks"]])
+		return [MockOBPResponse JSON: @{@"banks" : [self banks]} status: 200];
+
+	if ([parts isEqual: @[@"my", @"accounts"]])
+		return [MockOBPResponse JSON: @{@"accounts" : [self accountsAtBank: nil]} status: 200];
+
+	if ([parts count] >= 3 && [parts count] <= 4 && [parts[0] isEqualToString: @"banks"] && [parts[2] isEqualToString: @"accounts"])
+		return [MockOBPResponse JSON: @{@"accounts" : [self accountsAtBank: parts[1]]} status: 200];
+
+	if ([parts count] == 6 && [parts[0] isEqualToString: @"banks"] && [parts[2] isEqualToString: @"accounts"])
+	{
+		if ([parts[5] isEqualToString: @"account"])
+			return [MockOBPResponse JSON: [self accountWithID: parts[3] atBank: parts[1]] status: 200];
+		if ([parts[5] isEqualToString: @"transactions"])
+		{
+			limit = headers[@"obp_limit"] ? (NSUInteger)MAX(0, [headers[@"obp_limit"] integerValue]) : 50;
+			offset = headers[@"obp_offset"] ? (NSUInteger)MAX(0, [headers[@"obp_offset"] integerValue]) : 0;
+			return [MockOBPResponse status: 200 type: @"application/json" body: [self transactionsForAccount: parts[3] offset: offset limit: limit]];
+		}
+	}
+
+	return [MockOBPResponse JSON: @{@"error" : @"Not found"} status: 404];
+}
+#pragma mark -
+- (NSArray*)banks
+{
+	NSMutableArray* banks = [NSMutableArray array];
+	for (NSUInteger i = 0; i < _bankCount; i++)
+		[banks addObject: @{
+			@"id"			: [NSString stringWithFormat: @"bank-%lu", (unsigned long)i],
+			@"short_name"	: [NSString stringWithFormat: @"Bank %lu", (unsigned long)i],
+			@"full_name"	: [NSString stringWithFormat: @"Benchmark Bank %lu", (unsigned long)i],
+			@"logo"			: @"",
+			@"website"		: @"https://example.com",
+		}];
+	return banks;
+}
+- (NSDictionary*)accountWithID:(NSString*)accountID atBank:(NSString*)bankID
+{
+	return @{
+		@"id"				: accountID,
+		@"bank_id"			: bankID,
+		@"label"			: [@"Account " stringByAppendingString: accountID],
+		@"number"			: @"12345678",
+		@"type"				: @"CURRENT",
+		@"IBAN"				: @"GB00BENC00000012345678",
+		@"balance"			: @{@"currency" : @"EUR", @"amount" : @"1234.56"},
+		@"views_available"	: @[@{@"id" : @"owner", @"short_name" : @"Owner", @"is_public" : @NO}],
+	};
+}
+- (NSArray*)accountsAtBank:(NSString*)bankID
+{
+	NSMutableArray* accounts = [NSMutableArray array];
+	for (NSUInteger b = 0; b < _bankCount; b++)
+	{
+		NSString* bank = [NSString stringWithFormat: @"bank-%lu", (unsigned long)b];
+		if (bankID && ![bankID isEqualToString: bank])
+			continue;
+		for (NSUInteger a = 0; a < _accountsPerBank; a++)
+			[accounts addObject: [self accountWithID: [NSString stringWithFormat: @"%@-account-%lu", bank, (unsigned long)a] atBank: bank]];
+	}
+	return accounts;
+}
+- (NSData*)transactionsForAccount:(NSString*)accountID offset:(NSUInteger)offset limit:(NSUInteger)limit
+{
+	// Pages are generated once, so that serving costs little of the time being measured
+	NSUInteger	count = offset < _transactionCount ? MIN(limit, _transactionCount - offset) : 0;
+	NSString*	key = [NSString stringWithFormat: @"%@|%lu|%lu", accountID, (unsigned long)offset, (unsigned long)count];
+	NSData*		data = [_pages objectForKey: key];
+	if (!data)
+	{
+		data = [[self class] transactionsJSONForAccount: accountID offset: offset count: count padding: _payloadPadding];
+		[_pages setObject: data forKey: key cost: [data length]];
+	}
+	return data;
+}
++ (NSData*)transactionsJSONForAccount:(NSString*)accountID offset:(NSUInteger)offset count:(NSUInteger)count padding:(NSUInteger)padding
+{
+	NSMutableArray*		transactions = [NSMutableArray arrayWithCapacity: count];
+	NSString*			pad = [@"" stringByPaddingToLength: padding withString: @"x" startingAtIndex: 0];
+	NSUInteger			i, n;
+	char				date[32];
+	time_t				t;
+	long				cents, balance;
+
+	for (i = offset, n = offset + count; i < n; i++)
+	{
+		t = 1451606400 + (time_t)i * 3600; // from 2016-01-01, hourly
+		strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+		cents = -(long)((i * 7919) % 100000);
+		balance = 10000000 + cents * (long)(i % 13);
+		[transactions addObject: @{
+			@"id"				: [NSString stringWithFormat: @"%@-txn-%lu", accountID, (unsigned long)i],
+			@"this_account"		: @{
+				@"id"				: accountID,
+				@"holders"			: @[@{@"name" : @"Benchmark User", @"is_alias" : @NO}],
+				@"number"			: @"12345678",
+				@"kind"				: @"CURRENT",
+				@"IBAN"				: @"GB00BENC00000012345678",
+				@"bank"				: @{@"national_identifier" : @"benchmark-bank", @"name" : @"Benchmark Bank"},
+			},
+			@"other_account"	: @{
+				@"id"				: [NSString stringWithFormat: @"counterparty-%lu", (unsigned long)(i % 50)],
+				@"holder"			: @{@"name" : [NSString stringWithFormat: @"Counterparty %lu", (unsigned long)(i % 50)], @"is_alias" : @NO},
+				@"number"			: @"",
+				@"kind"				: @"",
+				@"IBAN"				: @"",
+				@"bank"				: @{@"national_identifier" : @"other-bank", @"name" : @"Other Bank"},
+			},
+			@"details"			: @{
+				@"type"				: @"10219",
+				@"description"		: [NSString stringWithFormat: @"Payment %lu%@", (unsigned long)i, pad],
+				@"posted"			: @(date),
+				@"completed"		: @(date),
+				@"new_balance"		: @{@"currency" : @"EUR", @"amount" : [NSString stringWithFormat: @"%ld.%02ld", balance / 100, labs(balance % 100)]},
+				@"value"			: @{@"currency" : @"EUR", @"amount" : [NSString stringWithFormat: @"-%ld.%02ld", -cents / 100, -cents % 100]},
+			},
+			@"metadata"			: @{@"narrative" : [NSNull null], @"comments" : @[], @"tags" : @[], @"images" : @[], @"where" : [NSNull null]},
+		}];
+	}
+	return [NSJSONSerialization dataWithJSONObject: @{@"transactions" : transactions} options: 0 error: NULL];
+}
+@end
@@ -0,0 +1,266 @@
+//
+//  PollerBenchmark.m
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OBPKit/OBPKit.h>
+#import "Benchmark.h"
+#import "MockOBPServer.h"
+
+
+
+#define kBenchmarkPollerTimeout		30.0
+#define kBenchmarkPollerPathTemplate	@"/banks/{bankID}/accounts/{accountID}/{viewID}/account"
+#define kBenchmarkPollerSlowLatency	0.25
+
+
+
+static NSDictionary* BenchmarkPollerOptions(void)
+{
+	return @{
+		OBPMarshalOptionCoalesce			: @NO, // ...so that every send goes to the server
+		OBPMarshalOptionOmitResponseBody	: @YES,
+	};
+}
+
+static NSDictionary* BenchmarkPollerParameters(NSUInteger i)
+{
+	return @{
+		@"bankID"		: @"bank-0",
+		@"accountID"	: [NSString stringWithFormat: @"bank-0-account-%lu", (unsigned long)(i % 4)],
+		@"viewID"		: @"owner",
+	};
+}
+
+static void BenchmarkPollerRunFor(NSTimeInterval seconds)
+{
+	double until = OBPMonotonicTime() + seconds;
+	BenchmarkRunUntil(^BOOL{ return OBPMonotonicTime() >= until; }, seconds + 1);
+}
+
+
+
+#pragma mark -
+typedef OBPMarshalRequest* (^BenchmarkSendBlock)(NSUInteger i, HandleOBPMarshalData resultHandler, HandleOBPMarshalError errorHandler);
+
+static BOOL BenchmarkSends(NSString* label, NSUInteger requests, BenchmarkUsage* usageAt, BenchmarkSendBlock send)
+{
+	__block NSUInteger		completed = 0, failed = 0;
+	HandleOBPMarshalData	resultHandler = ^(id deserializedObject, NSString* body) { completed++; };
+	HandleOBPMarshalError	errorHandler = ^(NSError* error, NSString* path) { completed++, failed++; };
+	NSUInteger				launched = 0, i;
+	BenchmarkUsage			usage;
+
+	// Only launching is measured: the round trip that follows is the same either way
+	BenchmarkUsageBegin();
+	for (i = 0; i < requests; i++)
+		@autoreleasepool {
+			if (send(i, resultHandler, errorHandler))
+				launched++;
+		}
+	usage = BenchmarkUsageEnd();
+	BenchmarkRunUntil(^BOOL{ return completed == launched; }, kBenchmarkPollerTimeout);
+
+	if (label)
+		printf("  %-48s %12.2f us/send  (%lu in %.3fs, %.1f allocs each)\n", [label UTF8String],
+			usage.seconds / requests * 1e6, (unsigned long)requests, usage.seconds, (double)usage.allocations / requests);
+	if (usageAt)
+		*usageAt = usage;
+	if (launched < requests || completed < launched || failed)
+	{
+		fprintf(stderr, "  %s: %lu of %lu requests launched, %lu completed, %lu failed\n", [label ?: @"warm-up" UTF8String],
+			(unsigned long)launched, (unsigned long)requests, (unsigned long)completed, (unsigned long)failed);
+		return NO;
+	}
+	return YES;
+}
+
+static BOOL BenchmarkPreparedSends(OBPSession* session, NSUInteger requests)
+{
+	OBPMarshal*				marshal = session.marshal;
+	NSDictionary*			options = BenchmarkPollerOptions();
+	OBPPreparedRequest*		prepared = [OBPPreparedRequest GETAtAPIPath: kBenchmarkPollerPathTemplate withOptions: options];
+	BenchmarkSendBlock		sendOrdinary =
+		^OBPMarshalRequest*(NSUInteger i, HandleOBPMarshalData resultHandler, HandleOBPMarshalError errorHandler) {
+			NSString* path = [NSString stringWithFormat: @"/banks/bank-0/accounts/bank-0-account-%lu/owner/account", (unsigned long)(i % 4)];
+			return [marshal getResourceAtAPIPath: path withOptions: options forResultHandler: resultHandler orErrorHandler: errorHandler];
+		};
+	BenchmarkSendBlock		sendPrepared =
+		^OBPMarshalRequest*(NSUInteger i, HandleOBPMarshalData resultHandler, HandleOBPMarshalError errorHandler) {
+			return [marshal sendPreparedRequest: prepared withParameters: BenchmarkPollerParameters(i) payload: nil forResultHandler: resultHandler orErrorHandler: errorHandler];
+		};
+	BenchmarkUsage			ordinary, preparedUsage;
+
+	if (!BenchmarkSends(nil, 100, NULL, sendOrdinary)
+	 || !BenchmarkSends(nil, 100, NULL, sendPrepared)
+	 || !BenchmarkSends(@"-[OBPMarshal getResourceAtAPIPath:...]", requests, &ordinary, sendOrdinary)
+	 || !BenchmarkSends(@"-[OBPMarshal sendPreparedRequest:...]", requests, &preparedUsage, sendPrepared))
+		return NO;
+	printf("  %-48s %12.2f us/send  (%.0f%%, %.1f allocs each)\n", "saved by preparing",
+		(ordinary.seconds - preparedUsage.seconds) / requests * 1e6,
+		100 * (ordinary.seconds - preparedUsage.seconds) / ordinary.seconds,
+		((double)ordinary.allocations - (double)preparedUsage.allocations) / requests);
+	return YES;
+}
+
+
+
+#pragma mark -
+static BOOL BenchmarkPollerJitter(OBPSession* session)
+{
+	// Ask for more jitter than allowed: sends must still be at least half an interval apart, and must vary
+	OBPPoller*				poller = [[OBPPoller alloc] initWithMarshal: session.marshal];
+	OBPPreparedRequest*		request = [OBPPreparedRequest GETAtAPIPath: kBenchmarkPollerPathTemplate withOptions: BenchmarkPollerOptions()];
+	NSTimeInterval			interval = 0.1;
+	NSUInteger				wanted = 30;
+	NSMutableArray*			times = [NSMutableArray array];
+	__block NSUInteger		failed = 0;
+	double					gap, gapMin = DBL_MAX, gapMax = 0;
+	NSUInteger				i;
+
+	poller.coalescingWindow = 0;
+	[poller addPollNamed: @"jitter" request: request parameters: BenchmarkPollerParameters(0) interval: interval jitter: 1 handler:
+		^(NSString* name, id deserializedObject, NSError* error) {
+			[times addObject: @(OBPMonotonicTime())];
+			if (error)
+				failed++;
+		}];
+	[poller start];
+	BenchmarkRunUntil(^BOOL{ return [times count] >= wanted; }, kBenchmarkPollerTimeout);
+	[poller stop];
+
+	for (i = 1; i < [times count]; i++)
+	{
+		gap = [times[i] doubleValue] - [times[i-1] doubleValue];
+		gapMin = MIN(gapMin, gap);
+		gapMax = MAX(gapMax, gap);
+	}
+	printf("  %-48s %5.0f to %.0f ms apart  (interval %.0f ms, jitter 1 asked)\n", "poller jitter", gapMin * 1e3, gapMax * 1e3, interval * 1e3);
+	if ([times count] < wanted || failed || gapMin < 0.4 * interval || gapMax > 2 * interval || gapMax - gapMin < 0.1 * interval)
+	{
+		fprintf(stderr, "  poller jitter: %lu sends, %lu failed, gaps under half an interval, over two, or not varied\n", (unsigned long)[times count], (unsigned long)failed);
+		return NO;
+	}
+	return YES;
+}
+
+static NSUInteger BenchmarkPollerPairedSends(OBPSession* session, NSTimeInterval window, NSUInteger* sendsAt)
+{
+	// Two polls of the same interval, the second added a third of an interval after the first: within the window they should go together
+	OBPPoller*				poller = [[OBPPoller alloc] initWithMarshal: session.marshal];
+	OBPPreparedRequest*		request = [OBPPreparedRequest GETAtAPIPath: kBenchmarkPollerPathTemplate withOptions: BenchmarkPollerOptions()];
+	NSTimeInterval			interval = 0.3;
+	NSUInteger				wanted = 6, paired = 0, i;
+	NSMutableDictionary<NSString*,NSMutableArray*>*
+							times = [@{@"a" : [NSMutableArray array], @"b" : [NSMutableArray array]} mutableCopy];
+	HandleOBPPollerResult	handler = ^(NSString* name, id deserializedObject, NSError* error) {
+								[times[name] addObject: @(OBPMonotonicTime())];
+							};
+
+	poller.coalescingWindow = window;
+	[poller addPollNamed: @"a" request: request parameters: BenchmarkPollerParameters(0) interval: interval jitter: 0 handler: handler];
+	[poller start];
+	BenchmarkPollerRunFor(interval / 3);
+	[poller addPollNamed: @"b" request: request parameters: BenchmarkPollerParameters(1) interval: interval jitter: 0 handler: handler];
+	BenchmarkRunUntil(^BOOL{ return [times[@"b"] count] >= wanted; }, kBenchmarkPollerTimeout);
+	[poller stop];
+
+	// The first send of b is when it is added; count those after that went out with a send of a
+	for (i = 1; i < [times[@"b"] count]; i++)
+	for (NSNumber* t in times[@"a"])
+	if (fabs([t doubleValue] - [times[@"b"][i] doubleValue]) < interval / 10)
+	{
+		paired++;
+		break;
+	}
+	*sendsAt = MAX(1, [times[@"b"] count]) - 1;
+	return paired;
+}
+
+static BOOL BenchmarkPollerCoalescing(OBPSession* session)
+{
+	NSUInteger		sends, sendsApart;
+	NSUInteger		paired = BenchmarkPollerPairedSends(session, 0.15, &sends);
+	NSUInteger		pairedApart = BenchmarkPollerPairedSends(session, 0, &sendsApart);
+
+	printf("  %-48s %5lu of %lu sent together  (%lu of %lu with no window)\n", "poller coalescing",
+		(unsigned long)paired, (unsigned long)sends, (unsigned long)pairedApart, (unsigned long)sendsApart);
+	if (!sends || paired < sends || pairedApart)
+	{
+		fprintf(stderr, "  poller coalescing: polls falling due within the window were not sent together, or were without one\n");
+		return NO;
+	}
+	return YES;
+}
+
+static BOOL BenchmarkPollerSkipping(OBPSession* session)
+{
+	// Against a server slower than the interval, only one request may be in flight at a time, and the turns missed are counted
+	OBPPoller*				poller = [[OBPPoller alloc] initWithMarshal: session.marshal];
+	OBPPreparedRequest*		request = [OBPPreparedRequest GETAtAPIPath: kBenchmarkPollerPathTemplate withOptions: BenchmarkPollerOptions()];
+	NSTimeInterval			interval = kBenchmarkPollerSlowLatency / 5;
+	NSUInteger				wanted = 4, sent, skipped;
+	__block NSUInteger		completed = 0;
+
+	poller.coalescingWindow = 0;
+	[poller addPollNamed: @"slow" request: request parameters: BenchmarkPollerParameters(0) interval: interval jitter: 0 handler:
+		^(NSString* name, id deserializedObject, NSError* error) {
+			completed++;
+		}];
+	[poller start];
+	BenchmarkRunUntil(^BOOL{ return completed >= wanted; }, kBenchmarkPollerTimeout);
+	[poller stop];
+	sent = poller.sentCount;
+	skipped = poller.skippedCount;
+
+	printf("  %-48s %5lu sent, %lu skipped  (interval %.0f ms, latency %.0f ms)\n", "poller skipping",
+		(unsigned long)sent, (unsigned long)skipped, interval * 1e3, kBenchmarkPollerSlowLatency * 1e3);
+	if (completed < wanted || sent > completed + 1 || skipped < wanted)
+	{
+		fprintf(stderr, "  poller skipping: %lu sent, %lu completed, %lu skipped; polls stacked up or were not skipped\n",
+			(unsigned long)sent, (unsigned long)completed, (unsigned long)skipped);
+		return NO;
+	}
+	return YES;
+}
+
+
+
+#pragma mark -
+int BenchmarkPoller(NSUInteger count)
+{
+	MockOBPServer*		fast = [MockOBPServer new];
+	MockOBPServer*		slow = [MockOBPServer new];
+	OBPSession*			fastSession = nil;
+	OBPSession*			slowSession = nil;
+	NSUInteger			requests = (NSUInteger)BenchmarkIntegerOption(@"requests", (NSInteger)MAX(100, count / 100));
+	BOOL				ok;
+
+	fast.bankCount = slow.bankCount = 1;
+	slow.latency = kBenchmarkPollerSlowLatency;
+	if (![fast start] || ![slow start])
+	{
+		fprintf(stderr, "  could not start mock servers\n");
+		return 1;
+	}
+
+	ok = nil != (fastSession = BenchmarkValidDirectLoginSession(fast))
+	  && nil != (slowSession = BenchmarkValidDirectLoginSession(slow))
+	  && BenchmarkPreparedSends(fastSession, requests)
+	  && BenchmarkPollerJitter(fastSession)
+	  && BenchmarkPollerCoalescing(fastSession)
+	  && BenchmarkPollerSkipping(slowSession);
+
+	if (fastSession)
+		BenchmarkEndSession(fastSession);
+	if (slowSession)
+		BenchmarkEndSession(slowSession);
+	[fast stop];
+	[slow stop];
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+//
+//  SessionBenchmark.m
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OBPKit/OBPKit.h>
+#import "Benchmark.h"
+#import "MockOBPServer.h"
+
+
+
+#define kBenchmarkClientKey		@"benchmark-client-key"
+#define kBenchmarkClientSecret	@"benchmark-client-secret"
+#define kBenchmarkTimeout		60.0
+
+
+
+#pragma mark -
+/// Keeps credentials in memory, so that benchmark runs never read or write the keychain.
+@interface BenchmarkServerInfo : OBPServerInfo
+@end
+
+@implementation BenchmarkServerInfo
+{
+	NSMutableDictionary*	_credentials;
+}
+- (id)keyChainStore
+{
+	// OBPServerInfo only subscripts its store, so a dictionary stands in for the keychain
+	@synchronized (self) {
+		if (_credentials == nil)
+			_credentials = [NSMutableDictionary dictionary];
+	}
+	return _credentials;
+}
+@end
+
+void BenchmarkPrepareServerInfo(void)
+{
+	OBPServerInfoCustomise(@{
+		OBPServerInfoConfig_DataClass	: @"BenchmarkServerInfo",
+		OBPServerInfoConfig_LoadBlock	: ^OBPServerInfoArray*{ return @[]; },
+		OBPServerInfoConfig_SaveBlock	: ^(OBPServerInfoArray* entries){},
+	});
+}
+
+
+
+#pragma mark -
+/// Stands in for the user in the OAuth1 authorisation step: fetches the authorisation page without showing it and passes the redirect to the session's navigation filter.
+@interface BenchmarkWebViewProvider : NSObject <OBPWebViewProvider, NSURLSessionTaskDelegate>
+@end
+
+@implementation BenchmarkWebViewProvider
+{
+	NSURLSession*			_session;
+	OBPWebNavigationFilter	_filter;
+	OBPWebCancelNotifier	_cancel;
+}
+- (NSString*)callbackScheme
+{
+	return @"x-obpkit-benchmark";
+}
+- (void)showURL:(NSURL*)url filterNavWith:(OBPWebNavigationFilter)navigationFilter notifyCancelBy:(OBPWebCancelNotifier)canceled
+{
+	_filter = navigationFilter;
+	_cancel = canceled;
+	if (_session == nil)
+		_session = [NSURLSession sessionWithConfiguration: [NSURLSessionConfiguration ephemeralSessionConfiguration] delegate: self delegateQueue: [NSOperationQueue mainQueue]];
+	[[_session dataTaskWithURL: url] resume];
+}
+- (void)URLSession:(NSURLSession*)session task:(NSURLSessionTask*)task willPerformHTTPRedirection:(NSHTTPURLResponse*)response newRequest:(NSURLRequest*)request completionHandler:(void (^)(NSURLRequest* _Nullable))completionHandler
+{
+	OBPWebNavigationFilter	filter = _filter;
+	BOOL					reachedCallback = filter && filter(request.URL);
+
+	if (reachedCallback)
+		_filter = nil, _cancel = nil;
+	completionHandler(nil); // ...the callback scheme is not loadable, so stop here either way
+}
+- (void)URLSession:(NSURLSession*)session task:(NSURLSessionTask*)task didCompleteWithError:(NSError*)error
+{
+	OBPWebCancelNotifier	cancel = _cancel;
+
+	// Completing without reaching the callback is the equivalent of the user closing the web view
+	_filter = nil, _cancel = nil;
+	if (cancel)
+		cancel();
+}
+- (void)resetWebViewProvider
+{
+	_filter = nil, _cancel = nil;
+}
+@end
+
+
+
+#pragma mark -
+static OBPSession* BenchmarkMakeSession(MockOBPServer* server, OBPAuthMethod authMethod, BenchmarkWebViewProvider* webViewProvider)
+{
+	OBPServerInfo*		serverInfo = [OBPServerInfo addEntryForAPIServer: server.APIBase];
+	OBPSession*			session;
+
+	serverInfo.accessData = @{
+		OBPServerInfo_ClientKey		: kBenchmarkClientKey,
+		OBPServerInfo_ClientSecret	: kBenchmarkClientSecret,
+	};
+	session = [OBPSession sessionWithServerInfo: serverInfo];
+	session.webViewProvider = webViewProvider;
+	session.authMethod = authMethod;
+	session.directLoginParamsProvider =
+		^(ReceiveDirectLoginParamsBlock receiver) {
+			receiver(@"benchmark-user", @"benchmark-password");
+		};
+	return session;
+}
+
+static BOOL BenchmarkValidate(OBPSession* session, NSString* label)
+{
+	__block BOOL		done = NO;
+	__block NSError*	error = nil;
+	double				t0 = OBPMonotonicTime();
+
+	[session validate:
+		^(NSError* e) {
+			error = e;
+			done = YES;
+		}];
+	if (!BenchmarkRunUntil(^BOOL{ return done; }, kBenchmarkTimeout) || error || !session.valid)
+	{
+		fprintf(stderr, "  %s: validation failed: %s\n", [label UTF8String], [[error description] ?: @"timed out" UTF8String]);
+		return NO;
+	}
+	printf("  %-48s %12.1f ms\n", [label UTF8String], (OBPMonotonicTime() - t0) * 1e3);
+	return YES;
+}
+
+OBPSession* BenchmarkValidDirectLoginSession(MockOBPServer* server)
+{
+	OBPSession* session = BenchmarkMakeSession(server, OBPAuthMethod_DirectLogin, nil);
+	if (BenchmarkValidate(session, @"validate (DirectLogin)"))
+		return session;
+	BenchmarkEndSession(session);
+	return nil;
+}
+
+void BenchmarkEndSession(OBPSession* session)
+{
+	[OBPSession removeSession: session];
+	[OBPServerInfo removeEntry: session.serverInfo];
+}
+
+static void BenchmarkPrintUsage(BenchmarkUsage usage, NSUInteger count, NSString* unit)
+{
+	printf("  %-48s %12.0f %s/s  (%lu in %.3fs, %.1f allocs each, peak %.1f MB)\n", "", count / usage.seconds, [unit UTF8String],
+		(unsigned long)count, usage.seconds, (double)usage.allocations / MAX(1, count), usage.peakMB);
+}
+
+static void BenchmarkPrintMetrics(OBPMetricsSnapshot* snapshot, NSString* pathTemplate)
+{
+	OBPMetricsAggregate*	aggregate = snapshot.pathTemplates[pathTemplate];
+	OBPMetricsHistogram*	h;
+
+	if (aggregate == nil)
+		return;
+	h = [aggregate histogramForMetric: OBPMetricTimeToFirstByte];
+	printf("  %-48s p50 %.2f ms, p99 %.2f ms\n", "time to first byte", [h valueAtPercentile: 50] * 1e3, [h valueAtPercentile: 99] * 1e3);
+	h = [aggregate histogramForMetric: OBPMetricDecode];
+	printf("  %-48s p50 %.2f ms, p99 %.2f ms\n", "decode", [h valueAtPercentile: 50] * 1e3, [h valueAtPercentile: 99] * 1e3);
+	if (aggregate.errorCount)
+		printf("  %-48s %lu\n", "errors", (unsigned long)aggregate.errorCount);
+}
+
+static BOOL BenchmarkLoad(OBPSession* session, MockOBPServer* server, NSString* label, NSUInteger requests, NSDictionary* extraOptions)
+{
+	OBPMarshal*			marshal = session.marshal;
+	NSUInteger			pageSize = 50, pages = MAX(1, server.transactionCount / pageSize);
+	NSUInteger			accounts = server.bankCount * server.accountsPerBank;
+	NSMutableDictionary* options = [NSMutableDictionary dictionary];
+	double*				latencies = calloc(requests, sizeof(double));
+	__block NSUInteger	completed = 0, failed = 0;
+	BenchmarkUsage		usage;
+	NSUInteger			i;
+
+	options[OBPMarshalOptionCoalesce] = @NO;
+	options[OBPMarshalOptionOmitResponseBody] = @YES;
+	[options addEntriesFromDictionary: extraOptions];
+
+	[[OBPMetrics sharedMetrics] reset];
+	BenchmarkUsageBegin();
+	for (i = 0; i < requests; i++)
+	{
+		NSUInteger		account = i % accounts, page = i / accounts % pages;
+		NSString*		path = [NSString stringWithFormat: @"banks/bank-%lu/accounts/bank-%lu-account-%lu/owner/transactions",
+									(unsigned long)(account / server.accountsPerBank), (unsigned long)(account / server.accountsPerBank), (unsigned long)(account % server.accountsPerBank)];
+		double			t0 = OBPMonotonicTime();
+		double*			latency = latencies + i;
+
+		options[OBPMarshalOptionExtraHeaders] = @{@"obp_limit" : @(pageSize), @"obp_offset" : @(page * pageSize)};
+		[marshal getResourceAtAPIPath: path withOptions: options
+			forResultHandler:
+				^(id deserializedObject, NSString* body) {
+					*latency = OBPMonotonicTime() - t0;
+					completed++;
+				}
+			orErrorHandler:
+				^(NSError* error, NSString* path) {
+					*latency = OBPMonotonicTime() - t0;
+					completed++, failed++;
+				}];
+	}
+	BenchmarkRunUntil(^BOOL{ return completed == requests; }, kBenchmarkTimeout);
+	usage = BenchmarkUsageEnd();
+
+	printf("  %s\n", [label UTF8String]);
+	BenchmarkPrintUsage(usage, completed, @"requests");
+	printf("  %-48s p50 %.2f ms, p99 %.2f ms\n", "end to end", BenchmarkPercentile(latencies, completed, 50) * 1e3, BenchmarkPercentile(latencies, completed, 99) * 1e3);
+	BenchmarkPrintMetrics([[OBPMetrics sharedMetrics] snapshotAndReset], @"GET /obp/v2.1.0/banks/*/accounts/*/*/transactions");
+	free(latencies);
+
+	if (completed < requests || failed)
+	{
+		fprintf(stderr, "  %s: %lu of %lu requests completed, %lu failed\n", [label UTF8String], (unsigned long)completed, (unsigned long)requests, (unsigned long)failed);
+		return NO;
+	}
+	return YES;
+}
+
+static BOOL BenchmarkPaging(OBPSession* session, MockOBPServer* server)
+{
+	__block BOOL		done = NO;
+	__block NSError*	error = nil;
+	__block NSUInteger	elements = 0;
+	BenchmarkUsage		usage;
+
+	BenchmarkUsageBegin();
+	[session.marshal pageResourcesAtAPIPath: @"banks/bank-0/accounts/bank-0-account-0/owner/transactions"
+								elementsKey: @"transactions"
+								withOptions: @{OBPMarshalOptionModelClass : [OBPTransaction class]}
+							 forPageHandler: ^(NSArray* page, NSUInteger offset, BOOL* stop) {}
+								 completion:
+		^(NSUInteger elementCount, NSError* e) {
+			elements = elementCount;
+			error = e;
+			done = YES;
+		}];
+	BenchmarkRunUntil(^BOOL{ return done; }, kBenchmarkTimeout);
+	usage = BenchmarkUsageEnd();
+
+	printf("  %s\n", "-[OBPMarshal pageResourcesAtAPIPath:...] (OBPTransaction)");
+	BenchmarkPrintUsage(usage, elements, @"elements");
+	if (!done || error || elements != server.transactionCount)
+	{
+		fprintf(stderr, "  paging: %lu of %lu elements, %s\n", (unsigned long)elements, (unsigned long)server.transactionCount, [[error description] ?: @"" UTF8String]);
+		return NO;
+	}
+	return YES;
+}
+
+
+
+#pragma mark -
+int BenchmarkSession(NSUInteger count)
+{
+	MockOBPServer*				server = [MockOBPServer new];
+	BenchmarkWebViewProvider*	webViewProvider = [BenchmarkWebViewProvider new];
+	OBPSession*					oauth;
+	OBPSession*					directLogin;
+	NSUInteger					requests = (NSUInteger)BenchmarkIntegerOption(@"requests", (NSInteger)MAX(100, count / 100));
+	BOOL						ok;
+
+	server.latency = BenchmarkIntegerOption(@"latency", 0) / 1e3;
+	server.transactionCount = (NSUInteger)BenchmarkIntegerOption(@"transactions", 1000);
+	server.payloadPadding = (NSUInteger)BenchmarkIntegerOption(@"padding", 0);
+	server.consumerSecret = kBenchmarkClientSecret;
+	if (![server start])
+	{
+		fprintf(stderr, "  could not start mock server\n");
+		return 1;
+	}
+	printf("  mock server %s, latency %.0f ms, %lu transactions per account, padding %lu bytes\n",
+		[server.APIServer UTF8String], server.latency * 1e3, (unsigned long)server.transactionCount, (unsigned long)server.payloadPadding);
+
+	oauth = BenchmarkMakeSession(server, OBPAuthMethod_OAuth1, webViewProvider);
+	directLogin = BenchmarkMakeSession(server, OBPAuthMethod_DirectLogin, webViewProvider);
+
+	ok = BenchmarkValidate(oauth, @"validate (OAuth1)")
+	  && BenchmarkValidate(directLogin, @"validate (DirectLogin)")
+	  && BenchmarkLoad(oauth, server, @"GET transactions (OAuth1, JSON)", requests, nil)
+	  && BenchmarkLoad(oauth, server, @"GET transactions (OAuth1, OBPTransaction)", requests, @{OBPMarshalOptionModelClass : [OBPTransaction class]})
+	  && BenchmarkLoad(directLogin, server, @"GET transactions (DirectLogin, JSON)", requests, nil)
+	  && BenchmarkPaging(oauth, server);
+	if (server.signatureFailures)
+	{
+		fprintf(stderr, "  %lu requests had bad OAuth1 signatures\n", (unsigned long)server.signatureFailures);
+		ok = NO;
+	}
+
+	BenchmarkEndSession(oauth);
+	BenchmarkEndSession(directLogin);
+	[server stop];
+
+	return ok ? 0 : 1;
+}
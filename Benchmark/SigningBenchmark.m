@@ -0,0 +1,107 @@
+//
+//  SigningBenchmark.m
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OAuthCore/OAuthCore.h>
+#import <OBPKit/OBPKit.h>
+#import "Benchmark.h"
+#import "MockOBPServer.h"
+
+
+
+static NSDictionary<NSString*,NSString*>* BenchmarkOAuthParameters(NSString* header)
+{
+	// The name="value" pairs of an OAuth Authorization header, values decoded
+	NSMutableDictionary*	params = [NSMutableDictionary dictionary];
+	NSCharacterSet*			quote = [NSCharacterSet characterSetWithCharactersInString: @"\""];
+	NSString*				item;
+	NSRange					equals;
+
+	if (![header hasPrefix: @"OAuth "])
+		return params;
+	for (item in [[header substringFromIndex: 6] componentsSeparatedByString: @","])
+	{
+		item = [item stringByTrimmingCharactersInSet: [NSCharacterSet whitespaceCharacterSet]];
+		if ((equals = [item rangeOfString: @"="]).length)
+			params[[item substringToIndex: equals.location]] = [[[item substringFromIndex: NSMaxRange(equals)] stringByTrimmingCharactersInSet: quote] stringByRemovingPercentEncoding] ?: @"";
+	}
+	return params;
+}
+
+static BOOL BenchmarkCheckSigner(OBPOAuth1Signer* signer, NSString* consumerKey, NSString* consumerSecret, NSString* tokenKey, NSString* tokenSecret)
+{
+	// The signer must give OAuthCore's header for the same nonce and timestamp, and a signature a server accepts, whatever the query
+	NSArray<NSString*>*	queries = @[@"", @"?flag", @"?a=b=c", @"?a%20b=c%2Fd", @"?limit=50&flag&sort_direction=ASC", @"?q=%C3%A9t%C3%A9&q=a", @"?empty=&x=1"];
+	NSString*			query;
+	NSURL*				url;
+	NSString*			legacy;
+	NSString*			header;
+	NSDictionary*		legacyParams;
+	BOOL				ok = YES;
+
+	for (query in queries)
+	{
+		url = [NSURL URLWithString: [@"https://apisandbox.openbankproject.com/obp/v2.1.0/banks/rbs/accounts/main/owner/transactions" stringByAppendingString: query]];
+		legacy = OAuthHeader(url, @"GET", nil, consumerKey, consumerSecret, tokenKey, tokenSecret, nil, nil, OAuthCoreSignatureMethod_HMAC_SHA256);
+		legacyParams = BenchmarkOAuthParameters(legacy);
+		header = [signer authorizationHeaderForURL: url method: @"GET" nonce: legacyParams[@"oauth_nonce"] ?: @"" timestamp: legacyParams[@"oauth_timestamp"] ?: @""];
+		if (![BenchmarkOAuthParameters(header) isEqual: legacyParams])
+		{
+			fprintf(stderr, "  signer differs from OAuthCore for %s:\n    %s\n    %s\n", [[url absoluteString] UTF8String], [header UTF8String], [legacy UTF8String]);
+			ok = NO;
+		}
+		if (![MockOBPServer verifyOAuthAuthorization: header method: @"GET" URL: url formBody: nil consumerSecret: consumerSecret tokenSecret: tokenSecret])
+		{
+			fprintf(stderr, "  signature for %s does not verify\n", [[url absoluteString] UTF8String]);
+			ok = NO;
+		}
+	}
+	return ok;
+}
+
+
+
+int BenchmarkSigning(NSUInteger count)
+{
+	NSString*			consumerKey = @"x1bkqhiqkjdeiyccrqlzagbshnrxlf3oeuk5plw5";
+	NSString*			consumerSecret = @"tvpeqjt0ikgf3zv0gn2gpp5zcb2m3aqzhifqwsed";
+	NSString*			tokenKey = @"LRKK5OTWBB1ERKFR1PXGFB0YO2BNFHZGK5D5XNCS";
+	NSString*			tokenSecret = @"WXHBGGJTB2LY1W5PPHDDFUK0CYYNGOBBGNQCR3UE";
+	NSArray<NSURL*>*	urls = @[
+		[NSURL URLWithString: @"https://apisandbox.openbankproject.com/obp/v2.1.0/my/accounts"],
+		[NSURL URLWithString: @"https://apisandbox.openbankproject.com/obp/v2.1.0/banks/rbs/accounts/main/owner/transactions"],
+		[NSURL URLWithString: @"https://apisandbox.openbankproject.com/obp/v2.1.0/banks/rbs/accounts/main/owner/transactions?sort_direction=ASC&limit=50"],
+	];
+	OBPOAuth1Signer*	signer = [[OBPOAuth1Signer alloc] initWithConsumerKey: consumerKey consumerSecret: consumerSecret token: tokenKey tokenSecret: tokenSecret];
+	NSUInteger			n = [urls count];
+	double				before, after;
+
+	if (!BenchmarkCheckSigner(signer, consumerKey, consumerSecret, tokenKey, tokenSecret))
+		return 1;
+
+	// Baseline: OAuthCore derives the key and encodes every parameter for each header
+	before = BenchmarkRate(@"OAuthHeader (OAuthCore)", count,
+		^(NSUInteger i) {
+			(void)OAuthHeader(urls[i % n], @"GET", nil, consumerKey, consumerSecret, tokenKey, tokenSecret, nil, nil, OAuthCoreSignatureMethod_HMAC_SHA256);
+		});
+
+	// Prepared signer, as used by OBPSession with its credential snapshot
+	after = BenchmarkRate(@"-[OBPOAuth1Signer authorizationHeaderForURL:]", count,
+		^(NSUInteger i) {
+			(void)[signer authorizationHeaderForURL: urls[i % n] method: @"GET"];
+		});
+
+	// Signer construction, which happens once per credential change
+	BenchmarkRate(@"-[OBPOAuth1Signer init...]", count / 10,
+		^(NSUInteger i) {
+			(void)[[OBPOAuth1Signer alloc] initWithConsumerKey: consumerKey consumerSecret: consumerSecret token: tokenKey tokenSecret: tokenSecret];
+		});
+
+	printf("  speed-up: %.1fx\n", after / before);
+	return 0;
+}
@@ -0,0 +1,119 @@
+//
+//  URLCodecBenchmark.m
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OBPKit/OBPKit.h>
+#import "Benchmark.h"
+
+
+
+// The NSString (OBPKit) URL helpers as they were before OBPURLCodec, kept here for comparison
+
+static NSString* LegacyPercentEncode(NSString* s)
+{
+	static NSCharacterSet* sAllowedSet = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		sAllowedSet = [NSCharacterSet characterSetWithCharactersInString:
+			@"-._~0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"];
+	});
+	return [s stringByAddingPercentEncodingWithAllowedCharacters: sAllowedSet];
+}
+
+static NSString* LegacyAppendQueryParams(NSString* s, NSDictionary* dictionary)
+{
+	NSMutableString*	str = [s mutableCopy];
+	const char*			sep = [str rangeOfString:@"?"].length ? "&" : "?";
+
+	for (id key in dictionary)
+	{
+		NSString *keyString = LegacyPercentEncode([key description]);
+		NSString *valString = LegacyPercentEncode([dictionary[key] description]);
+		[str appendFormat: @"%s%@=%@", sep, keyString, valString];
+		sep = "&";
+	}
+	return [str copy];
+}
+
+static NSDictionary* LegacyExtractQueryParams(NSString* s)
+{
+	NSMutableDictionary	*params = [NSMutableDictionary dictionary];
+	NSArray				*elements;
+	NSString			*pair, *key, *val;
+
+	for (pair in [s componentsSeparatedByString: @"&"])
+	{
+		elements = [pair componentsSeparatedByString: @"="];
+		if ([elements count] != 2)
+			continue;
+		key = [elements[0] stringByRemovingPercentEncoding];
+		val = [elements[1] stringByRemovingPercentEncoding];
+		if (key && val)
+			params[key] = val;
+	}
+	return [params copy];
+}
+
+
+
+static void BenchmarkCompareRates(NSString* label, NSUInteger count, void (^legacy)(NSUInteger i), void (^current)(NSUInteger i))
+{
+	double before = BenchmarkRate([label stringByAppendingString: @" (before)"], count, legacy);
+	double after = BenchmarkRate([label stringByAppendingString: @" (after)"], count, current);
+	printf("  %-48s %12.2fx\n", "", after / before);
+}
+
+int BenchmarkURLCodec(NSUInteger count)
+{
+	NSString*				base = @"https://apisandbox.openbankproject.com/obp/v2.1.0/banks/rbs/accounts/main/owner/transactions";
+	NSString*				token = @"LRKK5OTWBB1ERKFR1PXGFB0YO2BNFHZGK5D5XNCS";
+	NSString*				text = @"Caffè & Crème: 50% off! (today only) ~ a/b?c=d";
+	NSString*				withNUL = [NSString stringWithFormat: @"a%Cb", (unichar)0]; // ...must become a%00b, not be cut short
+	NSMutableDictionary*	params = [NSMutableDictionary dictionary];
+	NSMutableString*		longToken = [NSMutableString string];
+	NSString*				query;
+	NSUInteger				i;
+
+	// A long query, such as an OAuth exchange or form post: mostly tokens and identifiers, with some free text
+	for (i = 0; i < 24; i++)
+		params[[NSString stringWithFormat: @"oauth_param_%lu", (unsigned long)i]] = [token stringByAppendingFormat: @"%lu", (unsigned long)i];
+	for (i = 0; i < 8; i++)
+		params[[NSString stringWithFormat: @"note_%lu", (unsigned long)i]] = text;
+	for (i = 0; i < 32; i++)
+		[longToken appendString: token];
+	params[@"signature"] = longToken;
+	query = [[@"" stringByAppendingURLQueryParams: params] substringFromIndex: 1];
+
+	// Same answers before and after?
+	if (![LegacyAppendQueryParams(base, params) isEqualToString: [base stringByAppendingURLQueryParams: params]]
+	 || ![LegacyExtractQueryParams(query) isEqualToDictionary: [query extractURLQueryParams]]
+	 || ![[query extractURLQueryParams] isEqualToDictionary: params]
+	 || ![LegacyPercentEncode(text) isEqualToString: [text stringByAddingPercentEncodingForAllRFC3986ReservedCharachters]]
+	 || ![LegacyPercentEncode(longToken) isEqualToString: [longToken stringByAddingPercentEncodingForAllRFC3986ReservedCharachters]]
+	 || ![LegacyPercentEncode(withNUL) isEqualToString: [withNUL stringByAddingPercentEncodingForAllRFC3986ReservedCharachters]]
+	 || ![LegacyAppendQueryParams(base, @{@"q" : withNUL}) isEqualToString: [base stringByAppendingURLQueryParams: @{@"q" : withNUL}]])
+	{
+		fprintf(stderr, "  results differ from the previous implementation\n");
+		return 1;
+	}
+
+	printf("  query of %lu pairs, %lu bytes\n", (unsigned long)[params count], (unsigned long)[query length]);
+	BenchmarkCompareRates(@"encode text", count,
+		^(NSUInteger i) { (void)LegacyPercentEncode(text); },
+		^(NSUInteger i) { (void)[text stringByAddingPercentEncodingForAllRFC3986ReservedCharachters]; });
+	BenchmarkCompareRates(@"encode 1280 byte token", count / 4,
+		^(NSUInteger i) { (void)LegacyPercentEncode(longToken); },
+		^(NSUInteger i) { (void)[longToken stringByAddingPercentEncodingForAllRFC3986ReservedCharachters]; });
+	BenchmarkCompareRates(@"-stringByAppendingURLQueryParams:", count / 40,
+		^(NSUInteger i) { (void)LegacyAppendQueryParams(base, params); },
+		^(NSUInteger i) { (void)[base stringByAppendingURLQueryParams: params]; });
+	BenchmarkCompareRates(@"-extractURLQueryParams", count / 40,
+		^(NSUInteger i) { (void)LegacyExtractQueryParams(query); },
+		^(NSUInteger i) { (void)[query extractURLQueryParams]; });
+	return 0;
+}
@@ -0,0 +1,80 @@
+//
+//  main.m
+//  Benchmark
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "Benchmark.h"
+
+
+
+/** Benchmark
+
+Command line tool that measures the throughput of OBPKit's hot paths, so that changes to them can be compared before and after. It makes no requests beyond the loopback interface and touches no keychain items: the session and poller suites run OBPSession and OBPMarshal against a MockOBPServer, and keeps credentials in memory.
+
+Usage:
+
+	Benchmark [suite ...] [-n count] [-requests n] [-latency ms] [-transactions n] [-padding bytes]
+
+where suite is one of the names listed below (default: all), and count scales the number of iterations (default: 100000). The remaining options configure the session suite: the number of requests in each load run, which the poller suite also sends (default: count / 100), the mock server's response latency (default: 0), the number of transactions in each account (default: 1000) and the number of bytes by which to pad each transaction (default: 0).
+
+*/
+
+
+
+typedef int (*BenchmarkSuite)(NSUInteger count);
+
+
+
+int main(int argc, const char * argv[])
+{
+	@autoreleasepool
+	{
+		NSDictionary<NSString*,NSValue*>*	suites = @{
+			@"crypt"	: [NSValue valueWithPointer: (const void*)BenchmarkCredentialCrypt],
+			@"date"		: [NSValue valueWithPointer: (const void*)BenchmarkDates],
+			@"json"		: [NSValue valueWithPointer: (const void*)BenchmarkJSONDecode],
+			@"poller"	: [NSValue valueWithPointer: (const void*)BenchmarkPoller],
+			@"session"	: [NSValue valueWithPointer: (const void*)BenchmarkSession],
+			@"signing"	: [NSValue valueWithPointer: (const void*)BenchmarkSigning],
+			@"url"		: [NSValue valueWithPointer: (const void*)BenchmarkURLStrings],
+			@"urlcodec"	: [NSValue valueWithPointer: (const void*)BenchmarkURLCodec],
+		};
+		NSMutableArray<NSString*>*			selected = [NSMutableArray array];
+		NSUInteger							count = 100000;
+		NSString*							name;
+		int									i, result = 0;
+
+		BenchmarkPrepareServerInfo();
+
+		for (i = 1; i < argc; i++)
+		{
+			if (0 == strcmp(argv[i], "-n") && i + 1 < argc)
+				count = (NSUInteger)MAX(1, atol(argv[++i]));
+			else
+			if (argv[i][0] == '-' && i + 1 < argc)
+				i++; // ...a -name value option, read through BenchmarkIntegerOption()
+			else
+			if (suites[name = @(argv[i])])
+				[selected addObject: name];
+			else
+			{
+				fprintf(stderr, "usage: Benchmark [%s] [-n count] [-requests n] [-latency ms] [-transactions n] [-padding bytes]\n", [[[suites.allKeys sortedArrayUsingSelector: @selector(compare:)] componentsJoinedByString: @"|"] UTF8String]);
+				return 1;
+			}
+		}
+		if (![selected count])
+			[selected addObjectsFromArray: [suites.allKeys sortedArrayUsingSelector: @selector(compare:)]];
+
+		for (name in selected)
+		{
+			printf("%s\n", [name UTF8String]);
+			result |= ((BenchmarkSuite)[suites[name] pointerValue])(count);
+		}
+
+		return result;
+	}
+}
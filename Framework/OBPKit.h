@@ -23,10 +23,25 @@ FOUNDATION_EXPORT const unsigned char OBPKit_OSXVersionString[];
 // Public Headers
 #import <OBPKit/OBPServerInfo.h>
 #import <OBPKit/OBPServerInfoStore.h>
+#import <OBPKit/OBPServerInfoRecordStore.h>
+#import <OBPKit/OBPCredentialCryptor.h>
 #import <OBPKit/OBPSession.h>
+#import <OBPKit/OBPTransport.h>
+#import <OBPKit/OBPRateController.h>
+#import <OBPKit/OBPOAuth1Signer.h>
 #import <OBPKit/OBPWebViewProvider.h>
 #import <OBPKit/OBPMarshal.h>
+#import <OBPKit/OBPPager.h>
+#import <OBPKit/OBPBatch.h>
+#import <OBPKit/OBPPoller.h>
+#import <OBPKit/OBPFanOut.h>
+#import <OBPKit/OBPTransactionStore.h>
+#import <OBPKit/OBPJSONStreamParser.h>
+#import <OBPKit/OBPModel.h>
+#import <OBPKit/OBPResourceModels.h>
+#import <OBPKit/OBPResponseCache.h>
 #import <OBPKit/OBPDateFormatter.h>
+#import <OBPKit/OBPMetrics.h>
 #import <OBPKit/OBPLogging.h>
 #import <OBPKit/NSString+OBPKit.h>
 
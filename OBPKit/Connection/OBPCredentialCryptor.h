@@ -0,0 +1,44 @@
+//
+//  OBPCredentialCryptor.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OBPServerInfo.h"
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+/**	An OBPCredentialCryptor instance encrypts and decrypts client credentials for storage in the keychain, using the parameters from an OBPProvideCryptParamsBlock.
+
+	The parameters are fetched once, when the instance is created, and the cryptor contexts made from them are pooled and reset for each credential, so that converting many credentials, e.g. when importing or exporting server configurations, costs one key set-up rather than one each. Key material is scrubbed from memory when the instance is deallocated.
+
+	In the default mode, the output is the same as that of the blocks OBPServerInfo has always made from the parameters, so existing keychain items remain readable.
+
+	In authenticated mode, each credential is encrypted with AES-256 in CBC mode under a fresh random initialisation vector, and then authenticated with HMAC-SHA256 over the initialisation vector and cipher text (encrypt-then-MAC), using two keys derived from the provided key; decryption rejects any credential that has been altered. Authenticated output is marked with the prefix "v1:", and input without it is refused, so that a credential cannot be downgraded by swapping in one in the default format. Credentials stored before authenticated mode was turned on are read once with -decryptLegacyCredential:, which OBPServerInfo does for an entry's first read and then stores the credential again in the authenticated format; after that, the entry only accepts authenticated input. (Like any encryption stronger than DES, this affects your app's export compliance; see OBPServerInfoCustomise.)
+
+	Instances are safe to use from any thread.
+*/
+@interface OBPCredentialCryptor : NSObject
+- (instancetype)initWithParamsProvider:(nullable OBPProvideCryptParamsBlock)provideParams authenticated:(BOOL)authenticated; ///< Designated initialiser. \param provideParams supplies the key, initialisation vector and algorithm, as for OBPServerInfoConfig_ProvideCryptParamsBlock; if nil, the default algorithm is used with a zero key. \param authenticated selects encrypt-then-MAC, which derives its keys from the provided key; the provided parameters are then used only to decrypt credentials stored in the default format.
+@property (nonatomic, readonly) BOOL authenticated;
+
+- (nullable NSString*)encryptCredential:(NSString*)credential; ///< \returns the base64 encoded cipher text, or nil on failure.
+- (nullable NSString*)decryptCredential:(NSString*)credential; ///< \returns the plain text, or nil if credential could not be decrypted or, in authenticated mode, has been altered or is not in the authenticated format.
+- (nullable NSString*)decryptLegacyCredential:(NSString*)credential; ///< Decrypt a credential stored in the default format, in either mode, so that it can be converted. \returns the plain text, or nil if credential is not in the default format or could not be decrypted.
+- (NSArray*)encryptCredentials:(NSArray<NSString*>*)credentials; ///< Encrypt many credentials using one cryptor context. \returns an array of the same length, holding NSNull for any that failed.
+- (NSArray*)decryptCredentials:(NSArray<NSString*>*)credentials; ///< Decrypt many credentials using one cryptor context. \returns an array of the same length, holding NSNull for any that failed.
+
+@property (nonatomic, readonly) OBPClientCredentialCryptBlock encryptBlock; ///< A block for OBPServerInfoConfig_ClientCredentialEncryptBlock that uses this instance, and on failure returns its input unchanged in the default mode, or an empty string in authenticated mode, so that the credential is never stored in the clear.
+@property (nonatomic, readonly) OBPClientCredentialCryptBlock decryptBlock; ///< A block for OBPServerInfoConfig_ClientCredentialDecryptBlock that uses this instance, and on failure returns its input unchanged in the default mode, or an empty string in authenticated mode, so that altered credentials read as missing.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,359 @@
+//
+//  OBPCredentialCryptor.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPCredentialCryptor.h"
+// sdk
+#import <CommonCrypto/CommonCrypto.h>
+#import <CommonCrypto/CommonRandom.h>
+
+
+
+#define kAuthenticatedPrefix	@"v1:"
+#define kAuthKeyLen				kCCKeySizeAES256
+#define kAuthIVLen				kCCBlockSizeAES128
+#define kAuthTagLen				CC_SHA256_DIGEST_LENGTH
+#define kPoolMax				4		// idle cryptors kept per kind
+
+typedef NS_ENUM(uint8_t, ECryptor) {
+	eCryptor_Encrypt,			// default format
+	eCryptor_Decrypt,
+	eCryptor_AuthEncrypt,		// AES-256-CBC for encrypt-then-MAC
+	eCryptor_AuthDecrypt,
+	eCryptor_count
+};
+
+typedef struct CryptorSet {
+	CCCryptorRef	ref[eCryptor_count];	// borrowed from the pools as needed
+} CryptorSet;
+
+
+
+static void Scrub(void* p, size_t n)
+{
+	volatile uint8_t* v = p; // ...so that the compiler cannot drop the stores
+	while (n--)
+		*v++ = 0;
+}
+
+static BOOL Crypt(CCCryptorRef cryptor, const void* iv, const void* bytes, size_t length, NSMutableData* output)
+{
+	size_t		start = [output length];
+	size_t		available, moved = 0, movedFinal = 0;
+	uint8_t*	out;
+
+	if (cryptor == NULL || kCCSuccess != CCCryptorReset(cryptor, iv))
+		return NO;
+	available = CCCryptorGetOutputLength(cryptor, length, true);
+	[output setLength: start + available];
+	out = (uint8_t*)[output mutableBytes] + start;
+	if (kCCSuccess != CCCryptorUpdate(cryptor, bytes, length, out, available, &moved)
+	 || kCCSuccess != CCCryptorFinal(cryptor, out + moved, available - moved, &movedFinal))
+	{
+		Scrub(out, available);
+		[output setLength: start];
+		return NO;
+	}
+	[output setLength: start + moved + movedFinal];
+	return YES;
+}
+
+
+
+#pragma mark -
+@implementation OBPCredentialCryptor
+{
+	OBPCryptParams				_params;		// as provided; key and iv point into _material
+	uint8_t*					_material;		// provided key and iv, then derived encryption and MAC keys; scrubbed at dealloc
+	size_t						_materialSize;
+	const uint8_t*				_authKey;		// into _material, in authenticated mode
+	const uint8_t*				_macKey;
+	NSArray<NSMutableArray<NSValue*>*>*	_pools;	// idle cryptors, by ECryptor
+}
+- (instancetype)initWithParamsProvider:(nullable OBPProvideCryptParamsBlock)provideParams authenticated:(BOOL)authenticated
+{
+	if (nil == (self = [super init]))
+		return nil;
+
+	enum {
+		kKeyStoreMax = kOBPClientCredentialMaxCryptKeyLen * 2,
+		kIVStoreMax = kOBPClientCredentialMaxCryptBlockLen * 2,
+	};
+	static const char		encLabel[] = "OBPKit credential encryption";
+	static const char		macLabel[] = "OBPKit credential authentication";
+	uint8_t					keyStore[kKeyStoreMax];
+	uint8_t					ivStore[kIVStoreMax];
+	OBPCryptParams			params = {
+		.algorithm	= kOBPClientCredentialCryptAlg,
+		.options	= 0,
+		.keySize	= kOBPClientCredentialCryptKeyLen,
+		.blockSize	= kOBPClientCredentialCryptBlockLen,
+		.key		= keyStore,
+		.iv			= ivStore
+	};
+	NSUInteger				i;
+
+	// Fetch the parameters once; the provider may point key and iv at its own storage
+	memset(keyStore, 0, kKeyStoreMax);
+	memset(ivStore, 0, kIVStoreMax);
+	if (provideParams)
+		provideParams(&params, kKeyStoreMax, kIVStoreMax);
+
+	_materialSize = params.keySize + params.blockSize + (authenticated ? 2 * kAuthKeyLen : 0);
+	_material = malloc(_materialSize);
+	_params = params;
+	_params.key = _material;
+	_params.iv = _material + params.keySize;
+	memcpy(_params.key, params.key, params.keySize);
+	memcpy(_params.iv, params.iv, params.blockSize);
+	if (authenticated)
+	{
+		// Separate keys for encryption and authentication, derived from the provided key
+		_authKey = _params.iv + params.blockSize;
+		_macKey = _authKey + kAuthKeyLen;
+		CCHmac(kCCHmacAlgSHA256, _params.key, _params.keySize, encLabel, sizeof(encLabel) - 1, (void*)_authKey);
+		CCHmac(kCCHmacAlgSHA256, _params.key, _params.keySize, macLabel, sizeof(macLabel) - 1, (void*)_macKey);
+	}
+	Scrub(keyStore, kKeyStoreMax);
+	Scrub(ivStore, kIVStoreMax);
+
+	NSMutableArray* pools = [NSMutableArray arrayWithCapacity: eCryptor_count];
+	for (i = 0; i < eCryptor_count; i++)
+		[pools addObject: [NSMutableArray array]];
+	_pools = [pools copy];
+
+	return self;
+}
+- (void)dealloc
+{
+	for (NSArray<NSValue*>* pool in _pools)
+		for (NSValue* value in pool)
+			CCCryptorRelease([value pointerValue]); // ...which also clears the cryptor's key schedule
+	if (_material)
+	{
+		Scrub(_material, _materialSize);
+		free(_material);
+	}
+}
+- (BOOL)authenticated
+{
+	return _authKey != NULL;
+}
+#pragma mark -
+- (CCCryptorRef)cryptor:(ECryptor)which in:(CryptorSet*)set
+{
+	NSMutableArray<NSValue*>*	pool = _pools[which];
+	NSValue*					value;
+	CCCryptorRef				cryptor;
+	BOOL						auth = which >= eCryptor_AuthEncrypt;
+
+	if (NULL != (cryptor = set->ref[which]))
+		return cryptor;
+	@synchronized (pool) {
+		if (nil != (value = [pool lastObject]))
+			[pool removeLastObject];
+	}
+	if (value)
+		cryptor = [value pointerValue];
+	else
+	if (kCCSuccess != CCCryptorCreate(
+						which == eCryptor_Encrypt || which == eCryptor_AuthEncrypt ? kCCEncrypt : kCCDecrypt,
+						auth ? kCCAlgorithmAES : _params.algorithm,
+						auth ? kCCOptionPKCS7Padding : _params.options,
+						auth ? _authKey : _params.key,
+						auth ? kAuthKeyLen : _params.keySize,
+						auth ? NULL : _params.iv,
+						&cryptor))
+		cryptor = NULL;
+	return set->ref[which] = cryptor;
+}
+- (void)returnCryptors:(CryptorSet*)set
+{
+	NSMutableArray<NSValue*>*	pool;
+	NSUInteger					i;
+
+	for (i = 0; i < eCryptor_count; i++)
+	if (set->ref[i] != NULL)
+	{
+		pool = _pools[i];
+		@synchronized (pool) {
+			if ([pool count] < kPoolMax)
+				[pool addObject: [NSValue valueWithPointer: set->ref[i]]], set->ref[i] = NULL;
+		}
+		if (set->ref[i] != NULL)
+			CCCryptorRelease(set->ref[i]);
+	}
+}
+#pragma mark -
+- (NSString*)encrypt:(NSString*)credential with:(CryptorSet*)set
+{
+	NSData*				plain = [credential dataUsingEncoding: NSUTF8StringEncoding];
+	NSMutableData*		output = [NSMutableData data];
+	NSMutableData*		input;
+	uint8_t				iv[kAuthIVLen];
+	uint8_t				tag[kAuthTagLen];
+	NSString*			result = nil;
+
+	if (plain == nil)
+		return nil;
+
+	if (_authKey)
+	{
+		// iv | cipher text | HMAC-SHA256(iv | cipher text)
+		if (kCCSuccess != CCRandomGenerateBytes(iv, kAuthIVLen))
+			return nil;
+		[output appendBytes: iv length: kAuthIVLen];
+		if (Crypt([self cryptor: eCryptor_AuthEncrypt in: set], iv, [plain bytes], [plain length], output))
+		{
+			CCHmac(kCCHmacAlgSHA256, _macKey, kAuthKeyLen, [output bytes], [output length], tag);
+			[output appendBytes: tag length: kAuthTagLen];
+			result = [kAuthenticatedPrefix stringByAppendingString: [output base64EncodedStringWithOptions: 0]];
+		}
+		return result;
+	}
+
+	// Default format: zero padded to a whole number of blocks, as the blocks made by OBPServerInfo always did
+	input = [plain mutableCopy];
+	[input setLength: ([plain length] + _params.blockSize - 1) / _params.blockSize * _params.blockSize];
+	if (Crypt([self cryptor: eCryptor_Encrypt in: set], _params.iv, [input bytes], [input length], output))
+		result = [output base64EncodedStringWithOptions: 0];
+	Scrub([input mutableBytes], [input length]);
+	return result;
+}
+- (NSString*)decrypt:(NSString*)credential with:(CryptorSet*)set
+{
+	if (_authKey)
+		return [credential hasPrefix: kAuthenticatedPrefix] ? [self decryptAuthenticated: credential with: set] : nil; // ...never fall back to the default format, which would allow a downgrade
+	return [self decryptLegacy: credential with: set];
+}
+- (NSString*)decryptAuthenticated:(NSString*)credential with:(CryptorSet*)set
+{
+	NSMutableData*		output = [NSMutableData data];
+	NSData*				data;
+	const uint8_t*		bytes;
+	uint8_t				tag[kAuthTagLen];
+	uint8_t				diff = 0;
+	size_t				length, i;
+	NSString*			result = nil;
+
+	data = [[NSData alloc] initWithBase64EncodedString: [credential substringFromIndex: [kAuthenticatedPrefix length]] options: 0];
+	length = [data length];
+	if (length < kAuthIVLen + kCCBlockSizeAES128 + kAuthTagLen)
+		return nil;
+	bytes = [data bytes];
+	length -= kAuthTagLen;
+
+	// Check the tag in constant time before decrypting anything
+	CCHmac(kCCHmacAlgSHA256, _macKey, kAuthKeyLen, bytes, length, tag);
+	for (i = 0; i < kAuthTagLen; i++)
+		diff |= tag[i] ^ bytes[length + i];
+	if (diff)
+		return nil;
+
+	if (Crypt([self cryptor: eCryptor_AuthDecrypt in: set], bytes, bytes + kAuthIVLen, length - kAuthIVLen, output))
+		result = [[NSString alloc] initWithData: output encoding: NSUTF8StringEncoding];
+	Scrub([output mutableBytes], [output length]);
+	return result;
+}
+- (NSString*)decryptLegacy:(NSString*)credential with:(CryptorSet*)set
+{
+	NSMutableData*		output = [NSMutableData data];
+	NSMutableData*		input;
+	NSData*				data;
+	const uint8_t*		bytes;
+	size_t				length;
+	NSString*			result = nil;
+
+	// Default format
+	if ([credential hasPrefix: kAuthenticatedPrefix])
+		return nil;
+	if (nil == (data = [[NSData alloc] initWithBase64EncodedString: credential options: 0]))
+		return nil;
+	input = [data mutableCopy];
+	[input setLength: ([data length] + _params.blockSize - 1) / _params.blockSize * _params.blockSize];
+	if (Crypt([self cryptor: eCryptor_Decrypt in: set], _params.iv, [input bytes], [input length], output))
+	{
+		// ...ends at the first zero of the padding
+		bytes = [output bytes];
+		length = strnlen((const char*)bytes, [output length]);
+		result = [[NSString alloc] initWithBytes: bytes length: length encoding: NSUTF8StringEncoding];
+	}
+	Scrub([output mutableBytes], [output length]);
+	return result;
+}
+#pragma mark -
+- (nullable NSString*)encryptCredential:(NSString*)credential
+{
+	CryptorSet	set = {{NULL}};
+	NSString*	result = [self encrypt: credential with: &set];
+	[self returnCryptors: &set];
+	return result;
+}
+- (nullable NSString*)decryptCredential:(NSString*)credential
+{
+	CryptorSet	set = {{NULL}};
+	NSString*	result = [self decrypt: credential with: &set];
+	[self returnCryptors: &set];
+	return result;
+}
+- (nullable NSString*)decryptLegacyCredential:(NSString*)credential
+{
+	CryptorSet	set = {{NULL}};
+	NSString*	result = [self decryptLegacy: credential with: &set];
+	[self returnCryptors: &set];
+	return result;
+}
+- (NSArray*)encryptCredentials:(NSArray<NSString*>*)credentials
+{
+	NSMutableArray*	results = [NSMutableArray arrayWithCapacity: [credentials count]];
+	CryptorSet		set = {{NULL}};
+	NSString*		result;
+
+	for (NSString* credential in credentials)
+	{
+		result = [credential isKindOfClass: [NSString class]] ? [self encrypt: credential with: &set] : nil;
+		[results addObject: result ?: [NSNull null]];
+	}
+	[self returnCryptors: &set];
+	return [results copy];
+}
+- (NSArray*)decryptCredentials:(NSArray<NSString*>*)credentials
+{
+	NSMutableArray*	results = [NSMutableArray arrayWithCapacity: [credentials count]];
+	CryptorSet		set = {{NULL}};
+	NSString*		result;
+
+	for (NSString* credential in credentials)
+	{
+		result = [credential isKindOfClass: [NSString class]] ? [self decrypt: credential with: &set] : nil;
+		[results addObject: result ?: [NSNull null]];
+	}
+	[self returnCryptors: &set];
+	return [results copy];
+}
+#pragma mark -
+- (OBPClientCredentialCryptBlock)encryptBlock
+{
+	BOOL authenticated = self.authenticated;
+	return ^NSString*(NSString* credential)
+		{
+			if (![credential length])
+				return credential;
+			return [self encryptCredential: credential] ?: (authenticated ? @"" : credential);
+		};
+}
+- (OBPClientCredentialCryptBlock)decryptBlock
+{
+	BOOL authenticated = self.authenticated;
+	return ^NSString*(NSString* credential)
+		{
+			if (![credential length])
+				return credential;
+			return [self decryptCredential: credential] ?: (authenticated ? @"" : credential);
+		};
+}
+@end
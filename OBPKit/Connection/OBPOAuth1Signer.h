@@ -0,0 +1,31 @@
+//
+//  OBPOAuth1Signer.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+/**	An OBPOAuth1Signer instance makes OAuth 1.0a Authorization headers (HMAC-SHA256 signature method) for one set of client and token credentials.
+
+	The header it makes is equivalent to that made by OAuthHeader() from OAuthCore for a request without a form body, but the work that does not vary between requests is done once, at initialisation: the HMAC key is expanded into prepared inner and outer digest states, and the static oauth_ parameters are percent-encoded and sorted ahead of time. Signing a request then needs only the per-request nonce, timestamp and query parameters. As RFC 5849 requires, each query parameter is split at its first '=', a parameter without one has an empty value, and names and values are decoded before being encoded for the signature.
+
+	OBPSession makes a signer from its credential snapshot and uses it for all requests until the credentials change. Instances are immutable and may be used from any thread.
+*/
+@interface OBPOAuth1Signer : NSObject
+- (instancetype)initWithConsumerKey:(NSString*)consumerKey consumerSecret:(NSString*)consumerSecret token:(nullable NSString*)token tokenSecret:(nullable NSString*)tokenSecret; ///< Designated initialiser.
+- (NSString*)authorizationHeaderForURL:(NSURL*)url method:(NSString*)method; ///< Return the value for the Authorization header of a request, signing the method, the normalised url and its query parameters with a fresh nonce and timestamp.
+- (NSString*)authorizationHeaderForURL:(NSURL*)url method:(NSString*)method nonce:(NSString*)nonce timestamp:(NSString*)timestamp; ///< As -authorizationHeaderForURL:method:, but with the given nonce and timestamp, for reproducible signatures when testing and measuring.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
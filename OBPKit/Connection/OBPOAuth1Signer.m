@@ -0,0 +1,198 @@
+//
+//  OBPOAuth1Signer.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPOAuth1Signer.h"
+// sdk
+#include <CommonCrypto/CommonDigest.h>
+#include <time.h>
+// prj
+#import "OBPURLCodec.h"
+
+
+
+#define kHMACBlockSize	CC_SHA256_BLOCK_BYTES
+
+
+
+static void OBPAppendRFC3986EncodedString(NSMutableData* md, NSString* s)
+{
+	OBPURLAppendPercentEncodedString(md, s); // ...all but the unreserved characters, as OAuth requires
+}
+
+static NSString* OBPRFC3986EncodedString(NSString* s)
+{
+	NSMutableData* md = [NSMutableData dataWithCapacity: [s length] + 8];
+	OBPAppendRFC3986EncodedString(md, s);
+	return [[NSString alloc] initWithData: md encoding: NSASCIIStringEncoding] ?: @"";
+}
+
+static void OBPAppendASCII(NSMutableData* md, const char* s)
+{
+	[md appendBytes: s length: strlen(s)];
+}
+
+static void OBPAppendString(NSMutableData* md, NSString* s)
+{
+	OBPURLAppendUTF8String(md, s);
+}
+
+
+
+#pragma mark -
+@implementation OBPOAuth1Signer
+{
+	NSString*		_encodedConsumerKey;
+	NSString*		_encodedToken;			// nil if no token
+	NSString*		_headerPrefix;			// "OAuth " and the static parameters
+	CC_SHA256_CTX	_inner;					// digest state after absorbing key ^ ipad
+	CC_SHA256_CTX	_outer;					// digest state after absorbing key ^ opad
+}
+- (instancetype)initWithConsumerKey:(NSString*)consumerKey consumerSecret:(NSString*)consumerSecret token:(NSString*)token tokenSecret:(NSString*)tokenSecret
+{
+	if (nil == (self = [super init]))
+		return nil;
+
+	NSMutableData*		key = [NSMutableData data];
+	uint8_t				block[kHMACBlockSize];
+	uint8_t				pad[kHMACBlockSize];
+	NSUInteger			i;
+
+	_encodedConsumerKey = OBPRFC3986EncodedString(consumerKey ?: @"");
+	_encodedToken = token ? OBPRFC3986EncodedString(token) : nil;
+
+	_headerPrefix = _encodedToken
+		? [NSString stringWithFormat: @"OAuth oauth_consumer_key=\"%@\", oauth_signature_method=\"HMAC-SHA256\", oauth_token=\"%@\", oauth_version=\"1.0\"", _encodedConsumerKey, _encodedToken]
+		: [NSString stringWithFormat: @"OAuth oauth_consumer_key=\"%@\", oauth_signature_method=\"HMAC-SHA256\", oauth_version=\"1.0\"", _encodedConsumerKey];
+
+	// HMAC key is encoded(consumer secret) & encoded(token secret); prepare the padded inner and outer states once
+	OBPAppendRFC3986EncodedString(key, consumerSecret ?: @"");
+	OBPAppendASCII(key, "&");
+	OBPAppendRFC3986EncodedString(key, tokenSecret ?: @"");
+	memset(block, 0, sizeof(block));
+	if ([key length] > kHMACBlockSize)
+		CC_SHA256([key bytes], (CC_LONG)[key length], block);
+	else
+		memcpy(block, [key bytes], [key length]);
+
+	for (i = 0; i < kHMACBlockSize; i++)
+		pad[i] = block[i] ^ 0x36;
+	CC_SHA256_Init(&_inner);
+	CC_SHA256_Update(&_inner, pad, kHMACBlockSize);
+
+	for (i = 0; i < kHMACBlockSize; i++)
+		pad[i] = block[i] ^ 0x5c;
+	CC_SHA256_Init(&_outer);
+	CC_SHA256_Update(&_outer, pad, kHMACBlockSize);
+
+	memset(block, 0, sizeof(block));
+	memset(pad, 0, sizeof(pad));
+
+	return self;
+}
+- (NSString*)authorizationHeaderForURL:(NSURL*)url method:(NSString*)method
+{
+	return [self authorizationHeaderForURL: url
+									method: method
+									 nonce: [[NSUUID UUID] UUIDString]
+								 timestamp: [NSString stringWithFormat: @"%ld", (long)time(NULL)]];
+}
+- (NSString*)authorizationHeaderForURL:(NSURL*)url method:(NSString*)method nonce:(NSString*)nonce timestamp:(NSString*)timestamp
+{
+	NSString*			encodedNonce = OBPRFC3986EncodedString(nonce);
+	NSString*			encodedTimestamp = OBPRFC3986EncodedString(timestamp);
+	NSMutableData*		params = [NSMutableData dataWithCapacity: 256];
+	NSMutableData*		base = [NSMutableData dataWithCapacity: 512];
+	NSString*			query = [url query];
+	NSNumber*			port = [url port];
+	CC_SHA256_CTX		ctx;
+	uint8_t				digest[CC_SHA256_DIGEST_LENGTH];
+	NSString*			signature;
+
+	// Normalised parameters
+	if (![query length])
+	{
+		// Only the oauth_ parameters, whose sorted order is fixed
+		OBPAppendASCII(params, "oauth_consumer_key="), OBPAppendString(params, _encodedConsumerKey);
+		OBPAppendASCII(params, "&oauth_nonce="), OBPAppendString(params, encodedNonce);
+		OBPAppendASCII(params, "&oauth_signature_method=HMAC-SHA256");
+		OBPAppendASCII(params, "&oauth_timestamp="), OBPAppendString(params, encodedTimestamp);
+		if (_encodedToken)
+			OBPAppendASCII(params, "&oauth_token="), OBPAppendString(params, _encodedToken);
+		OBPAppendASCII(params, "&oauth_version=1.0");
+	}
+	else
+	{
+		NSMutableArray<NSArray<NSString*>*>*	pairs = [NSMutableArray array];
+		NSArray<NSString*>*						pair;
+		NSString*								item;
+		NSString*								name;
+		NSString*								value;
+		NSRange									equals;
+		BOOL									first = YES;
+
+		[pairs addObject: @[@"oauth_consumer_key", _encodedConsumerKey]];
+		[pairs addObject: @[@"oauth_nonce", encodedNonce]];
+		[pairs addObject: @[@"oauth_signature_method", @"HMAC-SHA256"]];
+		[pairs addObject: @[@"oauth_timestamp", encodedTimestamp]];
+		if (_encodedToken)
+			[pairs addObject: @[@"oauth_token", _encodedToken]];
+		[pairs addObject: @[@"oauth_version", @"1.0"]];
+		for (item in [query componentsSeparatedByString: @"&"])
+		{
+			// name=value splits at the first '='; a bare name has an empty value; both are decoded before being encoded afresh
+			if (![item length])
+				continue;
+			equals = [item rangeOfString: @"="];
+			name = equals.length ? [item substringToIndex: equals.location] : item;
+			value = equals.length ? [item substringFromIndex: NSMaxRange(equals)] : @"";
+			name = [name stringByRemovingPercentEncoding] ?: name;
+			value = [value stringByRemovingPercentEncoding] ?: value;
+			[pairs addObject: @[OBPRFC3986EncodedString(name), OBPRFC3986EncodedString(value)]];
+		}
+		[pairs sortUsingComparator: ^NSComparisonResult(NSArray<NSString*>* a, NSArray<NSString*>* b) {
+			NSComparisonResult r = [a[0] compare: b[0]];
+			return r != NSOrderedSame ? r : [a[1] compare: b[1]];
+		}];
+		for (pair in pairs)
+		{
+			if (!first)
+				OBPAppendASCII(params, "&");
+			first = NO;
+			OBPAppendString(params, pair[0]), OBPAppendASCII(params, "="), OBPAppendString(params, pair[1]);
+		}
+	}
+
+	// Signature base string: method & url & parameters, each encoded
+	OBPAppendRFC3986EncodedString(base, method);
+	OBPAppendASCII(base, "&");
+	{
+		NSMutableData* normalisedURL = [NSMutableData dataWithCapacity: 128];
+		OBPAppendString(normalisedURL, [[url scheme] lowercaseString]);
+		OBPAppendASCII(normalisedURL, "://");
+		OBPAppendString(normalisedURL, [[url host] lowercaseString]);
+		if (port)
+			OBPAppendASCII(normalisedURL, ":"), OBPAppendString(normalisedURL, [port stringValue]);
+		OBPAppendString(normalisedURL, [url path]);
+		OBPURLAppendPercentEncoded(base, [normalisedURL bytes], [normalisedURL length]);
+	}
+	OBPAppendASCII(base, "&");
+	OBPURLAppendPercentEncoded(base, [params bytes], [params length]);
+
+	// HMAC-SHA256 from the prepared states
+	ctx = _inner;
+	CC_SHA256_Update(&ctx, [base bytes], (CC_LONG)[base length]);
+	CC_SHA256_Final(digest, &ctx);
+	ctx = _outer;
+	CC_SHA256_Update(&ctx, digest, CC_SHA256_DIGEST_LENGTH);
+	CC_SHA256_Final(digest, &ctx);
+	signature = [[NSData dataWithBytes: digest length: CC_SHA256_DIGEST_LENGTH] base64EncodedStringWithOptions: 0];
+
+	return [NSString stringWithFormat: @"%@, oauth_nonce=\"%@\", oauth_timestamp=\"%@\", oauth_signature=\"%@\"",
+				_headerPrefix, encodedNonce, encodedTimestamp, OBPRFC3986EncodedString(signature)];
+}
+@end
@@ -0,0 +1,59 @@
+//
+//  OBPRateController.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+typedef NS_ENUM(uint8_t, OBPRateControlState)
+{
+	OBPRateControlStateSteady,		///< The limit is at its maximum.
+	OBPRateControlStateRecovering,	///< The limit is below its maximum, and rising by one for each limit's worth of successful responses.
+	OBPRateControlStateBackingOff,	///< The limit has just been cut, and is held while the requests sent before the cut complete, so that their responses do not cut it again.
+	OBPRateControlStatePaused,		///< The server asked, through Retry-After, that no requests be sent until a later time.
+};
+
+
+
+/**	An OBPRateController instance adapts the number of requests an OBPTransport keeps in progress to what its server can currently handle.
+
+	It follows additive increase, multiplicative decrease: each response refused with 429 (Too Many Requests) or 503 (Service Unavailable), and each request that timed out, halves the limit, while a rise in smoothed time to first byte well above the lowest seen cuts it by a quarter; each successful response then raises the limit by 1/limit, i.e. by one per round of requests, back towards maxLimit. After a cut, further cuts are held off for about two round trips, so that one episode of overload cuts the limit once, and the limit settles near the server's capacity rather than oscillating. When a refusal carries Retry-After, no requests are dispatched until the time it gives.
+
+	The controller also times the retries of idempotent requests, with exponential backoff and full jitter, so that clients refused together do not return together.
+
+	Each transport has its own controller, and so each OBPSession and its OBPServerInfo. All methods are thread safe.
+*/
+@interface OBPRateController : NSObject
+- (instancetype)initWithMaxLimit:(NSUInteger)maxLimit; ///< Designated initialiser. The limit starts at maxLimit.
+
+@property (atomic) BOOL enabled; ///< Get/set whether the limit adapts. When NO, the limit stays at maxLimit and Retry-After is ignored. Default YES.
+@property (atomic) NSUInteger maxLimit; ///< Get/set the greatest limit (minimum 1); the transport keeps this equal to its maxConcurrentRequests.
+@property (atomic) double latencyTolerance; ///< Get/set how many times the lowest time to first byte seen the smoothed time may reach before it is treated as a sign of overload. Default 3.
+@property (atomic, readonly) double limit; ///< Get the current limit, which is fractional while recovering.
+@property (atomic, readonly) NSUInteger effectiveLimit; ///< Get the number of requests that may be in progress at once now, i.e. the limit rounded down, and at least 1.
+@property (atomic, readonly) OBPRateControlState state;
+@property (atomic, readonly) NSTimeInterval pauseRemaining; ///< Get the seconds left until requests may be dispatched again, or zero if not paused.
+@property (atomic, readonly) NSTimeInterval baselineLatency; ///< Get the lowest time to first byte seen, drifting slowly upwards so that it follows lasting changes; NAN until measured.
+@property (atomic, readonly) NSTimeInterval smoothedLatency; ///< Get the exponentially smoothed time to first byte; NAN until measured.
+@property (atomic, readonly) NSUInteger throttledCount; ///< Get the number of responses refused with 429 or 503 so far.
+
+- (void)recordResponse:(nullable NSHTTPURLResponse*)response latency:(NSTimeInterval)latency error:(nullable NSError*)error; ///< Adapt the limit to the outcome of a request. \param latency gives its time to first byte, or NAN if there was no response. Cancelled requests are ignored.
+- (NSTimeInterval)retryDelayForAttempt:(NSUInteger)attempt response:(nullable NSHTTPURLResponse*)response; ///< Return the seconds to wait before retrying a request that failed attempt times before (zero for the first retry): a random time up to 0.25s × 2^attempt, capped at 30s, but no less than any Retry-After in response, nor any pause still remaining.
+- (NSDictionary<NSString*,id>*)dictionaryRepresentation; ///< Return the limit, state and latencies, e.g. for logging.
+
++ (BOOL)shouldRetryResponse:(nullable NSHTTPURLResponse*)response error:(nullable NSError*)error; ///< Return YES if an idempotent request with this outcome is worth retrying: a 429 or 503 response, or a time out or lost connection in transit.
++ (NSTimeInterval)retryAfterForResponse:(nullable NSHTTPURLResponse*)response; ///< Return the seconds from now given by the Retry-After header of response, as either delta seconds or an HTTP date, or zero if absent or unreadable.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,262 @@
+//
+//  OBPRateController.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPRateController.h"
+// sdk
+#include <stdlib.h>
+// prj
+#import "OBPMetrics.h"
+
+
+
+#define kOBPRateThrottleDecrease		0.5		// factor applied to the limit on 429, 503 or time out
+#define kOBPRateLatencyDecrease			0.75	// factor applied to the limit on a latency spike
+#define kOBPRateLatencySmoothing		0.2		// weight of each new sample in the smoothed latency
+#define kOBPRateBaselineDrift			0.01	// fraction of the gap by which the baseline rises towards a higher sample
+#define kOBPRateLatencyFloor			0.05	// seconds of rise always tolerated, so that jitter on fast links is not taken for overload
+#define kOBPRateMinHoldOff				0.25	// seconds for which cuts are held off, at least
+#define kOBPRateRetryBase				0.25
+#define kOBPRateRetryCap				30.0
+
+
+
+@implementation OBPRateController
+{
+	NSUInteger		_maxLimit;
+	double			_limit;
+	double			_latencyTolerance;
+	NSTimeInterval	_baselineLatency;
+	NSTimeInterval	_smoothedLatency;
+	NSTimeInterval	_holdOffUntil;		// monotonic time until which cuts are held off
+	NSTimeInterval	_pausedUntil;		// monotonic time until which nothing is dispatched
+	NSUInteger		_throttledCount;
+	BOOL			_enabled;
+}
+- (instancetype)init
+{
+	return [self initWithMaxLimit: 4];
+}
+- (instancetype)initWithMaxLimit:(NSUInteger)maxLimit
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_maxLimit = MAX(1, maxLimit);
+	_limit = _maxLimit;
+	_latencyTolerance = 3;
+	_baselineLatency = NAN;
+	_smoothedLatency = NAN;
+	_enabled = YES;
+	return self;
+}
+#pragma mark -
+- (BOOL)enabled
+{
+	@synchronized (self) {
+		return _enabled;
+	}
+}
+- (void)setEnabled:(BOOL)enabled
+{
+	@synchronized (self) {
+		_enabled = enabled;
+		if (!enabled)
+			_limit = _maxLimit, _pausedUntil = _holdOffUntil = 0;
+	}
+}
+- (NSUInteger)maxLimit
+{
+	@synchronized (self) {
+		return _maxLimit;
+	}
+}
+- (void)setMaxLimit:(NSUInteger)maxLimit
+{
+	@synchronized (self) {
+		_maxLimit = MAX(1, maxLimit);
+		if (_limit > _maxLimit || !_enabled)
+			_limit = _maxLimit;
+	}
+}
+- (double)latencyTolerance
+{
+	@synchronized (self) {
+		return _latencyTolerance;
+	}
+}
+- (void)setLatencyTolerance:(double)latencyTolerance
+{
+	@synchronized (self) {
+		_latencyTolerance = MAX(1, latencyTolerance);
+	}
+}
+- (double)limit
+{
+	@synchronized (self) {
+		return _limit;
+	}
+}
+- (NSUInteger)effectiveLimit
+{
+	@synchronized (self) {
+		return MAX(1, (NSUInteger)_limit);
+	}
+}
+- (OBPRateControlState)state
+{
+	NSTimeInterval now = OBPMonotonicTime();
+	@synchronized (self) {
+		if (_pausedUntil > now)
+			return OBPRateControlStatePaused;
+		if (_holdOffUntil > now)
+			return OBPRateControlStateBackingOff;
+		return _limit < _maxLimit ? OBPRateControlStateRecovering : OBPRateControlStateSteady;
+	}
+}
+- (NSTimeInterval)pauseRemaining
+{
+	NSTimeInterval now = OBPMonotonicTime();
+	@synchronized (self) {
+		return _pausedUntil > now ? _pausedUntil - now : 0;
+	}
+}
+- (NSTimeInterval)baselineLatency
+{
+	@synchronized (self) {
+		return _baselineLatency;
+	}
+}
+- (NSTimeInterval)smoothedLatency
+{
+	@synchronized (self) {
+		return _smoothedLatency;
+	}
+}
+- (NSUInteger)throttledCount
+{
+	@synchronized (self) {
+		return _throttledCount;
+	}
+}
+#pragma mark -
+- (void)cutLimitBy:(double)factor now:(NSTimeInterval)now // called within @synchronized
+{
+	// One cut per episode: hold off further cuts until requests sent at the old limit have had time to complete
+	if (_holdOffUntil > now)
+		return;
+	_limit = MAX(1, _limit * factor);
+	_holdOffUntil = now + MAX(kOBPRateMinHoldOff, 2 * (isnan(_smoothedLatency) ? 0 : _smoothedLatency));
+}
+- (void)recordResponse:(NSHTTPURLResponse*)response latency:(NSTimeInterval)latency error:(NSError*)error
+{
+	NSTimeInterval		now = OBPMonotonicTime();
+	NSTimeInterval		retryAfter;
+	NSInteger			status = response.statusCode;
+	BOOL				throttled = status == 429 || status == 503;
+
+	if ([error.domain isEqualToString: NSURLErrorDomain] && error.code == NSURLErrorCancelled)
+		return;
+	retryAfter = throttled ? [[self class] retryAfterForResponse: response] : 0;
+
+	@synchronized (self) {
+		if (throttled)
+			_throttledCount++;
+		if (!_enabled)
+			return;
+
+		// Latency, from responses the server actually worked on
+		if (response && !throttled && !isnan(latency) && latency >= 0)
+		{
+			_smoothedLatency = isnan(_smoothedLatency) ? latency : _smoothedLatency + kOBPRateLatencySmoothing * (latency - _smoothedLatency);
+			if (isnan(_baselineLatency) || latency < _baselineLatency)
+				_baselineLatency = latency;
+			else
+				_baselineLatency += kOBPRateBaselineDrift * (latency - _baselineLatency);
+		}
+
+		if (throttled || ([error.domain isEqualToString: NSURLErrorDomain] && error.code == NSURLErrorTimedOut))
+		{
+			[self cutLimitBy: kOBPRateThrottleDecrease now: now];
+			if (retryAfter > 0)
+				_pausedUntil = MAX(_pausedUntil, now + retryAfter);
+		}
+		else
+		if (!isnan(_smoothedLatency) && _smoothedLatency > _baselineLatency * _latencyTolerance && _smoothedLatency > _baselineLatency + kOBPRateLatencyFloor)
+			[self cutLimitBy: kOBPRateLatencyDecrease now: now];
+		else
+		if (response && status < 500 && _holdOffUntil <= now)
+			_limit = MIN((double)_maxLimit, _limit + 1 / _limit);
+	}
+}
+- (NSTimeInterval)retryDelayForAttempt:(NSUInteger)attempt response:(NSHTTPURLResponse*)response
+{
+	NSTimeInterval cap = MIN(kOBPRateRetryCap, kOBPRateRetryBase * (double)(1ULL << MIN(attempt, 16)));
+	NSTimeInterval delay = cap * ((double)arc4random_uniform(1U << 20) / (double)(1U << 20));
+	return MAX(delay, MAX([[self class] retryAfterForResponse: response], self.pauseRemaining));
+}
+- (NSDictionary<NSString*,id>*)dictionaryRepresentation
+{
+	static NSString* const names[] = {@"steady", @"recovering", @"backingOff", @"paused"};
+	OBPRateControlState state = self.state;
+	@synchronized (self) {
+		NSMutableDictionary* md = [NSMutableDictionary dictionary];
+		md[@"state"] = names[state];
+		md[@"limit"] = @(_limit);
+		md[@"maxLimit"] = @(_maxLimit);
+		md[@"throttled"] = @(_throttledCount);
+		if (!isnan(_baselineLatency))
+			md[@"baselineLatency"] = @(_baselineLatency);
+		if (!isnan(_smoothedLatency))
+			md[@"smoothedLatency"] = @(_smoothedLatency);
+		return [md copy];
+	}
+}
+- (NSString*)description
+{
+	return [NSString stringWithFormat: @"<%@ %p %@>", NSStringFromClass([self class]), (void*)self, [self dictionaryRepresentation]];
+}
+#pragma mark -
++ (BOOL)shouldRetryResponse:(NSHTTPURLResponse*)response error:(NSError*)error
+{
+	if (error)
+		return [error.domain isEqualToString: NSURLErrorDomain]
+			&& (error.code == NSURLErrorTimedOut || error.code == NSURLErrorNetworkConnectionLost);
+	return response.statusCode == 429 || response.statusCode == 503;
+}
++ (NSTimeInterval)retryAfterForResponse:(NSHTTPURLResponse*)response
+{
+	static NSDateFormatter*	sFormatter = nil;
+	NSDictionary*			headers = response.allHeaderFields;
+	NSString*				value = nil;
+	NSString*				key;
+	NSDate*					date;
+
+	for (key in headers)
+		if (NSOrderedSame == [key caseInsensitiveCompare: @"Retry-After"])
+			{value = [headers[key] description]; break;}
+	value = [value stringByTrimmingCharactersInSet: [NSCharacterSet whitespaceCharacterSet]];
+	if (![value length])
+		return 0;
+
+	// Either delta seconds...
+	if ([value rangeOfCharacterFromSet: [[NSCharacterSet decimalDigitCharacterSet] invertedSet]].location == NSNotFound)
+		return MIN([value doubleValue], 24 * 60 * 60);
+
+	// ...or an HTTP date
+	@synchronized ([OBPRateController class]) {
+		if (!sFormatter)
+		{
+			sFormatter = [[NSDateFormatter alloc] init];
+			sFormatter.locale = [NSLocale localeWithLocaleIdentifier: @"en_US_POSIX"];
+			sFormatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT: 0];
+			sFormatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss 'GMT'";
+		}
+		date = [sFormatter dateFromString: value];
+	}
+	return date ? MIN(MAX(0, [date timeIntervalSinceNow]), 24 * 60 * 60) : 0;
+}
+@end
@@ -32,6 +32,11 @@ extern NSString* const OBPServerInfo_ClientSecret;		// (aka Consumer Key)
 extern NSString* const OBPServerInfo_TokenKey;			// (aka AccessToken)
 extern NSString* const OBPServerInfo_TokenSecret;		// (aka AccessSecret)
 
+// Notifications posted on the main queue when credentials are checked after a deferred load (see OBPServerInfoConfig_DeferCredentialChecks)
+extern NSString* const OBPServerInfoDidVerifyEntryNotification;		// object is the entry, whose credentials were found
+extern NSString* const OBPServerInfoDidDropEntryNotification;		// object is the entry, which was removed from +entries because its credentials are missing
+extern NSString* const OBPServerInfoDidFinishVerifyingNotification;	// object is the OBPServerInfo class; all entries loaded at startup have been checked
+
 
 
 /**
@@ -47,17 +52,21 @@ The class keeps a persistent record of all complete instances. An instance is co
 + (nullable instancetype)addEntryForAPIServer:(NSString*)APIServer; ///< add a new instance for accessing the OBP server at url APIServer to the instance recorded by the class. \param APIServer identifies the server through a valid url string, giving scheme, host and optionally the path to the API base including API version path component. \return the new instance. \note If you pass in the API base url, the API server and version will be extracted and set. \note You can have more than one instance for the same server, typically for use with different user logins, and they are differentiated by the unique key property; for user interface, you can differentiate them using the name property.
 + (nullable OBPServerInfo*)firstEntryForAPIServer:(NSString*)APIServer; ///< Finds and returns the first entry matching APIServer. \param APIServer identifies the server through a valid url string, giving scheme, host and optionally the path to the API base including API version path component.
 + (nullable OBPServerInfo*)defaultEntry; ///< returns the first entry. This will be the oldest instance still held. (Convenience when using only a single entry.)
-+ (OBPServerInfoArray*)entries;
++ (OBPServerInfoArray*)entries; ///< Return the instances recorded by the class. Safe to call from any queue: the array returned is a snapshot, which later additions and removals do not change.
 + (void)removeEntry:(OBPServerInfo*)entry;
 
+@property (nonatomic, strong, readonly) NSString* key; ///< A unique and persistent identifier for this instance, also used to name its keychain items and other per-server storage.
 @property (nonatomic, copy, null_resettable) NSString* name; ///< A differentiating name for use in user interface; set to the API host by default
 @property (nonatomic, strong, readonly) NSString* APIServer; ///< url string for the API server
 @property (nonatomic, strong, readonly) NSString* APIVersion; ///< string for the version of the API to use
 @property (nonatomic, strong, readonly) NSString* APIBase; ///< base url for API calls, formed using the APIServer and APIVersion properties
 @property (nonatomic, copy) NSDictionary* accessData; ///< Get/set access data. \note When getting data, the returned dictionary contains values for _all_ the OBPServerInfo_<xxx> keys defined in OBPServerInfo.h, with derived and default values filled in as necessary. \note When setting data, _only_ the values for the OBPServerInfo_<xxx> keys defined in OBPServerInfo.h are copied, while other values held are left unchanged. \note The API host is never changed after the instance has been created, regardless of values passed in for the keys OBPServerInfo_APIServer and OBPServerInfo_APIBase, and the client key and secret are not changeable once set.
+@property (readonly) NSUInteger accessDataGeneration; ///< Get a count that changes whenever accessData is set, so that holders of a copy of accessData can tell when to fetch it again instead of reading the keychain on every use.
 @property (nonatomic, copy, nullable) NSDictionary* appData; ///< Get/set general data associated with this server for use by the host app. Persisted. Contents must conform to NSSecureCoding.
-@property (readonly) BOOL usable; ///< returns YES when entry has credentials to request access (client key and secret).
-@property (readonly) BOOL inUse; ///< returns YES when entry has credentials to access user's data (token key and secret).
+@property (readonly) BOOL usable; ///< returns YES when entry has credentials to request access (client key and secret). Verifies the entry first if necessary.
+@property (readonly) BOOL inUse; ///< returns YES when entry has credentials to access user's data (token key and secret). Verifies the entry first if necessary.
+@property (readonly) BOOL verified; ///< returns YES once the entry's stored credentials have been checked. Entries are verified as they are loaded, unless loading was deferred with OBPServerInfoConfig_DeferCredentialChecks, in which case they are verified in the background, or on demand by -verify.
+- (BOOL)verify; ///< Check the entry's stored credentials now, if not already verified, e.g. for the entry the user has just opened; if they are missing, the entry is removed from +entries and OBPServerInfoDidDropEntryNotification is posted. Safe to call from any queue; the notifications are posted on the main queue. \returns usable.
 @end
 /*
 Note: Keychain authorisations on OSX during development.
@@ -86,8 +95,12 @@ You can optionally customise any of: instance class, save & load blocks, credent
 
 	-	config[OBPServerInfoConfig_ClientCredentialDecryptBlock] gives a block to decrypt the client credentials after retrieval from the keychain;
 
+	-	config[OBPServerInfoConfig_DeferCredentialChecks] gives an NSNumber; if YES, then the entries loaded at startup are published immediately, unverified and assumed usable, while their keychain credentials are checked concurrently in the background, so that launch time does not grow with the number of entries; OBPServerInfoDidVerifyEntryNotification or OBPServerInfoDidDropEntryNotification is posted for each entry as it is checked, and OBPServerInfoDidFinishVerifyingNotification once all are done. Call -verify on an entry to check it without waiting. The default, NO, checks every entry before +entries returns.
+
 	-	config[OBPServerInfoConfig_ProvideCryptParamsBlock] gives a block to provide parameters for encryption of the client credentials while stored in the keychain; at a minimum, the encryption key and initialisation vector, but a non-default encryption algorithm can also be selected. It is ignored if both a client credential encryption and decryption block is present. Encryption is advisable on OSX because retrieval of the client key and secret via the Key Chain Access application needs just the account login, so another unscrupulous developer could easily download your app and obtain your client key and secret; this problem does not arise on iOS. See also comment describing OBPProvideCryptParamsBlock.
 
+	-	config[OBPServerInfoConfig_AuthenticatedCredentialEncryption] gives an NSNumber; if YES, and config[OBPServerInfoConfig_ProvideCryptParamsBlock] is also given, then client credentials are stored encrypted with AES-256 and authenticated with HMAC-SHA256 (encrypt-then-MAC), using keys derived from the provided key, so that altered keychain items are rejected; an entry's credentials stored in the default format are converted to the authenticated format when the entry first reads them, after which that entry refuses credentials in any other format, so that they cannot be downgraded. See OBPCredentialCryptor.
+
 \note By default OBPServerInfo uses DES encryption (very weak), as DES seems to be the strongest encryption (!) that can gain an exemption from some of the export certification process that is oblogatory for all apps that are distributed through the AppStore. You should consider using stronger encryption in your production app, but you will then also need to get export certification from Apple in order to ship your app — you will need to comply with the requirements for "trade compliance" in iTunes Connect.
 */
 void OBPServerInfoCustomise(NSDictionary* config);
@@ -109,6 +122,8 @@ typedef void						(^OBPProvideCryptParamsBlock)(OBPCryptParams* ioParams, size_t
 #define OBPServerInfoConfig_ClientCredentialEncryptBlock @"eb"   // OBPClientCredentialCryptBlock
 #define OBPServerInfoConfig_ClientCredentialDecryptBlock @"db"   // OBPClientCredentialCryptBlock
 #define OBPServerInfoConfig_ProvideCryptParamsBlock      @"pp"   // OBPProvideCryptParamsBlock
+#define OBPServerInfoConfig_DeferCredentialChecks        @"dv"   // NSNumber with BOOL
+#define OBPServerInfoConfig_AuthenticatedCredentialEncryption @"ae" // NSNumber with BOOL
 
 #define kOBPClientCredentialCryptAlg                     kCCAlgorithmDES
 #define kOBPClientCredentialCryptKeyLen                  kCCKeySizeDES
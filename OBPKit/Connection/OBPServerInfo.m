@@ -10,10 +10,15 @@
 // sdk
 #import <objc/runtime.h>
 #import <CommonCrypto/CommonCrypto.h>
+#import <stdatomic.h>
 // ext
 #import <UICKeyChainStore/UICKeyChainStore.h>
 // prj
 #import "OBPServerInfoStore.h"
+#import "OBPServerInfoRecordStore.h"
+#import "OBPCredentialCryptor.h"
+#import "OBPTransactionStore.h"
+#import "OBPSnapshot.h"
 #import "OBPLogging.h"
 
 
@@ -37,6 +42,10 @@ NSString* const OBPServerInfo_ClientSecret		= @"ClientSecret";		// aka Consumer
 NSString* const OBPServerInfo_TokenKey			= @"TokenKey";			// aka AccessToken
 NSString* const OBPServerInfo_TokenSecret		= @"TokenSecret";		// aka AccessSecret
 
+NSString* const OBPServerInfoDidVerifyEntryNotification		= @"OBPServerInfoDidVerifyEntry";
+NSString* const OBPServerInfoDidDropEntryNotification		= @"OBPServerInfoDidDropEntry";
+NSString* const OBPServerInfoDidFinishVerifyingNotification	= @"OBPServerInfoDidFinishVerifying";
+
 
 
 static NSDictionary* gOBPServerInfo = nil;
@@ -46,7 +55,11 @@ static NSDictionary* gOBPServerInfo = nil;
 #define gOBPServerInfoKey_SaveBlock @"save"
 #define gOBPServerInfoKey_EncryptBlock @"+"
 #define gOBPServerInfoKey_DecryptBlock @"-"
-#define gOBPServerInfoKey_EntriesArrayHolder @"holder"
+#define gOBPServerInfoKey_LegacyDecryptBlock @"<"
+#define gOBPServerInfoKey_EntriesSnapshot @"entries"
+#define gOBPServerInfoKey_ChangedKeys @"changed"
+#define gOBPServerInfoKey_DeferChecks @"defer"
+#define gOBPServerInfoKey_LoadsSingly @"singly"
 
 void OBPServerInfoCustomise(NSDictionary* config)
 {
@@ -107,95 +120,6 @@ void OBPServerInfoCustomise(NSDictionary* config)
 
 
 
-OBPClientCredentialCryptBlock
-	MakeCryptBlockUsingParamsProvider(
-		OBPProvideCryptParamsBlock provideParams,
-		CCOperation op)
-{
-	if (provideParams == nil)
-		return nil;
-
-	OBPClientCredentialCryptBlock cb =
-		^NSString*(NSString* credential)
-		{
-			if (![credential length])
-				return credential;
-
-			enum {
-				kKeyStoreMax = kOBPClientCredentialMaxCryptKeyLen * 2,
-				kIVStoreMax = kOBPClientCredentialMaxCryptBlockLen * 2,
-				kStackStoreSize = kOBPClientCredentialMaxCryptBlockLen * 8
-			};
-
-			uint8_t					stackStore[kStackStoreSize];
-			uint8_t*				buf = stackStore;
-			size_t					bufSize = kStackStoreSize, bufSizeMin;
-			size_t					inputLen, outputLen;
-			NSString*				transformed = credential;
-			NSData*					data;
-			uint8_t					keyStore[kKeyStoreMax];
-			uint8_t					ivStore[kIVStoreMax]; // initialization vector store
-
-			OBPCryptParams			params = {
-				.algorithm	= kOBPClientCredentialCryptAlg,
-				.options	= 0,
-				.keySize	= kOBPClientCredentialCryptKeyLen,
-				.blockSize	= kOBPClientCredentialCryptBlockLen,
-				.key		= keyStore,
-				.iv			= ivStore
-			};
-
-			memset(keyStore, 0, kKeyStoreMax);
-			memset(ivStore, 0, kIVStoreMax);
-			provideParams(&params, kKeyStoreMax, kIVStoreMax);
-
-			if (op == kCCDecrypt)
-				data = [[NSData alloc] initWithBase64EncodedString: credential options: 0];
-			else
-				data = [credential dataUsingEncoding: NSUTF8StringEncoding];
-			inputLen = [data length];
-
-			bufSizeMin = (inputLen / params.blockSize + 2) * params.blockSize;
-			if (bufSize < bufSizeMin)
-				buf = malloc(bufSize = bufSizeMin);
-			memcpy(buf, [data bytes], inputLen);
-			memset(buf + inputLen, 0, bufSize - inputLen);
-			// ...after zeroing remaining buf space, we always need to bump input length up to the
-			// next multiple of the encryption block size...
-			inputLen = (inputLen + params.blockSize - 1) / params.blockSize * params.blockSize;
-
-			CCCryptorStatus status =
-				CCCrypt(
-					op,						// kCCEncrypt or kCCDecrypt
-					params.algorithm,		// AES, DES, RCA, etc.
-					params.options,			// CCOptions: kCCOptionPKCS7Padding, ...
-					params.key,
-					params.keySize,
-					params.iv,				// initialization vector, optional
-					buf,					// dataIn, optional per op and alg
-					inputLen,				// dataInLength
-					buf,					// dataOut (can be transformed in place)
-					bufSize,				// dataOutAvailable
-					&outputLen);			// dataOutMoved
-
-			if (outputLen < bufSize)
-				buf[outputLen] = 0;
-
-			if (status == kCCSuccess)
-				transformed = op == kCCEncrypt
-							? [[NSData dataWithBytes: buf length: outputLen] base64EncodedStringWithOptions: 0]
-							: [NSString stringWithUTF8String: (char*)buf];
-
-			if (buf != stackStore)
-				free(buf);
-
-			return transformed;
-		};
-	return cb;
-}
-
-
-
 #pragma mark -
 @interface OBPServerInfo ()
 {
@@ -210,12 +134,20 @@ OBPClientCredentialCryptBlock
 
 	BOOL			_usable;
 	BOOL			_inUse;
+	BOOL			_verified;
+	BOOL			_credentialsAuthenticated;	// client credentials are stored in the authenticated format, so no other is accepted
+	NSUInteger		_accessDataGeneration;
 }
 @property (nonatomic, strong) UICKeyChainStore* keyChainStore;
 @end
 
 
 
+static NSMutableDictionary<NSString*,OBPServerInfo*>*	sEntriesDecodedEarly = nil;	// by key, before all entries have been loaded from a record store; guarded by the store
+static atomic_bool										sEntriesLoaded = NO;
+
+
+
 #pragma mark -
 @implementation OBPServerInfo
 + (void)initialize
@@ -233,10 +165,14 @@ OBPClientCredentialCryptBlock
 	OBPClientCredentialCryptBlock	encryptBlock;
 	OBPClientCredentialCryptBlock	decryptBlock;
 	OBPProvideCryptParamsBlock		provideCryptParams;
+	BOOL							deferChecks;
+	BOOL							authenticated;
 
 	if (gOBPServerInfo == nil)
 		gOBPServerInfo = @{};
 	md = [NSMutableDictionary dictionary];
+	deferChecks = [gOBPServerInfo[OBPServerInfoConfig_DeferCredentialChecks] boolValue];
+	authenticated = [gOBPServerInfo[OBPServerInfoConfig_AuthenticatedCredentialEncryption] boolValue];
 
 	className = gOBPServerInfo[OBPServerInfoConfig_DataClass] ?: @"OBPServerInfo";
 	class = NSClassFromString(className);
@@ -250,12 +186,27 @@ OBPClientCredentialCryptBlock
 
 	loadBlock = gOBPServerInfo[OBPServerInfoConfig_LoadBlock];
 	if (loadBlock == nil)
-		loadBlock = ^(){return store.entries;};
+	if ([store isKindOfClass: [OBPServerInfoRecordStore class]])
+	{
+		// A record store gives entries one at a time, so those already asked for by +defaultEntry or +firstEntryForAPIServer: are not unarchived again
+		md[gOBPServerInfoKey_LoadsSingly] = @YES;
+		sEntriesDecodedEarly = [NSMutableDictionary dictionary];
+		loadBlock = ^(){
+			NSMutableArray*	ma = [NSMutableArray array];
+			OBPServerInfo*	entry;
+			for (NSString* key in [self storedEntryKeys])
+				if (nil != (entry = [self storedEntryForKey: key]))
+					[ma addObject: entry];
+			return [ma copy];
+		};
+	}
+	else
+		loadBlock = ^(){@synchronized (store) {return store.entries;}};
 	md[gOBPServerInfoKey_LoadBlock] = loadBlock;
 
 	saveBlock = gOBPServerInfo[OBPServerInfoConfig_SaveBlock];
 	if (saveBlock == nil)
-		saveBlock = ^(OBPServerInfoArray* entries){store.entries = entries;};
+		saveBlock = ^(OBPServerInfoArray* entries){@synchronized (store) {[store setEntries: entries changedKeys: [gOBPServerInfo[gOBPServerInfoKey_ChangedKeys] copy]];}}; // ...called by +save, holding the changed keys
 	md[gOBPServerInfoKey_SaveBlock] = saveBlock;
 
 	encryptBlock = gOBPServerInfo[OBPServerInfoConfig_ClientCredentialEncryptBlock];
@@ -265,8 +216,12 @@ OBPClientCredentialCryptBlock
 		provideCryptParams = gOBPServerInfo[OBPServerInfoConfig_ProvideCryptParamsBlock];
 		if (provideCryptParams)
 		{
-			encryptBlock = MakeCryptBlockUsingParamsProvider(provideCryptParams, kCCEncrypt);
-			decryptBlock = MakeCryptBlockUsingParamsProvider(provideCryptParams, kCCDecrypt);
+			// One cryptor for both, so that params are fetched once
+			OBPCredentialCryptor* cryptor = [[OBPCredentialCryptor alloc] initWithParamsProvider: provideCryptParams authenticated: authenticated];
+			encryptBlock = cryptor.encryptBlock;
+			decryptBlock = cryptor.decryptBlock;
+			if (cryptor.authenticated)
+				md[gOBPServerInfoKey_LegacyDecryptBlock] = ^NSString*(NSString* s){return [cryptor decryptLegacyCredential: s];};
 		}
 		else
 		{
@@ -277,61 +232,196 @@ OBPClientCredentialCryptBlock
 	md[gOBPServerInfoKey_EncryptBlock] = encryptBlock;
 	md[gOBPServerInfoKey_DecryptBlock] = decryptBlock;
 
-	md[gOBPServerInfoKey_EntriesArrayHolder] = [NSMutableArray arrayWithObject: @[]];
+	md[gOBPServerInfoKey_EntriesSnapshot] = [[OBPSnapshot alloc] initWithValue: @[]];
+	md[gOBPServerInfoKey_ChangedKeys] = [NSMutableSet set];
+	md[gOBPServerInfoKey_DeferChecks] = @(deferChecks);
 
 	gOBPServerInfo = [md copy];
 
-	//	2. Load entries
-	OBPServerInfoArray* entries = loadBlock();
-	NSMutableArray*		ma = [NSMutableArray array];
-	//	Copy valid entries, i.e. keychain still contains corresponding credentials, and remove if not so. (On Mac user can delete keychain items.)
-	for (OBPServerInfo* entry in entries)
-		if ([entry checkValid])
-			[ma addObject: entry];
-		else
-			OBP_LOG(@"Ignoring invalid entry %@", entry);
-	gOBPServerInfo[gOBPServerInfoKey_EntriesArrayHolder][0] = [ma copy];
+	//	2. Load entries now, unless they can be unarchived singly as first needed
+	if (![gOBPServerInfo[gOBPServerInfoKey_LoadsSingly] boolValue])
+		[self entriesSnapshot];
+}
++ (void)loadEntries
+{
+	OBPServerInfoLoadBlock	loadBlock = gOBPServerInfo[gOBPServerInfoKey_LoadBlock];
+	OBPServerInfoArray*		entries = loadBlock();
+	NSMutableArray*			ma = [NSMutableArray array];
+
+	if ([gOBPServerInfo[gOBPServerInfoKey_DeferChecks] boolValue])
+	{
+		//	Publish entries now, assumed usable as only usable entries are saved, and check them in the background
+		for (OBPServerInfo* entry in entries)
+			if (!entry->_verified)
+				entry->_usable = YES;
+		[gOBPServerInfo[gOBPServerInfoKey_EntriesSnapshot] update: ^id(id current){return [entries copy];}];
+		[self verifyEntriesInBackground: entries];
+	}
+	else
+	{
+		//	Copy valid entries, i.e. keychain still contains corresponding credentials, and remove if not so. (On Mac user can delete keychain items.)
+		for (OBPServerInfo* entry in entries)
+			if ([entry checkValidOnce])
+				[ma addObject: entry];
+			else
+				OBP_LOG(@"Ignoring invalid entry %@", entry);
+		[gOBPServerInfo[gOBPServerInfoKey_EntriesSnapshot] update: ^id(id current){return [ma copy];}];
+	}
+	@synchronized (gOBPServerInfo[gOBPServerInfoKey_Store]) {
+		atomic_store(&sEntriesLoaded, YES);
+		sEntriesDecodedEarly = nil; // ...all now held by the snapshot, or dropped
+	}
+}
++ (NSArray<NSString*>*)storedEntryKeys
+{
+	OBPServerInfoRecordStore* store = gOBPServerInfo[gOBPServerInfoKey_Store];
+	@synchronized (store) {
+		return store.entryKeys;
+	}
+}
++ (OBPServerInfo*)storedEntryForKey:(NSString*)key
+{
+	// Unarchive an entry from the record store once, whether for +loadEntries or ahead of it
+	OBPServerInfoRecordStore* store = gOBPServerInfo[gOBPServerInfoKey_Store];
+	@synchronized (store) {
+		OBPServerInfo* entry = sEntriesDecodedEarly[key];
+		if (!entry && nil != (entry = [store entryForKey: key]))
+		{
+			if ([gOBPServerInfo[gOBPServerInfoKey_DeferChecks] boolValue])
+				entry->_usable = YES;
+			sEntriesDecodedEarly[key] = entry;
+		}
+		return entry;
+	}
+}
++ (nullable OBPServerInfo*)firstEntryPassingTest:(BOOL(^)(OBPServerInfo* entry))test
+{
+	OBPServerInfo*	entry;
+	BOOL			defer;
+
+	// Until all entries are loaded from a record store, unarchive them one at a time, only as far as the first that passes
+	if ([gOBPServerInfo[gOBPServerInfoKey_LoadsSingly] boolValue] && !atomic_load(&sEntriesLoaded))
+	{
+		defer = [gOBPServerInfo[gOBPServerInfoKey_DeferChecks] boolValue];
+		for (NSString* key in [self storedEntryKeys])
+		{
+			entry = [self storedEntryForKey: key];
+			if (atomic_load(&sEntriesLoaded))
+				break; // ...loaded meanwhile, and maybe with some dropped, so look there instead
+			if (entry && (defer || [entry checkValidOnce]) && test(entry))
+				return entry;
+		}
+		if (!atomic_load(&sEntriesLoaded))
+			return nil;
+	}
+	for (entry in [self entries])
+		if (test(entry))
+			return entry;
+	return nil;
+}
++ (OBPSnapshot<OBPServerInfoArray*>*)entriesSnapshot
+{
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{[self loadEntries];});
+	return gOBPServerInfo[gOBPServerInfoKey_EntriesSnapshot];
 }
 + (OBPServerInfoArray*)entries
 {
-	return gOBPServerInfo[gOBPServerInfoKey_EntriesArrayHolder][0];
+	return [self entriesSnapshot].value;
 }
 + (void)save
 {
-	static BOOL savePending = NO;
-	if (savePending)
+	static atomic_bool savePending = NO;
+	if (atomic_exchange(&savePending, YES))
 		return;
-	savePending = YES;
 	dispatch_async(dispatch_get_main_queue(),
 		^{
-			savePending = NO;
-			NSMutableArray* ma = [NSMutableArray array];
-			for (OBPServerInfo* entry in [self entries])
-			if (entry.usable)
-				[ma addObject:entry];
-			OBPServerInfoSaveBlock saveBlock = gOBPServerInfo[gOBPServerInfoKey_SaveBlock];
-			saveBlock(ma);
+			// Changed keys are held while saving, so that a key changed meanwhile is either saved now or left for the save it schedules
+			NSMutableSet* changedKeys = gOBPServerInfo[gOBPServerInfoKey_ChangedKeys];
+			atomic_store(&savePending, NO);
+			@synchronized (changedKeys) {
+				NSMutableArray* ma = [NSMutableArray array];
+				for (OBPServerInfo* entry in [self entries])
+				if (entry->_usable) // ...not .usable, which would verify unverified entries
+					[ma addObject:entry];
+				OBPServerInfoSaveBlock saveBlock = gOBPServerInfo[gOBPServerInfoKey_SaveBlock];
+				saveBlock(ma);
+				[changedKeys removeAllObjects];
+			}
 		}
 	);
 }
++ (void)verifyEntriesInBackground:(OBPServerInfoArray*)entries
+{
+	OBPClientCredentialCryptBlock	decrypt = gOBPServerInfo[gOBPServerInfoKey_DecryptBlock];
+	dispatch_queue_t				queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+	NSUInteger						count = [entries count];
+
+	dispatch_async(queue,
+		^{
+			// Read each entry's keychain items concurrently, without touching the entry, then apply the results on the main queue
+			dispatch_group_t group = dispatch_group_create();
+			dispatch_apply(count, queue,
+				^(size_t i) {
+					OBPServerInfo*		entry = entries[i];
+					NSUInteger			generation = entry.accessDataGeneration; // ...before reading, so that a change made meanwhile is noticed
+					UICKeyChainStore*	keyChainStore = [UICKeyChainStore keyChainStoreWithService: entry->_key];
+					NSString*			stored = keyChainStore[ClientKeyAndSecretKCAccount];
+					NSString*			clientPair = decrypt(stored);
+					NSString*			tokenPair = keyChainStore[TokenKeyAndSecretKCAccount];
+					if ([stored length] && ![clientPair length])
+						clientPair = nil; // ...refused, or to be converted: leave it to the entry to read again
+
+					dispatch_group_async(group, dispatch_get_main_queue(),
+						^{
+							[entry verifyWithStoredClientPair: clientPair tokenPair: tokenPair generation: generation];
+						});
+				});
+			dispatch_group_notify(group, dispatch_get_main_queue(),
+				^{
+					[[NSNotificationCenter defaultCenter] postNotificationName: OBPServerInfoDidFinishVerifyingNotification object: self];
+				});
+		});
+}
++ (void)dropEntry:(OBPServerInfo*)entry
+{
+	// Remove from entries, but leave credentials alone, as when an invalid entry is ignored at load
+	[[self entriesSnapshot] update:
+		^OBPServerInfoArray*(OBPServerInfoArray* entries) {
+			NSMutableArray* ma = [entries mutableCopy];
+			[ma removeObjectIdenticalTo: entry];
+			return [ma copy];
+		}];
+	OBP_LOG(@"Ignoring invalid entry %@", entry);
+	[[NSNotificationCenter defaultCenter] postNotificationName: OBPServerInfoDidDropEntryNotification object: entry];
+}
 + (instancetype)defaultEntry
 {
-	OBPServerInfo* entry = [[self entries] firstObject];
+	OBPServerInfo* entry = [self firstEntryPassingTest: ^BOOL(OBPServerInfo* candidate){return YES;}];
 	return entry;
 }
 + (void)removeEntry:(OBPServerInfo*)entry
 {
 	if (!entry)
 		return;
-	NSUInteger index = [[self entries] indexOfObjectIdenticalTo: entry];
-	if (index != NSNotFound)
+	__block BOOL removed = NO;
+	[[self entriesSnapshot] update:
+		^OBPServerInfoArray*(OBPServerInfoArray* entries) {
+			if (NSNotFound == [entries indexOfObjectIdenticalTo: entry])
+				return entries;
+			NSMutableArray* ma = [entries mutableCopy];
+			[ma removeObjectIdenticalTo: entry];
+			removed = YES;
+			return [ma copy];
+		}];
+	if (removed)
 	{
-		NSMutableArray* ma = [[self entries] mutableCopy];
-		[ma removeObjectIdenticalTo: entry];
-		gOBPServerInfo[gOBPServerInfoKey_EntriesArrayHolder][0] = [ma copy];
-		[entry storePair: ePair_ClientKeyAndSecret from: @{}];
-		[entry storePair: ePair_TokenKeyAndSecret from: @{}];
-		entry.keyChainStore = nil;
+		@synchronized (entry) {
+			[entry storePair: ePair_ClientKeyAndSecret from: @{}];
+			[entry storePair: ePair_TokenKeyAndSecret from: @{}];
+			entry.keyChainStore = nil;
+		}
+		[OBPTransactionStore removeStoreForServerInfo: entry];
 		[self save];
 	}
 }
@@ -349,7 +439,7 @@ OBPClientCredentialCryptBlock
 	class = gOBPServerInfo[gOBPServerInfoKey_InstanceClass];
 	entry = [class alloc];
 	entry = [entry initWithKey: key APIServerURLComponents: components];
-	gOBPServerInfo[gOBPServerInfoKey_EntriesArrayHolder][0] = [[self entries] arrayByAddingObject: entry];
+	[[self entriesSnapshot] update: ^OBPServerInfoArray*(OBPServerInfoArray* entries){return [entries arrayByAddingObject: entry];}];
 	// ...save is only scheduled once the entry's data has been assigned and checked
 	return entry;
 }
@@ -365,13 +455,12 @@ OBPClientCredentialCryptBlock
 	matchVersion = [self versionFromOBPPath: components.path];
 	components.path = nil;
 	matchServer = components.string;
-	for (entry in [self entries])
-	{
-		if ([matchServer isEqualToString: entry->_APIServer])
-		if (!matchVersion || [matchVersion isEqualToString: entry->_APIVersion])
-			return entry;
-	}
-	return nil;
+	entry = [self firstEntryPassingTest:
+		^BOOL(OBPServerInfo* candidate) {
+			return [matchServer isEqualToString: candidate->_APIServer]
+				&& (!matchVersion || [matchVersion isEqualToString: candidate->_APIVersion]);
+		}];
+	return entry;
 }
 #pragma mark -
 + (NSString*)versionFromOBPPath:(NSString*)path
@@ -408,6 +497,8 @@ OBPClientCredentialCryptBlock
 	if (nil == (self = [super init]))
 		return nil;
 	_key = key;
+	_verified = YES; // ...nothing stored yet
+	_credentialsAuthenticated = nil != gOBPServerInfo[gOBPServerInfoKey_LegacyDecryptBlock]; // ...so nothing else will be
 	_name = components.host;
 	_APIVersion = [[self class] versionFromOBPPath: components.path] ?: @"v1.2";
 	components.path = nil;
@@ -438,6 +529,7 @@ OBPClientCredentialCryptBlock
 	_AuthServerDict = [aDecoder decodeObjectOfClass: [NSDictionary class] forKey: @"AuthServerDict"];
 	if ([aDecoder containsValueForKey: @"appData"])
 		_appData = [aDecoder decodeObjectOfClass: [NSDictionary class] forKey: @"appData"];
+	_credentialsAuthenticated = [aDecoder decodeBoolForKey: @"credentialsAuthenticated"];
 	return self;
 }
 - (void)encodeWithCoder:(NSCoder *)aCoder
@@ -450,35 +542,43 @@ OBPClientCredentialCryptBlock
 	[aCoder encodeObject: _AuthServerDict forKey: @"AuthServerDict"];
 	if (_appData)
 		[aCoder encodeObject: _appData forKey: @"appData"];
+	if (_credentialsAuthenticated)
+		[aCoder encodeBool: YES forKey: @"credentialsAuthenticated"];
 }
 - (void)save
 {
 	if (_usable)
-		[[self class] save];
+		[self scheduleSave];
+}
+- (void)scheduleSave
+{
+	NSMutableSet* changedKeys = gOBPServerInfo[gOBPServerInfoKey_ChangedKeys];
+	@synchronized (changedKeys) {
+		[changedKeys addObject: _key]; // ...so that the store need only write this entry
+	}
+	[[self class] save];
 }
 #pragma mark -
 - (UICKeyChainStore*)keyChainStore
 {
-	if (_keyChainStore == nil)
-	{
-		_keyChainStore = [UICKeyChainStore keyChainStoreWithService: _key];
-		_keyChainStore.accessibility = UICKeyChainStoreAccessibilityAlways;
+	@synchronized (self) {
+		if (_keyChainStore == nil)
+		{
+			_keyChainStore = [UICKeyChainStore keyChainStoreWithService: _key];
+			_keyChainStore.accessibility = UICKeyChainStoreAccessibilityAlways;
+		}
+		return _keyChainStore;
 	}
-	return _keyChainStore;
 }
 - (void)fetchPair:(EPair)whichPair into:(NSMutableDictionary*)md
 {
 	BOOL				client = whichPair == ePair_ClientKeyAndSecret;
-	NSString*			(^decrypt)(NSString*s) =
-							  client
-							? (OBPClientCredentialCryptBlock)gOBPServerInfo[gOBPServerInfoKey_DecryptBlock]
-							: ^(NSString*s){return s;};
 	NSString*			key = client ? ClientKeyAndSecretKCAccount : TokenKeyAndSecretKCAccount;
 	NSString*			value;
 	NSArray*			pair;
 
 	if ((_cache && nil != (value = _cache[key]))
-	 || nil != (value = decrypt(self.keyChainStore[key])))
+	 || nil != (value = client ? [self fetchClientPair] : self.keyChainStore[key]))
 	if (nil != (pair = [value componentsSeparatedByString: KEY_SEP]))
 	if (2 == [pair count])
 	{
@@ -493,6 +593,36 @@ OBPClientCredentialCryptBlock
 		}
 	}
 }
+- (NSString*)fetchClientPair
+{
+	OBPClientCredentialCryptBlock	decrypt = gOBPServerInfo[gOBPServerInfoKey_DecryptBlock];
+	NSString*						(^decryptLegacy)(NSString*) = gOBPServerInfo[gOBPServerInfoKey_LegacyDecryptBlock];
+	OBPClientCredentialCryptBlock	encrypt;
+	NSString*						stored = self.keyChainStore[ClientKeyAndSecretKCAccount];
+	NSString*						value = decrypt(stored);
+	NSString*						converted;
+	BOOL							authenticatedWas = _credentialsAuthenticated;
+
+	if (!decryptLegacy || ![stored length])
+		return value;
+	if ([value length])
+		_credentialsAuthenticated = YES;
+	else
+	if (!_credentialsAuthenticated && [(value = decryptLegacy(stored)) length])
+	{
+		// Stored before authenticated encryption was turned on: convert it, once; from then on only the authenticated format is accepted
+		encrypt = gOBPServerInfo[gOBPServerInfoKey_EncryptBlock];
+		if ([(converted = encrypt(value)) length])
+		{
+			self.keyChainStore[ClientKeyAndSecretKCAccount] = converted;
+			_credentialsAuthenticated = YES;
+		}
+		OBP_LOG_IF(!_credentialsAuthenticated, @"[OBPServerInfo %@] • could not convert client credentials to the authenticated format •", _key);
+	}
+	if (_credentialsAuthenticated != authenticatedWas)
+		[self scheduleSave]; // ...so that the format is remembered, and an item in the old format refused from now on, even if not yet known to be usable
+	return value;
+}
 - (void)storePair:(EPair)whichPair from:(NSDictionary*)d
 {
 	BOOL				client = whichPair == ePair_ClientKeyAndSecret;
@@ -508,10 +638,20 @@ OBPClientCredentialCryptBlock
 							  ? [s0 stringByAppendingFormat: @"%@%@", KEY_SEP, s1]
 							  : nil;
 
+	NSString*			encrypted;
+
 	if (!_cache															// no cache => update
 	 || !(value ? [valueCached isEqualToString: value] : !valueCached))	// change => update
 	{
-		self.keyChainStore[key] = value ? encrypt(value) : nil;
+		encrypted = value ? encrypt(value) : nil;
+		if (value && ![encrypted length])
+		{
+			OBP_LOG(@"[OBPServerInfo %@] • could not encrypt credentials; they are not stored •", _key);
+			return;
+		}
+		self.keyChainStore[key] = encrypted;
+		if (client && gOBPServerInfo[gOBPServerInfoKey_LegacyDecryptBlock])
+			_credentialsAuthenticated = YES;
 		NSMutableDictionary* md = [(_cache ?: @{}) mutableCopy];
 		md[key] = value ?: @"";
 		_cache = [md copy];
@@ -525,125 +665,224 @@ OBPClientCredentialCryptBlock
 #pragma mark -
 - (void)setAccessData:(NSDictionary*)data
 {
-	if (nil == data)
-		return;
-	BOOL			changed = NO;
-	BOOL			changedToken = NO;
-	NSString*		APIVersion = nil;
-	NSString		*s0, *s1, *k;
-
-	// Check for API version either explicitly or within API base
-	if ([(s0 = data[OBPServerInfo_APIVersion]) length])
-		APIVersion = s0;
-	else
-	if ([(s0 = data[OBPServerInfo_APIBase]) length])
-	if (![s0 isEqualToString: _APIBase])
-		APIVersion = s0.lastPathComponent;
-
-	// Check if API version is changed
-	if (APIVersion && ![APIVersion isEqualToString: _APIVersion])
-	{
-		_APIVersion = APIVersion;
-		_APIBase = [[self class] APIBaseForServer: _APIServer andAPIVersion: _APIVersion];
-		changed = YES;
-	}
-
-	// For Auth server base and paths, check for and apply any new non-empty values
-	NSMutableDictionary* md = [_AuthServerDict mutableCopy];
-	for (k in @[OBPServerInfo_AuthServerBase, OBPServerInfo_RequestPath,
-				OBPServerInfo_GetUserAuthPath, OBPServerInfo_GetTokenPath])
-	{
-		if ([(s0 = data[k]) length])
-		if (![(s1 = md[k]) isEqualToString: s0])
-			md[k] = s0;
-	}
-	if (![_AuthServerDict isEqualToDictionary: md])
-		_AuthServerDict = [md copy], changed = YES;
-
-	// If any credentials have been supplied, check and store updates if necessary
-	if (data[OBPServerInfo_ClientKey]
-	 || data[OBPServerInfo_ClientSecret]
-	 || data[OBPServerInfo_TokenKey]
-	 || data[OBPServerInfo_TokenSecret])
-	{
-		// Fetch current credentials
-		md = [NSMutableDictionary dictionary];
-		[self fetchPair: ePair_ClientKeyAndSecret into: md];
-		[self fetchPair: ePair_TokenKeyAndSecret into: md];
+	// Credentials are read and written from any queue; the keychain store and cache are shared
+	@synchronized (self) {
+		if (nil == data)
+			return;
+		_accessDataGeneration++; // ...tells holders of snapshots that they are out of date
+		BOOL			changed = NO;
+		BOOL			changedToken = NO;
+		NSString*		APIVersion = nil;
+		NSString		*s0, *s1, *k;
+
+		// Check for API version either explicitly or within API base
+		if ([(s0 = data[OBPServerInfo_APIVersion]) length])
+			APIVersion = s0;
+		else
+		if ([(s0 = data[OBPServerInfo_APIBase]) length])
+		if (![s0 isEqualToString: _APIBase])
+			APIVersion = s0.lastPathComponent;
 
-		// Set client key and secret if not already set
-		int needed = 2;
-		for (k in @[OBPServerInfo_ClientKey, OBPServerInfo_ClientSecret])
+		// Check if API version is changed
+		if (APIVersion && ![APIVersion isEqualToString: _APIVersion])
 		{
-			if ([(s0 = data[k]) length])
-			if (![(s1 = md[k]) length])
-				needed--;
+			_APIVersion = APIVersion;
+			_APIBase = [[self class] APIBaseForServer: _APIServer andAPIVersion: _APIVersion];
+			changed = YES;
 		}
-		if (needed == 0) // we have the key and secret, so save
-			[self storePair: ePair_ClientKeyAndSecret from: data], _usable = YES, changed = YES;
 
-		// Always update token key and secret, including setting to empty (==logged out or revoked access)
-		changedToken = NO;
-		for (k in @[OBPServerInfo_TokenKey, OBPServerInfo_TokenSecret])
+		// For Auth server base and paths, check for and apply any new non-empty values
+		NSMutableDictionary* md = [_AuthServerDict mutableCopy];
+		for (k in @[OBPServerInfo_AuthServerBase, OBPServerInfo_RequestPath,
+					OBPServerInfo_GetUserAuthPath, OBPServerInfo_GetTokenPath])
 		{
-			if (nil != (s0 = data[k]))
+			if ([(s0 = data[k]) length])
 			if (![(s1 = md[k]) isEqualToString: s0])
-				changedToken = YES;
+				md[k] = s0;
+		}
+		if (![_AuthServerDict isEqualToDictionary: md])
+			_AuthServerDict = [md copy], changed = YES;
+
+		// If any credentials have been supplied, check and store updates if necessary
+		if (data[OBPServerInfo_ClientKey]
+		 || data[OBPServerInfo_ClientSecret]
+		 || data[OBPServerInfo_TokenKey]
+		 || data[OBPServerInfo_TokenSecret])
+		{
+			// Fetch current credentials
+			md = [NSMutableDictionary dictionary];
+			[self fetchPair: ePair_ClientKeyAndSecret into: md];
+			[self fetchPair: ePair_TokenKeyAndSecret into: md];
+
+			// Set client key and secret if not already set
+			int needed = 2;
+			for (k in @[OBPServerInfo_ClientKey, OBPServerInfo_ClientSecret])
+			{
+				if ([(s0 = data[k]) length])
+				if (![(s1 = md[k]) length])
+					needed--;
+			}
+			if (needed == 0) // we have the key and secret, so save
+				[self storePair: ePair_ClientKeyAndSecret from: data], _usable = YES, changed = YES;
+
+			// Always update token key and secret, including setting to empty (==logged out or revoked access)
+			changedToken = NO;
+			for (k in @[OBPServerInfo_TokenKey, OBPServerInfo_TokenSecret])
+			{
+				if (nil != (s0 = data[k]))
+				if (![(s1 = md[k]) isEqualToString: s0])
+					changedToken = YES;
+			}
+			if (changedToken)
+				[self storePair: ePair_TokenKeyAndSecret from: data];
+
+			self.keyChainStore = nil;
 		}
-		if (changedToken)
-			[self storePair: ePair_TokenKeyAndSecret from: data];
 
-		self.keyChainStore = nil;
+		if (changed)
+			[self save];
 	}
-
-	if (changed)
-		[self save];
 }
 - (NSDictionary*)accessData
 {
-	// load data from key chain and return (never store; we only store retrieval params)
-	NSMutableDictionary*	md = [NSMutableDictionary dictionary];
-	md[OBPServerInfo_APIServer] = _APIServer;
-	md[OBPServerInfo_APIVersion] = _APIVersion;
-	md[OBPServerInfo_APIBase] = _APIBase;
-	[md addEntriesFromDictionary: _AuthServerDict];
-	[self fetchPair: ePair_ClientKeyAndSecret into: md];
-	[self fetchPair: ePair_TokenKeyAndSecret into: md];
-	self.keyChainStore = nil;
-	return [md copy];
+	@synchronized (self) {
+		// load data from key chain and return (never store; we only store retrieval params)
+		NSMutableDictionary*	md = [NSMutableDictionary dictionary];
+		md[OBPServerInfo_APIServer] = _APIServer;
+		md[OBPServerInfo_APIVersion] = _APIVersion;
+		md[OBPServerInfo_APIBase] = _APIBase;
+		[md addEntriesFromDictionary: _AuthServerDict];
+		[self fetchPair: ePair_ClientKeyAndSecret into: md];
+		[self fetchPair: ePair_TokenKeyAndSecret into: md];
+		self.keyChainStore = nil;
+		return [md copy];
+	}
+}
+- (NSUInteger)accessDataGeneration
+{
+	@synchronized (self) {
+		return _accessDataGeneration;
+	}
 }
 - (BOOL)checkValid
 {
-	NSMutableDictionary* md;
-	md = [NSMutableDictionary dictionary];
-	[self fetchPair: ePair_ClientKeyAndSecret into: md];
-	[self fetchPair: ePair_TokenKeyAndSecret into: md];
-	_usable = [md[OBPServerInfo_ClientKey] length] && [md[OBPServerInfo_ClientSecret] length];
-	_inUse = [md[OBPServerInfo_TokenKey] length] && [md[OBPServerInfo_TokenSecret] length];
-	return _usable;
+	@synchronized (self) {
+		NSMutableDictionary* md;
+		md = [NSMutableDictionary dictionary];
+		[self fetchPair: ePair_ClientKeyAndSecret into: md];
+		[self fetchPair: ePair_TokenKeyAndSecret into: md];
+		_usable = [md[OBPServerInfo_ClientKey] length] && [md[OBPServerInfo_ClientSecret] length];
+		_inUse = [md[OBPServerInfo_TokenKey] length] && [md[OBPServerInfo_TokenSecret] length];
+		_verified = YES;
+		return _usable;
+	}
+}
+- (BOOL)checkValidOnce
+{
+	@synchronized (self) {
+		return _verified ? _usable : [self checkValid];
+	}
+}
+- (BOOL)verify
+{
+	BOOL	verifiedNow = NO;
+	BOOL	usable;
+
+	@synchronized (self) {
+		if (!_verified)
+		{
+			[self checkValid];
+			self.keyChainStore = nil;
+			verifiedNow = YES;
+		}
+		usable = _usable;
+	}
+	if (verifiedNow)
+	{
+		// Outcomes are announced on the main queue, whichever queue asked
+		dispatch_block_t announce =
+			^{
+				if (usable)
+					[[NSNotificationCenter defaultCenter] postNotificationName: OBPServerInfoDidVerifyEntryNotification object: self];
+				else
+					[[self class] dropEntry: self];
+			};
+		if ([NSThread isMainThread])
+			announce();
+		else
+			dispatch_async(dispatch_get_main_queue(), announce);
+	}
+	return usable;
+}
+- (void)verifyWithStoredClientPair:(NSString*)clientPair tokenPair:(NSString*)tokenPair generation:(NSUInteger)generation
+{
+	@synchronized (self) {
+		if (_verified)
+			return; // ...already verified on demand
+		// Prime the cache with what was read in the background, so that checking needs no further keychain reads, unless credentials have been read or changed since, when what was read may be stale
+		if (clientPair && !_cache && _accessDataGeneration == generation)
+			_cache = @{
+				ClientKeyAndSecretKCAccount	: clientPair ?: @"",
+				TokenKeyAndSecretKCAccount	: tokenPair ?: @"",
+			};
+	}
+	[self verify];
+}
+- (BOOL)usable
+{
+	@synchronized (self) {
+		if (_verified)
+			return _usable;
+	}
+	return [self verify];
+}
+- (BOOL)inUse
+{
+	[self usable];
+	@synchronized (self) {
+		return _inUse;
+	}
+}
+- (BOOL)verified
+{
+	@synchronized (self) {
+		return _verified;
+	}
 }
 #pragma mark -
 - (void)setAppData:(NSDictionary*)appData
 {
-	if (appData ? [_appData isEqualToDictionary: appData] : !_appData)
-		return;
-	_appData = [appData copy];
+	@synchronized (self) {
+		if (appData ? [_appData isEqualToDictionary: appData] : !_appData)
+			return;
+		_appData = [appData copy];
+	}
 	[self save];
 }
 - (NSDictionary*)appData
 {
-	return _appData;
+	@synchronized (self) {
+		return _appData;
+	}
 }
 #pragma mark -
 - (void)setName:(NSString*)name
 {
-	if (![name length])
-		name = [NSURLComponents componentsWithString: _APIServer].host;
-	if ([name isEqualToString: _name])
-		return;
-	_name = name;
+	@synchronized (self) {
+		if (![name length])
+			name = [NSURLComponents componentsWithString: _APIServer].host;
+		if ([name isEqualToString: _name])
+			return;
+		_name = [name copy];
+	}
 	[self save];
 }
+- (NSString*)name
+{
+	@synchronized (self) {
+		return _name;
+	}
+}
 @end
 
 
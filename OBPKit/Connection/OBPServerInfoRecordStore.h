@@ -0,0 +1,36 @@
+//
+//  OBPServerInfoRecordStore.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OBPServerInfoStore.h"
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+/**	An OBPServerInfoRecordStore instance stores each OBPServerInfo instance as a separate record in an append-only file, so that saving costs time in proportion to the entries that changed, instead of re-archiving them all.
+
+	Each record holds the entry's key and its keyed archive, and a checksum. A save appends a record for each new or changed entry and a deletion record for each entry removed, then a commit record holding the length and checksum of the batch, and the records take effect only with their commit. At load, the file is memory-mapped and only the record headers are read to find the latest record of each entry, so superseded records are never decoded, and entries are unarchived when first asked for. Since each save is synced before the next is appended, only the last batch can be left incomplete by a crash: its checksum is checked at load and the whole batch is discarded if it is torn or has no commit; every other record's checksum is checked when it is decoded, and a damaged record gives no entry.
+
+	OBPServerInfo uses -entryKeys and -entryForKey: rather than -entries, so that +defaultEntry and +firstEntryForAPIServer: unarchive entries only as far as the one they return, until +entries is first needed.
+
+	When superseded records take up more than half of the file, the live records are written to a new file that then replaces the old one atomically, so the store is never left without a complete copy.
+
+	To use it, pass @"OBPServerInfoRecordStore" for OBPServerInfoConfig_StoreClass to OBPServerInfoCustomise. Entries found in the file written by OBPServerInfoStore are imported the first time.
+*/
+@interface OBPServerInfoRecordStore : OBPServerInfoStore
+@property (nonatomic, readonly) NSArray<NSString*>* entryKeys; ///< Get the keys of the stored entries, in order, without unarchiving any of them.
+- (nullable OBPServerInfo*)entryForKey:(NSString*)key; ///< Unarchive and return only the entry with key, or nil if none.
+- (void)compact; ///< Rewrite the file with only the live records now, rather than waiting until superseded records take up half of it.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,411 @@
+//
+//  OBPServerInfoRecordStore.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPServerInfoRecordStore.h"
+// sdk
+#include <fcntl.h>
+#include <unistd.h>
+// prj
+#import "OBPServerInfo.h"
+#import "OBPLogging.h"
+
+
+
+#define kRecordFileMagic			"OBPSIR02"
+#define kRecordFileMagicLength		8
+#define kRecordFileCompactMinLength	(64 * 1024)		// don't bother compacting files smaller than this
+
+typedef NS_ENUM(uint8_t, ERecordKind) {eRecordKind_Put = 1, eRecordKind_Delete = 2, eRecordKind_Commit = 3};
+
+// Stored little-endian, followed by the key (UTF-8) and, for a put, the keyed archive of the entry, or for a commit, a CommitBody and no key
+typedef struct RecordHeader {
+	uint32_t	length;		// bytes of key and archive following the header
+	uint32_t	checksum;	// of kind, key and archive
+	uint16_t	keyLength;
+	uint8_t		kind;		// ERecordKind
+	uint8_t		reserved;
+} RecordHeader;
+
+// Ends the records written by one save, so that they take effect together or not at all
+typedef struct CommitBody {
+	uint32_t	batchLength;	// bytes of the records since the previous commit
+	uint32_t	batchChecksum;	// of those bytes
+} CommitBody;
+
+
+
+static uint32_t RecordChecksum(uint8_t kind, const uint8_t* bytes, size_t length)
+{
+	// FNV-1a; enough to detect a torn or garbled record
+	uint32_t	h = 2166136261u;
+	const uint8_t* end = bytes + length;
+
+	h = (h ^ kind) * 16777619u;
+	while (bytes < end)
+		h = (h ^ *bytes++) * 16777619u;
+	return h;
+}
+
+static BOOL RecordIsIntact(const uint8_t* record)
+{
+	RecordHeader	h;
+	memcpy(&h, record, sizeof(h));
+	return CFSwapInt32LittleToHost(h.checksum) == RecordChecksum(h.kind, record + sizeof(h), CFSwapInt32LittleToHost(h.length));
+}
+
+static void AppendRecord(NSMutableData* md, ERecordKind kind, NSString* key, NSData* archive)
+{
+	NSData*			keyData = [key dataUsingEncoding: NSUTF8StringEncoding];
+	NSUInteger		start = [md length];
+	RecordHeader	h;
+
+	h.length = CFSwapInt32HostToLittle((uint32_t)([keyData length] + [archive length]));
+	h.checksum = 0;
+	h.keyLength = CFSwapInt16HostToLittle((uint16_t)[keyData length]);
+	h.kind = kind;
+	h.reserved = 0;
+	[md appendBytes: &h length: sizeof(h)];
+	[md appendData: keyData];
+	if (archive)
+		[md appendData: archive];
+	h.checksum = CFSwapInt32HostToLittle(RecordChecksum(kind, (const uint8_t*)[md bytes] + start + sizeof(h), [md length] - start - sizeof(h)));
+	[md replaceBytesInRange: NSMakeRange(start, sizeof(h)) withBytes: &h];
+}
+
+static void AppendCommit(NSMutableData* md, NSUInteger batchStart)
+{
+	NSUInteger		start = [md length];
+	RecordHeader	h;
+	CommitBody		c;
+
+	c.batchLength = CFSwapInt32HostToLittle((uint32_t)(start - batchStart));
+	c.batchChecksum = CFSwapInt32HostToLittle(RecordChecksum(eRecordKind_Commit, (const uint8_t*)[md bytes] + batchStart, start - batchStart));
+	h.length = CFSwapInt32HostToLittle((uint32_t)sizeof(c));
+	h.checksum = CFSwapInt32HostToLittle(RecordChecksum(eRecordKind_Commit, (const uint8_t*)&c, sizeof(c)));
+	h.keyLength = 0;
+	h.kind = eRecordKind_Commit;
+	h.reserved = 0;
+	[md appendBytes: &h length: sizeof(h)];
+	[md appendBytes: &c length: sizeof(c)];
+}
+
+static BOOL WriteToFile(NSString* path, NSData* data, off_t offset, BOOL truncate)
+{
+	int			fd = open([path fileSystemRepresentation], O_WRONLY | O_CREAT, 0600);
+	const char*	bytes = [data bytes];
+	size_t		remaining = [data length];
+	ssize_t		written;
+	BOOL		ok = fd >= 0;
+
+	if (ok && truncate)
+		ok = 0 == ftruncate(fd, offset);
+	while (ok && remaining)
+	{
+		written = pwrite(fd, bytes, remaining, offset);
+		if (written < 0)
+			ok = NO;
+		else
+			bytes += written, offset += written, remaining -= (size_t)written;
+	}
+	if (ok)
+		ok = 0 == fsync(fd);
+	if (fd >= 0)
+		close(fd);
+	OBP_LOG_IF(!ok, @"[OBPServerInfoRecordStore] • failed to write %@: %s •", path, strerror(errno));
+	return ok;
+}
+
+
+
+#pragma mark -
+@implementation OBPServerInfoRecordStore
+{
+	NSString*									_legacyPath;	// file written by OBPServerInfoStore, to import from
+	NSMutableArray<NSString*>*					_keys;			// of live entries, in order
+	NSMutableDictionary<NSString*,NSValue*>*	_records;		// key -> range in file of the entry's live record
+	NSData*										_mapped;		// nil until needed, and after the file changes
+	unsigned long long							_fileLength;	// zero if there is no valid file yet
+	unsigned long long							_liveLength;	// bytes of live records
+	BOOL										_loaded;
+}
+- (instancetype)initWithPath:(nullable NSString*)path
+{
+	if (nil == (self = [super initWithPath: path]))
+		return nil;
+	if (path == nil)
+		_legacyPath = [super defaultPath];
+	return self;
+}
+- (NSString*)defaultPath
+{
+	return [[[super defaultPath] stringByDeletingPathExtension] stringByAppendingPathExtension: @"rec"];
+}
+#pragma mark -
+- (NSData*)mappedData
+{
+	if (_mapped == nil)
+		_mapped = [NSData dataWithContentsOfFile: self.path options: NSDataReadingMappedIfSafe error: NULL];
+	return _mapped;
+}
+- (void)load
+{
+	if (_loaded)
+		return;
+	_loaded = YES;
+	_keys = [NSMutableArray array];
+	_records = [NSMutableDictionary dictionary];
+
+	NSData*				data = [self mappedData];
+	const uint8_t*		bytes = [data bytes];
+	NSUInteger			length = [data length];
+	NSUInteger			offset, recordLength, committed;
+	RecordHeader		h;
+	CommitBody			c;
+	NSString*			key;
+	NSMutableArray*		batch = [NSMutableArray array];	// of @[key, range of put or NSNull for delete], until committed
+	OBPServerInfoArray*	legacy;
+
+	if (data == nil)
+	{
+		// First use: bring over anything saved by OBPServerInfoStore
+		if (_legacyPath && nil != (legacy = [NSKeyedUnarchiver unarchiveObjectWithFile: _legacyPath]) && [legacy count])
+			[self writeEntries: legacy changedKeys: nil];
+		return;
+	}
+	if (length < kRecordFileMagicLength || memcmp(bytes, kRecordFileMagic, kRecordFileMagicLength))
+	{
+		OBP_LOG(@"[OBPServerInfoRecordStore load] • %@ is not a record file; it will be replaced at next save •", self.path);
+		return;
+	}
+
+	// Replay the records, reading only their headers and keys. Each save appends its records as a batch ended by a commit record, and they take effect only when it is reached. Each batch is synced before the next is written, so only the last can have been torn by a crash: it alone is checksummed now, whole, and the records of the others when they are decoded.
+	for (offset = committed = kRecordFileMagicLength; offset + sizeof(h) <= length; offset += recordLength)
+	{
+		memcpy(&h, bytes + offset, sizeof(h));
+		h.length = CFSwapInt32LittleToHost(h.length);
+		h.keyLength = CFSwapInt16LittleToHost(h.keyLength);
+		recordLength = sizeof(h) + h.length;
+		if (recordLength > length - offset)
+			break;
+		if (h.kind == eRecordKind_Commit)
+		{
+			if (h.keyLength || h.length != sizeof(c) || !RecordIsIntact(bytes + offset))
+				break;
+			memcpy(&c, bytes + offset + sizeof(h), sizeof(c));
+			if (CFSwapInt32LittleToHost(c.batchLength) != offset - committed
+			 || (offset + recordLength == length && CFSwapInt32LittleToHost(c.batchChecksum) != RecordChecksum(eRecordKind_Commit, bytes + committed, offset - committed)))
+				break;
+			[self replayBatch: batch];
+			[batch removeAllObjects];
+			committed = offset + recordLength;
+			continue;
+		}
+		if (!h.keyLength || h.keyLength > h.length || (h.kind != eRecordKind_Put && h.kind != eRecordKind_Delete)
+		 || nil == (key = [[NSString alloc] initWithBytes: bytes + offset + sizeof(h) length: h.keyLength encoding: NSUTF8StringEncoding]))
+			break;
+		[batch addObject: @[key, h.kind == eRecordKind_Put ? [NSValue valueWithRange: NSMakeRange(offset, recordLength)] : [NSNull null]]];
+	}
+	_fileLength = committed;
+
+	if (committed < length)
+	{
+		// ...a save torn by a crash, or damage: keep what was committed before it
+		OBP_LOG(@"[OBPServerInfoRecordStore load] • discarding %lu bytes after offset %lu of %@ •", (unsigned long)(length - committed), (unsigned long)committed, self.path);
+		_mapped = nil;
+		if (!WriteToFile(self.path, [NSData data], (off_t)committed, YES))
+			_fileLength = 0;
+	}
+}
+- (void)replayBatch:(NSArray*)batch
+{
+	NSString*		key;
+	NSValue*		old;
+	NSValue*		put;
+
+	for (NSArray* record in batch)
+	{
+		key = record[0];
+		put = [record[1] isKindOfClass: [NSValue class]] ? record[1] : nil;
+		if (nil != (old = _records[key]))
+			_liveLength -= [old rangeValue].length;
+		if (put)
+		{
+			if (old == nil)
+				[_keys addObject: key];
+			_records[key] = put;
+			_liveLength += [put rangeValue].length;
+		}
+		else
+		if (old != nil)
+		{
+			[_keys removeObject: key];
+			[_records removeObjectForKey: key];
+		}
+	}
+}
+- (NSData*)archiveForRecordAt:(NSRange)range
+{
+	NSData*			data = [self mappedData];
+	RecordHeader	h;
+
+	if (NSMaxRange(range) > [data length])
+		return nil;
+	if (!RecordIsIntact((const uint8_t*)[data bytes] + range.location))
+	{
+		OBP_LOG(@"[OBPServerInfoRecordStore] • record at offset %lu of %@ is damaged •", (unsigned long)range.location, self.path);
+		return nil;
+	}
+	[data getBytes: &h range: NSMakeRange(range.location, sizeof(h))];
+	h.keyLength = CFSwapInt16LittleToHost(h.keyLength);
+	return [data subdataWithRange: NSMakeRange(range.location + sizeof(h) + h.keyLength, range.length - sizeof(h) - h.keyLength)];
+}
+#pragma mark -
+- (NSArray<NSString*>*)entryKeys
+{
+	[self load];
+	return [_keys copy];
+}
+- (nullable OBPServerInfo*)entryForKey:(NSString*)key
+{
+	[self load];
+	NSValue*		record = _records[key];
+	NSData*			archive = record ? [self archiveForRecordAt: [record rangeValue]] : nil;
+	OBPServerInfo*	entry = archive ? [NSKeyedUnarchiver unarchiveObjectWithData: archive] : nil;
+	return [entry isKindOfClass: [OBPServerInfo class]] ? entry : nil;
+}
+- (OBPServerInfoArray*)entries
+{
+	[self load];
+	NSMutableArray*		ma = [NSMutableArray arrayWithCapacity: [_keys count]];
+	OBPServerInfo*		entry;
+
+	for (NSString* key in _keys)
+		if (nil != (entry = [self entryForKey: key]))
+			[ma addObject: entry];
+	return [ma copy];
+}
+- (void)setEntries:(OBPServerInfoArray*)entries
+{
+	[self load];
+	[self writeEntries: entries changedKeys: nil];
+}
+- (void)setEntries:(OBPServerInfoArray*)entries changedKeys:(NSSet<NSString*>*)changedKeys
+{
+	[self load];
+	[self writeEntries: entries changedKeys: changedKeys];
+}
+- (void)writeEntries:(OBPServerInfoArray*)entries changedKeys:(nullable NSSet<NSString*>*)changedKeys
+{
+	// When changedKeys is nil, every entry is archived and compared with its record instead
+	NSMutableData*				append = [NSMutableData data];
+	NSMutableArray<NSString*>*	keys = [NSMutableArray arrayWithCapacity: [entries count]];
+	NSMutableSet<NSString*>*	keySet = [NSMutableSet setWithCapacity: [entries count]];
+	NSMutableArray<NSString*>*	replayed = [NSMutableArray arrayWithCapacity: [entries count]];
+	NSMutableArray<NSString*>*	added = [NSMutableArray array];
+	NSMutableDictionary*		puts = [NSMutableDictionary dictionary];
+	unsigned long long			base = _fileLength ?: kRecordFileMagicLength;
+	NSUInteger					start;
+	NSValue*					old;
+	NSData*						archive;
+	NSString*					key;
+
+	for (OBPServerInfo* entry in entries)
+	{
+		key = entry.key;
+		if (![key length] || [keySet containsObject: key])
+			continue;
+		[keys addObject: key];
+		[keySet addObject: key];
+		old = _records[key];
+		if (old && changedKeys && ![changedKeys containsObject: key])
+			continue;
+		archive = [NSKeyedArchiver archivedDataWithRootObject: entry];
+		if (old && [archive isEqualToData: [self archiveForRecordAt: [old rangeValue]]])
+			continue;
+		start = [append length];
+		AppendRecord(append, eRecordKind_Put, key, archive);
+		puts[key] = [NSValue valueWithRange: NSMakeRange((NSUInteger)base + start, [append length] - start)];
+		if (!old)
+			[added addObject: key];
+	}
+	for (key in _keys)
+		if (![keySet containsObject: key])
+			AppendRecord(append, eRecordKind_Delete, key, nil);
+		else
+			[replayed addObject: key];
+	[replayed addObjectsFromArray: added];
+
+	if ([append length])
+	{
+		if (_fileLength == 0)
+		{
+			NSMutableData* md = [NSMutableData dataWithBytes: kRecordFileMagic length: kRecordFileMagicLength];
+			[md appendData: append];
+			append = md;
+		}
+		AppendCommit(append, _fileLength ? 0 : kRecordFileMagicLength);
+		// Truncate first, so that nothing left by an earlier failed write follows the new batch
+		if (!WriteToFile(self.path, append, (off_t)_fileLength, YES))
+			return;
+		_mapped = nil;
+		_fileLength = base + [append length] - (_fileLength ? 0 : kRecordFileMagicLength);
+
+		// Update the index to match
+		for (key in _keys)
+			if (![keySet containsObject: key])
+				_liveLength -= [_records[key] rangeValue].length, [_records removeObjectForKey: key];
+		for (key in puts)
+		{
+			if (nil != (old = _records[key]))
+				_liveLength -= [old rangeValue].length;
+			_records[key] = puts[key];
+			_liveLength += [puts[key] rangeValue].length;
+		}
+	}
+	_keys = keys;
+
+	// The file gives entries in replay order; if that is not the order asked for, or too much of the file is dead, rewrite it
+	if (![replayed isEqualToArray: keys]
+	 || (_fileLength > kRecordFileCompactMinLength && _liveLength * 2 < _fileLength))
+		[self compact];
+}
+- (void)compact
+{
+	[self load];
+	NSMutableData*			md = [NSMutableData dataWithCapacity: (NSUInteger)_liveLength + kRecordFileMagicLength];
+	NSMutableDictionary*	records = [NSMutableDictionary dictionaryWithCapacity: [_keys count]];
+	NSData*					data = [self mappedData];
+	NSString*				tempPath = [self.path stringByAppendingString: @".tmp"];
+	NSRange					range;
+
+	[md appendBytes: kRecordFileMagic length: kRecordFileMagicLength];
+	for (NSString* key in _keys)
+	{
+		range = [_records[key] rangeValue];
+		if (NSMaxRange(range) > [data length])
+			return; // ...index does not match file; leave it alone
+		records[key] = [NSValue valueWithRange: NSMakeRange([md length], range.length)];
+		[md appendBytes: (const uint8_t*)[data bytes] + range.location length: range.length];
+	}
+	AppendCommit(md, kRecordFileMagicLength);
+
+	// Write a complete new file beside the old one, then swap it in atomically
+	if (!WriteToFile(tempPath, md, 0, YES))
+		return;
+	if (0 != rename([tempPath fileSystemRepresentation], [self.path fileSystemRepresentation]))
+	{
+		OBP_LOG(@"[OBPServerInfoRecordStore compact] • failed to replace %@: %s •", self.path, strerror(errno));
+		unlink([tempPath fileSystemRepresentation]);
+		return;
+	}
+	_mapped = nil;
+	_records = records;
+	_fileLength = [md length];
+	_liveLength = [md length] - kRecordFileMagicLength - sizeof(RecordHeader) - sizeof(CommitBody);
+}
+@end
@@ -23,6 +23,8 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithPath:(nullable NSString*)path; ///< Designated initializer. \param path identifies the location to find/store archived data if non-nil; otherwise a default path is used, which on iOS is file AD.dat in the app's Documents directory, and on OSX is the file AD.dat in ~/Library/Application Support/<bundle id>.
 @property (nonatomic, strong, readonly) NSString* path; ///< \returns the path to which data is archived.
 @property (nonatomic, copy) NSArray<OBPServerInfo*>*_Nonnull entries; ///< set synchronously writes the supplied entries to an archive at .path, while get synchronously reads and restores entries from the archive at .path.
+- (void)setEntries:(NSArray<OBPServerInfo*>*)entries changedKeys:(NSSet<NSString*>*)changedKeys; ///< Write the supplied entries, where changedKeys holds the keys of those entries whose archived state may have changed since the last write; entries not present in the last write are always written. OBPServerInfo calls this instead of setting entries, so that subclasses can write only what changed. The default sets entries.
+- (NSString*)defaultPath; ///< Return the path used when none is passed to the initializer. Override to store elsewhere.
 @end
 
 
@@ -51,4 +51,8 @@
 {
 	return [NSKeyedUnarchiver unarchiveObjectWithFile: _path] ?: @[];
 }
+- (void)setEntries:(OBPServerInfoArray*)entries changedKeys:(NSSet<NSString*>*)changedKeys
+{
+	self.entries = entries;
+}
 @end
@@ -28,6 +28,7 @@ typedef NSArray<OBPSession*> OBPSessionArray;
 @protocol OBPWebViewProvider;
 typedef NSObject<OBPWebViewProvider>* OBPWebViewProviderRef;
 @class OBPMarshal;
+@class OBPTransport;
 @class STHTTPRequest;
 
 
@@ -75,6 +76,8 @@ You can also use authorisation method OBPAuthMethod_DirectLogin during developme
 If only access to public resources is required, use authorisation method OBPAuthMethod_None.
 
 Each instance holds an OBPMarshal helper object in its marshal property, for retrieving resources through the API. You can replace the default instance with your own if you need a different implementation or behaviour.
+
+The class methods, the marshal and transport, and request authorisation may be used from any queue, so that background workers can issue requests directly. Validation and invalidation always run on the main queue; when asked for from another queue they are started there asynchronously, and so state and valid only ever change on the main queue, as do KVO notifications of valid.
 */
 @interface OBPSession : NSObject
 // Managing sessions
@@ -107,6 +110,9 @@ Each instance holds an OBPMarshal helper object in its marshal property, for ret
 - (BOOL)authorizeSTHTTPRequest:(STHTTPRequest*)request; ///< Add an authorisation header to the supplied request. Call this as the very last step before launching the request.
 - (BOOL)authorizeURLRequest:(NSMutableURLRequest*)request andWrapErrorHandler:(HandleResultBlock _Nullable * _Nonnull)errorHandlerAt; ///< Add an authorisation header to the supplied request. Call as last step before launching an NSURLRequest. \param errorHandlerAt points to your local variable that references an error handler block which you will use to handle any errors from the execution of request; it will be replaced by an error handler belonging to this instance, and which will in turn call your original handler; this is necessary so that this instance can detect any errors that show access has been revoked.
 
+// Transport for requests to the OBP server in this session
+@property (nonatomic, strong, readonly) OBPTransport* transport; ///< Get the transport that sends this session's API requests to its server over one pooled connection, with a limit on concurrent requests and dispatch by priority. It is created at first use, and released when the session is removed.
+
 // Access helper for marshalling resources through OBP API as part of this session
 @property (nonatomic, strong) OBPMarshal* marshal; ///< Get a default helper for marshalling resources through the OBP API (or one that has been previously assigned) for this session. Reseting to nil will cause a default marshal helper to be created at next request. Assign your own subclass instance if you need an alternative implementation to be used.
 @end
@@ -21,6 +21,11 @@
 #import "OBPServerInfo.h"
 #import "OBPWebViewProvider.h"
 #import "OBPMarshal.h"
+#import "OBPResponseCache.h"
+#import "OBPTransactionStore.h"
+#import "OBPTransport.h"
+#import "OBPOAuth1Signer.h"
+#import "OBPSnapshot.h"
 #import "NSString+OBPKit.h"
 #import "STHTTPRequest+Error.h"
 
@@ -30,12 +35,19 @@ NSString* const OBPSessionErrorDomain = @"OBPSession";
 
 #define DL_TOKEN_SECRET @"-"
 
+#define kOBPTransportDefaultMaxConcurrentRequests 4
+
 
 
 @interface OBPSession ()
 {
 	OBPServerInfo*			_serverInfo;
 	OBPMarshal*				_marshal;
+	OBPTransport*			_transport;
+	// Credentials
+	NSDictionary*			_credentials;			// snapshot of _serverInfo.accessData...
+	NSUInteger				_credentialsGeneration;	// ...taken at this accessDataGeneration
+	OBPOAuth1Signer*		_signer;				// made from _credentials when first needed
 	//
 	OBPAuthMethod			_authMethod;
 	// Direct Login
@@ -49,6 +61,9 @@ NSString* const OBPSessionErrorDomain = @"OBPSession";
 @property (nonatomic, readwrite) OBPSessionState state;
 @property (nonatomic, strong) HandleResultBlock validateCompletion;
 @property (nonatomic, readwrite) BOOL valid;
+- (NSDictionary*)credentials;
+- (void)discardCredentials;
+- (OBPOAuth1Signer*)signer;
 @end
 
 
@@ -69,63 +84,100 @@ NSString* const OBPSessionErrorDomain = @"OBPSession";
 
 
 
+static void OBPPerformOnMainQueue(dispatch_block_t block)
+{
+	// The state machine runs on the main queue; requests from other queues to change state are passed there
+	if ([NSThread isMainThread])
+		block();
+	else
+		dispatch_async(dispatch_get_main_queue(), block);
+}
+
+
+
 #pragma mark -
 @implementation OBPSession
-static OBPSessionArray* sSessions = nil;
+static OBPSnapshot<OBPSessionArray*>* sSessions = nil; // ...read from any queue without locking; changes are serialised
 + (void)initialize
 {
 	if (self != [OBPSession class])
 		return;
-	sSessions = [OBPSessionArray array];
+	sSessions = [[OBPSnapshot alloc] initWithValue: [OBPSessionArray array]];
 }
 + (nullable OBPSession*)currentSession
 {
-	return [sSessions firstObject];
+	return [sSessions.value firstObject];
 }
 + (void)setCurrentSession:(OBPSession*)session
 {
-	NSUInteger index = session ? [sSessions indexOfObjectIdenticalTo: session] : NSNotFound;
+	__block NSUInteger index = NSNotFound;
+	[sSessions update:
+		^OBPSessionArray*(OBPSessionArray* sessions) {
+			index = session ? [sessions indexOfObjectIdenticalTo: session] : NSNotFound;
+			if (index == NSNotFound || index == 0)
+				return sessions;
+			NSMutableArray<OBPSession*>* ma = [sessions mutableCopy];
+			[ma removeObjectIdenticalTo: session];
+			[ma insertObject: session atIndex: 0];
+			return [ma copy];
+		}];
 	OBP_LOG_IF(index == NSNotFound, @"[OBPSession setCurrentSession: %@] — bad parameter.", session);
-	if (index == NSNotFound || index == 0)
-		return;
-	NSMutableArray<OBPSession*>* ma = [sSessions mutableCopy];
-	[ma removeObjectIdenticalTo: session];
-	[ma insertObject: session atIndex: 0];
-	sSessions = [ma copy];
 }
 + (nullable instancetype)findSessionWithServerInfo:(OBPServerInfo*)serverInfo
 {
 	OBPSession* session;
-	for (session in sSessions)
+	for (session in sSessions.value)
 	if (session->_serverInfo == serverInfo)
 		return session;
 	return nil;
 }
 + (nullable instancetype)sessionWithServerInfo:(OBPServerInfo*)serverInfo
 {
-	OBPSession* session;
+	__block OBPSession* session;
 	if (!serverInfo)
 		return nil;
 	if (nil != (session = [self findSessionWithServerInfo: serverInfo]))
 		return session;
-	session = [[self alloc] initWithServerInfo: serverInfo];
-	session.webViewProvider = [OBPDefaultWebViewProvider instance];
-	sSessions = [sSessions arrayByAddingObject: session];
+	// Look again while changes are held off, so that two queues asking at once get the same session
+	[sSessions update:
+		^OBPSessionArray*(OBPSessionArray* sessions) {
+			for (session in sessions)
+			if (session->_serverInfo == serverInfo)
+				return sessions;
+			session = [[self alloc] initWithServerInfo: serverInfo];
+			session.webViewProvider = [OBPDefaultWebViewProvider instance];
+			return [sessions arrayByAddingObject: session];
+		}];
 	return session;
 }
 + (void)removeSession:(OBPSession*)session
 {
-	if (NSNotFound == [sSessions indexOfObjectIdenticalTo: session])
+	__block BOOL removed = NO;
+	[sSessions update:
+		^OBPSessionArray*(OBPSessionArray* sessions) {
+			if (NSNotFound == [sessions indexOfObjectIdenticalTo: session])
+				return sessions;
+			NSMutableArray* ma = [sessions mutableCopy];
+			[ma removeObjectIdenticalTo: session];
+			removed = YES;
+			return [ma copy];
+		}];
+	if (!removed)
 		return;
-	if (session.state != OBPSessionStateInvalid)
-		[session invalidate];
-	NSMutableArray* ma = [sSessions mutableCopy];
-	[ma removeObjectIdenticalTo: session];
-	sSessions = [ma copy];
+	OBPPerformOnMainQueue(^{
+		if (session.state != OBPSessionStateInvalid)
+			[session invalidate];
+	});
+	OBPTransport* transport;
+	@synchronized (session) {
+		transport = session->_transport;
+		session->_transport = nil;
+	}
+	[transport invalidate];
 }
 + (OBPSessionArray*)allSessions
 {
-	return [sSessions copy];
+	return sSessions.value;
 }
 #pragma mark -
 - (instancetype)initWithServerInfo:(OBPServerInfo*)serverInfo
@@ -155,18 +207,31 @@ static OBPSessionArray* sSessions = nil;
 {
 	if (marshal && marshal.session != self)
 		marshal = nil;
-	if (_marshal != marshal)
+	@synchronized (self) {
 		_marshal = marshal;
+	}
 }
 - (OBPMarshal*)marshal
 {
-	if (_marshal == nil)
-		_marshal = [[OBPMarshal alloc] initWithSessionAuth: self];
-	return _marshal;
+	@synchronized (self) {
+		if (_marshal == nil)
+			_marshal = [[OBPMarshal alloc] initWithSessionAuth: self];
+		return _marshal;
+	}
+}
+- (OBPTransport*)transport
+{
+	@synchronized (self) {
+		if (_transport == nil)
+			_transport = [[OBPTransport alloc] initWithConfiguration: nil maxConcurrentRequests: kOBPTransportDefaultMaxConcurrentRequests];
+		return _transport;
+	}
 }
 #pragma mark -
 - (void)setAuthMethod:(OBPAuthMethod)authMethod
 {
+	if (![NSThread isMainThread])
+		{OBPPerformOnMainQueue(^{self.authMethod = authMethod;}); return;}
 	if (_authMethod != authMethod)
 	{
 		[self invalidate];
@@ -176,6 +241,8 @@ static OBPSessionArray* sSessions = nil;
 #pragma mark -
 - (void)validate:(HandleResultBlock)completion
 {
+	if (![NSThread isMainThread])
+		{OBPPerformOnMainQueue(^{[self validate: completion];}); return;}
 	OBP_ASSERT(_state == OBPSessionStateInvalid);
 	if (_state != OBPSessionStateValid)
 	if (completion)
@@ -188,6 +255,8 @@ static OBPSessionArray* sSessions = nil;
 }
 - (void)invalidate
 {
+	if (![NSThread isMainThread])
+		{OBPPerformOnMainQueue(^{[self invalidate];}); return;}
 	NSDictionary*	data = @{
 		OBPServerInfo_TokenKey		: @"",
 		OBPServerInfo_TokenSecret	: @"",
@@ -217,6 +286,12 @@ static OBPSessionArray* sSessions = nil;
 	BOOL	validWas = _valid;
 	_state = newState;
 	_serverInfo.accessData = data;
+	[self discardCredentials];
+	if (!validNow && validWas)
+	{
+		[_marshal.responseCache removeAllEntries]; // ...don't keep the user's private resources around after logout or revocation
+		[OBPTransactionStore removeStoreForServerInfo: _serverInfo];
+	}
 	if (_validateCompletion)
 	{
 		// We want to call the completion function before KV observers of our valid property get notified.
@@ -231,6 +306,40 @@ static OBPSessionArray* sSessions = nil;
 	self.valid = validNow;
 }
 #pragma mark -
+- (NSDictionary*)credentials
+{
+	// Reading accessData goes to the keychain, so keep a snapshot until it changes
+	@synchronized (self) {
+		NSUInteger generation = _serverInfo.accessDataGeneration;
+		if (!_credentials || _credentialsGeneration != generation)
+		{
+			_credentials = _serverInfo.accessData;
+			_credentialsGeneration = generation;
+			_signer = nil;
+		}
+		return _credentials;
+	}
+}
+- (void)discardCredentials
+{
+	@synchronized (self) {
+		_credentials = nil;
+		_signer = nil;
+	}
+}
+- (OBPOAuth1Signer*)signer
+{
+	@synchronized (self) {
+		NSDictionary* d = [self credentials];
+		if (!_signer)
+			_signer = [[OBPOAuth1Signer alloc] initWithConsumerKey: d[OBPServerInfo_ClientKey]
+													consumerSecret: d[OBPServerInfo_ClientSecret]
+															 token: d[OBPServerInfo_TokenKey]
+													   tokenSecret: d[OBPServerInfo_TokenSecret]];
+		return _signer;
+	}
+}
+#pragma mark -
 - (HandleResultBlock)detectRevokeBlockWithChainToBlock:(HandleResultBlock)chainBlock
 {
 	HandleResultBlock	block =
@@ -562,7 +671,7 @@ static OBPSessionArray* sSessions = nil;
 #pragma mark -
 - (void)addAuthorizationHeader1ToSTHTTPRequest:(STHTTPRequest*)request
 {
-	NSDictionary*			d = _serverInfo.accessData;
+	NSDictionary*			d = [self credentials];
 	NSString*				consumerKey = d[OBPServerInfo_ClientKey];
 	NSString*				consumerSecret = d[OBPServerInfo_ClientSecret];
 	NSString*				tokenKey = d[OBPServerInfo_TokenKey];
@@ -573,23 +682,13 @@ static OBPSessionArray* sSessions = nil;
 	//	If STHTTPRequest's HTTPMethod property is not explicitly set, then STHTTPRequest infers it lazily at the last moment, and we can get a value from the property that is not yet accurate at this stage. Assert that this is not the case here:
 	OBP_ASSERT(([request.HTTPMethod isEqualToString: @"GET"] || [request.HTTPMethod isEqualToString: @"DELETE"]) == (request.POSTDictionary==nil && request.rawPOSTData==nil));
 
-	header = OAuthHeader(
-		request.url,
-		request.HTTPMethod,
-		nil, // body (parsed for extra query parameters)
-		consumerKey,
-		consumerSecret,
-		tokenKey, // oauth_token
-		tokenSecret, // oauth_token_secret
-		nil, // oauth_verifier,
-		nil, // callback
-		OAuthCoreSignatureMethod_HMAC_SHA256);
+	header = [[self signer] authorizationHeaderForURL: request.url method: request.HTTPMethod];
 
     [request setHeaderWithName: @"Authorization" value: header];
 }
 - (void)addAuthorizationHeader1ToURLRequest:(NSMutableURLRequest*)request
 {
-	NSDictionary*			d = _serverInfo.accessData;
+	NSDictionary*			d = [self credentials];
 	NSString*				consumerKey = d[OBPServerInfo_ClientKey];
 	NSString*				consumerSecret = d[OBPServerInfo_ClientSecret];
 	NSString*				tokenKey = d[OBPServerInfo_TokenKey];
@@ -598,17 +697,7 @@ static OBPSessionArray* sSessions = nil;
 
 	OBP_ASSERT(0 != [consumerKey length] * [consumerSecret length] * [tokenKey length] * [tokenSecret length] && ![DL_TOKEN_SECRET isEqualToString: tokenSecret]);
 
-	header = OAuthHeader(
-		request.URL,
-		request.HTTPMethod,
-		nil, // body (parsed for extra query parameters)
-		consumerKey,
-		consumerSecret,
-		tokenKey, // oauth_token
-		tokenSecret, // oauth_token_secret
-		nil, // oauth_verifier
-		nil, // callback
-		OAuthCoreSignatureMethod_HMAC_SHA256);
+	header = [[self signer] authorizationHeaderForURL: request.URL method: request.HTTPMethod];
 
     [request setValue: header forHTTPHeaderField: @"Authorization"];
 }
@@ -785,7 +874,7 @@ static OBPSessionArray* sSessions = nil;
 }
 - (void)addAuthorizationHeader2ToSTHTTPRequest:(STHTTPRequest*)request
 {
-	NSDictionary*			d = _serverInfo.accessData;
+	NSDictionary*			d = [self credentials];
 	NSString*				tokenKey = d[OBPServerInfo_TokenKey];
 	NSString*				tokenSecret = d[OBPServerInfo_TokenSecret];
 	NSString*				header;
@@ -798,7 +887,7 @@ static OBPSessionArray* sSessions = nil;
 }
 - (void)addAuthorizationHeader2ToURLRequest:(NSMutableURLRequest*)request
 {
-	NSDictionary*			d = _serverInfo.accessData;
+	NSDictionary*			d = [self credentials];
 	NSString*				tokenKey = d[OBPServerInfo_TokenKey];
 	NSString*				tokenSecret = d[OBPServerInfo_TokenSecret];
 	NSString*				header;
@@ -0,0 +1,79 @@
+//
+//  OBPTransport.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OBPMetrics.h"
+#import "OBPRateController.h"
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+extern NSString* const	OBPTransportErrorDomain; ///< Domain of errors for responses with an HTTP status of 400 or more; the error code is the HTTP status.
+extern NSString* const	OBPTransportErrorRetryAfterKey; ///< Key in the userInfo of an error in OBPTransportErrorDomain for an NSNumber giving the seconds the server asked the client to wait, through Retry-After, before trying again.
+
+
+
+typedef NS_ENUM(uint8_t, OBPTransportPriority)
+{
+	OBPTransportPriorityBackground,		///< For bulk work the user is not waiting on, e.g. background sync. Never uses the slot reserved for interactive requests.
+	OBPTransportPriorityDefault,		///< For ordinary requests. This is the default.
+	OBPTransportPriorityInteractive,	///< For requests the user is waiting on. Dispatched ahead of all other waiting requests, and may use the slot reserved for interactive requests.
+
+	OBPTransportPriority_count
+};
+
+
+
+typedef void(^HandleOBPTransportResponse)(NSHTTPURLResponse* _Nullable response, NSData* _Nullable data, NSError* _Nullable error); // (response, data, error)
+typedef void(^HandleOBPTransportData)(NSHTTPURLResponse* response, NSData* data); // (response, data)
+
+
+
+/// An OBPTransportTask instance represents one request submitted to an OBPTransport, whether still waiting to be dispatched or running.
+@interface OBPTransportTask : NSObject
+@property (nonatomic, strong, readonly) NSURLRequest* request; ///< The request as submitted.
+@property (nonatomic, readonly) OBPTransportPriority priority; ///< The priority class of the request.
+- (void)cancel; ///< Cancel the request. If it is waiting it is removed from its queue, and if running its network task is cancelled; either way its response handler is called with NSURLErrorCancelled. Has no effect once the handler has been called.
+@end
+
+
+
+/**	An OBPTransport instance sends requests to one OBP server over a single NSURLSession, so that connections are kept alive and TLS sessions reused, while limiting how many requests are in progress at once and dispatching waiting requests in order of priority.
+
+	Each OBPSession instance owns a transport, which its OBPMarshal uses for all requests. You can submit your own authorised requests to it as well, so that they take their turn alongside the marshal's.
+
+	When more requests are submitted than may run at once, the excess wait in a queue per priority class and are dispatched highest priority first, and first-in first-out within a class. One slot is reserved for OBPTransportPriorityInteractive requests (when maxConcurrentRequests is at least two), so that a burst of background work can never fully occupy the connection.
+
+	The number of requests actually allowed in progress is further adapted by the transport's rateController, which cuts it when the server refuses requests for load (429, 503), times out or slows down, raises it again as requests succeed, and holds all dispatch while the server has asked, through Retry-After, that clients wait.
+
+	Response handlers are called on the main queue, unless you ask for another queue.
+*/
+@interface OBPTransport : NSObject
+- (instancetype)initWithConfiguration:(nullable NSURLSessionConfiguration*)configuration maxConcurrentRequests:(NSUInteger)maxConcurrentRequests; ///< Designated initialiser. \param configuration gives the session configuration to use; if nil, a copy of the default configuration is used. \param maxConcurrentRequests gives the number of requests that may be in progress at once; this is also applied as the configuration's HTTPMaximumConnectionsPerHost.
+
+@property (atomic, assign) NSUInteger maxConcurrentRequests; ///< Get/set the greatest number of requests that may be in progress at once (minimum 1); the rateController may allow fewer. Raising the limit dispatches waiting requests immediately; lowering it lets running requests finish.
+@property (atomic, readonly) NSUInteger runningCount; ///< Get the number of requests currently in progress.
+@property (atomic, readonly) NSUInteger waitingCount; ///< Get the number of requests waiting to be dispatched.
+@property (nonatomic, strong, readonly) OBPRateController* rateController; ///< Get the controller that adapts the number of requests in progress, up to maxConcurrentRequests, to the server's load; inspect its limit and state, or disable it.
+
+- (nullable OBPTransportTask*)sendRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority responseHandler:(HandleOBPTransportResponse)handler; ///< Submit an already authorised request to be sent when its turn comes. \param handler is called once on the main queue with the response and the complete body data, or with an error if the request failed in transit or was cancelled; responses with any status are passed to the handler without error. \returns a task that can be used to cancel the request, or nil if the transport has been invalidated.
+- (nullable OBPTransportTask*)sendRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority handlerQueue:(nullable dispatch_queue_t)queue responseHandler:(HandleOBPTransportResponse)handler; ///< As -sendRequest:priority:responseHandler:, but call handler on queue (the main queue when nil), e.g. so that the response can be decoded without first passing through the main thread.
+- (nullable OBPTransportTask*)sendRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority handlerQueue:(nullable dispatch_queue_t)queue metrics:(nullable OBPRequestMetrics*)metrics responseHandler:(HandleOBPTransportResponse)handler; ///< As -sendRequest:priority:handlerQueue:responseHandler:, and also fill in the queue wait, time to first byte, transfer time, body size and status of metrics before calling handler. Recording the metrics is left to the caller.
+- (nullable OBPTransportTask*)sendRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority handlerQueue:(nullable dispatch_queue_t)queue metrics:(nullable OBPRequestMetrics*)metrics dataHandler:(nullable HandleOBPTransportData)dataHandler responseHandler:(HandleOBPTransportResponse)handler; ///< As -sendRequest:priority:handlerQueue:metrics:responseHandler:, but when the response has an HTTP status below 400, pass each piece of its body to dataHandler as it arrives instead of collecting it, and then call handler with empty data; the body of any other response is collected and passed to handler as usual. Both handlers are called on queue, which should be serial so that the pieces are handled in order.
+
+- (void)invalidate; ///< Cancel all waiting and running requests and release the underlying NSURLSession. The transport cannot be used afterwards.
+
++ (nullable NSError*)errorForResponse:(NSHTTPURLResponse*)response data:(nullable NSData*)data; ///< Return an error in OBPTransportErrorDomain for a response with HTTP status 400 or more, with a description including the server's own description of the error when available, or nil for any other status.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,361 @@
+//
+//  OBPTransport.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPTransport.h"
+// prj
+#import "OBPLogging.h"
+#import "STHTTPRequest+Error.h"
+
+
+
+NSString* const OBPTransportErrorDomain = @"OBPTransport";
+NSString* const OBPTransportErrorRetryAfterKey = @"retryAfter";
+
+
+
+#pragma mark -
+@interface OBPTransportTask ()
+{
+@public
+	OBPTransport __weak*		_transport;
+	HandleOBPTransportResponse	_handler;		// nil once called
+	HandleOBPTransportData		_dataHandler;	// nil unless streaming requested
+	dispatch_queue_t			_handlerQueue;
+	NSURLSessionDataTask*		_dataTask;		// nil while waiting
+	NSMutableData*				_data;			// nil while streaming
+	NSUInteger					_bodyBytes;
+	BOOL						_streaming;		// body pieces are passed to _dataHandler as they arrive
+	NSHTTPURLResponse*			_response;
+	OBPRequestMetrics*			_metrics;
+	NSTimeInterval				_submittedAt;
+	NSTimeInterval				_startedAt;
+	NSTimeInterval				_respondedAt;
+}
+- (instancetype)initWithRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority queue:(dispatch_queue_t)queue handler:(HandleOBPTransportResponse)handler transport:(OBPTransport*)transport;
+@end
+
+
+
+@interface OBPTransport () <NSURLSessionDataDelegate>
+- (void)cancelTask:(OBPTransportTask*)task;
+@end
+
+
+
+#pragma mark -
+@implementation OBPTransportTask
+- (instancetype)initWithRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority queue:(dispatch_queue_t)queue handler:(HandleOBPTransportResponse)handler transport:(OBPTransport*)transport
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_request = [request copy];
+	_priority = priority < OBPTransportPriority_count ? priority : OBPTransportPriorityDefault;
+	_handler = handler;
+	_handlerQueue = queue ?: dispatch_get_main_queue();
+	_transport = transport;
+	_submittedAt = OBPMonotonicTime();
+	return self;
+}
+- (void)cancel
+{
+	[_transport cancelTask: self];
+}
+@end
+
+
+
+#pragma mark -
+@implementation OBPTransport
+{
+	dispatch_queue_t								_queue;			// serialises all state below, and is the session's delegate queue
+	NSURLSession*									_session;
+	NSMutableArray<OBPTransportTask*>*				_waiting[OBPTransportPriority_count];
+	NSMutableDictionary<NSNumber*,OBPTransportTask*>*	_running;		// by data task identifier
+	NSUInteger										_maxConcurrentRequests;
+	BOOL											_invalidated;
+	BOOL											_resumeScheduled;	// a dispatch is due when the rate controller's pause ends
+}
+- (instancetype)init
+{
+	return [self initWithConfiguration: nil maxConcurrentRequests: 4];
+}
+- (instancetype)initWithConfiguration:(NSURLSessionConfiguration*)configuration maxConcurrentRequests:(NSUInteger)maxConcurrentRequests
+{
+	if (nil == (self = [super init]))
+		return nil;
+
+	NSOperationQueue*		delegateQueue;
+	NSUInteger				i;
+
+	_maxConcurrentRequests = MAX(1, maxConcurrentRequests);
+	_queue = dispatch_queue_create("com.tesobe.OBPKit.OBPTransport", DISPATCH_QUEUE_SERIAL);
+	delegateQueue = [[NSOperationQueue alloc] init];
+	delegateQueue.maxConcurrentOperationCount = 1;
+	delegateQueue.underlyingQueue = _queue;
+
+	configuration = configuration ? [configuration copy] : [NSURLSessionConfiguration defaultSessionConfiguration];
+	configuration.HTTPMaximumConnectionsPerHost = _maxConcurrentRequests;
+	configuration.HTTPShouldUsePipelining = NO;
+	_session = [NSURLSession sessionWithConfiguration: configuration delegate: self delegateQueue: delegateQueue];
+
+	for (i = 0; i < OBPTransportPriority_count; i++)
+		_waiting[i] = [NSMutableArray array];
+	_running = [NSMutableDictionary dictionary];
+	_rateController = [[OBPRateController alloc] initWithMaxLimit: _maxConcurrentRequests];
+
+	return self;
+}
+#pragma mark -
+- (NSUInteger)maxConcurrentRequests
+{
+	__block NSUInteger n;
+	dispatch_sync(_queue, ^{n = self->_maxConcurrentRequests;});
+	return n;
+}
+- (void)setMaxConcurrentRequests:(NSUInteger)maxConcurrentRequests
+{
+	dispatch_async(_queue, ^{
+		self->_maxConcurrentRequests = MAX(1, maxConcurrentRequests);
+		self->_rateController.maxLimit = self->_maxConcurrentRequests;
+		[self dispatchWaiting];
+	});
+}
+- (NSUInteger)runningCount
+{
+	__block NSUInteger n;
+	dispatch_sync(_queue, ^{n = [self->_running count];});
+	return n;
+}
+- (NSUInteger)waitingCount
+{
+	__block NSUInteger n = 0;
+	dispatch_sync(_queue, ^{
+		for (NSUInteger i = 0; i < OBPTransportPriority_count; i++)
+			n += [self->_waiting[i] count];
+	});
+	return n;
+}
+#pragma mark -
+- (OBPTransportTask*)sendRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority responseHandler:(HandleOBPTransportResponse)handler
+{
+	return [self sendRequest: request priority: priority handlerQueue: nil responseHandler: handler];
+}
+- (OBPTransportTask*)sendRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority handlerQueue:(dispatch_queue_t)queue responseHandler:(HandleOBPTransportResponse)handler
+{
+	return [self sendRequest: request priority: priority handlerQueue: queue metrics: nil responseHandler: handler];
+}
+- (OBPTransportTask*)sendRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority handlerQueue:(dispatch_queue_t)queue metrics:(OBPRequestMetrics*)metrics responseHandler:(HandleOBPTransportResponse)handler
+{
+	return [self sendRequest: request priority: priority handlerQueue: queue metrics: metrics dataHandler: nil responseHandler: handler];
+}
+- (OBPTransportTask*)sendRequest:(NSURLRequest*)request priority:(OBPTransportPriority)priority handlerQueue:(dispatch_queue_t)queue metrics:(OBPRequestMetrics*)metrics dataHandler:(HandleOBPTransportData)dataHandler responseHandler:(HandleOBPTransportResponse)handler
+{
+	if (!request || !handler || _invalidated)
+		return nil;
+	OBPTransportTask* task = [[OBPTransportTask alloc] initWithRequest: request priority: priority queue: queue handler: handler transport: self];
+	task->_metrics = metrics;
+	task->_dataHandler = dataHandler;
+	dispatch_async(_queue, ^{
+		if (self->_invalidated)
+			{[self finishTask: task response: nil data: nil error: [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorCancelled userInfo: nil]]; return;}
+		[self->_waiting[task.priority] addObject: task];
+		[self dispatchWaiting];
+	});
+	return task;
+}
+- (void)cancelTask:(OBPTransportTask*)task
+{
+	dispatch_async(_queue, ^{
+		if (task->_dataTask)
+			[task->_dataTask cancel]; // ...completes through -URLSession:task:didCompleteWithError:
+		else
+		if (task->_handler)
+		{
+			[self->_waiting[task.priority] removeObjectIdenticalTo: task];
+			[self finishTask: task response: nil data: nil error: [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorCancelled userInfo: nil]];
+		}
+	});
+}
+- (void)invalidate
+{
+	dispatch_async(_queue, ^{
+		if (self->_invalidated)
+			return;
+		self->_invalidated = YES;
+		NSError* error = [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorCancelled userInfo: nil];
+		for (NSUInteger i = 0; i < OBPTransportPriority_count; i++)
+		{
+			for (OBPTransportTask* task in self->_waiting[i])
+				[self finishTask: task response: nil data: nil error: error];
+			[self->_waiting[i] removeAllObjects];
+		}
+		[self->_session invalidateAndCancel];
+	});
+}
+#pragma mark -
+- (OBPTransportTask*)nextWaitingTask // called on _queue
+{
+	NSUInteger			running = [_running count];
+	NSUInteger			limit = MIN(_maxConcurrentRequests, _rateController.effectiveLimit);
+	NSTimeInterval		pause;
+	NSInteger			i;
+	OBPTransportTask*	task;
+
+	if (running >= limit)
+		return nil;
+
+	// Hold everything while the server has asked us to wait, and look again when it is over
+	if ((pause = _rateController.pauseRemaining) > 0)
+	{
+		if (!_resumeScheduled)
+		{
+			_resumeScheduled = YES;
+			dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(pause * NSEC_PER_SEC)), _queue, ^{
+				self->_resumeScheduled = NO;
+				[self dispatchWaiting];
+			});
+		}
+		return nil;
+	}
+
+	// Keep the last free slot for interactive requests
+	BOOL lastSlot = running + 1 == limit && limit > 1;
+
+	for (i = OBPTransportPriority_count - 1; i >= 0; i--)
+	{
+		if (lastSlot && i != OBPTransportPriorityInteractive)
+			break;
+		if (nil != (task = [_waiting[i] firstObject]))
+		{
+			[_waiting[i] removeObjectAtIndex: 0];
+			return task;
+		}
+	}
+	return nil;
+}
+- (void)dispatchWaiting // called on _queue
+{
+	OBPTransportTask*		task;
+	NSURLSessionDataTask*	dataTask;
+
+	while (!_invalidated && nil != (task = [self nextWaitingTask]))
+	{
+		dataTask = [_session dataTaskWithRequest: task.request];
+		if (!dataTask)
+		{
+			[self finishTask: task response: nil data: nil error: [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorBadURL userInfo: nil]];
+			continue;
+		}
+		if ([dataTask respondsToSelector: @selector(setPriority:)])
+			dataTask.priority = task.priority == OBPTransportPriorityInteractive ? NSURLSessionTaskPriorityHigh
+							  : task.priority == OBPTransportPriorityBackground ? NSURLSessionTaskPriorityLow
+							  : NSURLSessionTaskPriorityDefault;
+		task->_dataTask = dataTask;
+		task->_startedAt = OBPMonotonicTime();
+		_running[@(dataTask.taskIdentifier)] = task;
+		[dataTask resume];
+	}
+}
+- (void)finishTask:(OBPTransportTask*)task response:(NSHTTPURLResponse*)response data:(NSData*)data error:(NSError*)error // called on _queue
+{
+	HandleOBPTransportResponse handler = task->_handler;
+	OBPRequestMetrics* metrics = task->_metrics;
+	NSTimeInterval now;
+	if (!handler)
+		return;
+	if (metrics)
+	{
+		now = OBPMonotonicTime();
+		metrics.queueWait = (task->_startedAt ?: now) - task->_submittedAt;
+		if (task->_respondedAt)
+		{
+			metrics.timeToFirstByte = task->_respondedAt - task->_startedAt;
+			metrics.transfer = now - task->_respondedAt;
+			metrics.bodyBytes = task->_bodyBytes;
+		}
+		metrics.statusCode = response.statusCode;
+		task->_metrics = nil;
+	}
+	task->_handler = nil;
+	task->_dataHandler = nil;
+	task->_data = nil;
+	task->_response = nil;
+	dispatch_async(task->_handlerQueue, ^{
+		handler(response, data, error);
+	});
+}
+#pragma mark - NSURLSessionDataDelegate
+- (void)URLSession:(NSURLSession*)session dataTask:(NSURLSessionDataTask*)dataTask didReceiveResponse:(NSURLResponse*)response completionHandler:(void (^)(NSURLSessionResponseDisposition))completionHandler
+{
+	OBPTransportTask* task = _running[@(dataTask.taskIdentifier)];
+	task->_respondedAt = OBPMonotonicTime();
+	if ([response isKindOfClass: [NSHTTPURLResponse class]])
+		task->_response = (NSHTTPURLResponse*)response;
+	if (task->_dataHandler && task->_response.statusCode < 400)
+	{
+		task->_streaming = YES;
+		completionHandler(NSURLSessionResponseAllow);
+		return;
+	}
+	long long expected = response.expectedContentLength;
+	task->_data = [NSMutableData dataWithCapacity: expected > 0 && expected < (1 << 26) ? (NSUInteger)expected : 0];
+	completionHandler(NSURLSessionResponseAllow);
+}
+- (void)URLSession:(NSURLSession*)session dataTask:(NSURLSessionDataTask*)dataTask didReceiveData:(NSData*)data
+{
+	OBPTransportTask* task = _running[@(dataTask.taskIdentifier)];
+	task->_bodyBytes += [data length];
+	if (task->_streaming)
+	{
+		HandleOBPTransportData dataHandler = task->_dataHandler;
+		NSHTTPURLResponse* response = task->_response;
+		if (dataHandler)
+			dispatch_async(task->_handlerQueue, ^{dataHandler(response, data);});
+		return;
+	}
+	if (!task->_data)
+		task->_data = [NSMutableData data];
+	[task->_data appendData: data];
+}
+- (void)URLSession:(NSURLSession*)session task:(NSURLSessionTask*)dataTask didCompleteWithError:(NSError*)error
+{
+	NSNumber*			key = @(dataTask.taskIdentifier);
+	OBPTransportTask*	task = _running[key];
+	if (!task)
+		return;
+	[_running removeObjectForKey: key];
+	task->_dataTask = nil;
+	[_rateController recordResponse: error ? nil : task->_response latency: task->_respondedAt ? task->_respondedAt - task->_startedAt : NAN error: error];
+	[self finishTask: task response: error ? nil : task->_response data: error ? nil : task->_data ?: [NSData data] error: error]; // ...handing over the body as collected, as the task has finished with it
+	[self dispatchWaiting];
+}
+- (void)URLSession:(NSURLSession*)session didBecomeInvalidWithError:(NSError*)error
+{
+	OBP_LOG_IF(error, @"[OBPTransport URLSession: didBecomeInvalidWithError: %@]", error);
+}
+#pragma mark -
++ (NSError*)errorForResponse:(NSHTTPURLResponse*)response data:(NSData*)data
+{
+	NSInteger				status = response.statusCode;
+	NSMutableDictionary*	userInfo;
+	NSTimeInterval			retryAfter;
+	NSError*				error;
+
+	if (status < 400)
+		return nil;
+
+	userInfo = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+					[NSHTTPURLResponse localizedStringForStatusCode: status], NSLocalizedDescriptionKey,
+					response.URL ?: [NSNull null], NSURLErrorKey,
+					nil];
+	if ((retryAfter = [OBPRateController retryAfterForResponse: response]) > 0)
+		userInfo[OBPTransportErrorRetryAfterKey] = @(retryAfter);
+	error = [NSError errorWithDomain: OBPTransportErrorDomain code: status userInfo: userInfo];
+	return OBPErrorByAddingServerSideDescription(error, response.allHeaderFields, data);
+}
+@end
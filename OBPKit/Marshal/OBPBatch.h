@@ -0,0 +1,63 @@
+//
+//  OBPBatch.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+@class OBPMarshal;
+
+
+
+typedef NSArray<NSString*>* _Nullable (^OBPBatchDerivePaths)(NSDictionary<NSString*,id>* parentResults); // (parentResults) -> paths
+typedef void(^HandleOBPBatchCompletion)(NSDictionary<NSString*,id>* results, NSDictionary<NSString*,NSError*>* errors); // (results, errors)
+
+
+
+/**	An OBPBatchRequest instance describes one node of a batch: either a get request for a fixed path, or a set of get requests whose paths are derived from the results of other nodes, its parents, once they have all finished.
+
+	The result of a node with a fixed path is the deserialized object for that path (NSNull if the response had no body). The result of a node with derived paths is an NSArray holding the deserialized object for each derived path in the order the paths were given, with NSNull in place of any request that failed.
+*/
+@interface OBPBatchRequest : NSObject
++ (instancetype)requestNamed:(NSString*)name path:(NSString*)path options:(nullable NSDictionary*)options; ///< Get the resource at path. \param name identifies the node within its batch, and keys its result and error. \param options may supply the usual OBPMarshal options for this node, which take precedence over those given for the whole batch.
++ (instancetype)requestNamed:(NSString*)name after:(NSArray<NSString*>*)parentNames options:(nullable NSDictionary*)options paths:(OBPBatchDerivePaths)derivePaths; ///< Once the nodes named in parentNames have finished, call derivePaths on the main queue with a dictionary of their results by name, and get the resources at the paths it returns, e.g. the accounts of each bank in a parent's list of banks. Returning nil or no paths gives the node an empty array as its result.
+@property (nonatomic, copy, readonly) NSString* name;
+@property (nonatomic, copy, readonly) NSArray<NSString*>* parentNames;
+@property (nonatomic, copy, readonly, nullable) NSString* path; ///< nil when paths are derived.
+@property (nonatomic, copy, readonly, nullable) NSDictionary* options;
+@property (nonatomic, copy, readonly, nullable) OBPBatchDerivePaths derivePaths;
+@end
+
+
+
+/**	An OBPBatch instance runs a set of get requests that may depend on each other's results, such as banks → accounts of each bank → transactions of each account, sending every request as soon as the results it depends on are available, with at most maxConcurrentRequests in flight at once. A screen's worth of resources thereby arrives in the fewest possible waves of round trips.
+
+	A node fails if its request fails, or, for a node with derived paths, if every one of its requests fails; the nodes that depend on a failed node are not run, and fail with OBPMarshalErrorDependencyFailed, which carries the parent's error as NSUnderlyingErrorKey. A node with derived paths that succeeds in part has the error of its first failed request in errors, as well as its result.
+
+	The completion handler is called exactly once, when every node has finished, with the result of each node that succeeded and the error of each node that failed, by node name. Cancelling gives each unfinished node the error NSUserCancelledError.
+
+	Obtain an instance through -[OBPMarshal getResourcesInBatch:withOptions:completion:]. A running batch keeps itself alive until completion, and all handlers are called on the main queue; call -cancel from the main queue too.
+*/
+@interface OBPBatch : NSObject
+- (nullable instancetype)initWithMarshal:(OBPMarshal*)marshal requests:(NSArray<OBPBatchRequest*>*)requests options:(nullable NSDictionary*)options completion:(HandleOBPBatchCompletion)completion; ///< Designated initialiser. \param requests must have unique names and only name parents within the batch, without cycles; otherwise nil is returned. \param options may supply the usual OBPMarshal options as defaults for every node, plus OBPMarshalOptionBatchConcurrency.
+
+@property (nonatomic, readonly) NSUInteger maxConcurrentRequests; ///< Maximum number of requests in flight at once (OBPMarshalOptionBatchConcurrency; default 4).
+@property (nonatomic, readonly) NSUInteger requestCount; ///< Number of requests sent so far.
+@property (nonatomic, readonly) BOOL finished; ///< YES once the completion handler has been called.
+
+- (BOOL)start; ///< Start sending requests. \returns NO if the batch was already started.
+- (void)cancel; ///< Stop sending requests, cancel the requests still in flight, and call the completion handler. Has no effect once finished.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
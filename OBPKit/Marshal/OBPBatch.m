@@ -0,0 +1,346 @@
+//
+//  OBPBatch.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPBatch.h"
+// prj
+#import "OBPMarshal.h"
+#import "OBPLogging.h"
+
+
+
+#define kOBPBatchDefaultConcurrency		4
+
+
+
+@implementation OBPBatchRequest
++ (instancetype)requestNamed:(NSString*)name path:(NSString*)path options:(NSDictionary*)options
+{
+	OBPBatchRequest* request = [[self alloc] init];
+	request->_name = [name copy];
+	request->_parentNames = @[];
+	request->_path = [path copy];
+	request->_options = [options copy];
+	return request;
+}
++ (instancetype)requestNamed:(NSString*)name after:(NSArray<NSString*>*)parentNames options:(NSDictionary*)options paths:(OBPBatchDerivePaths)derivePaths
+{
+	OBPBatchRequest* request = [[self alloc] init];
+	request->_name = [name copy];
+	request->_parentNames = [parentNames copy] ?: @[];
+	request->_options = [options copy];
+	request->_derivePaths = [derivePaths copy];
+	return request;
+}
+- (NSString*)description
+{
+	return [NSString stringWithFormat: @"<%@ %@ %@>", NSStringFromClass([self class]), _name, _path ?: [@"after " stringByAppendingString: [_parentNames componentsJoinedByString: @","]]];
+}
+@end
+
+
+
+#pragma mark -
+@interface OBPBatchNode : NSObject
+{
+@public
+	OBPBatchRequest*		_request;
+	NSMutableArray*			_results;		// one per derived path
+	NSUInteger				_outstanding;	// requests not yet finished
+	NSUInteger				_succeeded;
+}
+@end
+@implementation OBPBatchNode
+@end
+
+
+
+#pragma mark -
+@implementation OBPBatch
+{
+	OBPMarshal*									_marshal;
+	NSArray<OBPBatchRequest*>*					_requests;
+	NSDictionary*								_options;
+	HandleOBPBatchCompletion					_completion;
+	NSMutableArray<OBPBatchRequest*>*			_pending;		// waiting for parents to finish
+	NSMutableArray<NSArray*>*					_ready;			// @[node, path, index] waiting for a free slot
+	NSMutableDictionary<NSString*,OBPBatchNode*>*	_running;		// by name
+	NSMutableSet<NSString*>*					_done;
+	NSMutableDictionary<NSString*,id>*			_results;
+	NSMutableDictionary<NSString*,NSError*>*	_errors;
+	NSMutableArray<OBPMarshalRequest*>*			_outstanding;	// requests awaiting their response
+	NSUInteger									_inFlight;
+	BOOL										_started;
+	OBPBatch*									_keepAlive;
+}
+- (instancetype)initWithMarshal:(OBPMarshal*)marshal requests:(NSArray<OBPBatchRequest*>*)requests options:(NSDictionary*)options completion:(HandleOBPBatchCompletion)completion
+{
+	if (!marshal || !completion || ![self.class validateRequests: requests])
+		{self = nil; return nil;}
+	if (nil == (self = [super init]))
+		return nil;
+
+	id						obj;
+	NSMutableDictionary*	md;
+
+	_marshal = marshal;
+	_requests = [requests copy];
+	_completion = completion;
+	_pending = [_requests mutableCopy];
+	_ready = [NSMutableArray array];
+	_running = [NSMutableDictionary dictionary];
+	_done = [NSMutableSet set];
+	_results = [NSMutableDictionary dictionary];
+	_errors = [NSMutableDictionary dictionary];
+	_outstanding = [NSMutableArray array];
+
+	_maxConcurrentRequests = kOBPBatchDefaultConcurrency;
+	obj = options[OBPMarshalOptionBatchConcurrency];
+	if ([obj respondsToSelector: @selector(unsignedIntegerValue)] && [obj unsignedIntegerValue])
+		_maxConcurrentRequests = [obj unsignedIntegerValue];
+
+	md = [(options ?: @{}) mutableCopy];
+	[md removeObjectForKey: OBPMarshalOptionBatchConcurrency];
+	md[OBPMarshalOptionResultQueue] = dispatch_get_main_queue(); // ...our state is only touched on the main queue, whatever the marshal's resultQueue
+	if (!md[OBPMarshalOptionOmitResponseBody])
+		md[OBPMarshalOptionOmitResponseBody] = @YES; // ...only the deserialized objects are used
+	_options = [md copy];
+
+	return self;
+}
++ (BOOL)validateRequests:(NSArray<OBPBatchRequest*>*)requests
+{
+	NSMutableDictionary<NSString*,OBPBatchRequest*>*	byName = [NSMutableDictionary dictionary];
+	NSMutableSet<NSString*>*							resolved = [NSMutableSet set];
+	OBPBatchRequest*									request;
+	NSString*											name;
+	BOOL												progress = YES;
+
+	for (request in requests)
+	{
+		if (![request isKindOfClass: [OBPBatchRequest class]] || ![request.name length] || byName[request.name]
+		 || (![request.path length] && !request.derivePaths))
+		{
+			OBP_LOG(@"[OBPBatch validateRequests:] invalid or duplicate request %@", request);
+			return NO;
+		}
+		byName[request.name] = request;
+	}
+	for (request in requests)
+	for (name in request.parentNames)
+	if (!byName[name])
+	{
+		OBP_LOG(@"[OBPBatch validateRequests:] %@ depends on unknown request %@", request, name);
+		return NO;
+	}
+
+	// Every request must be reachable in dependency order, i.e. there are no cycles
+	while (progress && [resolved count] < [requests count])
+	{
+		progress = NO;
+		for (request in requests)
+		if (![resolved containsObject: request.name] && [[NSSet setWithArray: request.parentNames] isSubsetOfSet: resolved])
+			[resolved addObject: request.name], progress = YES;
+	}
+	OBP_LOG_IF([resolved count] < [requests count], @"[OBPBatch validateRequests:] dependency cycle among %@", requests);
+	return [resolved count] == [requests count];
+}
+#pragma mark -
+- (BOOL)start
+{
+	if (_started)
+		return NO;
+	_started = YES;
+	_keepAlive = self;
+	[self advance];
+	return YES;
+}
+- (void)cancel
+{
+	if (_finished)
+		return;
+	NSError* error = [NSError errorWithDomain: NSCocoaErrorDomain code: NSUserCancelledError userInfo: nil];
+	for (OBPBatchRequest* request in _requests)
+		if (![_done containsObject: request.name])
+			_errors[request.name] = error;
+	[self finish];
+}
+- (void)finish
+{
+	if (_finished)
+		return;
+	_finished = YES;
+	[_pending removeAllObjects];
+	[_ready removeAllObjects];
+	[_running removeAllObjects];
+	// Requests still in flight when cancelled are no longer wanted, so free their transport slots
+	NSArray<OBPMarshalRequest*>* outstanding = [_outstanding copy];
+	[_outstanding removeAllObjects];
+	[outstanding makeObjectsPerformSelector: @selector(cancel)];
+	HandleOBPBatchCompletion completion = _completion;
+	_completion = nil;
+	completion([_results copy], [_errors copy]);
+	_keepAlive = nil;
+}
+#pragma mark -
+- (void)advance
+{
+	NSArray*		item;
+	BOOL			progress;
+
+	do
+	{
+		progress = [self promotePending];
+		while (!_finished && _inFlight < _maxConcurrentRequests && nil != (item = [_ready firstObject]))
+		{
+			[_ready removeObjectAtIndex: 0];
+			if (![self launch: item])
+				progress = YES; // ...its node may now be done
+		}
+	}
+	while (!_finished && progress);
+
+	if (!_finished && !_inFlight && ![_ready count] && ![_pending count])
+		[self finish];
+}
+- (BOOL)promotePending
+{
+	OBPBatchRequest*		request;
+	OBPBatchNode*			node;
+	NSString*				name;
+	NSMutableDictionary*	parentResults;
+	NSArray<NSString*>*		paths;
+	NSError*				parentError;
+	NSUInteger				i;
+	BOOL					progress = NO;
+
+	for (request in [_pending copy])
+	{
+		if (![[NSSet setWithArray: request.parentNames] isSubsetOfSet: _done])
+			continue;
+		[_pending removeObjectIdenticalTo: request];
+		progress = YES;
+
+		parentResults = [NSMutableDictionary dictionary];
+		parentError = nil;
+		for (name in request.parentNames)
+		{
+			if (!_results[name])
+				{parentError = _errors[name]; break;}
+			parentResults[name] = _results[name];
+		}
+		if (parentError)
+		{
+			_errors[request.name] = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorDependencyFailed
+													userInfo: @{NSLocalizedDescriptionKey : @"A request this request depends on failed.",
+																NSUnderlyingErrorKey : parentError}];
+			[_done addObject: request.name];
+			continue;
+		}
+
+		paths = request.path ? @[request.path] : request.derivePaths(parentResults);
+		if (![paths count])
+		{
+			_results[request.name] = @[];
+			[_done addObject: request.name];
+			continue;
+		}
+
+		node = [[OBPBatchNode alloc] init];
+		node->_request = request;
+		node->_outstanding = [paths count];
+		if (!request.path)
+		{
+			node->_results = [NSMutableArray arrayWithCapacity: [paths count]];
+			for (i = 0; i < [paths count]; i++)
+				[node->_results addObject: [NSNull null]];
+		}
+		_running[request.name] = node;
+		for (i = 0; i < [paths count]; i++)
+			[_ready addObject: @[node, paths[i], @(i)]];
+	}
+
+	return progress;
+}
+- (BOOL)launch:(NSArray*)item
+{
+	OBPBatchNode*			node = item[0];
+	NSString*				path = item[1];
+	NSUInteger				index = [item[2] unsignedIntegerValue];
+	NSMutableDictionary*	options = [_options mutableCopy];
+	__block OBPMarshalRequest*	request;
+
+	[options addEntriesFromDictionary: node->_request.options ?: @{}];
+	options[OBPMarshalOptionResultQueue] = dispatch_get_main_queue();
+
+	// Handlers are called later on the main queue, by when request has been set
+	request =
+		[_marshal startGetResourceAtAPIPath: path
+								withOptions: options
+						   forResultHandler:
+							^(id deserializedObject, NSString* responseBody) {
+								[self->_outstanding removeObjectIdenticalTo: request];
+								request = nil;
+								[self finishedItemOfNode: node index: index result: deserializedObject ?: [NSNull null] error: nil];
+							}
+							 orErrorHandler:
+							^(NSError* error, NSString* path) {
+								[self->_outstanding removeObjectIdenticalTo: request];
+								request = nil;
+								[self finishedItemOfNode: node index: index result: nil error: error];
+							}];
+
+	if (request)
+	{
+		[_outstanding addObject: request];
+		_inFlight++;
+		_requestCount++;
+		return YES;
+	}
+
+	OBP_LOG(@"[OBPBatch launch:] could not launch request for %@ of %@", path, node->_request.name);
+	[self finishItemOfNode: node index: index result: nil
+					 error: [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResult
+											userInfo: @{NSLocalizedDescriptionKey : @"Unable to launch request."}]];
+	return NO;
+}
+- (void)finishedItemOfNode:(OBPBatchNode*)node index:(NSUInteger)index result:(id)result error:(NSError*)error
+{
+	if (_finished)
+		return; // ...cancelled
+	_inFlight--;
+	[self finishItemOfNode: node index: index result: result error: error];
+	[self advance];
+}
+- (void)finishItemOfNode:(OBPBatchNode*)node index:(NSUInteger)index result:(id)result error:(NSError*)error
+{
+	NSString*		name = node->_request.name;
+
+	if (error)
+	{
+		if (!_errors[name])
+			_errors[name] = error;
+	}
+	else
+	{
+		node->_succeeded++;
+		if (node->_results)
+			node->_results[index] = result;
+		else
+			_results[name] = result;
+	}
+
+	if (--node->_outstanding)
+		return;
+
+	// All of the node's requests have finished
+	if (node->_results && node->_succeeded)
+		_results[name] = [node->_results copy];
+	[_running removeObjectForKey: name];
+	[_done addObject: name];
+}
+@end
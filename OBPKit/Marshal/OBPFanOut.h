@@ -0,0 +1,52 @@
+//
+//  OBPFanOut.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+@class OBPSession;
+@class OBPServerInfo;
+
+
+
+typedef void(^HandleOBPFanOutResult)(OBPServerInfo* serverInfo, id result); // (serverInfo, result)
+typedef void(^HandleOBPFanOutCompletion)(NSDictionary<NSString*,id>* results, NSDictionary<NSString*,NSError*>* errors); // (results, errors)
+
+
+
+/**	An OBPFanOut instance sends the same get request to several sessions at once, typically every valid session, each to its own server, so that aggregated views such as all accounts across all banks take as long as the slowest bank rather than the sum of them all.
+
+	Each session's result is passed to the result handler as soon as it arrives, tagged with the session's OBPServerInfo. If the options include OBPMarshalOptionStreamElementsKey, each session's response is streamed instead, and the result handler gets each run of elements as they arrive (an NSArray), so that rows from every bank appear as they are received; the result for the session is then the number of elements it delivered.
+
+	A deadline bounds the whole fan-out: sessions that have not answered by then fail with NSURLErrorTimedOut, and their requests are cancelled, so one slow bank cannot hold up the rest.
+
+	The completion handler is called exactly once, when every session has answered or failed, or at the deadline, with the result of each session that succeeded and the error of each that failed, keyed by OBPServerInfo key; a partial failure leaves the other sessions' results intact. Cancelling gives each unanswered session the error NSUserCancelledError.
+
+	A running fan-out keeps itself alive until completion, and all handlers are called on the main queue; call -cancel from the main queue too.
+*/
+@interface OBPFanOut : NSObject
++ (nullable instancetype)getResourceAtAPIPath:(NSString*)path fromAllSessionsWithOptions:(nullable NSDictionary*)options deadline:(NSTimeInterval)deadline forResultHandler:(nullable HandleOBPFanOutResult)resultHandler completion:(HandleOBPFanOutCompletion)completion; ///< Start a fan-out to every valid session in +[OBPSession allSessions] (or, with OBPMarshalOptionOnlyPublicResources, every session). \returns the started fan-out, which you can use to cancel, or nil if there are no such sessions or the parameters were invalid.
+- (nullable instancetype)initWithSessions:(NSArray<OBPSession*>*)sessions path:(NSString*)path options:(nullable NSDictionary*)options deadline:(NSTimeInterval)deadline resultHandler:(nullable HandleOBPFanOutResult)resultHandler completion:(HandleOBPFanOutCompletion)completion; ///< Designated initialiser. \param sessions gives the sessions to query, each through its own marshal. \param path identifies the resource, relative to each server's API base. \param options may supply the usual OBPMarshal options, applied to every session's request. \param deadline gives the seconds from -start after which unanswered sessions fail; pass zero for no deadline.
+
+@property (nonatomic, copy, readonly) NSArray<OBPSession*>* sessions;
+@property (nonatomic, readonly) NSTimeInterval deadline;
+@property (nonatomic, readonly) NSUInteger pendingCount; ///< Number of sessions yet to answer.
+@property (nonatomic, readonly) BOOL finished; ///< YES once the completion handler has been called.
+
+- (BOOL)start; ///< Send the request to every session. \returns NO if already started.
+- (void)cancel; ///< Stop waiting for sessions that have not answered, cancel their requests, and call the completion handler. Has no effect once finished.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
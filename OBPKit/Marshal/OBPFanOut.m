@@ -0,0 +1,205 @@
+//
+//  OBPFanOut.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPFanOut.h"
+// prj
+#import "OBPSession.h"
+#import "OBPServerInfo.h"
+#import "OBPMarshal.h"
+#import "OBPLogging.h"
+
+
+
+@implementation OBPFanOut
+{
+	NSString*									_path;
+	NSDictionary*								_options;
+	HandleOBPFanOutResult						_resultHandler;
+	HandleOBPFanOutCompletion					_completion;
+	NSMutableSet<NSString*>*					_pending;		// keys of the sessions yet to answer
+	NSMutableDictionary<NSString*,OBPMarshalRequest*>*	_requests;		// ...and their requests, by the same keys
+	NSMutableDictionary<NSString*,id>*			_results;
+	NSMutableDictionary<NSString*,NSError*>*	_errors;
+	BOOL										_started;
+	OBPFanOut*									_keepAlive;
+}
++ (instancetype)getResourceAtAPIPath:(NSString*)path fromAllSessionsWithOptions:(NSDictionary*)options deadline:(NSTimeInterval)deadline forResultHandler:(HandleOBPFanOutResult)resultHandler completion:(HandleOBPFanOutCompletion)completion
+{
+	BOOL				onlyPublic = [options[OBPMarshalOptionOnlyPublicResources] isEqual: @YES];
+	NSMutableArray*		sessions = [NSMutableArray array];
+	OBPSession*			session;
+	OBPFanOut*			fanOut;
+
+	for (session in [OBPSession allSessions])
+		if (session.valid || onlyPublic)
+			[sessions addObject: session];
+	fanOut = [[self alloc] initWithSessions: sessions path: path options: options deadline: deadline resultHandler: resultHandler completion: completion];
+	return [fanOut start] ? fanOut : nil;
+}
+- (instancetype)initWithSessions:(NSArray<OBPSession*>*)sessions path:(NSString*)path options:(NSDictionary*)options deadline:(NSTimeInterval)deadline resultHandler:(HandleOBPFanOutResult)resultHandler completion:(HandleOBPFanOutCompletion)completion
+{
+	if (![sessions count] || ![path length] || !completion)
+		{self = nil; return nil;}
+	if (nil == (self = [super init]))
+		return nil;
+
+	NSMutableDictionary*	md;
+
+	_sessions = [sessions copy];
+	_path = [path copy];
+	_deadline = MAX(0, deadline);
+	_resultHandler = resultHandler;
+	_completion = completion;
+	_pending = [NSMutableSet set];
+	_requests = [NSMutableDictionary dictionary];
+	_results = [NSMutableDictionary dictionary];
+	_errors = [NSMutableDictionary dictionary];
+
+	md = [(options ?: @{}) mutableCopy];
+	md[OBPMarshalOptionResultQueue] = dispatch_get_main_queue(); // ...our state is only touched on the main queue, whatever the marshal's resultQueue
+	[md removeObjectForKey: OBPMarshalOptionStreamElementHandler]; // ...each session's is our own
+	if (!md[OBPMarshalOptionOmitResponseBody])
+		md[OBPMarshalOptionOmitResponseBody] = @YES; // ...only the deserialized objects are used
+	_options = [md copy];
+
+	return self;
+}
+- (NSUInteger)pendingCount
+{
+	return [_pending count];
+}
+#pragma mark -
+- (BOOL)start
+{
+	if (_started)
+		return NO;
+	_started = YES;
+	_keepAlive = self;
+
+	OBPSession*			session;
+	NSString*			key;
+
+	for (session in _sessions)
+		if (nil != (key = session.serverInfo.key))
+			[_pending addObject: key];
+
+	for (session in _sessions)
+		[self launchForSession: session];
+
+	if (_deadline > 0 && !_finished)
+	{
+		__weak __typeof(self) self_ifStillRunning = self;
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_deadline * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+			[self_ifStillRunning passDeadline];
+		});
+	}
+	if (![_pending count])
+		[self finish];
+	return YES;
+}
+- (void)launchForSession:(OBPSession*)session
+{
+	OBPServerInfo*			serverInfo = session.serverInfo;
+	NSString*				key = serverInfo.key;
+	HandleOBPFanOutResult	resultHandler = _resultHandler;
+	NSDictionary*			options = _options;
+	OBPMarshalRequest*		request;
+
+	if (!key)
+		return;
+
+	// Streamed elements are passed on, tagged, as they arrive, until this session's answer is no longer wanted
+	if (options[OBPMarshalOptionStreamElementsKey])
+	{
+		NSMutableDictionary* md = [options mutableCopy];
+		md[OBPMarshalOptionStreamElementHandler] =
+			^(NSArray* elements, NSUInteger offset, BOOL* stop) {
+				if (![self->_pending containsObject: key])
+					{*stop = YES; return;}
+				if (resultHandler)
+					resultHandler(serverInfo, elements);
+			};
+		options = [md copy];
+	}
+
+	request =
+		[session.marshal startGetResourceAtAPIPath: _path
+									   withOptions: options
+								  forResultHandler:
+									^(id deserializedObject, NSString* responseBody) {
+										[self session: serverInfo answeredWithResult: deserializedObject ?: [NSNull null] error: nil];
+									}
+									orErrorHandler:
+									^(NSError* error, NSString* path) {
+										[self session: serverInfo answeredWithResult: nil error: error];
+									}];
+
+	if (request)
+		_requests[key] = request;
+	else
+	{
+		OBP_LOG(@"[OBPFanOut launchForSession:] could not launch request for %@ at %@", _path, serverInfo.APIBase);
+		[self session: serverInfo answeredWithResult: nil
+				error: [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResult
+									   userInfo: @{NSLocalizedDescriptionKey : @"Unable to launch request."}]];
+	}
+}
+- (void)session:(OBPServerInfo*)serverInfo answeredWithResult:(id)result error:(NSError*)error
+{
+	NSString* key = serverInfo.key;
+	if (_finished || ![_pending containsObject: key])
+		return; // ...late, after the deadline or cancellation
+	[_pending removeObject: key];
+	[_requests removeObjectForKey: key];
+	if (error)
+		_errors[key] = error;
+	else
+	{
+		_results[key] = result;
+		if (_resultHandler && !_options[OBPMarshalOptionStreamElementsKey])
+			_resultHandler(serverInfo, result);
+	}
+	if (![_pending count])
+		[self finish];
+}
+- (void)passDeadline
+{
+	if (_finished)
+		return;
+	OBP_LOG(@"[OBPFanOut passDeadline] %@ of %@ sessions had not answered %@ within %.1fs", @([_pending count]), @([_sessions count]), _path, _deadline);
+	[self failPendingWithError: [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorTimedOut userInfo: @{NSLocalizedDescriptionKey : @"No answer before the deadline."}]];
+}
+- (void)cancel
+{
+	if (_finished)
+		return;
+	[self failPendingWithError: [NSError errorWithDomain: NSCocoaErrorDomain code: NSUserCancelledError userInfo: nil]];
+}
+- (void)failPendingWithError:(NSError*)error
+{
+	// The requests of sessions that have not answered are cancelled, so that they stop using their transports
+	NSArray<OBPMarshalRequest*>* requests = [_requests allValues];
+	for (NSString* key in _pending)
+		_errors[key] = error;
+	[_pending removeAllObjects];
+	[_requests removeAllObjects];
+	[requests makeObjectsPerformSelector: @selector(cancel)];
+	[self finish];
+}
+- (void)finish
+{
+	if (_finished)
+		return;
+	_finished = YES;
+	HandleOBPFanOutCompletion completion = _completion;
+	_completion = nil;
+	_resultHandler = nil;
+	completion([_results copy], [_errors copy]);
+	_keepAlive = nil;
+}
+@end
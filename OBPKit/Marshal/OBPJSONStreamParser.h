@@ -0,0 +1,40 @@
+//
+//  OBPJSONStreamParser.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+typedef void(^HandleOBPJSONStreamElement)(id element, BOOL* stop); // (element, stop)
+
+
+
+/**	An OBPJSONStreamParser instance finds the elements of one array in a JSON document whose bytes arrive in pieces, and passes each element to its handler, deserialized, as soon as the last byte of that element has been seen.
+
+	The array is either the document itself, or the value of a named member of the document's root object, e.g. the transactions array in a response to get transactions. Only the bytes of the element currently being received are kept, so memory use does not grow with the size of the document. Other members of the root object are skipped without being deserialized, and are only checked for balanced nesting; each element is fully checked as it is deserialized.
+
+	Feed the pieces in order with -parseData:, then call -finish once the last has been fed. A parser must only be used by one thread at a time.
+*/
+@interface OBPJSONStreamParser : NSObject
+- (instancetype)initWithElementsKey:(nullable NSString*)elementsKey elementHandler:(HandleOBPJSONStreamElement)elementHandler; ///< Designated initialiser. \param elementsKey names the member of the root object holding the array, e.g. @"transactions"; pass nil if the document is itself an array. A document that is itself an array is accepted whatever the elementsKey. \param elementHandler is called with each element in order; set *stop to YES to parse no further.
+
+@property (nonatomic, readonly) NSUInteger elementCount; ///< Number of elements passed to the handler so far.
+@property (nonatomic, readonly) BOOL found; ///< Whether the start of the array has been seen.
+@property (nonatomic, readonly, nullable) NSError* error; ///< The error that stopped parsing, if any.
+
+- (BOOL)parseData:(NSData*)data; ///< Parse the next piece of the document, calling the element handler for each element completed by it. \returns NO if the document is malformed or the handler has asked to stop, in which case further pieces are ignored.
+- (BOOL)finish; ///< Check that the document is complete and that the array was found. \returns NO and sets error if not, or if parsing had already failed.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,230 @@
+//
+//  OBPJSONStreamParser.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPJSONStreamParser.h"
+// prj
+#import "OBPLogging.h"
+
+
+
+static NSError* OBPJSONStreamError(NSString* description)
+{
+	return [NSError errorWithDomain: NSCocoaErrorDomain code: NSPropertyListReadCorruptError userInfo: @{NSLocalizedDescriptionKey : description}];
+}
+
+
+
+@implementation OBPJSONStreamParser
+{
+	HandleOBPJSONStreamElement	_elementHandler;
+	NSData*						_elementsKey;		// UTF-8, compared with the raw bytes of each root member name
+	NSMutableData*				_element;			// bytes of the element being received; reused
+	NSMutableData*				_key;				// bytes of the root member name being received; reused
+	NSUInteger					_depth;				// number of containers open
+	NSUInteger					_targetDepth;		// depth at which elements of the array lie, while in the array; else zero
+	BOOL						_inString;
+	BOOL						_escape;
+	BOOL						_inElement;
+	BOOL						_elementIsContainer;	// else ends at the next comma or close at _targetDepth
+	BOOL						_rootIsObject;
+	BOOL						_expectKey;			// next string at depth 1 is a member name
+	BOOL						_capturingKey;
+	BOOL						_pendingTarget;		// member name matched; its value follows
+	BOOL						_ended;				// root value closed
+	BOOL						_stopped;
+}
+- (instancetype)initWithElementsKey:(NSString*)elementsKey elementHandler:(HandleOBPJSONStreamElement)elementHandler
+{
+	if (!elementHandler)
+		{self = nil; return nil;}
+	if (nil == (self = [super init]))
+		return nil;
+	_elementHandler = elementHandler;
+	_elementsKey = [elementsKey dataUsingEncoding: NSUTF8StringEncoding];
+	_element = [NSMutableData dataWithCapacity: 1024];
+	_key = [NSMutableData dataWithCapacity: 32];
+	return self;
+}
+#pragma mark -
+- (BOOL)failWithDescription:(NSString*)description
+{
+	_error = OBPJSONStreamError(description);
+	_stopped = YES;
+	return NO;
+}
+- (BOOL)completeElement
+{
+	NSError*	error = nil;
+	id			element;
+	BOOL		stop = NO;
+
+	element = [NSJSONSerialization JSONObjectWithData: _element options: NSJSONReadingAllowFragments error: &error];
+	[_element setLength: 0];
+	_inElement = NO;
+	if (!element)
+	{
+		OBP_LOG(@"Element %@ of streamed array could not be deserialized: %@", @(_elementCount), error);
+		_error = error ?: OBPJSONStreamError(@"Malformed array element.");
+		_stopped = YES;
+		return NO;
+	}
+	_elementCount++;
+	_elementHandler(element, &stop);
+	if (stop)
+		_stopped = YES;
+	return !stop;
+}
+- (BOOL)parseBytes:(const uint8_t*)p length:(NSUInteger)length
+{
+	NSUInteger		i;
+	NSUInteger		runStart = 0;		// start of the current element's bytes within p
+	uint8_t			c;
+
+	for (i = 0; i < length; i++)
+	{
+		c = p[i];
+
+		// Within a string only an unescaped quote matters
+		if (_inString)
+		{
+			if (_escape)
+				_escape = NO;
+			else
+			if (c == '\\')
+				_escape = YES;
+			else
+			if (c == '"')
+			{
+				_inString = NO;
+				if (_capturingKey)
+					{_capturingKey = NO; continue;}
+			}
+			if (_capturingKey)
+				[_key appendBytes: &c length: 1];
+			continue;
+		}
+		if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+			continue;
+		if (_ended)
+			return [self failWithDescription: @"Unexpected content after JSON document."];
+
+		// Value of the matching root member: the array, or else not what we are looking for
+		if (_pendingTarget)
+		{
+			_pendingTarget = NO;
+			if (c == '[' && !_found)
+				_targetDepth = 2, _found = YES;
+		}
+
+		// Start of an element
+		if (_targetDepth && _depth == _targetDepth && !_inElement && c != ',' && c != ']')
+		{
+			_inElement = YES;
+			_elementIsContainer = c == '{' || c == '[';
+			runStart = i;
+		}
+
+		switch (c)
+		{
+			case '"':
+				_inString = YES;
+				if (_depth == 1 && _rootIsObject && _expectKey)
+				{
+					_capturingKey = YES;
+					[_key setLength: 0];
+				}
+				break;
+			case '{':
+			case '[':
+				if (_depth == 0)
+				{
+					_rootIsObject = c == '{';
+					_expectKey = _rootIsObject;
+					if (!_rootIsObject)
+						_targetDepth = 1, _found = YES;
+				}
+				_depth++;
+				break;
+			case '}':
+			case ']':
+				if (_inElement && !_elementIsContainer && _depth == _targetDepth)
+				{
+					[_element appendBytes: p + runStart length: i - runStart];
+					if (![self completeElement])
+						return NO;
+				}
+				if (_depth == 0)
+					return [self failWithDescription: @"Unbalanced JSON document."];
+				_depth--;
+				if (_inElement && _elementIsContainer && _depth == _targetDepth)
+				{
+					[_element appendBytes: p + runStart length: i + 1 - runStart];
+					if (![self completeElement])
+						return NO;
+				}
+				else
+				if (_targetDepth && _depth + 1 == _targetDepth)
+					_targetDepth = 0;
+				if (_depth == 0)
+					_ended = YES;
+				break;
+			case ',':
+				if (_inElement && !_elementIsContainer && _depth == _targetDepth)
+				{
+					[_element appendBytes: p + runStart length: i - runStart];
+					if (![self completeElement])
+						return NO;
+				}
+				if (_depth == 1 && _rootIsObject)
+					_expectKey = YES;
+				break;
+			case ':':
+				if (_depth == 1 && _rootIsObject)
+				{
+					_expectKey = NO;
+					_pendingTarget = _elementsKey && [_key isEqualToData: _elementsKey];
+				}
+				break;
+			default:
+				if (_depth == 0)
+					return [self failWithDescription: @"Expected a JSON object or array."];
+				break;
+		}
+	}
+
+	// Keep the part of the element received so far
+	if (_inElement)
+		[_element appendBytes: p + runStart length: length - runStart];
+	return YES;
+}
+#pragma mark -
+- (BOOL)parseData:(NSData*)data
+{
+	if (_stopped)
+		return NO;
+	__block BOOL ok = YES;
+	[data enumerateByteRangesUsingBlock:
+		^(const void* bytes, NSRange byteRange, BOOL* stop) {
+			if (!(ok = [self parseBytes: bytes length: byteRange.length]))
+				*stop = YES;
+		}];
+	return ok;
+}
+- (BOOL)finish
+{
+	if (_error)
+		return NO;
+	if (_stopped)
+		return YES;
+	if (!_ended)
+		return [self failWithDescription: @"Unexpected end of JSON document."];
+	if (!_found)
+		return [self failWithDescription: @"JSON document holds no array with the expected name."];
+	return YES;
+}
+@end
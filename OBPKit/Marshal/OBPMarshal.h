@@ -7,6 +7,11 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "OBPPager.h"
+#import "OBPBatch.h"
+#import "OBPPoller.h"
+#import "OBPTransport.h"
+#import "OBPResourceModels.h"
 
 
 
@@ -15,26 +20,72 @@ NS_ASSUME_NONNULL_BEGIN
 
 
 @class OBPSession;
+@class OBPResponseCache;
 
 
 
 static NSString* const	OBPMarshalErrorDomain						= @"OBPMarshalErrorDomain";
 NS_ENUM(NSInteger) {	OBPMarshalErrorUnexpectedResourceKind		= 4192,
 						OBPMarshalErrorUnexpectedResult				= 4193,
+						OBPMarshalErrorDependencyFailed				= 4194,
 };
 
 static NSString* const	OBPMarshalOptionOnlyPublicResources			= @"onlyPublic"; ///< OBPMarshalOptionOnlyPublicResources key for options dictionary, value of type NSNumber interpreted as BOOL, where value YES indicates omit authorization in order to act on only the publicly available resources and value NO (default when omitted) indicates add authorisation so as to act on both the privately available resources of the authorised user and the publicly available resources.
 static NSString* const	OBPMarshalOptionSendDictAsForm				= @"serializeToJSON"; ///< OBPMarshalOptionSendDictAsForm key for options dictionary, value of type NSNumber interpreted as BOOL, where value YES indicates send a dictionary payload as "application/x-www-form-urlencoded", and value NO (same as omitting the option) indicates serialize the payload (for POST/PUT...) as a JSON object; a payload of type NSData is always sent as raw data.
 static NSString* const	OBPMarshalOptionExtraHeaders				= @"extraHeaders"; ///< OBPMarshalOptionExtraHeaders key for options dictionary, value of type dictionary, containing extra header key-value pairs that are acceptable for the particular API call, e.g. for sorting, and subranging by date and/or ordinal; header values supplied as NSDate and NSNumber will be converted to correct string values.
 static NSString* const	OBPMarshalOptionExpectClass					= @"expectClass"; ///< OBPMarshalOptionExpectClass key for options dictionary, value of type Class is the expected class of the deserialized JSON object, pass [NSNull null] or [NSNull class] to signify no fixed expectation; if omited, then desrialized object is expected to be an NSDictionary; mismatch is treated as OBPMarshalErrorUnexpectedResourceKind
+static NSString* const	OBPMarshalOptionModelClass					= @"modelClass"; ///< OBPMarshalOptionModelClass key for options dictionary, value of type Class, a subclass of OBPModel (e.g. [OBPTransaction class]), into which to decode the deserialized JSON, so that the result handler receives a single model, or an NSArray of models when the response is an array or holds an array under the model class's collectionKey; the JSON root object may then be of any class unless OBPMarshalOptionExpectClass is also given; a response that cannot be decoded is treated as OBPMarshalErrorUnexpectedResourceKind. The elements of a collection are decoded straight from the body, one at a time, so the tree of the whole response is never built; other members of its root object are then skipped and only checked for balanced nesting. A single resource is deserialized and then decoded.
 static NSString* const	OBPMarshalOptionExpectStatus				= @"expectStatus"; ///< OBPMarshalOptionExpectStatus key for options dictionary, value of type NSNumber or array of NSNumber giving the expected normal response status code(s); when omitted, the default expectations are 201 for POST, 204 for DELETE, 200 for others.
 static NSString* const	OBPMarshalOptionDeserializeJSON				= @"deserializeJSON"; ///< OBPMarshalOptionDeserializeJSON key for options dictionary, value of type NSNumber interpreted as BOOL and indicating whether to deserialize the response body as a JSON object: value YES is the same as omitting the option; use NO to suppress.
+static NSString* const	OBPMarshalOptionOmitResponseBody			= @"omitResponseBody"; ///< OBPMarshalOptionOmitResponseBody key for options dictionary, value of type NSNumber interpreted as BOOL, where value YES indicates pass nil for responseBody to the result handler, so that the response bytes are never converted to a string; value NO is the same as omitting the option. Use it whenever you only need the deserialized object, e.g. for large collections.
+static NSString* const	OBPMarshalOptionResultQueue					= @"resultQueue"; ///< OBPMarshalOptionResultQueue key for options dictionary, value of type dispatch_queue_t giving the queue on which to call the result and error handlers; when omitted, handlers are called on the marshal's resultQueue, which is the main queue by default.
+static NSString* const	OBPMarshalOptionCacheMaxAge					= @"cacheMaxAge"; ///< OBPMarshalOptionCacheMaxAge key for options dictionary, value of type NSNumber giving, in seconds, how long a cached response to a GET request may be used without contacting the server; including this option enables use of the marshal's responseCache for the request, so that once the max age has passed the request is sent as a conditional GET (If-None-Match/If-Modified-Since) and a 304 Not Modified reply is answered with the cached deserialized object; pass @0 to always revalidate. Ignored for verbs other than GET.
+static NSString* const	OBPMarshalOptionCacheStaleWhileRevalidate	= @"cacheStaleWhileRevalidate"; ///< OBPMarshalOptionCacheStaleWhileRevalidate key for options dictionary, value of type NSNumber giving, in seconds, how long after the OBPMarshalOptionCacheMaxAge has passed a cached response may still be delivered immediately, while it is revalidated with the server in the background for the benefit of later requests. Only applies together with OBPMarshalOptionCacheMaxAge.
+static NSString* const	OBPMarshalOptionPriority					= @"priority"; ///< OBPMarshalOptionPriority key for options dictionary, value of type NSNumber holding an OBPTransportPriority, which determines the order in which the session's transport dispatches waiting requests; use OBPTransportPriorityInteractive for requests the user is waiting on and OBPTransportPriorityBackground for bulk work such as sync; default OBPTransportPriorityDefault.
+static NSString* const	OBPMarshalOptionCoalesce					= @"coalesce"; ///< OBPMarshalOptionCoalesce key for options dictionary, value of type NSNumber interpreted as BOOL, where value YES (default when omitted) indicates that a GET request identical in path, extra headers, authorisation mode and response expectations to one already in flight should share that request's response instead of being sent again, and value NO indicates always send a separate request. Ignored for verbs other than GET.
+static NSString* const	OBPMarshalOptionPageSize					= @"pageSize"; ///< OBPMarshalOptionPageSize key for options dictionary used with -pageResourcesAtAPIPath:..., value of type NSNumber giving the number of elements to request per page (sent as the obp_limit header); default 50.
+static NSString* const	OBPMarshalOptionPagesInFlight				= @"pagesInFlight"; ///< OBPMarshalOptionPagesInFlight key for options dictionary used with -pageResourcesAtAPIPath:..., value of type NSNumber giving the maximum number of page requests to have outstanding at once, which also bounds the number of pages held in memory awaiting in-order delivery; default 4.
+static NSString* const	OBPMarshalOptionMetricsPathTemplate			= @"metricsPathTemplate"; ///< OBPMarshalOptionMetricsPathTemplate key for options dictionary, value of type NSString giving the path template under which to aggregate the request's measurements in OBPMetrics, e.g. @"/my/special/*"; when omitted, the template is made from the path by +[OBPMetrics pathTemplateForPath:].
+static NSString* const	OBPMarshalOptionBatchConcurrency			= @"batchConcurrency"; ///< OBPMarshalOptionBatchConcurrency key for options dictionary used with -getResourcesInBatch:..., value of type NSNumber giving the maximum number of the batch's requests to have in flight at once; default 4.
+static NSString* const	OBPMarshalOptionMaxRetries					= @"maxRetries"; ///< OBPMarshalOptionMaxRetries key for options dictionary, value of type NSNumber giving the number of times a GET request may be retried after the server refuses it for load (429, 503) or it times out or loses its connection in transit; retries are spaced by exponential backoff with random jitter, and never sooner than any Retry-After the server gave; pass @0 to never retry; default 2. Ignored for verbs other than GET, which may not be safe to repeat.
+static NSString* const	OBPMarshalOptionStreamElementsKey			= @"streamElementsKey"; ///< OBPMarshalOptionStreamElementsKey key for options dictionary, value of type NSString naming the array in the response's root object whose elements are to be streamed, e.g. @"transactions", or NSNull when the response is itself an array; together with OBPMarshalOptionStreamElementHandler, this selects streaming mode, in which the body is parsed as it arrives and each element is passed to the element handler as soon as it is complete, without the whole body ever being held in memory; the result handler is then called once the response is complete, with an NSNumber giving the number of elements delivered and a nil responseBody. Elements are decoded with OBPMarshalOptionModelClass if given; the response cache and coalescing are not used in streaming mode.
+static NSString* const	OBPMarshalOptionStreamElementHandler		= @"streamElementHandler"; ///< OBPMarshalOptionStreamElementHandler key for options dictionary, value of type HandleOBPMarshalElements block to be called on the result queue, in order, with the elements completed by each piece of the body received; set *stop to YES to cancel the request, after which the result handler is called with the number of elements delivered. Only applies together with OBPMarshalOptionStreamElementsKey.
 static NSString* const	OBPMarshalOptionErrorHandler				= @"errorHandler"; ///< OBPMarshalOptionErrorHandler key for options dictionary, value of type HandleOBPMarshalError block gives alternative error handler to the standard handler.
 
 
 
 typedef void(^HandleOBPMarshalError)(NSError* error, NSString* path); // (error, path)
 typedef void(^HandleOBPMarshalData)(id deserializedObject, NSString* responseBody); // (deserializedObject, responseBody)
+typedef void(^HandleOBPMarshalElements)(NSArray* elements, NSUInteger offset, BOOL* stop); // (elements, offset, stop)
+
+
+
+/**	An OBPPreparedRequest instance holds a request that you send often, such as one you poll, with its options already interpreted, so that each send only has to substitute parameters into its path, sign and go.
+
+	The path template is a path relative to the API base, in which each parameter is written as its name in braces, e.g. @"/banks/{bankID}/accounts/{accountID}/{viewID}/transactions". Values substituted for parameters are percent-encoded. Options are read once, when the instance is made, including any extra headers, with dates converted to strings at that moment; send a request whose headers change, such as obp_from_date, through the ordinary OBPMarshal methods instead. Unless the options give OBPMarshalOptionMetricsPathTemplate, measurements are aggregated under the path template, with each parameter replaced by *.
+
+	An instance is immutable and may be sent through any marshal, from any queue, any number of times at once. Send it with -[OBPMarshal sendPreparedRequest:withParameters:payload:forResultHandler:orErrorHandler:], or have an OBPPoller send it at intervals.
+*/
+@interface OBPPreparedRequest : NSObject
+- (nullable instancetype)initWithMethod:(NSString*)method pathTemplate:(NSString*)pathTemplate options:(nullable NSDictionary*)options; ///< Designated initialiser. \param method is one of @"GET", @"PUT", @"POST" and @"DELETE". \param pathTemplate gives the path relative to the API base, with parameters in braces. \param options may supply the usual OBPMarshal options, including OBPMarshalOptionExpectClass and OBPMarshalOptionErrorHandler. \returns nil if method is not recognised, or the path template is empty or has an unclosed or empty parameter.
++ (nullable instancetype)GETAtAPIPath:(NSString*)pathTemplate withOptions:(nullable NSDictionary*)options; ///< Convenience for the most common case.
+@property (nonatomic, copy, readonly) NSString* method;
+@property (nonatomic, copy, readonly) NSString* pathTemplate;
+@property (nonatomic, copy, readonly) NSDictionary* options;
+@property (nonatomic, copy, readonly) NSArray<NSString*>* parameterNames; ///< Names of the parameters in pathTemplate, in order of appearance.
+- (nullable NSString*)pathWithParameters:(nullable NSDictionary<NSString*,id>*)parameters; ///< Return the path with the description of each parameter's value substituted, percent-encoded, or nil if a parameter has no value.
+@end
+
+
+
+/**	An OBPMarshalRequest instance is a handle to a request launched by an OBPMarshal, through which you can cancel it.
+
+	Cancelling a request stops it wherever it is, whether waiting for the transport, on the network or waiting to be retried, and its error handler is then called with NSURLErrorCancelled. When the request shares the response of an identical request already in flight (see OBPMarshalOptionCoalesce), only your handlers are withdrawn, and the shared request is itself cancelled once every caller sharing it has cancelled. Cancelling has no effect once the handlers have been called, nor on a request answered from the response cache.
+*/
+@interface OBPMarshalRequest : NSObject
+@property (readonly) BOOL cancelled; ///< YES once -cancel has been called before the request finished.
+- (void)cancel; ///< Cancel the request. May be called from any queue.
+@end
 
 
 
@@ -52,22 +103,56 @@ typedef void(^HandleOBPMarshalData)(id deserializedObject, NSString* responseBod
 	
 	-	if the response body is non-empty, expect it to be a serialized object in JSON format, will deserialize it for you and will reject the response if deserialised object is not a dictionary. To prevent deserialisation, add OBPMarshalOptionDeserializeJSON : @NO to your options dictionary. To expect a different class of JSON root object include OBPMarshalOptionExpectClass : class in your options dictionary. To suppress class checking, add OBPMarshalOptionExpectClass : [NSNull null].
 	
-	To add extra headers that modify the action of the call, add OBPMarshalOptionExtraHeaders : headerDictionary to your options dictionary. For example, to page transactions with get /banks/BANK_ID/accounts/ACCOUNT_ID/VIEW_ID/transactions, you can add OBPMarshalOptionExtraHeaders : @{@"obp_limit":@(chunkSize), @"obp_offset":@(nextChunkOffset)}. Note that OBPMarshal will convert any NSDate values you pass to strings using OBPDateFormatter.
+	-	pass deserialized JSON to your result handler as trees of dictionaries and arrays. For large responses, such as long transaction histories, add OBPMarshalOptionModelClass : [OBPTransaction class] (or another OBPModel subclass) to your options dictionary to have the JSON decoded into compact typed models instead, with amounts held as fixed-point numbers, dates parsed once and repeated strings shared. To have the elements of a large collection as they arrive, instead of all at once at the end, add OBPMarshalOptionStreamElementsKey : @"transactions" (or the name of another array in the response) and OBPMarshalOptionStreamElementHandler : elementHandler to your options dictionary.
+
+	-	decode responses on its decodeQueue, directly from the received bytes, and then call your handlers on its resultQueue, which is the main queue unless you set another. To have the handlers of one request called on another queue, add OBPMarshalOptionResultQueue : queue to your options dictionary, and if you do not need the response body as a string, add OBPMarshalOptionOmitResponseBody : @YES to avoid making one.
+
+	-	send its requests through the session's transport, which limits the number of requests in progress at once and dispatches waiting requests in order of priority. To set the priority of a request, add OBPMarshalOptionPriority : @(OBPTransportPriorityInteractive) (or another OBPTransportPriority value) to your options dictionary.
+
+	-	retry a GET request refused by the server for load (429, 503), or lost in transit, up to twice after a randomised and growing delay, and pass the error on only if every attempt fails. To change the number of retries, add OBPMarshalOptionMaxRetries : @(count) to your options dictionary. The session's transport also adapts how many requests it sends at once to the server's load; see OBPRateController.
+
+	-	share the response of a GET request already in flight with any identical GET requests made before it completes, calling each caller's handlers once; to always send a separate request, add OBPMarshalOptionCoalesce : @NO to your options dictionary.
+
+	To be able to cancel a get request, such as when the user leaves the screen that wanted it, send it with -startGetResourceAtAPIPath:withOptions:forResultHandler:orErrorHandler:, which returns an OBPMarshalRequest handle; -sendPreparedRequest:withParameters:payload:forResultHandler:orErrorHandler: returns one too. OBPPager and OBPBatch use these handles to cancel their requests still in flight when they are cancelled.
+
+	To avoid repeated round trips and decoding for resources that change infrequently, add OBPMarshalOptionCacheMaxAge : @(seconds) to the options of a get request, and optionally also OBPMarshalOptionCacheStaleWhileRevalidate : @(seconds). Responses are then kept in the responseCache, keyed by path, extra headers and authorisation identity, and revalidated with the server using conditional requests.
+
+	To add extra headers that modify the action of the call, add OBPMarshalOptionExtraHeaders : headerDictionary to your options dictionary. For example, to page transactions with get /banks/BANK_ID/accounts/ACCOUNT_ID/VIEW_ID/transactions, you can add OBPMarshalOptionExtraHeaders : @{@"obp_limit":@(chunkSize), @"obp_offset":@(nextChunkOffset)}, although it is usually better to let -pageResourcesAtAPIPath:elementsKey:withOptions:forPageHandler:completion: do this for you, as it keeps several pages in flight at once. Note that OBPMarshal will convert any NSDate values you pass to strings using OBPDateFormatter.
+
+	An OBPMarshal instance may be used from any queue at once, so background workers can send requests and, with a resultQueue of their own, handle the results without passing through the main queue. Only the session's validation needs the main queue, and the session arranges that itself.
+
+	Each request sent is measured and recorded in +[OBPMetrics sharedMetrics], which aggregates the time spent waiting, on the network, signing and decoding by server and by path template.
+
+	To send the same request repeatedly, such as to poll for new transactions, make an OBPPreparedRequest for it once and send it with -sendPreparedRequest:withParameters:payload:forResultHandler:orErrorHandler:, which skips interpreting the options each time; an OBPPoller will send prepared requests for you at intervals.
+
+	To load several related resources at once, such as the banks, the accounts at each bank and the transactions of each account, describe them as OBPBatchRequest nodes and pass them to -getResourcesInBatch:withOptions:completion:, which sends each request as soon as the results it depends on have arrived, and calls you back once with all the results and errors.
 */
 @interface OBPMarshal : NSObject
-@property (nonatomic, strong) HandleOBPMarshalError errorHandler; ///< Get/set a default error handler block for this instance.
+@property (atomic, strong) HandleOBPMarshalError errorHandler; ///< Get/set a default error handler block for this instance.
 @property (nonatomic, weak, readonly) OBPSession* session; ///< Get the session object that this instance exclusively works with, identifying the OBP server with which it communicates.
+@property (atomic, strong, null_resettable) dispatch_queue_t decodeQueue; ///< Get/set the queue on which response bodies are deserialized and checked before being passed to result handlers. Defaults to a global concurrent queue of utility quality of service; reseting to nil restores the default.
+@property (atomic, strong, null_resettable) dispatch_queue_t resultQueue; ///< Get/set the queue on which result and error handlers are called, unless a request's options give OBPMarshalOptionResultQueue. Defaults to the main queue; reseting to nil restores the default. Set a serial or concurrent queue of your own to have background workers handle their results without involving the main queue.
+@property (readonly) NSUInteger coalescedRequestCount; ///< Get the number of GET requests that were answered by sharing the response to an identical request already in flight, instead of being sent. \sa OBPMarshalOptionCoalesce
+@property (atomic, strong, null_resettable) OBPResponseCache* responseCache; ///< Get/set the cache used for get requests that include the OBPMarshalOptionCacheMaxAge option. By default, a cache for the session's server is created at first use, bounded to 4MB in memory and 20MB on disk. Reseting to nil will cause a default cache to be created at next use.
 
 - (instancetype)initWithSessionAuth:(OBPSession*)session; ///< Designated initialiser. session parameter is mandatory. Sets a default error handler which simply logs the error in Debug builds.
 
 - (BOOL)getResourceAtAPIPath:(NSString*)path withOptions:(nullable NSDictionary*)options forResultHandler:(HandleOBPMarshalData)resultHandler orErrorHandler:(nullable HandleOBPMarshalError)errorHandler; ///< Request the resource at path from API base (GET), passing the result to handler, or errors to the error handler. \param path identifies the resource to get, relative to the API base URL. \param options may supply key-value pairs to customise behaviour. \returns YES if the request was launched, or NO if the session or parameters were invalid. \sa See the class description for details of default behaviour and how to override using the options parameter.
 
+- (nullable OBPMarshalRequest*)startGetResourceAtAPIPath:(NSString*)path withOptions:(nullable NSDictionary*)options forResultHandler:(HandleOBPMarshalData)resultHandler orErrorHandler:(nullable HandleOBPMarshalError)errorHandler; ///< As -getResourceAtAPIPath:withOptions:forResultHandler:orErrorHandler:, but return a handle through which the request can be cancelled, or nil if it could not be launched.
+
 - (BOOL)updateResource:(id)resource atAPIPath:(NSString*)path withOptions:(nullable NSDictionary*)options forResultHandler:(HandleOBPMarshalData)resultHandler orErrorHandler:(nullable HandleOBPMarshalError)errorHandler; ///< Update the resource at path from API base (PUT), passing the result to handler, or errors to the error handler. \param path identifies the resource to update, relative to the API base URL. \param options may supply key-value pairs to customise behaviour. \returns YES if the request was launched, or NO if the session or parameters were invalid. \sa See the class description for details of default behaviour and how to override using the options parameter.
 
 - (BOOL)createResource:(id)resource atAPIPath:(NSString*)path withOptions:(nullable NSDictionary*)options forResultHandler:(HandleOBPMarshalData)resultHandler orErrorHandler:(nullable HandleOBPMarshalError)errorHandler; ///< Create a resource at path from API base (POST), passing the result to handler, or errors to the error handler. \param path identifies the resource to create, relative to the API base URL. \param options may supply key-value pairs to customise behaviour. \returns YES if the request was launched, or NO if the session or parameters were invalid. \sa See the class description for details of default behaviour and how to override using the options parameter.
 
+- (nullable OBPPager*)pageResourcesAtAPIPath:(NSString*)path elementsKey:(nullable NSString*)elementsKey withOptions:(nullable NSDictionary*)options forPageHandler:(HandleOBPPagerPage)pageHandler completion:(HandleOBPPagerCompletion)completion; ///< Get the collection resource at path from API base (GET) in pages, using the obp_limit and obp_offset headers, with several pages in flight at once, passing the elements of each page in order to pageHandler, and calling completion once at the end. \param path identifies the collection resource, relative to the API base URL. \param elementsKey names the array in each deserialized page that holds the elements, e.g. @"transactions"; pass nil if each page is itself an array. \param options may supply key-value pairs to customise behaviour, including OBPMarshalOptionPageSize and OBPMarshalOptionPagesInFlight. \returns the started pager, which you can use to cancel paging, or nil if the session or parameters were invalid. \sa OBPPager for details.
+
+- (nullable OBPBatch*)getResourcesInBatch:(NSArray<OBPBatchRequest*>*)requests withOptions:(nullable NSDictionary*)options completion:(HandleOBPBatchCompletion)completion; ///< Get the resources described by requests (GET), where each request may derive its paths from the results of others, running independent requests in parallel, and calling completion once with the results and errors of all requests, by name. \param options may supply key-value pairs applied to every request, including OBPMarshalOptionBatchConcurrency. \returns the started batch, which you can use to cancel, or nil if the session or parameters were invalid. \sa OBPBatch for details.
+
 - (BOOL)deleteResourceAtAPIPath:(NSString*)path withOptions:(nullable NSDictionary*)options forResultHandler:(HandleOBPMarshalData)resultHandler orErrorHandler:(nullable HandleOBPMarshalError)errorHandler; ///< Delete the resource at path from API base (DELETE), passing the result to handler, or errors to the error handler. \param options may supply key-value pairs to customise behaviour. \returns YES if the request was launched, or NO if the session or parameters were invalid. \sa See the class description for details of default behaviour and how to override using the options parameter.
 
+- (nullable OBPMarshalRequest*)sendPreparedRequest:(OBPPreparedRequest*)request withParameters:(nullable NSDictionary<NSString*,id>*)parameters payload:(nullable id)payload forResultHandler:(HandleOBPMarshalData)resultHandler orErrorHandler:(nullable HandleOBPMarshalError)errorHandler; ///< Send a prepared request, with parameters substituted into its path template, and payload as the resource to create or update, if any, passing the result to handler, or errors to the error handler. The request is signed afresh each time, but its options are not interpreted again. \returns a handle through which the request can be cancelled, or nil if the session was invalid or a parameter was missing. \sa OBPPreparedRequest
+
 @end
 
 
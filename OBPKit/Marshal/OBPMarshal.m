@@ -8,14 +8,24 @@
 
 #import "OBPMarshal.h"
 // sdk
-// ext
-#import <STHTTPRequest/STHTTPRequest.h>
+#import <objc/runtime.h>
 // prj
 #import "OBPServerInfo.h"
 #import "OBPSession.h"
 #import "NSString+OBPKit.h"
 #import "OBPLogging.h"
 #import "OBPDateFormatter.h"
+#import "OBPResponseCache.h"
+#import "OBPTransport.h"
+#import "OBPModel.h"
+#import "OBPMetrics.h"
+#import "OBPJSONStreamParser.h"
+
+
+
+#define kOBPResponseCacheDefaultMemoryCapacity	(4 * 1024 * 1024)
+#define kOBPResponseCacheDefaultDiskCapacity	(20 * 1024 * 1024)
+#define kOBPMarshalDefaultMaxRetries			2
 
 
 
@@ -36,7 +46,514 @@ NSString* NSStringDescribingNSURLResponseAndData(NSHTTPURLResponse* response, NS
 
 
 
+static NSString* OBPHeaderValue(NSDictionary* headers, NSString* name)
+{
+	NSString*	value = headers[name];
+	NSString*	key;
+	if (value)
+		return value;
+	for (key in headers)
+		if (NSOrderedSame == [key caseInsensitiveCompare: name])
+			return headers[key];
+	return nil;
+}
+
+
+
+static NSString* OBPMarshalBodyString(NSData* body)
+{
+	return [[NSString alloc] initWithData: body encoding: NSUTF8StringEncoding] ?: @"";
+}
+
+
+
+static NSArray* OBPMarshalDecodeCollection(NSData* body, Class expectedClass, Class modelClass, NSError** errorAt)
+{
+	// Decode the elements of a collection into models one by one from the token stream, so that only one element's tree is ever held, rather than the tree of the whole body. Returns nil without error when body is not a collection of modelClass, leaving it to be decoded whole.
+	const uint8_t*			p = body.bytes;
+	NSUInteger				i, length = body.length;
+	NSString*				key = [modelClass collectionKey];
+	OBPModelDecoder*		decoder;
+	OBPJSONStreamParser*	parser;
+	NSMutableArray*			models;
+	__block BOOL			rejected = NO;
+
+	for (i = 0; i < length && (p[i] == ' ' || p[i] == '\n' || p[i] == '\r' || p[i] == '\t'); i++)
+		;
+	if (i == length || !(p[i] == '[' || (p[i] == '{' && key)))
+		return nil;
+	if (expectedClass && ![(p[i] == '[' ? [NSArray class] : [NSDictionary class]) isSubclassOfClass: expectedClass])
+		return nil;
+
+	decoder = [[OBPModelDecoder alloc] init];
+	models = [NSMutableArray array];
+	parser = [[OBPJSONStreamParser alloc] initWithElementsKey: key elementHandler:
+		^(id element, BOOL* stop) {
+			id model = [element isKindOfClass: [NSDictionary class]] ? [modelClass modelWithJSONObject: element decoder: decoder] : nil;
+			if (model)
+				[models addObject: model];
+			else
+				rejected = *stop = YES;
+		}];
+	if ([parser parseData: body] && !parser.found)
+		return nil; // ...a single resource, or the array is missing or not an array
+	if (!rejected && [parser finish])
+		return [models copy];
+	if (errorAt)
+		*errorAt = rejected || !parser.error
+				 ? [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResourceKind userInfo: @{NSLocalizedDescriptionKey : @"Unexpected response data type."}]
+				 : parser.error;
+	return nil;
+}
+
+
+
+static id OBPMarshalDeserializeBody(NSData* body, Class expectedClass, Class modelClass, NSString* path, NSError** errorAt)
+{
+	// Parses the bytes as received; a string is only made from them to describe a failure
+	NSError*	error = nil;
+	id			container;
+
+	if (modelClass && (container = OBPMarshalDecodeCollection(body, expectedClass, modelClass, &error)))
+	{
+		if (errorAt)
+			*errorAt = nil;
+		return container;
+	}
+	if (error)
+	{
+		OBP_LOG(@"Resource at path %@ could not be decoded as %@: %@", path, NSStringFromClass(modelClass), error);
+		if (errorAt)
+			*errorAt = error;
+		return nil;
+	}
+
+	container = [NSJSONSerialization JSONObjectWithData: body ?: [NSData data] options: 0 error: &error];
+	OBP_LOG_IF(error, @"[NSJSONSerialization JSONObjectWithData: data options: 0 error:] gave error:\nerror = %@\ndata = %@", error, OBPMarshalBodyString(body));
+	OBP_LOG_IF(!error && expectedClass && ![container isKindOfClass: expectedClass], @"Expected to resource at path %@ to yield a %@, but got instead got:\n%@\nfrom body: %@", path, NSStringFromClass(expectedClass), container, OBPMarshalBodyString(body));
+	if (!error && expectedClass && ![container isKindOfClass: expectedClass])
+		error = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResourceKind userInfo:@{NSLocalizedDescriptionKey:@"Unexpected response data type.",@"body":OBPMarshalBodyString(body)}];
+	if (!error && modelClass)
+	{
+		// A single resource: map its tree to a compact model; the tree itself is released as soon as we return
+		container = [[[OBPModelDecoder alloc] init] decodeJSONObject: container modelClass: modelClass error: &error];
+		OBP_LOG_IF(error, @"Resource at path %@ could not be decoded as %@", path, NSStringFromClass(modelClass));
+	}
+	if (error)
+		container = nil;
+	if (errorAt)
+		*errorAt = error;
+	return container;
+}
+
+
+
+@interface OBPPreparedRequest ()
+- (instancetype)initWithVerb:(OBPMarshalVerb)verb pathTemplate:(NSString*)pathTemplate options:(NSDictionary*)options literal:(BOOL)literal;
+@property (nonatomic, readonly) OBPMarshalVerb verb;
+@property (nonatomic, copy, readonly) NSArray* acceptableStatusCodes;
+@property (nonatomic, readonly) Class expectedClass;
+@property (nonatomic, readonly) Class modelClass;
+@property (nonatomic, readonly) BOOL onlyPublicResources;
+@property (nonatomic, readonly) BOOL sendDictAsForm;
+@property (nonatomic, readonly) BOOL deserializeJSON;
+@property (nonatomic, readonly) BOOL omitBody;
+@property (nonatomic, readonly) BOOL coalesce;
+@property (nonatomic, strong, readonly) dispatch_queue_t resultQueue; // nil for the marshal's
+@property (nonatomic, readonly) OBPTransportPriority priority;
+@property (nonatomic, readonly) NSUInteger maxRetries;
+@property (nonatomic, copy, readonly) NSString* metricsPathTemplate;
+@property (nonatomic, strong, readonly) id streamElementsKey;
+@property (nonatomic, copy, readonly) HandleOBPMarshalElements streamElementHandler;
+@property (nonatomic, readonly) NSTimeInterval cacheMaxAge;
+@property (nonatomic, readonly) NSTimeInterval cacheStaleWhileRevalidate;
+@property (nonatomic, copy, readonly) NSDictionary<NSString*,NSString*>* headers;
+@property (nonatomic, copy, readonly) NSDictionary<NSString*,NSString*>* cacheKeyHeaders;
+@property (nonatomic, copy, readonly) HandleOBPMarshalError errorHandler;
+@end
+
+
+
+@implementation OBPPreparedRequest
+{
+	NSArray<NSString*>*		_segments;			// literal parts of the path template, around the parameters
+	BOOL					_literal;			// path is used as given, and changes with each send
+	NSString*				_coalesceKeySuffix;
+	NSURLRequest*			_reusableRequest;	// ...when the path has no parameters, for _reusableRequestBase
+	NSString*				_reusableRequestBase;
+}
++ (instancetype)GETAtAPIPath:(NSString*)pathTemplate withOptions:(NSDictionary*)options
+{
+	return [[self alloc] initWithMethod: @"GET" pathTemplate: pathTemplate options: options];
+}
+- (instancetype)initWithMethod:(NSString*)method pathTemplate:(NSString*)pathTemplate options:(NSDictionary*)options
+{
+	NSUInteger verb = [@[@"GET", @"PUT", @"POST", @"DELETE"] indexOfObject: [method uppercaseString]];
+	if (verb == NSNotFound)
+		{self = nil; return nil;}
+	return [self initWithVerb: (OBPMarshalVerb)verb pathTemplate: pathTemplate options: options literal: NO];
+}
+- (instancetype)initWithVerb:(OBPMarshalVerb)verb pathTemplate:(NSString*)pathTemplate options:(NSDictionary*)options literal:(BOOL)literal
+{
+	if (![pathTemplate length] || verb >= eOBPMarshalVerb_count)
+		{self = nil; return nil;}
+	if (nil == (self = [super init]))
+		return nil;
+
+	NSMutableArray*			segments;
+	NSMutableArray*			names;
+	NSMutableDictionary*	headers = [NSMutableDictionary dictionary];
+	NSDictionary*			dict;
+	NSString*				key;
+	NSUInteger				location, length;
+	NSRange					open, close;
+	id						obj;
+
+	_verb = verb;
+	_pathTemplate = [pathTemplate copy];
+	_options = [options copy] ?: @{};
+	_literal = literal;
+	_expectedClass = [NSDictionary class];
+	_deserializeJSON = YES;
+	_coalesce = YES;
+	_priority = OBPTransportPriorityDefault;
+	_maxRetries = kOBPMarshalDefaultMaxRetries;
+	_cacheMaxAge = -1;
+
+	// Method
+	switch (verb)
+	{
+		case eOBPMarshalVerb_GET:
+			_method = @"GET";
+			_acceptableStatusCodes = @[@200];
+			break;
+		case eOBPMarshalVerb_PUT:
+			_method = @"PUT";
+			_acceptableStatusCodes = @[@200];
+			break;
+		case eOBPMarshalVerb_POST:
+			_method = @"POST";
+			_acceptableStatusCodes = @[@201];
+			break;
+		case eOBPMarshalVerb_DELETE:
+			_method = @"DELETE";
+			_acceptableStatusCodes = @[@204];
+			break;
+		default:
+			break;
+	}
+
+	// Parameters
+	if (literal)
+		_segments = @[pathTemplate], _parameterNames = @[];
+	else
+	{
+		segments = [NSMutableArray array];
+		names = [NSMutableArray array];
+		for (location = 0, length = [pathTemplate length]; location < length; location = NSMaxRange(close))
+		{
+			open = [pathTemplate rangeOfString: @"{" options: 0 range: NSMakeRange(location, length - location)];
+			if (!open.length)
+				break;
+			close = [pathTemplate rangeOfString: @"}" options: 0 range: NSMakeRange(NSMaxRange(open), length - NSMaxRange(open))];
+			OBP_LOG_IF(!close.length || close.location == NSMaxRange(open), @"[OBPPreparedRequest init...] unclosed or empty parameter in path template %@", pathTemplate);
+			if (!close.length || close.location == NSMaxRange(open))
+				{self = nil; return nil;}
+			[segments addObject: [pathTemplate substringWithRange: NSMakeRange(location, open.location - location)]];
+			[names addObject: [pathTemplate substringWithRange: NSMakeRange(NSMaxRange(open), close.location - NSMaxRange(open))]];
+		}
+		[segments addObject: [pathTemplate substringFromIndex: MIN(location, length)]];
+		_segments = [segments copy];
+		_parameterNames = [names copy];
+	}
+
+	// Options
+	// Expected class of object after deserialisation
+	obj = _options[OBPMarshalOptionExpectClass];
+	if (obj)
+	if ([obj isEqual: [NSNull null]] || obj == [NSNull class])
+		_expectedClass = nil;
+	else
+		_expectedClass = obj;
+
+	// Decode to typed models? The JSON root may then be an object or an array, unless an expected class was also given
+	obj = _options[OBPMarshalOptionModelClass];
+	if (obj && class_isMetaClass(object_getClass(obj)) && [obj isSubclassOfClass: [OBPModel class]])
+	{
+		_modelClass = obj;
+		if (!_options[OBPMarshalOptionExpectClass])
+			_expectedClass = nil;
+	}
+
+	// Make public calls? (suppress authorisation)
+	obj = _options[OBPMarshalOptionOnlyPublicResources];
+	if ([obj respondsToSelector: @selector(boolValue)])
+		_onlyPublicResources = [obj boolValue];
+
+	// Send payload as form?
+	obj = _options[OBPMarshalOptionSendDictAsForm];
+	if ([obj respondsToSelector: @selector(boolValue)])
+		_sendDictAsForm = [obj boolValue];
+
+	// Expect reply body is JSON and deserialize?
+	obj = _options[OBPMarshalOptionDeserializeJSON];
+	if ([obj respondsToSelector: @selector(boolValue)])
+		_deserializeJSON = [obj boolValue];
+
+	// Leave out the response body string?
+	obj = _options[OBPMarshalOptionOmitResponseBody];
+	if ([obj respondsToSelector: @selector(boolValue)])
+		_omitBody = [obj boolValue];
+
+	// Call handlers on a queue other than the marshal's resultQueue?
+	_resultQueue = _options[OBPMarshalOptionResultQueue];
+
+	// Expect non-default reply status code(s)?
+	obj = _options[OBPMarshalOptionExpectStatus];
+	if ([obj respondsToSelector: @selector(integerValue)])
+		_acceptableStatusCodes = @[obj];
+	else
+	if ([obj isKindOfClass: [NSArray class]])
+		_acceptableStatusCodes = [obj copy];
+
+	// Priority class for the transport
+	obj = _options[OBPMarshalOptionPriority];
+	if ([obj respondsToSelector: @selector(unsignedCharValue)] && [obj unsignedCharValue] < OBPTransportPriority_count)
+		_priority = [obj unsignedCharValue];
+
+	// Share identical GETs already in flight?
+	obj = _options[OBPMarshalOptionCoalesce];
+	if ([obj respondsToSelector: @selector(boolValue)])
+		_coalesce = [obj boolValue];
+
+	// Aggregate measurements under a particular path template? A prepared template is made once, here, rather than from each path sent
+	obj = _options[OBPMarshalOptionMetricsPathTemplate];
+	if ([obj isKindOfClass: [NSString class]])
+		_metricsPathTemplate = [obj copy];
+	else
+	if (!literal)
+		_metricsPathTemplate = [OBPMetrics pathTemplateForPath: [_segments componentsJoinedByString: @"*"]];
+
+	// Retry GETs refused for load a different number of times?
+	obj = _options[OBPMarshalOptionMaxRetries];
+	if ([obj respondsToSelector: @selector(unsignedIntegerValue)])
+		_maxRetries = [obj unsignedIntegerValue];
+
+	// Stream the elements of a collection as they arrive?
+	obj = _options[OBPMarshalOptionStreamElementsKey];
+	if ([obj isKindOfClass: [NSString class]] || [obj isEqual: [NSNull null]])
+		_streamElementsKey = obj;
+	_streamElementHandler = _options[OBPMarshalOptionStreamElementHandler];
+
+	// Use response cache?
+	obj = _options[OBPMarshalOptionCacheMaxAge];
+	if ([obj respondsToSelector: @selector(doubleValue)])
+		_cacheMaxAge = MAX(0, [obj doubleValue]);
+	obj = _options[OBPMarshalOptionCacheStaleWhileRevalidate];
+	if ([obj respondsToSelector: @selector(doubleValue)])
+		_cacheStaleWhileRevalidate = MAX(0, [obj doubleValue]);
+
+	// Add extra headers?
+	dict = obj = _options[OBPMarshalOptionExtraHeaders];
+	if ([obj isKindOfClass: [NSDictionary class]])
+	for (key in dict)
+	{
+		obj = dict[key];
+		if ([obj isKindOfClass: [NSDate class]])
+			headers[key] = [OBPDateFormatter stringFromDate: obj];
+		else
+			headers[key] = [obj description];
+	}
+	_headers = [headers copy];
+
+	// Alternative error handler
+	_errorHandler = _options[OBPMarshalOptionErrorHandler];
+
+	// A streamed response is never held whole, so can neither be cached nor shared
+	if (_streamElementsKey && _streamElementHandler && _deserializeJSON)
+		_cacheMaxAge = -1, _coalesce = NO, _omitBody = YES;
+	else
+		_streamElementsKey = nil, _streamElementHandler = nil;
+
+	// Responses decoded to models are cached apart from those left as dictionaries, as the cache also holds the decoded object
+	if (_cacheMaxAge >= 0 && verb == eOBPMarshalVerb_GET)
+	{
+		_cacheKeyHeaders = _headers;
+		if (_modelClass)
+		{
+			headers[@" model"] = NSStringFromClass(_modelClass);
+			_cacheKeyHeaders = [headers copy];
+		}
+	}
+
+	return self;
+}
+- (NSString*)pathWithParameters:(NSDictionary<NSString*,id>*)parameters
+{
+	NSUInteger			i, n = [_parameterNames count];
+	NSMutableString*	path;
+	id					value;
+
+	if (!n)
+		return _pathTemplate;
+	path = [NSMutableString stringWithString: _segments[0]];
+	for (i = 0; i < n; i++)
+	{
+		if (nil == (value = parameters[_parameterNames[i]]))
+			return nil;
+		[path appendString: [[value description] stringByAddingPercentEncodingForAllRFC3986ReservedCharachters]];
+		[path appendString: _segments[i + 1]];
+	}
+	return [path copy];
+}
+- (NSMutableURLRequest*)requestForPath:(NSString*)path APIBase:(NSString*)APIBase
+{
+	// A prepared request without parameters is made once per API base, and a copy is signed for each send
+	BOOL					reusable = !_literal && ![_parameterNames count];
+	NSMutableURLRequest*	request;
+	NSURL*					url;
+	NSString*				name;
+
+	if (reusable)
+	@synchronized (self) {
+		if (_reusableRequest && [_reusableRequestBase isEqualToString: APIBase])
+			return [_reusableRequest mutableCopy];
+	}
+
+	url = [NSURL URLWithString: [APIBase stringForURLByAppendingPath: path]];
+	request = url ? [NSMutableURLRequest requestWithURL: url] : nil;
+	OBP_LOG_IF(!request, @"Unable to create request with path %@", path);
+	if (!request)
+		return nil;
+	request.HTTPMethod = _method;
+	for (name in _headers)
+		[request setValue: _headers[name] forHTTPHeaderField: name];
+
+	if (reusable)
+	@synchronized (self) {
+		_reusableRequest = [request copy];
+		_reusableRequestBase = [APIBase copy];
+	}
+	return request;
+}
+- (NSString*)coalesceKeyForPath:(NSString*)path conditionalHeaders:(NSDictionary*)conditionalHeaders
+{
+	// Requests are only shared when they would be sent identically and their responses treated identically
+	NSMutableString*	key;
+	NSString*			name;
+
+	@synchronized (self) {
+		if (!_coalesceKeySuffix)
+		{
+			key = [NSMutableString stringWithFormat: @"\n%d%d%d|%@|%@|%@", _onlyPublicResources, _deserializeJSON, _omitBody, _expectedClass ? NSStringFromClass(_expectedClass) : @"*", _modelClass ? NSStringFromClass(_modelClass) : @"", [_acceptableStatusCodes componentsJoinedByString: @","]];
+			for (name in [[_headers allKeys] sortedArrayUsingSelector: @selector(caseInsensitiveCompare:)])
+				[key appendFormat: @"\n%@:%@", [name lowercaseString], _headers[name]];
+			_coalesceKeySuffix = [key copy];
+		}
+	}
+	key = [NSMutableString stringWithString: path];
+	[key appendString: _coalesceKeySuffix];
+	for (name in [[conditionalHeaders allKeys] sortedArrayUsingSelector: @selector(caseInsensitiveCompare:)])
+		[key appendFormat: @"\n%@:%@", [name lowercaseString], conditionalHeaders[name]];
+	return [key copy];
+}
+@end
+
+
+
+@interface OBPMarshalRequest ()
+- (BOOL)attachTask:(OBPTransportTask*)task;
+- (void)setCancelAction:(dispatch_block_t)cancelAction;
+- (void)finish;
+@end
+
+
+
+@interface OBPMarshalFlight : NSObject
+{
+@public
+	NSMutableArray<NSArray*>*	_waiters;		// (result handler, error handler, result queue, handle) tuples
+	OBPMarshalRequest*			_request;		// holds the transport task shared by the waiters
+}
+@end
+@implementation OBPMarshalFlight
+@end
+
+
+
+@implementation OBPMarshalRequest
+{
+	OBPTransportTask*		_task;			// the attempt in progress on the transport, if any
+	dispatch_block_t		_cancelAction;	// ...or else how to withdraw from a shared request
+	BOOL					_cancelled;
+	BOOL					_finished;
+}
+- (BOOL)cancelled
+{
+	@synchronized (self) {
+		return _cancelled;
+	}
+}
+- (void)cancel
+{
+	OBPTransportTask*		task;
+	dispatch_block_t		cancelAction;
+
+	@synchronized (self) {
+		if (_cancelled || _finished)
+			return;
+		_cancelled = YES;
+		task = _task, _task = nil;
+		cancelAction = _cancelAction, _cancelAction = nil;
+	}
+	[task cancel]; // ...the response handler then gets NSURLErrorCancelled
+	if (cancelAction)
+		cancelAction();
+}
+- (BOOL)attachTask:(OBPTransportTask*)task
+{
+	// Each attempt (retries included) replaces the last; an attempt made after cancellation is cancelled at once
+	@synchronized (self) {
+		if (!_cancelled)
+		{
+			_task = _finished ? nil : task;
+			return YES;
+		}
+	}
+	[task cancel];
+	return NO;
+}
+- (void)setCancelAction:(dispatch_block_t)cancelAction
+{
+	@synchronized (self) {
+		_cancelAction = _finished ? nil : cancelAction;
+	}
+}
+- (void)finish
+{
+	@synchronized (self) {
+		_finished = YES;
+		_task = nil;
+		_cancelAction = nil;
+	}
+}
+@end
+
+
+
 @implementation OBPMarshal
+{
+	OBPResponseCache*		_responseCache;
+	dispatch_queue_t		_decodeQueue;
+	dispatch_queue_t		_resultQueue;
+	HandleOBPMarshalError	_errorHandler;
+	NSMutableDictionary<NSString*,OBPMarshalFlight*>*
+							_flights;			// in-flight GETs by coalesce key
+	NSUInteger				_coalescedRequestCount;
+	NSString*				_authIdentity;				// made from the access data...
+	NSUInteger				_authIdentityGeneration;	// ...at this accessDataGeneration...
+	OBPAuthMethod			_authIdentityMethod;		// ...for this auth method
+}
 - (instancetype)initWithSessionAuth:(OBPSession*)session
 {
 	if (!session)
@@ -56,7 +573,85 @@ NSString* NSStringDescribingNSURLResponseAndData(NSHTTPURLResponse* response, NS
 			OBP_LOG(@"Request for resource at path %@ served by %@ got error %@", path, self_ifStillAlive.session.serverInfo.APIBase, error);
 		};
 }
+- (OBPResponseCache*)responseCache
+{
+	@synchronized (self) {
+		if (_responseCache == nil)
+		{
+			NSString* identifier = _session.serverInfo.key;
+			if ([identifier length])
+				_responseCache = [[OBPResponseCache alloc] initWithIdentifier: identifier
+															   memoryCapacity: kOBPResponseCacheDefaultMemoryCapacity
+																 diskCapacity: kOBPResponseCacheDefaultDiskCapacity];
+		}
+		return _responseCache;
+	}
+}
+- (void)setResponseCache:(OBPResponseCache*)responseCache
+{
+	@synchronized (self) {
+		_responseCache = responseCache;
+	}
+}
+- (dispatch_queue_t)decodeQueue
+{
+	@synchronized (self) {
+		return _decodeQueue ?: dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+	}
+}
+- (void)setDecodeQueue:(dispatch_queue_t)decodeQueue
+{
+	@synchronized (self) {
+		_decodeQueue = decodeQueue;
+	}
+}
+- (dispatch_queue_t)resultQueue
+{
+	@synchronized (self) {
+		return _resultQueue ?: dispatch_get_main_queue();
+	}
+}
+- (void)setResultQueue:(dispatch_queue_t)resultQueue
+{
+	@synchronized (self) {
+		_resultQueue = resultQueue;
+	}
+}
+- (HandleOBPMarshalError)errorHandler
+{
+	@synchronized (self) {
+		return _errorHandler;
+	}
+}
+- (void)setErrorHandler:(HandleOBPMarshalError)errorHandler
+{
+	@synchronized (self) {
+		_errorHandler = errorHandler;
+	}
+}
+- (NSString*)authIdentity
+{
+	// Identifies whose view of resources a private request gets, so that cached responses are never shared between logins. (Hashed by OBPResponseCache before use.) Reading accessData goes to the keychain, so the identity is only made afresh when the access data or auth method has changed.
+	OBPSession*		session = _session;
+	OBPServerInfo*	serverInfo = session.serverInfo;
+	NSUInteger		generation = serverInfo.accessDataGeneration;
+	OBPAuthMethod	authMethod = session.authMethod;
+	@synchronized (self) {
+		if (!_authIdentity || _authIdentityGeneration != generation || _authIdentityMethod != authMethod)
+		{
+			NSString* token = serverInfo.accessData[OBPServerInfo_TokenKey];
+			_authIdentity = [NSString stringWithFormat: @"%d|%@|%@", (int)authMethod, serverInfo.APIBase, token ?: @""];
+			_authIdentityGeneration = generation;
+			_authIdentityMethod = authMethod;
+		}
+		return _authIdentity;
+	}
+}
 - (BOOL)getResourceAtAPIPath:(NSString*)p withOptions:(NSDictionary*)o forResultHandler:(HandleOBPMarshalData)rh orErrorHandler:(HandleOBPMarshalError)eh
+{
+	return nil != [self startGetResourceAtAPIPath: p withOptions: o forResultHandler: rh orErrorHandler: eh];
+}
+- (OBPMarshalRequest*)startGetResourceAtAPIPath:(NSString*)p withOptions:(NSDictionary*)o forResultHandler:(HandleOBPMarshalData)rh orErrorHandler:(HandleOBPMarshalError)eh
 {
 	if (eh == nil && o)
 		eh = o[@"errorHandler"];
@@ -66,139 +661,316 @@ NSString* NSStringDescribingNSURLResponseAndData(NSHTTPURLResponse* response, NS
 {
 	if (eh == nil && o)
 		eh = o[@"errorHandler"];
-	return [self sendRequestVerb: eOBPMarshalVerb_PUT withPayload: r toAPIPath: p withOptions: o forResultHandler: rh orErrorHandler: eh];
+	return nil != [self sendRequestVerb: eOBPMarshalVerb_PUT withPayload: r toAPIPath: p withOptions: o forResultHandler: rh orErrorHandler: eh];
 }
 - (BOOL)createResource:(id)r atAPIPath:(NSString*)p withOptions:(NSDictionary*)o forResultHandler:(HandleOBPMarshalData)rh orErrorHandler:(HandleOBPMarshalError)eh
 {
 	if (eh == nil && o)
 		eh = o[@"errorHandler"];
-	return [self sendRequestVerb: eOBPMarshalVerb_POST withPayload: r toAPIPath: p withOptions: o forResultHandler: rh orErrorHandler: eh];
+	return nil != [self sendRequestVerb: eOBPMarshalVerb_POST withPayload: r toAPIPath: p withOptions: o forResultHandler: rh orErrorHandler: eh];
 }
 - (BOOL)deleteResourceAtAPIPath:(NSString*)p withOptions:(NSDictionary*)o forResultHandler:(HandleOBPMarshalData)rh orErrorHandler:(HandleOBPMarshalError)eh
 {
 	if (eh == nil && o)
 		eh = o[@"errorHandler"];
-	return [self sendRequestVerb: eOBPMarshalVerb_DELETE withPayload: nil toAPIPath: p withOptions: o forResultHandler: rh orErrorHandler: eh];
+	return nil != [self sendRequestVerb: eOBPMarshalVerb_DELETE withPayload: nil toAPIPath: p withOptions: o forResultHandler: rh orErrorHandler: eh];
+}
+#pragma mark -
+- (NSUInteger)coalescedRequestCount
+{
+	@synchronized (self) {
+		return _coalescedRequestCount;
+	}
+}
+- (OBPMarshalFlight*)joinFlightForKey:(NSString*)key waiter:(NSArray*)waiter joined:(BOOL*)joinedAt
+{
+	// Sets *joinedAt to YES if joined an existing flight, or NO if a new flight was registered and the caller must launch the request
+	@synchronized (self) {
+		OBPMarshalFlight* flight = _flights[key];
+		*joinedAt = flight != nil;
+		if (flight)
+			_coalescedRequestCount++;
+		else
+		{
+			flight = [[OBPMarshalFlight alloc] init];
+			flight->_waiters = [NSMutableArray array];
+			flight->_request = [[OBPMarshalRequest alloc] init];
+			if (!_flights)
+				_flights = [NSMutableDictionary dictionary];
+			_flights[key] = flight;
+		}
+		[flight->_waiters addObject: waiter];
+		return flight;
+	}
+}
+- (NSArray<NSArray*>*)leaveFlight:(OBPMarshalFlight*)flight forKey:(NSString*)key
+{
+	// Flights are compared by identity, as a flight whose waiters have all withdrawn is succeeded by a new one for the same key
+	@synchronized (self) {
+		NSArray* waiters = [flight->_waiters copy];
+		if (_flights[key] == flight)
+			[_flights removeObjectForKey: key];
+		[flight->_waiters removeAllObjects];
+		return waiters;
+	}
 }
-- (BOOL)sendRequestVerb:(OBPMarshalVerb)verb
+- (void)setCancelActionOfWaiter:(OBPMarshalRequest*)handle inFlight:(OBPMarshalFlight*)flight forKey:(NSString*)key path:(NSString*)path
+{
+	// A waiter that cancels gets NSURLErrorCancelled at once, and the last to go takes the shared request with it
+	__weak OBPMarshalRequest* handle_ifStillAlive = handle;
+	[handle setCancelAction: ^{
+		NSArray*	waiter = nil;
+		BOOL		empty = NO;
+		@synchronized (self) {
+			NSUInteger i = [flight->_waiters indexOfObjectPassingTest: ^BOOL(NSArray* w, NSUInteger idx, BOOL* stop) {return w[3] == handle_ifStillAlive;}];
+			if (i != NSNotFound)
+			{
+				waiter = flight->_waiters[i];
+				[flight->_waiters removeObjectAtIndex: i];
+				if ((empty = ![flight->_waiters count]) && self->_flights[key] == flight)
+					[self->_flights removeObjectForKey: key];
+			}
+		}
+		if (!waiter)
+			return; // ...already answered
+		HandleOBPMarshalError waiterErrorHandler = waiter[1];
+		NSError* error = [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorCancelled userInfo: nil];
+		dispatch_async(waiter[2], ^{waiterErrorHandler(error, path);});
+		if (empty)
+			[flight->_request cancel];
+	}];
+}
+- (void)abandonFlight:(OBPMarshalFlight*)flight forKey:(NSString*)key path:(NSString*)path
+{
+	// The request for a flight could not be launched; the first waiter learns this from our return value, and any that joined meanwhile get an error
+	if (!flight)
+		return;
+	NSArray<NSArray*>*	waiters = [self leaveFlight: flight forKey: key];
+	NSError*			error = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResult userInfo: @{NSLocalizedDescriptionKey : @"Unable to launch request."}];
+	NSUInteger			i;
+	for (i = 0; i < [waiters count]; i++)
+	{
+		HandleOBPMarshalError waiterErrorHandler = waiters[i][1];
+		[waiters[i][3] finish];
+		if (i)
+			dispatch_async(waiters[i][2], ^{waiterErrorHandler(error, path);});
+	}
+}
+#pragma mark -
+- (OBPPager*)pageResourcesAtAPIPath:(NSString*)p elementsKey:(NSString*)k withOptions:(NSDictionary*)o forPageHandler:(HandleOBPPagerPage)ph completion:(HandleOBPPagerCompletion)c
+{
+	OBPPager* pager = [[OBPPager alloc] initWithMarshal: self path: p elementsKey: k options: o pageHandler: ph completion: c];
+	return [pager start] ? pager : nil;
+}
+- (OBPBatch*)getResourcesInBatch:(NSArray<OBPBatchRequest*>*)r withOptions:(NSDictionary*)o completion:(HandleOBPBatchCompletion)c
+{
+	if (!_session.valid && ![o[OBPMarshalOptionOnlyPublicResources] isEqual: @YES])
+		return nil;
+	OBPBatch* batch = [[OBPBatch alloc] initWithMarshal: self requests: r options: o completion: c];
+	return [batch start] ? batch : nil;
+}
+- (OBPMarshalRequest*)sendRequestVerb:(OBPMarshalVerb)verb
 			withPayload:(id)payload
 			  toAPIPath:(NSString*)path
 			withOptions:(NSDictionary*)options
 	   forResultHandler:(HandleOBPMarshalData)resultHandler
 		 orErrorHandler:(HandleOBPMarshalError)errorHandler
+{
+	// A one-off request is prepared for each send, with its path taken as given
+	OBPPreparedRequest* prepared = [[OBPPreparedRequest alloc] initWithVerb: verb pathTemplate: path options: options literal: YES];
+	return [self sendPrepared: prepared path: path payload: payload forResultHandler: resultHandler orErrorHandler: errorHandler];
+}
+- (OBPMarshalRequest*)sendPreparedRequest:(OBPPreparedRequest*)request withParameters:(NSDictionary<NSString*,id>*)parameters payload:(id)payload forResultHandler:(HandleOBPMarshalData)resultHandler orErrorHandler:(HandleOBPMarshalError)errorHandler
+{
+	NSString* path = [request pathWithParameters: parameters];
+	OBP_LOG_IF(request && !path, @"[OBPMarshal sendPreparedRequest:...] parameters %@ lack a value for path template %@", parameters, request.pathTemplate);
+	if (!path)
+		return nil;
+	return [self sendPrepared: request path: path payload: payload forResultHandler: resultHandler orErrorHandler: errorHandler ?: request.errorHandler];
+}
+- (OBPMarshalRequest*)sendPrepared:(OBPPreparedRequest*)prepared
+				path:(NSString*)path
+			 payload:(id)payload
+	forResultHandler:(HandleOBPMarshalData)resultHandler
+	  orErrorHandler:(HandleOBPMarshalError)errorHandler
+{
+	OBPResponseCache*		cache = self.responseCache;
+	HandleOBPMarshalError	eh = errorHandler ?: self.errorHandler;
+	BOOL					onlyPublicResources = prepared.onlyPublicResources;
+	dispatch_queue_t		resultQueue = prepared.resultQueue ?: self.resultQueue;
+	OBPMarshalRequest*		handle;
+	NSString*				cacheKey;
+
+	if (!cache || prepared.cacheMaxAge < 0 || prepared.verb != eOBPMarshalVerb_GET
+	 || (!_session.valid && !onlyPublicResources) || ![path length] || !resultHandler || !eh)
+		return [self sendPrepared: prepared path: path payload: payload cacheKey: nil cached: nil handle: nil forResultHandler: resultHandler orErrorHandler: errorHandler];
+
+	// Consult the response cache on the decode queue, since the entry may have to be read from disk and deserialized, and carry on from there
+	cacheKey = [OBPResponseCache keyForPath: path headers: prepared.cacheKeyHeaders authIdentity: onlyPublicResources ? nil : [self authIdentity]];
+	handle = [[OBPMarshalRequest alloc] init];
+	dispatch_async(self.decodeQueue, ^{
+		OBPResponseCacheEntry*	cached = [cache entryForKey: cacheKey];
+		NSError*				error;
+		if (cached && prepared.deserializeJSON && !cached.object)
+		if (nil == (cached.object = OBPMarshalDeserializeBody(cached.body, prepared.expectedClass, prepared.modelClass, path, NULL)))
+			[cache removeEntryForKey: cacheKey], cached = nil;
+		if (handle.cancelled)
+			error = [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorCancelled userInfo: nil];
+		else
+		if ([self sendPrepared: prepared path: path payload: payload cacheKey: cacheKey cached: cached handle: handle forResultHandler: resultHandler orErrorHandler: errorHandler])
+			return;
+		else
+			error = [NSError errorWithDomain: NSURLErrorDomain code: self->_session.valid || onlyPublicResources ? NSURLErrorCannotConnectToHost : NSURLErrorUserAuthenticationRequired userInfo: nil];
+		// ...the caller has a handle already, so learns of the failure through the error handler
+		[handle finish];
+		dispatch_async(resultQueue, ^{eh(error, path);});
+	});
+	return handle;
+}
+- (OBPMarshalRequest*)sendPrepared:(OBPPreparedRequest*)prepared
+				path:(NSString*)path
+			 payload:(id)payload
+			cacheKey:(NSString*)cacheKey	// ...nil to bypass the cache
+			  cached:(OBPResponseCacheEntry*)cached
+			  handle:(OBPMarshalRequest*)existingHandle
+	forResultHandler:(HandleOBPMarshalData)resultHandler
+	  orErrorHandler:(HandleOBPMarshalError)errorHandler
 {
 	OBPSession*				session = _session;
-	HandleOBPMarshalError	eh = errorHandler ?: _errorHandler;
+	HandleOBPMarshalError	eh = errorHandler ?: self.errorHandler;
+	BOOL					onlyPublicResources = prepared.onlyPublicResources;
 
-	if ((!session.valid && ![options[OBPMarshalOptionOnlyPublicResources] isEqual: @YES])
-	 || ![path length] || !resultHandler || !eh)
-		return NO;
+	if ((!session.valid && !onlyPublicResources)
+	 || !prepared || ![path length] || !resultHandler || !eh)
+		return nil;
 
-	NSString*				requestPath;
-	STHTTPRequest*			request;
-	STHTTPRequest __weak*	request_ifStillAround;
-	NSString*				method;
-	Class					expectedDeserializedObjectClass = [NSDictionary class];
-	id						obj;
-	BOOL					onlyPublicResources = NO;
-	BOOL					sendDictAsForm = NO;
-	BOOL					serializeToJSON = YES;
-	BOOL					deserializeJSON = YES;
-	BOOL					verbose = [[NSUserDefaults standardUserDefaults] boolForKey: @"OBPMarshalVerbose"];
-	NSArray*				acceptableStatusCodes;
-	NSDictionary*			dict;
+	OBPMarshalVerb			verb = prepared.verb;
+	NSMutableURLRequest*	request;
+	OBPTransportPriority	priority = prepared.priority;
+	NSString*				method = prepared.method;
+	Class					expectedDeserializedObjectClass = prepared.expectedClass;
+	Class					modelClass = prepared.modelClass;
+	BOOL					sendDictAsForm = prepared.sendDictAsForm;
+	BOOL					serializeToJSON = !sendDictAsForm;
+	BOOL					deserializeJSON = prepared.deserializeJSON;
+	BOOL					omitBody = prepared.omitBody;
+	dispatch_queue_t		resultQueue = prepared.resultQueue ?: self.resultQueue;
+	dispatch_queue_t		decodeQueue = self.decodeQueue;
+	BOOL					verbose = !gOBPTraceEnabled && [[NSUserDefaults standardUserDefaults] boolForKey: @"OBPMarshalVerbose"]; // ...dumps are for development; a trace records the same milestones without formatting
+	NSArray*				acceptableStatusCodes = prepared.acceptableStatusCodes;
 	NSString*				key;
 	NSData*					data;
 	NSError*				error;
-	NSMutableDictionary*	moreHeaders = [NSMutableDictionary dictionary];
+	NSMutableDictionary*	moreHeaders = [NSMutableDictionary dictionary]; // ...beyond the prepared request's own
+	NSTimeInterval			cacheMaxAge = prepared.cacheMaxAge;
+	NSTimeInterval			cacheStaleWhileRevalidate = prepared.cacheStaleWhileRevalidate;
+	NSTimeInterval			cacheAge;
+	OBPResponseCache*		cache = cacheKey ? self.responseCache : nil;
+	BOOL					revalidateInBackground = NO;
+	NSString*				coalesceKey = nil;
+	OBPMarshalFlight*		flight = nil;
+	BOOL					joined;
+	OBPMarshalRequest*		handle = existingHandle ?: [[OBPMarshalRequest alloc] init];	// ...the caller's
+	OBPMarshalRequest*		transportHandle = handle;					// ...the one that holds the transport task, which differs for a shared request
+	NSString*				metricsPathTemplate = prepared.metricsPathTemplate;
+	OBPMetrics*				metrics = [OBPMetrics sharedMetrics];
+	OBPRequestMetrics*		requestMetrics = nil;
+	NSTimeInterval			t0;
+	id						streamElementsKey = prepared.streamElementsKey;
+	HandleOBPMarshalElements	streamElementHandler = prepared.streamElementHandler;
+	OBPJSONStreamParser*	streamParser = nil;
+	dispatch_queue_t		streamQueue = nil;
+	HandleOBPTransportData	streamDataHandler = nil;
+	NSUInteger				maxRetries = prepared.maxRetries;
+	uint32_t				traceID = 0;
+	NSTimeInterval			traceStart = 0;
 
-	// Method
-	switch (verb)
+	// Answer from the entry found in the response cache, if any, which was deserialized on the decode queue
+	if (cached)
 	{
-		case eOBPMarshalVerb_GET:
-			method = @"GET";
-			acceptableStatusCodes = @[@200];
-			break;
-		case eOBPMarshalVerb_PUT:
-			method = @"PUT";
-			acceptableStatusCodes = @[@200];
-			break;
-		case eOBPMarshalVerb_POST:
-			method = @"POST";
-			acceptableStatusCodes = @[@201];
-			break;
-		case eOBPMarshalVerb_DELETE:
-			method = @"DELETE";
-			acceptableStatusCodes = @[@204];
-			break;
-		default:
-			return NO;
+		cacheAge = -[cached.storedAt timeIntervalSinceNow];
+		if (cacheAge <= cacheMaxAge + cacheStaleWhileRevalidate)
+		{
+			// Fresh, or stale but still acceptable while we revalidate in the background
+			id container = deserializeJSON ? cached.object : nil;
+			NSData* body = cached.body;
+			NSString* bodyString = omitBody ? nil : OBPMarshalBodyString(body);
+			HandleOBPMarshalData handler = resultHandler;
+			[cache countHitWithBytes: [body length] revalidated: NO];
+			dispatch_async(resultQueue, ^{handler(container, bodyString);});
+			[handle finish];
+			if (cacheAge <= cacheMaxAge)
+				return handle;
+			revalidateInBackground = YES;
+		}
+		if (cached.eTag)
+			moreHeaders[@"If-None-Match"] = cached.eTag;
+		if (cached.lastModified)
+			moreHeaders[@"If-Modified-Since"] = cached.lastModified;
+		acceptableStatusCodes = [acceptableStatusCodes arrayByAddingObject: @304];
 	}
 
-	// Options
-	if (options)
+	// When revalidating in the background, the caller has already been answered, so outcomes only update the cache
+	if (revalidateInBackground)
 	{
-		// Expected class of object after deserialisation
-		obj = options[OBPMarshalOptionExpectClass];
-		if (obj)
-		if ([obj isEqual: [NSNull null]] || obj == [NSNull class])
-			expectedDeserializedObjectClass = nil;
-		else
-			expectedDeserializedObjectClass = obj;
-
-		// Make public calls? (suppress authorisation)
-		obj = options[OBPMarshalOptionOnlyPublicResources];
-		if ([obj respondsToSelector: @selector(boolValue)])
-			onlyPublicResources = [obj boolValue];
-
-		// Send payload as form?
-		obj = options[OBPMarshalOptionSendDictAsForm];
-		if ([obj respondsToSelector: @selector(boolValue)])
-			serializeToJSON = !(sendDictAsForm = [obj boolValue]);
-
-		// Expect reply body is JSON and deserialize?
-		obj = options[OBPMarshalOptionDeserializeJSON];
-		if ([obj respondsToSelector: @selector(boolValue)])
-			deserializeJSON = [obj boolValue];
-
-		// Expect non-default reply status code(s)?
-		obj = options[OBPMarshalOptionExpectStatus];
-		if ([obj respondsToSelector: @selector(integerValue)])
-			acceptableStatusCodes = @[obj];
-		else
-		if ([obj isKindOfClass: [NSArray class]])
-			acceptableStatusCodes = obj;
+		resultHandler = ^(id deserializedObject, NSString* responseBody){};
+		eh = ^(NSError* error, NSString* path){
+			OBP_LOG_IF(verbose, @"Background revalidation of %@ got error %@", path, error);
+		};
+	}
 
-		// Add extra headers?
-		dict = obj = options[OBPMarshalOptionExtraHeaders];
-		if ([obj isKindOfClass: [NSDictionary class]])
-		for (key in dict)
-		{
-			obj = dict[key];
-			if ([obj isKindOfClass: [NSDate class]])
-				moreHeaders[key] = [OBPDateFormatter stringFromDate: obj];
-			else
-				moreHeaders[key] = [obj description];
-		}
+	// Join an identical GET already in flight, or else become the request that others can join
+	if (prepared.coalesce && verb == eOBPMarshalVerb_GET)
+	{
+		coalesceKey = [prepared coalesceKeyForPath: path conditionalHeaders: moreHeaders];
+		flight = [self joinFlightForKey: coalesceKey waiter: @[resultHandler, eh, resultQueue, handle] joined: &joined];
+		[self setCancelActionOfWaiter: handle inFlight: flight forKey: coalesceKey path: path];
+		if (joined)
+			return handle;
+		// Each waiter is called on its own result queue, so the shared handlers are called straight from the decode queue
+		resultHandler =
+			^(id deserializedObject, NSString* responseBody) {
+				for (NSArray* waiter in [self leaveFlight: flight forKey: coalesceKey])
+				{
+					HandleOBPMarshalData handler = waiter[0];
+					[waiter[3] finish];
+					dispatch_async(waiter[2], ^{handler(deserializedObject, responseBody);});
+				}
+			};
+		eh =
+			^(NSError* error, NSString* path) {
+				for (NSArray* waiter in [self leaveFlight: flight forKey: coalesceKey])
+				{
+					HandleOBPMarshalError handler = waiter[1];
+					[waiter[3] finish];
+					dispatch_async(waiter[2], ^{handler(error, path);});
+				}
+			};
+		resultQueue = nil;
+		transportHandle = flight->_request;
 	}
 
 	// Make the request and add its payload
-	requestPath = [session.serverInfo.APIBase stringForURLByAppendingPath: path];
-	request = [STHTTPRequest requestWithURLString: requestPath];
-	OBP_LOG_IF(!request, @"Unable to create request with path %@", requestPath);
+	request = [prepared requestForPath: path APIBase: session.serverInfo.APIBase];
 	if (!request)
-		return NO;
-	request.HTTPMethod = method;
+	{
+		[self abandonFlight: flight forKey: coalesceKey path: path];
+		return revalidateInBackground ? handle : nil;
+	}
 
 	if (payload)
 	{
 		if ([payload isKindOfClass: [NSData class]])
-			request.rawPOSTData = data = payload;
+			request.HTTPBody = data = payload;
 		else
 		if (sendDictAsForm)
 		{
 			if ([payload isKindOfClass: [NSDictionary class]])
-				request.POSTDictionary = payload;
+			{
+				data = [[[@"" stringByAppendingURLQueryParams: payload] substringFromIndex: 1] dataUsingEncoding: NSUTF8StringEncoding];
+				request.HTTPBody = data;
+				moreHeaders[@"Content-Type"] = @"application/x-www-form-urlencoded; charset=utf-8";
+			}
 			else
 				OBP_LOG(@"••• Payload needs to be a dictionary to send as a form; ignored: %@", payload);
 		}
@@ -209,7 +981,7 @@ NSString* NSStringDescribingNSURLResponseAndData(NSHTTPURLResponse* response, NS
 			OBP_LOG_IF(error || !data, @"Payload JSON serialize failed with error %@\n for data %@", error, payload);
 			if (data)
 			{
-				request.rawPOSTData = data;
+				request.HTTPBody = data;
 				moreHeaders[@"Content-Type"] = @"application/json";
 			}
 		}
@@ -217,54 +989,260 @@ NSString* NSStringDescribingNSURLResponseAndData(NSHTTPURLResponse* response, NS
 			OBP_LOG(@"••• Payload ignored: %@", payload);
 	}
 
-	if ([moreHeaders count])
-		[request.requestHeaders addEntriesFromDictionary: moreHeaders];
+	for (key in moreHeaders)
+		[request setValue: moreHeaders[key] forHTTPHeaderField: key];
+
+	// Trace this request? Only its path template is recorded, to keep identifiers out of the trace
+	if (gOBPTraceEnabled && 0 != (traceID = OBPTraceBeginRequest()))
+	{
+		traceStart = OBPMonotonicTime();
+		OBP_TRACE(OBPTraceKindRequestStart, traceID, verb, OBPTraceNameID([metricsPathTemplate ?: [OBPMetrics pathTemplateForPath: path] UTF8String]));
+	}
+
+	// Handlers are called on the result queue, or directly when it is nil (coalesced)
+	void (^deliverResult)(id, NSData*) = ^(id container, NSData* body) {
+		NSString* responseBody = omitBody ? nil : OBPMarshalBodyString(body);
+		OBP_TRACE(OBPTraceKindRequestEnd, traceID, 0, (OBPMonotonicTime() - traceStart) * 1e9);
+		[transportHandle finish];
+		if (resultQueue)
+			dispatch_async(resultQueue, ^{resultHandler(container, responseBody);});
+		else
+			resultHandler(container, responseBody);
+	};
+	void (^deliverError)(NSError*) = ^(NSError* error) {
+		OBP_TRACE_ERROR(traceID, error.code, [error.domain UTF8String]);
+		OBP_TRACE(OBPTraceKindRequestEnd, traceID, error.code ?: -1, (OBPMonotonicTime() - traceStart) * 1e9);
+		[transportHandle finish];
+		if (resultQueue)
+			dispatch_async(resultQueue, ^{eh(error, path);});
+		else
+			eh(error, path);
+	};
 
-	// Reply handler
-	request_ifStillAround = request;
-    request.completionBlock = ^(NSDictionary *headers, NSString *body) {
-		STHTTPRequest *request = request_ifStillAround;
-		NSInteger status = request.responseStatus;
-		OBP_LOG_IF(verbose, @"\nResponse: %d\nHeaders: %@\nBody: %@", (int)status, headers, body);
-		NSError* error = nil;
-		BOOL handled = NO;
+	// Measure this request?
+	if (metrics.enabled)
+		requestMetrics = [[OBPRequestMetrics alloc] initWithServer: session.serverInfo.APIBase method: method pathTemplate: metricsPathTemplate ?: [OBPMetrics pathTemplateForPath: path]];
+
+	// Authorise; the session wraps our error handler so that it can detect revoked access, and it may be called on any queue
+	HandleResultBlock onError = ^(NSError* error) {
+		deliverError(error);
+	};
+	t0 = OBPMonotonicTime();
+	if (!onlyPublicResources && ![session authorizeURLRequest: request andWrapErrorHandler: &onError])
+	{
+		[self abandonFlight: flight forKey: coalesceKey path: path];
+		return revalidateInBackground ? handle : nil;
+	}
+	if (!onlyPublicResources)
+	{
+		t0 = OBPMonotonicTime() - t0;
+		requestMetrics.signing = t0;
+		OBP_TRACE(OBPTraceKindAuth, traceID, 0, t0 * 1e9);
+	}
+
+	// In streaming mode, each piece of the body is parsed in turn on a serial queue, and the elements it completes are passed on together
+	__block BOOL				streamStopped = NO;
+	__block NSError*			streamError = nil;
+	__block NSTimeInterval		streamDecodeTime = 0;
+	if (streamElementsKey)
+	{
+		NSMutableArray*		elements = [NSMutableArray array];
+		OBPModelDecoder*	decoder = modelClass ? [[OBPModelDecoder alloc] init] : nil;
+		__block NSUInteger	delivered = 0;
+
+		streamQueue = dispatch_queue_create("com.tesobe.OBPKit.OBPMarshal.stream", DISPATCH_QUEUE_SERIAL);
+		dispatch_set_target_queue(streamQueue, decodeQueue);
+		decodeQueue = streamQueue;
+		streamParser = [[OBPJSONStreamParser alloc] initWithElementsKey: streamElementsKey == [NSNull null] ? nil : streamElementsKey
+														 elementHandler:
+			^(id element, BOOL* stop) {
+				NSError* error = nil;
+				if (decoder && nil == (element = [decoder decodeJSONObject: element modelClass: modelClass error: &error]))
+				{
+					OBP_LOG(@"Streamed element of resource at path %@ could not be decoded as %@", path, NSStringFromClass(modelClass));
+					streamError = error;
+					*stop = YES;
+					return;
+				}
+				[elements addObject: element];
+			}];
+		void (^stopStream)(void) = ^{
+			dispatch_async(streamQueue, ^{
+				streamStopped = YES;
+				[transportHandle cancel];
+			});
+		};
+		streamDataHandler = ^(NSHTTPURLResponse* response, NSData* data) {
+			if (streamStopped || streamError)
+				return;
+			NSTimeInterval decodeStart = OBPMonotonicTime();
+			if (![streamParser parseData: data])
+			{
+				// Malformed, or an element could not be decoded: the rest of the body is of no use
+				streamError = streamError ?: streamParser.error;
+				[transportHandle cancel];
+			}
+			streamDecodeTime += OBPMonotonicTime() - decodeStart;
+			if (![elements count])
+				return;
+			NSArray* batch = [elements copy];
+			NSUInteger offset = delivered;
+			[elements removeAllObjects];
+			delivered += [batch count];
+			dispatch_async(resultQueue, ^{
+				BOOL stop = NO;
+				streamElementHandler(batch, offset, &stop);
+				if (stop)
+					stopStream();
+			});
+		};
+	}
+
+	// Idempotent GETs refused for load, or lost in transit, are retried after a jittered backoff, each time signed afresh
+	__block void (^retry)(NSHTTPURLResponse*, NSData*, NSError*) = nil;
+	__block NSUInteger retryCount = 0;
+
+	// Reply handler, called on the decode queue
+	HandleOBPTransportResponse responseHandler = ^(NSHTTPURLResponse* response, NSData* responseData, NSError* error) {
+		OBP_TRACE(OBPTraceKindResponse, traceID, response.statusCode, [responseData length]);
+		if (streamParser && streamError)
+		{
+			// Cancelled because the body could not be parsed or decoded; report that rather than the cancellation
+			retry = nil;
+			OBP_LOG(@"Streamed resource at path %@ ended with error %@", path, streamError);
+			error = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResourceKind userInfo: @{NSLocalizedDescriptionKey : @"Unexpected response data type.", NSUnderlyingErrorKey : streamError}];
+			requestMetrics.decode = streamDecodeTime;
+			requestMetrics.error = error;
+			[metrics recordRequest: requestMetrics];
+			deliverError(error);
+			return;
+		}
+		if (streamParser && streamStopped)
+		{
+			// Cancelled by the element handler, which has had all it wanted
+			retry = nil;
+			[metrics recordRequest: requestMetrics];
+			deliverResult(@(streamParser.elementCount), nil);
+			return;
+		}
+		if (retry && retryCount < maxRetries && (response || !streamParser) && !transportHandle.cancelled && [OBPRateController shouldRetryResponse: response error: error])
+		{
+			retry(response, responseData, error);
+			return;
+		}
+		retry = nil; // ...which releases the blocks it holds
+		if (!error && !response)
+			error = [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorBadServerResponse userInfo: nil];
+		if (!error)
+			error = [OBPTransport errorForResponse: response data: responseData];
+		if (error)
+		{
+			OBP_LOG_IF(verbose && response, @"\n%@", NSStringDescribingNSURLResponseAndData(response, responseData));
+			requestMetrics.error = error;
+			[metrics recordRequest: requestMetrics];
+			onError(error);
+			return;
+		}
+		NSInteger status = response.statusCode;
+		NSDictionary* headers = response.allHeaderFields;
+		OBP_LOG_IF(verbose, @"\n%@", NSStringDescribingNSURLResponseAndData(response, responseData));
+		if (status == 304 && cached)
+		{
+			[cache touchEntry: cached forKey: cacheKey];
+			[cache countHitWithBytes: [cached.body length] revalidated: YES];
+			[metrics recordRequest: requestMetrics];
+			deliverResult(deserializeJSON ? cached.object : nil, cached.body);
+		}
+		else
         if (NSNotFound != [acceptableStatusCodes indexOfObject: @(status)])
 		{
             id container = nil;
+			if (streamParser)
+			{
+				requestMetrics.decode = streamDecodeTime;
+				OBP_TRACE(OBPTraceKindDecode, traceID, streamParser.elementCount, streamDecodeTime * 1e9);
+				if (!streamError && ![streamParser finish])
+					streamError = streamParser.error;
+				if (streamError)
+				{
+					OBP_LOG(@"Streamed resource at path %@ ended with error %@", path, streamError);
+					error = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResourceKind userInfo: @{NSLocalizedDescriptionKey : @"Unexpected response data type.", NSUnderlyingErrorKey : streamError}];
+				}
+				requestMetrics.error = error;
+				[metrics recordRequest: requestMetrics];
+				if (!error)
+					deliverResult(@(streamParser.elementCount), nil);
+				else
+					deliverError(error);
+				return;
+			}
 			if (deserializeJSON)
 			{
-				container = [NSJSONSerialization JSONObjectWithData: [body dataUsingEncoding: NSUTF8StringEncoding] options: 0 error: &error];
-				OBP_LOG_IF(error, @"[NSJSONSerialization JSONObjectWithData: data options: 0 error:] gave error:\nerror = %@\ndata = %@", error, body);
-				OBP_LOG_IF(!error && expectedDeserializedObjectClass && ![container isKindOfClass: expectedDeserializedObjectClass], @"Expected to resource at path %@ to yield a %@, but got instead got:\n%@\nfrom body: %@", path, NSStringFromClass(expectedDeserializedObjectClass), container, body);
-				if (!error && expectedDeserializedObjectClass && ![container isKindOfClass: expectedDeserializedObjectClass])
-					error = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResourceKind userInfo:@{NSLocalizedDescriptionKey:@"Unexpected response data type.",@"body":body?:@""}];
+				NSTimeInterval decodeStart = OBPMonotonicTime();
+				container = OBPMarshalDeserializeBody(responseData, expectedDeserializedObjectClass, modelClass, path, &error);
+				requestMetrics.decode = OBPMonotonicTime() - decodeStart;
+				OBP_TRACE(OBPTraceKindDecode, traceID, [responseData length], (OBPMonotonicTime() - decodeStart) * 1e9);
 			}
+			if (!error && cache && status == 200)
+			{
+				OBPResponseCacheEntry* entry;
+				entry = [[OBPResponseCacheEntry alloc] initWithBody: responseData eTag: OBPHeaderValue(headers, @"ETag") lastModified: OBPHeaderValue(headers, @"Last-Modified")];
+				entry.object = container;
+				[cache storeEntry: entry forKey: cacheKey];
+				[cache countMissWithBytes: [responseData length]];
+			}
+			requestMetrics.error = error;
+			[metrics recordRequest: requestMetrics];
 			if (!error)
-				resultHandler(container, body), handled = YES;
+				deliverResult(container, responseData);
+			else
+				deliverError(error);
 		}
 		else
 		{
+			NSString* body = OBPMarshalBodyString(responseData);
 			OBP_LOG(@"Unexpected response (%@), when expecting %@; body = %@", @(status), acceptableStatusCodes, body);
-			error = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResult userInfo:@{NSLocalizedDescriptionKey:[NSString stringWithFormat: @"Unexpected response status (%@).", @(status)],@"body":body?:@""}];
+			error = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResult userInfo:@{NSLocalizedDescriptionKey:[NSString stringWithFormat: @"Unexpected response status (%@).", @(status)],@"body":body}];
+			requestMetrics.error = error;
+			[metrics recordRequest: requestMetrics];
+			deliverError(error);
 		}
-		if (!handled)
-			eh(error, path);
 	};
 
-	// Error handler
-	request.errorBlock = ^(NSError *error) {
-        eh(error, path);
-    };
-
-	// Authorise and send
-	if (onlyPublicResources || [session authorizeSTHTTPRequest: request])
-	{
-		[request startAsynchronous];
-		OBP_LOG_IF(verbose, @"\n%@", NSStringDescribingNSURLRequest((NSURLRequest*)[(id)request performSelector: @selector(request)]));
-		return YES;
-	}
+	// Send
+	OBP_LOG_IF(verbose, @"\n%@", NSStringDescribingNSURLRequest(request));
+	BOOL (^send)(NSURLRequest*) = ^BOOL(NSURLRequest* signedRequest) {
+		OBPTransportTask* task = [session.transport sendRequest: signedRequest priority: priority handlerQueue: decodeQueue metrics: requestMetrics dataHandler: streamDataHandler responseHandler: responseHandler];
+		[transportHandle attachTask: task]; // ...so that it can be cancelled; cancelling a finished task has no effect
+		return task != nil;
+	};
+	if (verb == eOBPMarshalVerb_GET && maxRetries)
+		retry = ^(NSHTTPURLResponse* response, NSData* responseData, NSError* error) {
+			NSTimeInterval delay = [session.transport.rateController retryDelayForAttempt: retryCount++ response: response];
+			OBP_TRACE(OBPTraceKindRetry, traceID, retryCount, delay * 1e9);
+			OBP_LOG_IF(verbose, @"Retrying request for %@ in %.2fs after %@", path, delay, error ?: @(response.statusCode));
+			dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), decodeQueue, ^{
+				NSMutableURLRequest* again = [request mutableCopy];
+				if (transportHandle.cancelled)
+				{
+					// Cancelled while waiting to retry
+					retry = nil;
+					responseHandler(nil, nil, [NSError errorWithDomain: NSURLErrorDomain code: NSURLErrorCancelled userInfo: nil]);
+					return;
+				}
+				if ((onlyPublicResources || [session authorizeURLRequest: again andWrapErrorHandler: NULL]) && send(again))
+					return;
+				// Unable to send again, so the last outcome stands
+				retry = nil;
+				dispatch_async(decodeQueue, ^{responseHandler(response, responseData, error);});
+			});
+		};
+	if (send(request))
+		return handle;
+	retry = nil;
 
-	return NO;
+	[self abandonFlight: flight forKey: coalesceKey path: path];
+	return revalidateInBackground ? handle : nil;
 }
 @end
 
@@ -0,0 +1,82 @@
+//
+//  OBPModel.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+/// OBPAmount holds a monetary amount exactly, as a fixed-point number: the amount is units × 10^-scale, e.g. "-12.50" is {-1250, 2}.
+typedef struct OBPAmount {
+	int64_t		units;
+	int16_t		scale;
+} OBPAmount;
+
+BOOL OBPAmountFromString(NSString* _Nullable string, OBPAmount* amountAt); ///< Parse a decimal string such as "-1234.56" into *amountAt without rounding. \returns NO if string is not a plain decimal number or has more significant digits than an int64_t can hold.
+NSString* NSStringFromOBPAmount(OBPAmount amount); ///< Return the amount as a decimal string, with exactly scale digits after the point.
+NSDecimalNumber* NSDecimalNumberFromOBPAmount(OBPAmount amount); ///< Return the amount as a decimal number.
+
+
+
+typedef NS_ENUM(uint8_t, OBPModelFieldKind)
+{
+	OBPModelFieldKindString,			///< NSString* property; non-string JSON values are converted with -description.
+	OBPModelFieldKindInternedString,	///< NSString* property for values that repeat across many objects, such as currency codes and bank IDs; equal values share one instance.
+	OBPModelFieldKindAmount,			///< OBPAmount property, from a JSON string or number.
+	OBPModelFieldKindDate,				///< NSTimeInterval property, seconds since the NSDate reference date, parsed from an OBP date string; NAN when absent or unrecognised.
+	OBPModelFieldKindInteger,			///< int64_t property, from a JSON number or string.
+	OBPModelFieldKindBool,				///< BOOL property, from a JSON boolean, number or string.
+	OBPModelFieldKindModel,				///< Property holding an instance of an OBPModel subclass, from a JSON object.
+	OBPModelFieldKindModelArray,		///< NSArray* property holding instances of an OBPModel subclass, from a JSON array of objects.
+	OBPModelFieldKindJSON,				///< id property holding the JSON value as deserialized, for parts of a resource that have no model.
+
+	OBPModelFieldKind_count
+};
+
+
+
+/// An OBPModelField instance maps one property of an OBPModel subclass to a value in the JSON object for the model.
+@interface OBPModelField : NSObject
++ (instancetype)fieldWithName:(NSString*)name keyPath:(NSString*)keyPath kind:(OBPModelFieldKind)kind; ///< \param name is the name of the property, which must be backed by an instance variable of the same name with a leading underscore. \param keyPath locates the value in the JSON object, using dots to step into nested objects, e.g. @"details.value.amount".
++ (instancetype)fieldWithName:(NSString*)name keyPath:(NSString*)keyPath modelClass:(Class)modelClass; ///< Map a nested JSON object to a property holding an instance of modelClass.
++ (instancetype)fieldWithName:(NSString*)name keyPath:(NSString*)keyPath arrayOfModelClass:(Class)modelClass; ///< Map a nested JSON array of objects to an NSArray property holding instances of modelClass.
+@property (nonatomic, copy, readonly) NSString* name;
+@property (nonatomic, copy, readonly) NSString* keyPath;
+@property (nonatomic, readonly) OBPModelFieldKind kind;
+@property (nonatomic, readonly, nullable) Class modelClass;
+@end
+
+
+
+/**	An OBPModelDecoder instance maps deserialized JSON to OBPModel instances, and interns the repeated strings it meets along the way, so that all the objects decoded by one decoder share a single instance of each repeated value.
+
+	Use one decoder per response, or per batch of related responses; a decoder must only be used by one thread at a time.
+*/
+@interface OBPModelDecoder : NSObject
+- (nullable id)decodeJSONObject:(id)object modelClass:(Class)modelClass error:(NSError**)errorAt; ///< Decode a response into models: a JSON array gives an NSArray of models; a JSON object holding an array under the model class's collectionKey gives an NSArray of models from that array; any other JSON object gives a single model. \returns nil and sets *errorAt if object has an unexpected shape.
+- (NSString*)internString:(NSString*)string; ///< Return the instance of string already held by this decoder, or add and return string.
+@end
+
+
+
+/**	OBPModel is the base class of compact, typed models of OBP resources, which take far less memory than the equivalent trees of dictionaries and arrays, and have amounts and dates parsed once, at decoding time.
+
+	A subclass declares its readonly properties with instance variables, and overrides +modelFields to describe how each property is found in the JSON for the resource. OBPMarshal decodes responses into models when you add OBPMarshalOptionModelClass : [YourModel class] to your options dictionary.
+*/
+@interface OBPModel : NSObject
++ (NSArray<OBPModelField*>*)modelFields; ///< Override to return the fields of your model; include the fields of super if it is itself a model with fields. The default returns an empty array.
++ (nullable NSString*)collectionKey; ///< Override to name the array holding instances of your model in collection responses, e.g. @"transactions". The default returns nil.
++ (nullable instancetype)modelWithJSONObject:(NSDictionary*)object decoder:(OBPModelDecoder*)decoder; ///< Create an instance from a JSON object. Fields not present in object are left empty (nil, zero or NAN).
+@end
+
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,365 @@
+//
+//  OBPModel.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPModel.h"
+// sdk
+#import <objc/runtime.h>
+// prj
+#import "OBPMarshal.h"
+#import "OBPDateFormatter.h"
+#import "OBPLogging.h"
+
+
+
+#define kOBPAmountMaxChars	64
+
+
+
+#pragma mark -
+BOOL OBPAmountFromString(NSString* string, OBPAmount* amountAt)
+{
+	char			buf[kOBPAmountMaxChars];
+	const char*		p;
+	uint64_t		units = 0;
+	int				scale = 0;
+	BOOL			negative = NO, point = NO, digits = NO;
+
+	if (!amountAt || ![string length] || [string length] >= kOBPAmountMaxChars)
+		return NO;
+	if (nil == (p = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingASCII)))
+	{
+		if (![string getCString: buf maxLength: sizeof(buf) encoding: NSASCIIStringEncoding])
+			return NO;
+		p = buf;
+	}
+
+	if (*p == '-' || *p == '+')
+		negative = *p++ == '-';
+	for (; *p; p++)
+	{
+		if (*p == '.' && !point)
+			{point = YES; continue;}
+		if (*p < '0' || *p > '9')
+			return NO;
+		if (units > (INT64_MAX - 9) / 10)
+			return NO;
+		units = units * 10 + (uint64_t)(*p - '0');
+		digits = YES;
+		if (point)
+			scale++;
+	}
+	if (!digits)
+		return NO;
+
+	amountAt->units = negative ? -(int64_t)units : (int64_t)units;
+	amountAt->scale = (int16_t)scale;
+	return YES;
+}
+
+NSString* NSStringFromOBPAmount(OBPAmount amount)
+{
+	char		buf[kOBPAmountMaxChars];
+	char*		p = buf + sizeof(buf);
+	uint64_t	units = amount.units < 0 ? 0 - (uint64_t)amount.units : (uint64_t)amount.units;
+	int			scale = MAX(0, MIN(amount.scale, kOBPAmountMaxChars - 24));
+	int			n = 0;
+
+	*--p = 0;
+	do {
+		if (n == scale && n)
+			*--p = '.';
+		*--p = '0' + (char)(units % 10);
+		units /= 10;
+		n++;
+	} while (units || n <= scale);
+	if (amount.units < 0)
+		*--p = '-';
+
+	return [NSString stringWithUTF8String: p];
+}
+
+NSDecimalNumber* NSDecimalNumberFromOBPAmount(OBPAmount amount)
+{
+	uint64_t	units = amount.units < 0 ? 0 - (uint64_t)amount.units : (uint64_t)amount.units;
+	return [NSDecimalNumber decimalNumberWithMantissa: units exponent: -amount.scale isNegative: amount.units < 0];
+}
+
+
+
+#pragma mark -
+@interface OBPModelField ()
+{
+@public
+	NSArray<NSString*>*		_keys;			// keyPath split at dots
+	ptrdiff_t				_offset;		// of the backing instance variable, once resolved
+}
+@end
+
+
+
+@interface OBPModelDecoder ()
+- (NSArray<OBPModelField*>*)fieldsForClass:(Class)cls;
+- (void)decodeObject:(NSDictionary*)object intoModel:(OBPModel*)model;
+@end
+
+
+
+@implementation OBPModelField
++ (instancetype)fieldWithName:(NSString*)name keyPath:(NSString*)keyPath kind:(OBPModelFieldKind)kind modelClass:(Class)modelClass
+{
+	OBPModelField*	field = [[self alloc] init];
+	field->_name = [name copy];
+	field->_keyPath = [keyPath copy];
+	field->_keys = [keyPath componentsSeparatedByString: @"."];
+	field->_kind = kind;
+	field->_modelClass = modelClass;
+	return field;
+}
++ (instancetype)fieldWithName:(NSString*)name keyPath:(NSString*)keyPath kind:(OBPModelFieldKind)kind
+{
+	OBP_ASSERT(kind != OBPModelFieldKindModel && kind != OBPModelFieldKindModelArray);
+	return [self fieldWithName: name keyPath: keyPath kind: kind modelClass: Nil];
+}
++ (instancetype)fieldWithName:(NSString*)name keyPath:(NSString*)keyPath modelClass:(Class)modelClass
+{
+	return [self fieldWithName: name keyPath: keyPath kind: OBPModelFieldKindModel modelClass: modelClass];
+}
++ (instancetype)fieldWithName:(NSString*)name keyPath:(NSString*)keyPath arrayOfModelClass:(Class)modelClass
+{
+	return [self fieldWithName: name keyPath: keyPath kind: OBPModelFieldKindModelArray modelClass: modelClass];
+}
+- (BOOL)resolveInClass:(Class)cls
+{
+	NSString*		ivarName = [@"_" stringByAppendingString: _name];
+	Ivar			ivar = class_getInstanceVariable(cls, [ivarName UTF8String]);
+	const char*		type = ivar ? ivar_getTypeEncoding(ivar) : NULL;
+	BOOL			ok = NO;
+
+	if (type)
+	switch (_kind)
+	{
+		case OBPModelFieldKindAmount:	ok = 0 == strcmp(type, @encode(OBPAmount)); break;
+		case OBPModelFieldKindDate:		ok = 0 == strcmp(type, @encode(NSTimeInterval)); break;
+		case OBPModelFieldKindInteger:	ok = 0 == strcmp(type, @encode(int64_t)); break;
+		case OBPModelFieldKindBool:		ok = 0 == strcmp(type, @encode(BOOL)) || 0 == strcmp(type, @encode(bool)); break;
+		default:						ok = type[0] == '@'; break;
+	}
+
+	OBP_LOG_IF(!ok, @"[OBPModelField resolveInClass: %@] • no suitable instance variable %@ for field of kind %d •", cls, ivarName, (int)_kind);
+	if (ok)
+		_offset = ivar_getOffset(ivar);
+	return ok;
+}
+@end
+
+
+
+#pragma mark -
+@implementation OBPModelDecoder
+{
+	NSMutableSet<NSString*>*	_strings;
+	NSMutableDictionary<NSString*,NSArray<OBPModelField*>*>*
+								_fieldsByClass;		// resolved, by class name
+}
+static NSMutableDictionary<NSString*,NSArray<OBPModelField*>*>* sResolvedFields = nil;
+- (instancetype)init
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_strings = [NSMutableSet set];
+	_fieldsByClass = [NSMutableDictionary dictionary];
+	return self;
+}
+- (NSString*)internString:(NSString*)string
+{
+	NSString* held = [_strings member: string];
+	if (held)
+		return held;
+	string = [string copy];
+	[_strings addObject: string];
+	return string;
+}
+- (NSArray<OBPModelField*>*)fieldsForClass:(Class)cls
+{
+	NSString*				className = NSStringFromClass(cls);
+	NSArray<OBPModelField*>*fields = _fieldsByClass[className];
+	NSMutableArray*			resolved;
+	OBPModelField*			field;
+
+	if (fields)
+		return fields;
+
+	@synchronized ([OBPModelDecoder class]) {
+		if (nil == (fields = sResolvedFields[className]))
+		{
+			// Resolve each field to its instance variable once per process, dropping any that do not match
+			resolved = [NSMutableArray array];
+			for (field in [cls modelFields])
+				if ([field resolveInClass: cls])
+					[resolved addObject: field];
+			fields = [resolved copy];
+			if (!sResolvedFields)
+				sResolvedFields = [NSMutableDictionary dictionary];
+			sResolvedFields[className] = fields;
+		}
+	}
+
+	_fieldsByClass[className] = fields;
+	return fields;
+}
+#pragma mark -
+- (id)decodeJSONObject:(id)object modelClass:(Class)modelClass error:(NSError**)errorAt
+{
+	NSString*		key;
+	id				result = nil;
+
+	if (![modelClass isSubclassOfClass: [OBPModel class]])
+		OBP_LOG(@"[OBPModelDecoder decodeJSONObject:modelClass: %@] • not a subclass of OBPModel •", modelClass);
+	else
+	if ([object isKindOfClass: [NSArray class]])
+		result = [self modelsFromArray: object modelClass: modelClass];
+	else
+	if ([object isKindOfClass: [NSDictionary class]])
+	{
+		if (nil != (key = [modelClass collectionKey]) && [object[key] isKindOfClass: [NSArray class]])
+			result = [self modelsFromArray: object[key] modelClass: modelClass];
+		else
+			result = [modelClass modelWithJSONObject: object decoder: self];
+	}
+
+	if (!result && errorAt)
+		*errorAt = [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResourceKind userInfo: @{NSLocalizedDescriptionKey : @"Unexpected response data type."}];
+	return result;
+}
+- (NSArray*)modelsFromArray:(NSArray*)array modelClass:(Class)modelClass
+{
+	NSMutableArray*		models = [NSMutableArray arrayWithCapacity: [array count]];
+	id					element, model;
+
+	for (element in array)
+	{
+		if (![element isKindOfClass: [NSDictionary class]])
+			return nil;
+		if (nil == (model = [modelClass modelWithJSONObject: element decoder: self]))
+			return nil;
+		[models addObject: model];
+	}
+	return [models copy];
+}
+- (void)decodeObject:(NSDictionary*)object intoModel:(OBPModel*)model
+{
+	OBPModelField*		field;
+	NSString*			key;
+	id					value;
+	uint8_t*			base = (__bridge void*)model;
+
+	for (field in [self fieldsForClass: [model class]])
+	{
+		value = object;
+		for (key in field->_keys)
+			value = [value isKindOfClass: [NSDictionary class]] ? value[key] : nil;
+		if (value == [NSNull null])
+			value = nil;
+
+		switch (field.kind)
+		{
+			case OBPModelFieldKindString:
+			case OBPModelFieldKindInternedString:
+				if (value && ![value isKindOfClass: [NSString class]])
+					value = [value description];
+				if (value && field.kind == OBPModelFieldKindInternedString)
+					value = [self internString: value];
+				if (value)
+					[model setValue: value forKey: field.name];
+				break;
+
+			case OBPModelFieldKindAmount:
+				if ([value isKindOfClass: [NSNumber class]])
+					value = [value stringValue];
+				if ([value isKindOfClass: [NSString class]] && !OBPAmountFromString(value, (OBPAmount*)(base + field->_offset)))
+					OBP_LOG(@"[OBPModelDecoder decodeObject:intoModel: %@] • amount %@ for %@ not recognised •", [model class], value, field.keyPath);
+				break;
+
+			case OBPModelFieldKindDate:
+				*(NSTimeInterval*)(base + field->_offset) = [value isKindOfClass: [NSString class]] ? [OBPDateFormatter timeIntervalFromString: value] : NAN;
+				break;
+
+			case OBPModelFieldKindInteger:
+				if ([value respondsToSelector: @selector(longLongValue)])
+					*(int64_t*)(base + field->_offset) = [value longLongValue];
+				break;
+
+			case OBPModelFieldKindBool:
+				if ([value respondsToSelector: @selector(boolValue)])
+					*(BOOL*)(base + field->_offset) = [value boolValue];
+				break;
+
+			case OBPModelFieldKindModel:
+				if ([value isKindOfClass: [NSDictionary class]] && nil != (value = [field.modelClass modelWithJSONObject: value decoder: self]))
+					[model setValue: value forKey: field.name];
+				break;
+
+			case OBPModelFieldKindModelArray:
+				if ([value isKindOfClass: [NSArray class]] && nil != (value = [self modelsFromArray: value modelClass: field.modelClass]))
+					[model setValue: value forKey: field.name];
+				break;
+
+			case OBPModelFieldKindJSON:
+				if (value)
+					[model setValue: value forKey: field.name];
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+@end
+
+
+
+#pragma mark -
+@implementation OBPModel
++ (NSArray<OBPModelField*>*)modelFields
+{
+	return @[];
+}
++ (NSString*)collectionKey
+{
+	return nil;
+}
++ (instancetype)modelWithJSONObject:(NSDictionary*)object decoder:(OBPModelDecoder*)decoder
+{
+	if (![object isKindOfClass: [NSDictionary class]] || !decoder)
+		return nil;
+	OBPModel* model = [[self alloc] init];
+	[decoder decodeObject: object intoModel: model];
+	return model;
+}
+- (NSString*)description
+{
+	NSMutableString*	s = [NSMutableString stringWithFormat: @"<%@ %p", [self class], self];
+	OBPModelDecoder*	decoder = [[OBPModelDecoder alloc] init];
+	OBPModelField*		field;
+	uint8_t*			base = (__bridge void*)self;
+	id					value;
+
+	for (field in [decoder fieldsForClass: [self class]])
+	{
+		switch (field.kind)
+		{
+			case OBPModelFieldKindAmount:	value = NSStringFromOBPAmount(*(OBPAmount*)(base + field->_offset)); break;
+			case OBPModelFieldKindDate:		value = isnan(*(NSTimeInterval*)(base + field->_offset)) ? nil : [NSDate dateWithTimeIntervalSinceReferenceDate: *(NSTimeInterval*)(base + field->_offset)]; break;
+			default:						value = [self valueForKey: field.name]; break;
+		}
+		[s appendFormat: @"; %@ = %@", field.name, value];
+	}
+	[s appendString: @">"];
+	return s;
+}
+@end
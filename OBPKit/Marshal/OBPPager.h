@@ -0,0 +1,48 @@
+//
+//  OBPPager.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+@class OBPMarshal;
+
+
+
+typedef void(^HandleOBPPagerPage)(NSArray* elements, NSUInteger offset, BOOL* stop); // (elements, offset, stop)
+typedef void(^HandleOBPPagerCompletion)(NSUInteger elementCount, NSError* _Nullable error); // (elementCount, error)
+
+
+
+/**	An OBPPager instance fetches a collection resource page by page, using the obp_limit and obp_offset headers, keeping several page requests in flight at once.
+
+	Pages are delivered to the page handler strictly in order of offset, and at most pagesInFlight pages are ever requested ahead of the next page to be delivered, so memory use is bounded by the window regardless of the size of the collection. Paging ends at the first page holding fewer elements than the page size, and any requests for pages beyond it are cancelled.
+
+	The completion handler is called exactly once: with a nil error once the last page has been delivered, with the error of the first page to fail, or with NSUserCancelledError if paging was cancelled or the page handler set *stop.
+
+	Obtain an instance through -[OBPMarshal pageResourcesAtAPIPath:elementsKey:withOptions:forPageHandler:completion:]. A running pager keeps itself alive until completion, and all handlers are called on the main queue; call -cancel from the main queue too.
+*/
+@interface OBPPager : NSObject
+- (nullable instancetype)initWithMarshal:(OBPMarshal*)marshal path:(NSString*)path elementsKey:(nullable NSString*)elementsKey options:(nullable NSDictionary*)options pageHandler:(HandleOBPPagerPage)pageHandler completion:(HandleOBPPagerCompletion)completion; ///< Designated initialiser. \param path identifies the collection resource, relative to the API base URL. \param elementsKey names the array in the deserialized response holding the page elements, e.g. @"transactions"; pass nil if the response is itself an array. \param options may supply the usual OBPMarshal options, plus OBPMarshalOptionPageSize and OBPMarshalOptionPagesInFlight; with OBPMarshalOptionModelClass, elementsKey should match the model class's collectionKey.
+
+@property (nonatomic, readonly) NSUInteger pageSize; ///< Number of elements requested per page (OBPMarshalOptionPageSize; default 50).
+@property (nonatomic, readonly) NSUInteger pagesInFlight; ///< Maximum number of page requests outstanding ahead of the next page to be delivered (OBPMarshalOptionPagesInFlight; default 4).
+@property (nonatomic, readonly) NSUInteger elementCount; ///< Number of elements delivered so far.
+@property (nonatomic, readonly) BOOL finished; ///< YES once the completion handler has been called.
+
+- (BOOL)start; ///< Start requesting pages. \returns NO if the first requests could not be launched, in which case the completion handler has been called with an error.
+- (void)cancel; ///< Stop requesting and delivering pages, cancel the page requests still in flight, and call the completion handler with NSUserCancelledError. Has no effect once finished.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
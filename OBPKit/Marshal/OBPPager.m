@@ -0,0 +1,221 @@
+//
+//  OBPPager.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPPager.h"
+// prj
+#import "OBPMarshal.h"
+#import "OBPLogging.h"
+
+
+
+#define kOBPPagerDefaultPageSize		50
+#define kOBPPagerDefaultPagesInFlight	4
+
+
+
+@implementation OBPPager
+{
+	OBPMarshal*						_marshal;
+	NSString*						_path;
+	NSString*						_elementsKey;
+	NSDictionary*					_options;
+	NSDictionary*					_extraHeaders;
+	HandleOBPPagerPage				_pageHandler;
+	HandleOBPPagerCompletion		_completion;
+	NSMutableDictionary<NSNumber*,NSArray*>*
+									_received;			// pages received ahead of delivery, by page index
+	NSMutableDictionary<NSNumber*,OBPMarshalRequest*>*
+									_inFlight;			// page requests awaiting their response, by page index
+	NSUInteger						_nextPageToRequest;
+	NSUInteger						_nextPageToDeliver;
+	NSUInteger						_lastPage;			// NSNotFound until a short page has been seen
+	OBPPager*						_keepAlive;
+}
+- (instancetype)initWithMarshal:(OBPMarshal*)marshal path:(NSString*)path elementsKey:(NSString*)elementsKey options:(NSDictionary*)options pageHandler:(HandleOBPPagerPage)pageHandler completion:(HandleOBPPagerCompletion)completion
+{
+	if (!marshal || ![path length] || !pageHandler || !completion)
+		{self = nil; return nil;}
+	if (nil == (self = [super init]))
+		return nil;
+
+	id						obj;
+	NSMutableDictionary*	md;
+
+	_marshal = marshal;
+	_path = [path copy];
+	_elementsKey = [elementsKey copy];
+	_pageHandler = pageHandler;
+	_completion = completion;
+	_received = [NSMutableDictionary dictionary];
+	_inFlight = [NSMutableDictionary dictionary];
+	_lastPage = NSNotFound;
+
+	_pageSize = kOBPPagerDefaultPageSize;
+	obj = options[OBPMarshalOptionPageSize];
+	if ([obj respondsToSelector: @selector(unsignedIntegerValue)] && [obj unsignedIntegerValue])
+		_pageSize = [obj unsignedIntegerValue];
+
+	_pagesInFlight = kOBPPagerDefaultPagesInFlight;
+	obj = options[OBPMarshalOptionPagesInFlight];
+	if ([obj respondsToSelector: @selector(unsignedIntegerValue)] && [obj unsignedIntegerValue])
+		_pagesInFlight = [obj unsignedIntegerValue];
+
+	obj = options[OBPMarshalOptionExtraHeaders];
+	_extraHeaders = [obj isKindOfClass: [NSDictionary class]] ? obj : @{};
+
+	md = [(options ?: @{}) mutableCopy];
+	[md removeObjectForKey: OBPMarshalOptionPageSize];
+	[md removeObjectForKey: OBPMarshalOptionPagesInFlight];
+	md[OBPMarshalOptionResultQueue] = dispatch_get_main_queue(); // ...our state is only touched on the main queue, whatever the marshal's resultQueue
+	if (!md[OBPMarshalOptionOmitResponseBody])
+		md[OBPMarshalOptionOmitResponseBody] = @YES; // ...only the deserialized pages are used
+	if (!md[OBPMarshalOptionExpectClass])
+		md[OBPMarshalOptionExpectClass] = _elementsKey ? [NSDictionary class] : [NSArray class];
+	_options = [md copy];
+
+	return self;
+}
+#pragma mark -
+- (BOOL)start
+{
+	if (_finished || _keepAlive)
+		return NO;
+	_keepAlive = self;
+	[self requestMorePages];
+	return !_finished;
+}
+- (void)cancel
+{
+	[self finishWithError: [NSError errorWithDomain: NSCocoaErrorDomain code: NSUserCancelledError userInfo: nil]];
+}
+- (void)finishWithError:(NSError*)error
+{
+	if (_finished)
+		return;
+	_finished = YES;
+	[_received removeAllObjects];
+	// Page requests still outstanding are no longer wanted, so free their transport slots
+	NSArray<OBPMarshalRequest*>* outstanding = [_inFlight allValues];
+	[_inFlight removeAllObjects];
+	[outstanding makeObjectsPerformSelector: @selector(cancel)];
+	HandleOBPPagerCompletion completion = _completion;
+	_completion = nil;
+	_pageHandler = nil;
+	completion(_elementCount, error);
+	_keepAlive = nil;
+}
+#pragma mark -
+- (void)requestMorePages
+{
+	// Keep the window full: never request further ahead than pagesInFlight pages past the next page to deliver
+	while (!_finished
+		&& _lastPage == NSNotFound
+		&& _nextPageToRequest < _nextPageToDeliver + _pagesInFlight)
+	{
+		if (![self requestPage: _nextPageToRequest])
+			return;
+		_nextPageToRequest++;
+	}
+}
+- (BOOL)requestPage:(NSUInteger)page
+{
+	NSMutableDictionary*	headers = [_extraHeaders mutableCopy];
+	NSMutableDictionary*	options = [_options mutableCopy];
+	NSUInteger				offset = page * _pageSize;
+	OBPMarshalRequest*		request;
+
+	headers[@"obp_limit"] = @(_pageSize);
+	headers[@"obp_offset"] = @(offset);
+	options[OBPMarshalOptionExtraHeaders] = headers;
+
+	request =
+		[_marshal startGetResourceAtAPIPath: _path
+								withOptions: options
+						   forResultHandler:
+							^(id deserializedObject, NSString* responseBody) {
+								[self->_inFlight removeObjectForKey: @(page)];
+								[self receivedPage: page container: deserializedObject];
+							}
+							 orErrorHandler:
+							^(NSError* error, NSString* path) {
+								[self->_inFlight removeObjectForKey: @(page)];
+								[self failedPage: page error: error];
+							}];
+
+	if (request)
+		_inFlight[@(page)] = request;
+	else
+	{
+		OBP_LOG(@"[OBPPager requestPage: %lu] could not launch request for %@", (unsigned long)page, _path);
+		[self finishWithError: [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResult
+											   userInfo: @{NSLocalizedDescriptionKey : @"Unable to launch page request."}]];
+	}
+
+	return request != nil;
+}
+- (void)receivedPage:(NSUInteger)page container:(id)container
+{
+	if (_finished || page > _lastPage)
+		return; // ...beyond the end of the collection, or no longer wanted
+
+	// Pages decoded to models (OBPMarshalOptionModelClass) arrive as arrays already
+	NSArray* elements = [container isKindOfClass: [NSArray class]] ? container
+					  : _elementsKey && [container isKindOfClass: [NSDictionary class]] ? container[_elementsKey]
+					  : nil;
+	if (![elements isKindOfClass: [NSArray class]])
+	{
+		OBP_LOG(@"[OBPPager receivedPage: %lu] expected an array for key %@ in %@", (unsigned long)page, _elementsKey, container);
+		[self finishWithError: [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResourceKind
+											   userInfo: @{NSLocalizedDescriptionKey : @"Unexpected response data type."}]];
+		return;
+	}
+
+	if ([elements count] < _pageSize)
+	{
+		_lastPage = page;
+		// Discard anything received from beyond the end, and cancel requests for pages beyond it
+		for (NSNumber* n in [_received allKeys])
+			if ([n unsignedIntegerValue] > page)
+				[_received removeObjectForKey: n];
+		for (NSNumber* n in [_inFlight allKeys])
+			if ([n unsignedIntegerValue] > page)
+			{
+				[_inFlight[n] cancel];
+				[_inFlight removeObjectForKey: n];
+			}
+	}
+
+	_received[@(page)] = elements;
+	[self deliverReadyPages];
+}
+- (void)failedPage:(NSUInteger)page error:(NSError*)error
+{
+	if (_finished || page > _lastPage)
+		return;
+	[self finishWithError: error];
+}
+- (void)deliverReadyPages
+{
+	NSArray*		elements;
+	BOOL			stop = NO;
+
+	while (!_finished && nil != (elements = _received[@(_nextPageToDeliver)]))
+	{
+		[_received removeObjectForKey: @(_nextPageToDeliver)];
+		_pageHandler(elements, _nextPageToDeliver * _pageSize, &stop);
+		_elementCount += [elements count];
+		if (stop)
+			{[self cancel]; return;}
+		if (_nextPageToDeliver == _lastPage)
+			{[self finishWithError: nil]; return;}
+		_nextPageToDeliver++;
+	}
+
+	[self requestMorePages];
+}
+@end
@@ -0,0 +1,53 @@
+//
+//  OBPPoller.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+@class OBPMarshal;
+@class OBPPreparedRequest;
+
+
+
+typedef void(^HandleOBPPollerResult)(NSString* name, id _Nullable deserializedObject, NSError* _Nullable error); // (name, deserializedObject, error)
+
+
+
+/**	An OBPPoller instance sends a set of prepared requests through one marshal, each repeatedly at its own interval, such as to keep balances and recent transactions up to date while they are on screen.
+
+	Each poll is given a name, which identifies it to -removePollNamed: and -pollNow:, and is passed to its handler with each outcome. The handler is called on the result queue of the prepared request, or of the marshal if it has none.
+
+	To keep many clients of a server from falling into step, each interval is varied at random by up to the given jitter, as a fraction of the interval of at most one half, so that no poll is sent at less than half its interval, and the first send of each poll is delayed by a random part of it. To save wakeups, polls that fall due within coalescingWindow of each other are sent together. A poll that falls due while its previous request is still in flight is skipped until its next turn, rather than stacking up requests to a slow server; skippedCount counts these. A poll whose request cannot be launched, e.g. because the session is not valid, is tried again at its next turn.
+
+	Polls are sent only while the poller is running, between -start and -stop. The poller does not keep itself alive, so keep a reference to it while you want it to run. All methods may be called from any queue.
+*/
+@interface OBPPoller : NSObject
+- (instancetype)initWithMarshal:(OBPMarshal*)marshal; ///< Designated initialiser. The marshal is not retained; polling stops if it goes away.
+@property (nonatomic, weak, readonly) OBPMarshal* marshal;
+@property (atomic) NSTimeInterval coalescingWindow; ///< Get/set how far ahead of time, in seconds, a poll may be sent so as to go with others falling due. Default 0.5s.
+@property (nonatomic, readonly) BOOL running;
+@property (nonatomic, readonly) NSUInteger sentCount; ///< Number of requests sent so far.
+@property (nonatomic, readonly) NSUInteger skippedCount; ///< Number of times a poll fell due while its previous request was still in flight.
+
+- (BOOL)addPollNamed:(NSString*)name request:(OBPPreparedRequest*)request parameters:(nullable NSDictionary<NSString*,id>*)parameters interval:(NSTimeInterval)interval jitter:(double)jitter handler:(HandleOBPPollerResult)handler; ///< Send request with parameters every interval seconds, varied at random by up to ±jitter × interval, passing each outcome to handler. A poll already having name is replaced. \param jitter is a fraction between 0 and 0.5, to which greater values are reduced; 0.1 is a good choice. \returns NO if interval is not positive, or parameters lack a value for the request's path template.
+- (void)removePollNamed:(NSString*)name; ///< Stop sending the named poll; the outcome of a request in flight is still passed to its handler.
+- (void)pollNow:(NSString*)name; ///< Send the named poll now, if the poller is running and the poll's request is not in flight, and start its interval afresh.
+- (NSArray<NSString*>*)pollNames;
+
+- (void)start; ///< Start sending polls as they fall due.
+- (void)stop; ///< Stop sending polls. Requests in flight are not cancelled.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
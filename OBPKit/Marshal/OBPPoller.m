@@ -0,0 +1,241 @@
+//
+//  OBPPoller.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPPoller.h"
+// prj
+#import "OBPMarshal.h"
+#import "OBPMetrics.h"
+#import "OBPLogging.h"
+
+
+
+#define kOBPPollerDefaultCoalescingWindow	0.5
+#define kOBPPollerMaxJitter					0.5		// ...so that no interval is shortened by more than half
+
+
+
+@interface OBPPoll : NSObject
+@property (nonatomic, copy) NSString* name;
+@property (nonatomic, strong) OBPPreparedRequest* request;
+@property (nonatomic, copy) NSDictionary* parameters;
+@property (nonatomic) NSTimeInterval interval;
+@property (nonatomic) double jitter;
+@property (nonatomic, copy) HandleOBPPollerResult handler;
+@property (nonatomic) NSTimeInterval due;		// OBPMonotonicTime
+@property (nonatomic) BOOL inFlight;
+@end
+
+@implementation OBPPoll
+- (NSTimeInterval)jitteredDelayWithin:(double)fraction
+{
+	// Uniform in interval × [1 - fraction, 1 + fraction]
+	double unit = (double)arc4random_uniform(1U << 20) / (double)(1U << 20);
+	return _interval * (1 + fraction * (2 * unit - 1));
+}
+@end
+
+
+
+@implementation OBPPoller
+{
+	dispatch_queue_t							_queue;			// guards all state below
+	dispatch_source_t							_timer;			// while running
+	NSMutableDictionary<NSString*,OBPPoll*>*	_polls;
+	NSTimeInterval								_coalescingWindow;
+	NSUInteger									_sentCount;
+	NSUInteger									_skippedCount;
+}
+- (instancetype)initWithMarshal:(OBPMarshal*)marshal
+{
+	if (!marshal)
+		{self = nil; return nil;}
+	if (nil == (self = [super init]))
+		return nil;
+	_marshal = marshal;
+	_queue = dispatch_queue_create("com.tesobe.OBPKit.OBPPoller", DISPATCH_QUEUE_SERIAL);
+	_polls = [NSMutableDictionary dictionary];
+	_coalescingWindow = kOBPPollerDefaultCoalescingWindow;
+	return self;
+}
+- (void)dealloc
+{
+	if (_timer)
+		dispatch_source_cancel(_timer);
+}
+- (NSTimeInterval)coalescingWindow
+{
+	__block NSTimeInterval window;
+	dispatch_sync(_queue, ^{window = self->_coalescingWindow;});
+	return window;
+}
+- (void)setCoalescingWindow:(NSTimeInterval)coalescingWindow
+{
+	dispatch_async(_queue, ^{
+		self->_coalescingWindow = MAX(0, coalescingWindow);
+		[self schedule];
+	});
+}
+- (BOOL)running
+{
+	__block BOOL running;
+	dispatch_sync(_queue, ^{running = self->_timer != nil;});
+	return running;
+}
+- (NSUInteger)sentCount
+{
+	__block NSUInteger count;
+	dispatch_sync(_queue, ^{count = self->_sentCount;});
+	return count;
+}
+- (NSUInteger)skippedCount
+{
+	__block NSUInteger count;
+	dispatch_sync(_queue, ^{count = self->_skippedCount;});
+	return count;
+}
+- (NSArray<NSString*>*)pollNames
+{
+	__block NSArray* names;
+	dispatch_sync(_queue, ^{names = [self->_polls allKeys];});
+	return names;
+}
+#pragma mark -
+- (BOOL)addPollNamed:(NSString*)name request:(OBPPreparedRequest*)request parameters:(NSDictionary<NSString*,id>*)parameters interval:(NSTimeInterval)interval jitter:(double)jitter handler:(HandleOBPPollerResult)handler
+{
+	if (![name length] || !request || !handler || !(interval > 0))
+		return NO;
+	if (![request pathWithParameters: parameters])
+		return NO;
+
+	OBPPoll* poll = [[OBPPoll alloc] init];
+	poll.name = name;
+	poll.request = request;
+	poll.parameters = parameters;
+	poll.interval = interval;
+	poll.jitter = MIN(MAX(0, jitter), kOBPPollerMaxJitter);
+	poll.handler = handler;
+	// The first send is spread over the jitter too, so that polls added together do not all go at once
+	poll.due = OBPMonotonicTime() + interval * poll.jitter * ((double)arc4random_uniform(1U << 20) / (double)(1U << 20));
+
+	dispatch_async(_queue, ^{
+		self->_polls[name] = poll;
+		[self schedule];
+	});
+	return YES;
+}
+- (void)removePollNamed:(NSString*)name
+{
+	dispatch_async(_queue, ^{
+		[self->_polls removeObjectForKey: name];
+		[self schedule];
+	});
+}
+- (void)pollNow:(NSString*)name
+{
+	dispatch_async(_queue, ^{
+		OBPPoll* poll = self->_polls[name];
+		if (!poll)
+			return;
+		poll.due = OBPMonotonicTime();
+		[self fire];
+	});
+}
+- (void)start
+{
+	dispatch_async(_queue, ^{
+		if (self->_timer)
+			return;
+		__weak __typeof(self) self_ifStillAlive = self;
+		self->_timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self->_queue);
+		dispatch_source_set_event_handler(self->_timer, ^{[self_ifStillAlive fire];});
+		dispatch_source_set_timer(self->_timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+		dispatch_resume(self->_timer);
+		[self fire];
+	});
+}
+- (void)stop
+{
+	dispatch_async(_queue, ^{
+		if (!self->_timer)
+			return;
+		dispatch_source_cancel(self->_timer);
+		self->_timer = nil;
+	});
+}
+#pragma mark -
+- (void)fire
+{
+	// Called on _queue. Send every poll due within the coalescing window, then sleep until the next falls due
+	NSTimeInterval	now = OBPMonotonicTime();
+	OBPPoll*		poll;
+
+	if (!_timer)
+		return;
+	if (!_marshal)
+	{
+		OBP_LOG(@"[OBPPoller fire] marshal has gone; stopping %@ polls", @([_polls count]));
+		dispatch_source_cancel(_timer);
+		_timer = nil;
+		return;
+	}
+	for (poll in [_polls allValues])
+	if (poll.due <= now + _coalescingWindow)
+	{
+		poll.due = now + [poll jitteredDelayWithin: poll.jitter];
+		if (poll.inFlight)
+			_skippedCount++;
+		else
+			[self send: poll];
+	}
+	[self schedule];
+}
+- (void)send:(OBPPoll*)poll
+{
+	OBPMarshal*				marshal = _marshal;
+	HandleOBPPollerResult	handler = poll.handler;
+	NSString*				name = poll.name;
+	dispatch_queue_t		queue = _queue;
+	BOOL					launched;
+
+	poll.inFlight = YES;
+	launched = nil !=
+		[marshal sendPreparedRequest: poll.request
+					  withParameters: poll.parameters
+							 payload: nil
+					forResultHandler:
+						^(id deserializedObject, NSString* responseBody) {
+							dispatch_async(queue, ^{poll.inFlight = NO;});
+							handler(name, deserializedObject, nil);
+						}
+					  orErrorHandler:
+						^(NSError* error, NSString* path) {
+							dispatch_async(queue, ^{poll.inFlight = NO;});
+							handler(name, nil, error);
+						}];
+	if (launched)
+		_sentCount++;
+	else
+		poll.inFlight = NO; // ...and try again next time
+	OBP_LOG_IF(!launched, @"[OBPPoller send:] could not launch poll %@ for %@", name, poll.request.pathTemplate);
+}
+- (void)schedule
+{
+	// Called on _queue
+	NSTimeInterval	next = DBL_MAX;
+	OBPPoll*		poll;
+
+	if (!_timer)
+		return;
+	for (poll in [_polls allValues])
+		next = MIN(next, poll.due);
+	if (next == DBL_MAX)
+		dispatch_source_set_timer(_timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+	else
+		dispatch_source_set_timer(_timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX(0, next - OBPMonotonicTime()) * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, (uint64_t)(_coalescingWindow * NSEC_PER_SEC));
+}
+@end
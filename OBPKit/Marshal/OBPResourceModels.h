@@ -0,0 +1,73 @@
+//
+//  OBPResourceModels.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OBPModel.h"
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+/// OBPBank models a bank resource, as returned by get /banks and /banks/BANK_ID.
+@interface OBPBank : OBPModel
+@property (nonatomic, copy, readonly, nullable) NSString* bankID; ///< id
+@property (nonatomic, copy, readonly, nullable) NSString* shortName; ///< short_name
+@property (nonatomic, copy, readonly, nullable) NSString* fullName; ///< full_name
+@property (nonatomic, copy, readonly, nullable) NSString* logoURL; ///< logo
+@property (nonatomic, copy, readonly, nullable) NSString* website; ///< website
+@end
+
+
+
+/// OBPAccount models an account resource, as returned by get /banks/BANK_ID/accounts/ACCOUNT_ID/VIEW_ID/account and the account lists.
+@interface OBPAccount : OBPModel
+@property (nonatomic, copy, readonly, nullable) NSString* accountID; ///< id
+@property (nonatomic, copy, readonly, nullable) NSString* bankID; ///< bank_id (interned)
+@property (nonatomic, copy, readonly, nullable) NSString* label; ///< label
+@property (nonatomic, copy, readonly, nullable) NSString* number; ///< number
+@property (nonatomic, copy, readonly, nullable) NSString* type; ///< type (interned)
+@property (nonatomic, copy, readonly, nullable) NSString* IBAN; ///< IBAN
+@property (nonatomic, readonly) OBPAmount balance; ///< balance.amount
+@property (nonatomic, copy, readonly, nullable) NSString* currency; ///< balance.currency (interned)
+@end
+
+
+
+/// OBPCounterparty models the other party to a transaction, or an entry from get /banks/BANK_ID/accounts/ACCOUNT_ID/VIEW_ID/other_accounts.
+@interface OBPCounterparty : OBPModel
+@property (nonatomic, copy, readonly, nullable) NSString* counterpartyID; ///< id
+@property (nonatomic, copy, readonly, nullable) NSString* holderName; ///< holder.name
+@property (nonatomic, copy, readonly, nullable) NSString* number; ///< number
+@property (nonatomic, copy, readonly, nullable) NSString* kind; ///< kind (interned)
+@property (nonatomic, copy, readonly, nullable) NSString* IBAN; ///< IBAN
+@property (nonatomic, copy, readonly, nullable) NSString* bankName; ///< bank.name (interned)
+@property (nonatomic, copy, readonly, nullable) NSString* bankNationalIdentifier; ///< bank.national_identifier (interned)
+@end
+
+
+
+/// OBPTransaction models a transaction resource, as returned by get /banks/BANK_ID/accounts/ACCOUNT_ID/VIEW_ID/transactions.
+@interface OBPTransaction : OBPModel
+@property (nonatomic, copy, readonly, nullable) NSString* transactionID; ///< id
+@property (nonatomic, copy, readonly, nullable) NSString* accountID; ///< this_account.id (interned)
+@property (nonatomic, copy, readonly, nullable) NSString* bankNationalIdentifier; ///< this_account.bank.national_identifier (interned)
+@property (nonatomic, strong, readonly, nullable) OBPCounterparty* counterparty; ///< other_account
+@property (nonatomic, copy, readonly, nullable) NSString* type; ///< details.type (interned)
+@property (nonatomic, copy, readonly, nullable) NSString* summary; ///< details.description
+@property (nonatomic, readonly) NSTimeInterval posted; ///< details.posted, as seconds since the NSDate reference date, or NAN
+@property (nonatomic, readonly) NSTimeInterval completed; ///< details.completed, as seconds since the NSDate reference date, or NAN
+@property (nonatomic, readonly) OBPAmount amount; ///< details.value.amount
+@property (nonatomic, copy, readonly, nullable) NSString* currency; ///< details.value.currency (interned)
+@property (nonatomic, readonly) OBPAmount balance; ///< details.new_balance.amount
+@end
+
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,100 @@
+//
+//  OBPResourceModels.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPResourceModels.h"
+
+
+
+#define F(n, kp, k)		[OBPModelField fieldWithName: @#n keyPath: kp kind: OBPModelFieldKind##k]
+
+
+
+@implementation OBPBank
++ (NSArray<OBPModelField*>*)modelFields
+{
+	return @[
+		F(bankID,		@"id",					String),
+		F(shortName,	@"short_name",			String),
+		F(fullName,		@"full_name",			String),
+		F(logoURL,		@"logo",				String),
+		F(website,		@"website",				String),
+	];
+}
++ (NSString*)collectionKey
+{
+	return @"banks";
+}
+@end
+
+
+
+@implementation OBPAccount
++ (NSArray<OBPModelField*>*)modelFields
+{
+	return @[
+		F(accountID,	@"id",					String),
+		F(bankID,		@"bank_id",				InternedString),
+		F(label,		@"label",				String),
+		F(number,		@"number",				String),
+		F(type,			@"type",				InternedString),
+		F(IBAN,			@"IBAN",				String),
+		F(balance,		@"balance.amount",		Amount),
+		F(currency,		@"balance.currency",	InternedString),
+	];
+}
++ (NSString*)collectionKey
+{
+	return @"accounts";
+}
+@end
+
+
+
+@implementation OBPCounterparty
++ (NSArray<OBPModelField*>*)modelFields
+{
+	return @[
+		F(counterpartyID,			@"id",						String),
+		F(holderName,				@"holder.name",				String),
+		F(number,					@"number",					String),
+		F(kind,						@"kind",					InternedString),
+		F(IBAN,						@"IBAN",					String),
+		F(bankName,					@"bank.name",				InternedString),
+		F(bankNationalIdentifier,	@"bank.national_identifier",InternedString),
+	];
+}
++ (NSString*)collectionKey
+{
+	return @"other_accounts";
+}
+@end
+
+
+
+@implementation OBPTransaction
++ (NSArray<OBPModelField*>*)modelFields
+{
+	return @[
+		F(transactionID,			@"id",								String),
+		F(accountID,				@"this_account.id",					InternedString),
+		F(bankNationalIdentifier,	@"this_account.bank.national_identifier", InternedString),
+		[OBPModelField fieldWithName: @"counterparty" keyPath: @"other_account" modelClass: [OBPCounterparty class]],
+		F(type,						@"details.type",					InternedString),
+		F(summary,					@"details.description",				String),
+		F(posted,					@"details.posted",					Date),
+		F(completed,				@"details.completed",				Date),
+		F(amount,					@"details.value.amount",			Amount),
+		F(currency,					@"details.value.currency",			InternedString),
+		F(balance,					@"details.new_balance.amount",		Amount),
+	];
+}
++ (NSString*)collectionKey
+{
+	return @"transactions";
+}
+@end
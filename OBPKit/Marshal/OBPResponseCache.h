@@ -0,0 +1,68 @@
+//
+//  OBPResponseCache.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+typedef struct OBPResponseCacheCounters {
+	uint64_t	hits;			///< requests answered from the cache without contacting the server
+	uint64_t	revalidations;	///< requests answered from the cache after the server replied 304 Not Modified
+	uint64_t	misses;			///< requests for which the server sent a full response
+	uint64_t	bytesServed;	///< response body bytes delivered from the cache (hits + revalidations)
+	uint64_t	bytesFetched;	///< response body bytes received in full responses
+	uint64_t	memoryBytes;	///< response body bytes currently held in memory
+	uint64_t	diskBytes;		///< bytes currently held on disk
+} OBPResponseCacheCounters;
+
+
+
+/// An OBPResponseCacheEntry instance records a response body together with the validators needed to revalidate it with the server, and the deserialized object once it has been obtained.
+@interface OBPResponseCacheEntry : NSObject <NSSecureCoding>
+- (instancetype)initWithBody:(NSData*)body eTag:(nullable NSString*)eTag lastModified:(nullable NSString*)lastModified; ///< Designated initialiser. Sets storedAt to the current time.
+@property (nonatomic, strong, readonly) NSData* body; ///< The response body bytes as received.
+@property (nonatomic, copy, readonly, nullable) NSString* eTag; ///< The ETag header value of the response, if supplied, for use with If-None-Match.
+@property (nonatomic, copy, readonly, nullable) NSString* lastModified; ///< The Last-Modified header value of the response, if supplied, for use with If-Modified-Since.
+@property (nonatomic, strong) NSDate* storedAt; ///< When the response was last confirmed as current by the server.
+@property (atomic, strong, nullable) id object; ///< The deserialized object for body, cached in memory only.
+@end
+
+
+
+/**	An OBPResponseCache instance keeps responses to GET requests for one OBP server, bounded both in memory and on disk, so that OBPMarshal can avoid repeated round trips and JSON decoding for resources that change infrequently.
+
+	OBPMarshal creates and uses a cache for its session's server when you include OBPMarshalOptionCacheMaxAge in the options of a get request. Entries are keyed on the API path, extra headers and the authorisation identity used, so public and private views of a resource, and views for different users, are never mixed. On disk, entries are written with complete file protection, so that they cannot be read while the device is locked, and are excluded from backups.
+
+	Use the counters property to find out how effective the cache is.
+*/
+@interface OBPResponseCache : NSObject
+- (instancetype)initWithIdentifier:(NSString*)identifier memoryCapacity:(NSUInteger)memoryCapacity diskCapacity:(NSUInteger)diskCapacity; ///< Designated initialiser. \param identifier distinguishes this cache's on-disk storage from that of other caches, and is typically the key of an OBPServerInfo instance. \param memoryCapacity gives the maximum number of response body bytes held in memory. \param diskCapacity gives the maximum number of bytes held on disk; pass zero for an in-memory only cache.
+@property (nonatomic, copy, readonly) NSString* identifier; ///< Get the identifier passed at initialisation.
+@property (nonatomic, copy, readonly, nullable) NSString* directoryPath; ///< Get the directory holding on-disk entries, or nil if the cache is in-memory only.
+
++ (NSString*)keyForPath:(NSString*)path headers:(nullable NSDictionary<NSString*,NSString*>*)headers authIdentity:(nullable NSString*)authIdentity; ///< Form a cache key from the API path, the extra headers that modify the request, and an identity for the authorisation used (nil for public requests). The identity is only ever stored in hashed form.
+
+- (nullable OBPResponseCacheEntry*)entryForKey:(NSString*)key; ///< Return the entry for key, looking first in memory and then on disk, waiting for the read; OBPMarshal calls this on its decode queue.
+- (void)storeEntry:(OBPResponseCacheEntry*)entry forKey:(NSString*)key; ///< Store entry in memory and schedule it to be written to disk, evicting older entries if the capacity limits are exceeded.
+- (void)touchEntry:(OBPResponseCacheEntry*)entry forKey:(NSString*)key; ///< Record that the server has confirmed entry is still current (i.e. replied 304 Not Modified).
+- (void)removeEntryForKey:(NSString*)key;
+- (void)removeAllEntries;
+
+@property (readonly) OBPResponseCacheCounters counters; ///< Get a snapshot of the cache's counters.
+- (void)resetCounters; ///< Reset the hit, revalidation, miss and byte transfer counters to zero. (The memoryBytes and diskBytes counters reflect current usage and are not reset.)
+- (void)countHitWithBytes:(NSUInteger)bytes revalidated:(BOOL)revalidated; ///< Called by OBPMarshal when a request is answered from the cache.
+- (void)countMissWithBytes:(NSUInteger)bytes; ///< Called by OBPMarshal when a request is answered by a full response from the server.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
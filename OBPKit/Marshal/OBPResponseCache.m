@@ -0,0 +1,365 @@
+//
+//  OBPResponseCache.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPResponseCache.h"
+// sdk
+#import <CommonCrypto/CommonDigest.h>
+#import <stdatomic.h>
+// prj
+#import "OBPLogging.h"
+
+
+
+#define kEntryFileExtension @"obpc"
+
+#if TARGET_OS_IPHONE
+#define kEntryWritingOptions	(NSDataWritingAtomic | NSDataWritingFileProtectionComplete)
+#else
+#define kEntryWritingOptions	NSDataWritingAtomic
+#endif
+
+
+
+static NSString* OBPHexDigestOfString(NSString* s)
+{
+	NSData*				data = [s dataUsingEncoding: NSUTF8StringEncoding];
+	uint8_t				digest[CC_SHA256_DIGEST_LENGTH];
+	char				hex[CC_SHA256_DIGEST_LENGTH * 2 + 1];
+	const char*			digits = "0123456789abcdef";
+	NSUInteger			i;
+
+	CC_SHA256([data bytes], (CC_LONG)[data length], digest);
+	for (i = 0; i < CC_SHA256_DIGEST_LENGTH; i++)
+		hex[i*2] = digits[digest[i] >> 4], hex[i*2+1] = digits[digest[i] & 15];
+	hex[i*2] = 0;
+	return [NSString stringWithUTF8String: hex];
+}
+
+
+
+#pragma mark -
+@interface OBPResponseCacheEntry ()
+- (NSUInteger)cost;
+@end
+
+
+
+@implementation OBPResponseCacheEntry
+- (instancetype)initWithBody:(NSData*)body eTag:(NSString*)eTag lastModified:(NSString*)lastModified
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_body = body ?: [NSData data];
+	_eTag = [eTag copy];
+	_lastModified = [lastModified copy];
+	_storedAt = [NSDate date];
+	return self;
+}
++ (BOOL)supportsSecureCoding
+{
+	return YES;
+}
+- (instancetype)initWithCoder:(NSCoder*)aDecoder
+{
+	if (nil == (self = [super init]))
+		return nil;
+	Class classNSString = [NSString class];
+	_body = [aDecoder decodeObjectOfClass: [NSData class] forKey: @"body"] ?: [NSData data];
+	_eTag = [aDecoder decodeObjectOfClass: classNSString forKey: @"eTag"];
+	_lastModified = [aDecoder decodeObjectOfClass: classNSString forKey: @"lastModified"];
+	_storedAt = [aDecoder decodeObjectOfClass: [NSDate class] forKey: @"storedAt"] ?: [NSDate distantPast];
+	return self;
+}
+- (void)encodeWithCoder:(NSCoder*)aCoder
+{
+	[aCoder encodeObject: _body forKey: @"body"];
+	if (_eTag)
+		[aCoder encodeObject: _eTag forKey: @"eTag"];
+	if (_lastModified)
+		[aCoder encodeObject: _lastModified forKey: @"lastModified"];
+	[aCoder encodeObject: _storedAt forKey: @"storedAt"];
+}
+- (NSUInteger)cost
+{
+	return [_body length];
+}
+@end
+
+
+
+#pragma mark -
+@interface OBPResponseCache () <NSCacheDelegate>
+{
+	NSCache*			_memory;
+	NSUInteger			_diskCapacity;
+	dispatch_queue_t	_ioQueue;
+	_Atomic(uint64_t)	_hits;
+	_Atomic(uint64_t)	_revalidations;
+	_Atomic(uint64_t)	_misses;
+	_Atomic(uint64_t)	_bytesServed;
+	_Atomic(uint64_t)	_bytesFetched;
+	_Atomic(uint64_t)	_memoryBytes;
+	_Atomic(uint64_t)	_diskBytes;
+}
+@end
+
+
+
+@implementation OBPResponseCache
+- (instancetype)initWithIdentifier:(NSString*)identifier memoryCapacity:(NSUInteger)memoryCapacity diskCapacity:(NSUInteger)diskCapacity
+{
+	if (![identifier length])
+		{self = nil; return nil;}
+	if (nil == (self = [super init]))
+		return nil;
+	_identifier = [identifier copy];
+	_memory = [[NSCache alloc] init];
+	_memory.totalCostLimit = memoryCapacity;
+	_memory.delegate = self;
+	_diskCapacity = diskCapacity;
+	_ioQueue = dispatch_queue_create("com.tesobe.OBPKit.OBPResponseCache", DISPATCH_QUEUE_SERIAL);
+	if (_diskCapacity)
+	{
+		_directoryPath = [self defaultDirectoryPath];
+		[self createDirectory];
+		dispatch_async(_ioQueue, ^{[self measureDisk];});
+	}
+	return self;
+}
+- (void)dealloc
+{
+	_memory.delegate = nil;
+}
+- (NSString*)defaultDirectoryPath
+{
+	NSString*		path;
+	path = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES)[0];
+	path = [path stringByAppendingPathComponent: [NSBundle mainBundle].bundleIdentifier ?: @"OBPKit"];
+	path = [path stringByAppendingPathComponent: @"OBPResponseCache"];
+	path = [path stringByAppendingPathComponent: _identifier];
+	return path;
+}
+- (void)createDirectory
+{
+	// Responses to private requests hold account details, so are kept unreadable while the device is locked, and out of backups
+	NSDictionary*	attributes = nil;
+	NSURL*			url = [NSURL fileURLWithPath: _directoryPath isDirectory: YES];
+#if TARGET_OS_IPHONE
+	attributes = @{NSFileProtectionKey : NSFileProtectionComplete};
+#endif
+	[[NSFileManager defaultManager] createDirectoryAtPath: _directoryPath
+							  withIntermediateDirectories: YES
+											   attributes: attributes error: NULL];
+	[url setResourceValue: @YES forKey: NSURLIsExcludedFromBackupKey error: NULL];
+}
+#pragma mark -
++ (NSString*)keyForPath:(NSString*)path headers:(NSDictionary<NSString*,NSString*>*)headers authIdentity:(NSString*)authIdentity
+{
+	NSMutableString*	key = [NSMutableString stringWithString: path ?: @""];
+	NSString*			name;
+
+	for (name in [[headers allKeys] sortedArrayUsingSelector: @selector(caseInsensitiveCompare:)])
+		[key appendFormat: @"\n%@:%@", [name lowercaseString], headers[name]];
+	[key appendFormat: @"\n@%@", authIdentity ? OBPHexDigestOfString(authIdentity) : @"-"];
+
+	return [key copy];
+}
+- (NSString*)filePathForKey:(NSString*)key
+{
+	if (!_directoryPath)
+		return nil;
+	NSString* name = [OBPHexDigestOfString(key) stringByAppendingPathExtension: kEntryFileExtension];
+	return [_directoryPath stringByAppendingPathComponent: name];
+}
+#pragma mark -
+- (OBPResponseCacheEntry*)entryForKey:(NSString*)key
+{
+	OBPResponseCacheEntry*	entry;
+	NSString*				filePath;
+
+	if (nil != (entry = [_memory objectForKey: key]))
+		return entry;
+
+	if (nil == (filePath = [self filePathForKey: key]))
+		return nil;
+
+	__block NSData*			data = nil;
+	dispatch_sync(_ioQueue, ^{
+		data = [NSData dataWithContentsOfFile: filePath options: NSDataReadingMappedIfSafe error: NULL];
+	});
+	if (!data)
+		return nil;
+
+	@try {
+		NSKeyedUnarchiver* unarchiver = [[NSKeyedUnarchiver alloc] initForReadingWithData: data];
+		unarchiver.requiresSecureCoding = YES;
+		entry = [unarchiver decodeObjectOfClass: [OBPResponseCacheEntry class] forKey: NSKeyedArchiveRootObjectKey];
+		[unarchiver finishDecoding];
+	}
+	@catch (NSException* exception) {
+		OBP_LOG(@"[OBPResponseCache entryForKey:] discarding unreadable entry (%@)", exception);
+		entry = nil;
+	}
+
+	if (entry)
+		[self putInMemory: entry forKey: key];
+	else
+		dispatch_async(_ioQueue, ^{[self removeFileAtPath: filePath];});
+
+	return entry;
+}
+- (void)putInMemory:(OBPResponseCacheEntry*)entry forKey:(NSString*)key
+{
+	NSUInteger				cost = [entry cost];
+	OBPResponseCacheEntry*	previous = [_memory objectForKey: key];
+	if (previous == entry)
+		return;
+	if (previous)
+		[_memory removeObjectForKey: key]; // ...eviction callback adjusts byte count
+	atomic_fetch_add(&_memoryBytes, cost);
+	[_memory setObject: entry forKey: key cost: cost];
+}
+- (void)storeEntry:(OBPResponseCacheEntry*)entry forKey:(NSString*)key
+{
+	if (!entry || !key)
+		return;
+	[self putInMemory: entry forKey: key];
+	[self writeEntry: entry forKey: key];
+}
+- (void)touchEntry:(OBPResponseCacheEntry*)entry forKey:(NSString*)key
+{
+	entry.storedAt = [NSDate date];
+	[self putInMemory: entry forKey: key];
+	[self writeEntry: entry forKey: key];
+}
+- (void)removeEntryForKey:(NSString*)key
+{
+	[_memory removeObjectForKey: key];
+	NSString* filePath = [self filePathForKey: key];
+	if (filePath)
+		dispatch_async(_ioQueue, ^{[self removeFileAtPath: filePath];});
+}
+- (void)removeAllEntries
+{
+	[_memory removeAllObjects];
+	if (!_directoryPath)
+		return;
+	dispatch_async(_ioQueue, ^{
+		NSFileManager* fm = [NSFileManager defaultManager];
+		[fm removeItemAtPath: self->_directoryPath error: NULL];
+		[self createDirectory];
+		atomic_store(&self->_diskBytes, 0);
+	});
+}
+#pragma mark - NSCacheDelegate
+- (void)cache:(NSCache*)cache willEvictObject:(id)obj
+{
+	if ([obj isKindOfClass: [OBPResponseCacheEntry class]])
+		atomic_fetch_sub(&_memoryBytes, [(OBPResponseCacheEntry*)obj cost]);
+}
+#pragma mark - Disk
+- (void)writeEntry:(OBPResponseCacheEntry*)entry forKey:(NSString*)key
+{
+	NSString* filePath = [self filePathForKey: key];
+	if (!filePath)
+		return;
+	NSData* data = [NSKeyedArchiver archivedDataWithRootObject: entry];
+	if ([data length] > _diskCapacity / 4)
+		return; // ...not worth displacing most of the disk cache for one entry
+	dispatch_async(_ioQueue, ^{
+		NSFileManager*	fm = [NSFileManager defaultManager];
+		uint64_t		oldSize = [[fm attributesOfItemAtPath: filePath error: NULL] fileSize];
+		if ([data writeToFile: filePath options: kEntryWritingOptions error: NULL])
+		{
+			atomic_fetch_sub(&self->_diskBytes, oldSize);
+			if (atomic_fetch_add(&self->_diskBytes, [data length]) + [data length] > self->_diskCapacity)
+				[self trimDisk];
+		}
+	});
+}
+- (void)removeFileAtPath:(NSString*)filePath
+{
+	NSFileManager*	fm = [NSFileManager defaultManager];
+	uint64_t		size = [[fm attributesOfItemAtPath: filePath error: NULL] fileSize];
+	if ([fm removeItemAtPath: filePath error: NULL])
+		atomic_fetch_sub(&_diskBytes, size);
+}
+- (NSArray<NSURL*>*)diskEntryURLs
+{
+	NSArray<NSURL*>* urls =
+		[[NSFileManager defaultManager]
+			contentsOfDirectoryAtURL: [NSURL fileURLWithPath: _directoryPath]
+		  includingPropertiesForKeys: @[NSURLFileSizeKey, NSURLContentModificationDateKey]
+							 options: NSDirectoryEnumerationSkipsHiddenFiles error: NULL];
+	return [urls filteredArrayUsingPredicate: [NSPredicate predicateWithFormat: @"pathExtension == %@", kEntryFileExtension]];
+}
+- (void)measureDisk
+{
+	uint64_t		total = 0;
+	NSNumber*		size;
+	for (NSURL* url in [self diskEntryURLs])
+		if ([url getResourceValue: &size forKey: NSURLFileSizeKey error: NULL])
+			total += [size unsignedLongLongValue];
+	atomic_store(&_diskBytes, total);
+	if (total > _diskCapacity)
+		[self trimDisk];
+}
+- (void)trimDisk // called on _ioQueue
+{
+	// Evict least recently written entries until usage is back to three quarters of capacity
+	uint64_t			target = _diskCapacity / 4 * 3;
+	NSArray<NSURL*>*	urls;
+
+	urls = [[self diskEntryURLs] sortedArrayUsingComparator:
+				^NSComparisonResult(NSURL* u1, NSURL* u2) {
+					NSDate *d1 = nil, *d2 = nil;
+					[u1 getResourceValue: (id*)&d1 forKey: NSURLContentModificationDateKey error: NULL];
+					[u2 getResourceValue: (id*)&d2 forKey: NSURLContentModificationDateKey error: NULL];
+					return [d1 ?: [NSDate distantPast] compare: d2 ?: [NSDate distantPast]];
+				}];
+
+	for (NSURL* url in urls)
+	{
+		if (atomic_load(&_diskBytes) <= target)
+			break;
+		[self removeFileAtPath: url.path];
+	}
+}
+#pragma mark - Counters
+- (OBPResponseCacheCounters)counters
+{
+	OBPResponseCacheCounters c = {
+		.hits			= atomic_load(&_hits),
+		.revalidations	= atomic_load(&_revalidations),
+		.misses			= atomic_load(&_misses),
+		.bytesServed	= atomic_load(&_bytesServed),
+		.bytesFetched	= atomic_load(&_bytesFetched),
+		.memoryBytes	= atomic_load(&_memoryBytes),
+		.diskBytes		= atomic_load(&_diskBytes),
+	};
+	return c;
+}
+- (void)resetCounters
+{
+	atomic_store(&_hits, 0);
+	atomic_store(&_revalidations, 0);
+	atomic_store(&_misses, 0);
+	atomic_store(&_bytesServed, 0);
+	atomic_store(&_bytesFetched, 0);
+}
+- (void)countHitWithBytes:(NSUInteger)bytes revalidated:(BOOL)revalidated
+{
+	atomic_fetch_add(revalidated ? &_revalidations : &_hits, 1);
+	atomic_fetch_add(&_bytesServed, bytes);
+}
+- (void)countMissWithBytes:(NSUInteger)bytes
+{
+	atomic_fetch_add(&_misses, 1);
+	atomic_fetch_add(&_bytesFetched, bytes);
+}
+@end
@@ -0,0 +1,64 @@
+//
+//  OBPTransactionStore.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "OBPResourceModels.h"
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+@class OBPServerInfo;
+@class OBPMarshal;
+
+
+
+typedef void(^HandleOBPTransactionStoreSync)(NSUInteger addedCount, NSUInteger changedCount, NSError* _Nullable error); // (addedCount, changedCount, error); changedCount includes records removed
+typedef BOOL(^OBPTransactionStoreFilter)(OBPTransaction* transaction); // (transaction) -> include
+
+
+
+/**	An OBPTransactionStore instance keeps a local replica of the accounts and transactions of one OBP server, so that views of account history can be answered in memory instead of by downloading it again.
+
+	Records are kept as received, one JSON object per line in an append-only file per account, and are decoded into OBPAccount and OBPTransaction models when an account is first used. Transactions are indexed by account and by posted date, so that range, filter and sum queries take a binary search and a scan of the range only.
+
+	Syncing fetches only what may have changed: the first sync of an account fetches its whole history in pages, and later syncs ask only for transactions posted since the last sync, less syncOverlap to catch late changes, using the obp_from_date and obp_to_date headers. Each record received is compared with the one held, by a fingerprint of a canonical serialisation of its content, and only new or changed records are decoded and appended. When a sync completes, transactions held in the range it covered that the server no longer lists are removed, as deleted on the server. Once superseded records outnumber live ones the file is compacted.
+
+	Files are written with complete file protection on iOS, and the store's directory is excluded from backup. OBPSession removes the store of its server when it becomes invalid, e.g. at logout, and +[OBPServerInfo removeEntry:] removes it with the entry.
+
+	The store is optional: nothing in OBPKit uses it unless you do. Obtain the store for a server with +storeForServerInfo:. All methods are thread safe; queries are answered synchronously, and sync completion handlers are called on the main queue.
+*/
+@interface OBPTransactionStore : NSObject
++ (nullable instancetype)storeForServerInfo:(OBPServerInfo*)serverInfo; ///< Return the store for the server represented by serverInfo, creating it if necessary, with files in a directory of the app's caches named for the server info key.
++ (void)removeStoreForServerInfo:(OBPServerInfo*)serverInfo; ///< Discard all records of the store for the server represented by serverInfo, in memory and on disk, whether or not the store has been obtained since launch.
+- (instancetype)initWithIdentifier:(NSString*)identifier directoryPath:(nullable NSString*)directoryPath; ///< Designated initialiser. \param identifier distinguishes this store from those of other servers, and is typically the key of an OBPServerInfo instance. \param directoryPath gives the directory holding the store's files; pass nil for the default location.
+@property (nonatomic, copy, readonly) NSString* identifier;
+@property (nonatomic, copy, readonly) NSString* directoryPath;
+@property (atomic) NSTimeInterval syncOverlap; ///< Get/set how many seconds before the last sync an incremental sync starts from, so that transactions posted late or amended are caught. Default three days.
+
+- (BOOL)syncAccountsAtAPIPath:(NSString*)path withMarshal:(OBPMarshal*)marshal options:(nullable NSDictionary*)options completion:(HandleOBPTransactionStoreSync)completion; ///< Fetch the account list at path, e.g. @"/my/accounts", and merge it into the store. \param options may supply the usual OBPMarshal options. \returns NO if the request could not be launched.
+- (BOOL)syncTransactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID viewID:(NSString*)viewID withMarshal:(OBPMarshal*)marshal options:(nullable NSDictionary*)options completion:(HandleOBPTransactionStoreSync)completion; ///< Fetch the transactions of an account posted since its last sync (all of them the first time), in pages, and merge them into the store, removing those held in the synced range that the server no longer lists. Transactions deleted on the server that were posted before the range are only noticed by a full sync, after -removeAllRecords. \param options may supply the usual OBPMarshal options, including OBPMarshalOptionPageSize and OBPMarshalOptionPriority (e.g. OBPTransportPriorityBackground); extra headers given are sent as well as the date range. \returns NO if paging could not be started.
+- (nullable NSDate*)lastSyncOfAccountID:(NSString*)accountID bankID:(NSString*)bankID; ///< Return when the last successful sync of the account's transactions began, or nil if never synced.
+
+- (void)mergeAccountJSONObjects:(NSArray<NSDictionary*>*)objects added:(nullable NSUInteger*)addedAt changed:(nullable NSUInteger*)changedAt; ///< Merge account objects, as deserialized from a response you fetched yourself.
+- (void)mergeTransactionJSONObjects:(NSArray<NSDictionary*>*)objects ofAccountID:(NSString*)accountID bankID:(NSString*)bankID added:(nullable NSUInteger*)addedAt changed:(nullable NSUInteger*)changedAt; ///< Merge transaction objects of one account, as deserialized from a response you fetched yourself.
+
+- (NSArray<OBPAccount*>*)accounts; ///< Return the accounts held, in the order first received.
+- (nullable OBPAccount*)accountWithID:(NSString*)accountID bankID:(NSString*)bankID;
+- (NSArray<OBPTransaction*>*)transactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID from:(NSTimeInterval)from to:(NSTimeInterval)to matching:(nullable OBPTransactionStoreFilter)filter; ///< Return the transactions of an account posted at or after from and before to, in order of posting, that filter accepts. Pass NAN for from or to to leave that end open; transactions with no posted date are only included when both are open. Times are seconds since the NSDate reference date, as in OBPTransaction.
+- (NSUInteger)countOfTransactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID from:(NSTimeInterval)from to:(NSTimeInterval)to matching:(nullable OBPTransactionStoreFilter)filter; ///< As -transactionsOfAccountID:bankID:from:to:matching:, but only count them.
+- (OBPAmount)sumOfTransactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID from:(NSTimeInterval)from to:(NSTimeInterval)to matching:(nullable OBPTransactionStoreFilter)filter; ///< Return the exact sum of the amounts of the transactions selected as by -transactionsOfAccountID:bankID:from:to:matching:, at the greatest scale among them. Use filter to select a single currency if the account may hold more than one.
+
+- (void)removeAllRecords; ///< Discard all accounts, transactions and sync history, in memory and on disk. Syncs in progress are discarded as they complete.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
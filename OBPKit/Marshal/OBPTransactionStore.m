@@ -0,0 +1,731 @@
+//
+//  OBPTransactionStore.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPTransactionStore.h"
+// sdk
+#import <CommonCrypto/CommonDigest.h>
+// prj
+#import "OBPServerInfo.h"
+#import "OBPMarshal.h"
+#import "OBPLogging.h"
+#import "OBPURLCodec.h"
+
+
+
+#define kOBPTransactionStoreDefaultSyncOverlap	(3 * 24 * 60 * 60)
+#define kOBPStoreCompactionSlack				256		// superseded records tolerated beyond the live count before compacting
+
+#if TARGET_OS_IPHONE
+#define kOBPStoreWritingOptions	(NSDataWritingAtomic | NSDataWritingFileProtectionComplete)
+#else
+#define kOBPStoreWritingOptions	NSDataWritingAtomic
+#endif
+
+
+
+static NSString* OBPStoreHexDigestOfString(NSString* s)
+{
+	NSData*				data = [s dataUsingEncoding: NSUTF8StringEncoding];
+	uint8_t				digest[CC_SHA256_DIGEST_LENGTH];
+	char				hex[CC_SHA256_DIGEST_LENGTH * 2 + 1];
+	const char*			digits = "0123456789abcdef";
+	NSUInteger			i;
+
+	CC_SHA256([data bytes], (CC_LONG)[data length], digest);
+	for (i = 0; i < CC_SHA256_DIGEST_LENGTH; i++)
+		hex[i*2] = digits[digest[i] >> 4], hex[i*2+1] = digits[digest[i] & 15];
+	hex[i*2] = 0;
+	return [NSString stringWithUTF8String: hex];
+}
+
+static uint64_t OBPStoreFingerprintBytes(uint64_t h, const void* bytes, size_t length)
+{
+	const uint8_t* p = bytes;
+	for (; length; length--, p++)
+		h = (h ^ *p) * 1099511628211ULL;
+	return h;
+}
+
+static uint64_t OBPStoreFingerprintValue(uint64_t h, id value)
+{
+	// Feed a canonical serialisation: each value tagged with its kind, strings with their length, and dictionary members in order of key, so that equal content always gives the same bytes, whatever order it arrived in, and different content different bytes
+	const char*		s;
+	uint64_t		n;
+	uint8_t			buffer[256];
+	uint8_t*		allocated;
+	const uint8_t*	utf8;
+	size_t			length;
+
+	if ([value isKindOfClass: [NSDictionary class]])
+	{
+		NSArray* keys = [[value allKeys] sortedArrayUsingComparator: ^NSComparisonResult(id a, id b) {
+			return [[a description] compare: [b description] options: NSLiteralSearch];
+		}];
+		n = [keys count];
+		h = OBPStoreFingerprintBytes(OBPStoreFingerprintBytes(h, "{", 1), &n, sizeof(n));
+		for (id key in keys)
+			h = OBPStoreFingerprintValue(OBPStoreFingerprintValue(h, [key description]), value[key]);
+	}
+	else
+	if ([value isKindOfClass: [NSArray class]])
+	{
+		n = [value count];
+		h = OBPStoreFingerprintBytes(OBPStoreFingerprintBytes(h, "[", 1), &n, sizeof(n));
+		for (id element in value)
+			h = OBPStoreFingerprintValue(h, element);
+	}
+	else
+	if ([value isKindOfClass: [NSString class]])
+	{
+		utf8 = OBPURLGetUTF8Bytes(value, buffer, sizeof(buffer), &length, &allocated); // ...whole, even past a U+0000
+		n = utf8 ? length : 0;
+		h = OBPStoreFingerprintBytes(OBPStoreFingerprintBytes(OBPStoreFingerprintBytes(h, "s", 1), &n, sizeof(n)), utf8, n);
+		free(allocated);
+	}
+	else
+	if ([value isKindOfClass: [NSNumber class]])
+	{
+		s = [[value stringValue] UTF8String] ?: "";
+		n = strlen(s);
+		h = OBPStoreFingerprintBytes(h, CFGetTypeID((__bridge CFTypeRef)value) == CFBooleanGetTypeID() ? "b" : "n", 1);
+		h = OBPStoreFingerprintBytes(OBPStoreFingerprintBytes(h, &n, sizeof(n)), s, n);
+	}
+	else
+		h = OBPStoreFingerprintBytes(h, "0", 1); // NSNull
+	return h;
+}
+
+static uint64_t OBPStoreFingerprint(NSDictionary* object)
+{
+	return OBPStoreFingerprintValue(14695981039346656037ULL, object);
+}
+
+static NSString* OBPStoreDefaultDirectoryPath(NSString* identifier)
+{
+	NSString*		path;
+	path = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES)[0];
+	path = [path stringByAppendingPathComponent: [NSBundle mainBundle].bundleIdentifier ?: @"OBPKit"];
+	path = [path stringByAppendingPathComponent: @"OBPTransactionStore"];
+	path = [path stringByAppendingPathComponent: OBPStoreHexDigestOfString(identifier)];
+	return path;
+}
+
+static void OBPStoreCreateDirectory(NSString* directoryPath)
+{
+	// Records hold account details, so are kept unreadable while the device is locked, and out of backups
+	NSDictionary*	attributes = nil;
+	NSURL*			url = [NSURL fileURLWithPath: directoryPath isDirectory: YES];
+#if TARGET_OS_IPHONE
+	attributes = @{NSFileProtectionKey : NSFileProtectionComplete};
+#endif
+	[[NSFileManager defaultManager] createDirectoryAtPath: directoryPath
+							  withIntermediateDirectories: YES
+											   attributes: attributes error: NULL];
+	[url setResourceValue: @YES forKey: NSURLIsExcludedFromBackupKey error: NULL];
+}
+
+static NSString* OBPStoreAccountKey(NSString* accountID, NSString* bankID)
+{
+	return [NSString stringWithFormat: @"%@/%@", bankID ?: @"", accountID ?: @""];
+}
+
+static double OBPStorePostedKey(OBPTransaction* transaction)
+{
+	double posted = transaction.posted;
+	return isnan(posted) ? -INFINITY : posted;
+}
+
+static BOOL OBPAmountAddTo(OBPAmount* sum, OBPAmount amount)
+{
+	// Bring both to the greater scale, then add; NO on overflow
+	int64_t		units;
+	while (sum->scale < amount.scale)
+	{
+		if (__builtin_mul_overflow(sum->units, 10, &sum->units))
+			return NO;
+		sum->scale++;
+	}
+	units = amount.units;
+	while (amount.scale < sum->scale)
+	{
+		if (__builtin_mul_overflow(units, 10, &units))
+			return NO;
+		amount.scale++;
+	}
+	return !__builtin_add_overflow(sum->units, units, &sum->units);
+}
+
+
+
+#pragma mark -
+/// An OBPStoreLedger instance holds the records of one file of the store: the accounts, or the transactions of one account.
+@interface OBPStoreLedger : NSObject
+{
+@public
+	NSString*									_path;
+	Class										_modelClass;
+	BOOL										_isAccounts;		// records keyed by bank and account; else by id, and models kept in order of posting
+	OBPModelDecoder*							_decoder;
+	NSMutableArray*								_models;
+	NSMutableDictionary<NSString*,id>*			_byKey;
+	NSMutableDictionary<NSString*,NSNumber*>*	_fingerprints;
+	NSMutableDictionary<NSString*,NSValue*>*	_ranges;			// of each record's latest line in the file
+	unsigned long long							_fileLength;
+	NSUInteger									_lineCount;			// lines in the file, including superseded records
+	BOOL										_loaded;
+}
+@end
+
+
+
+@implementation OBPStoreLedger
+- (instancetype)initWithPath:(NSString*)path accounts:(BOOL)isAccounts
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_path = [path copy];
+	_isAccounts = isAccounts;
+	_modelClass = isAccounts ? [OBPAccount class] : [OBPTransaction class];
+	_decoder = [[OBPModelDecoder alloc] init];
+	_models = [NSMutableArray array];
+	_byKey = [NSMutableDictionary dictionary];
+	_fingerprints = [NSMutableDictionary dictionary];
+	_ranges = [NSMutableDictionary dictionary];
+	return self;
+}
+- (NSString*)keyForObject:(NSDictionary*)object
+{
+	id identifier = [object isKindOfClass: [NSDictionary class]] ? object[@"id"] : nil;
+	if (![identifier isKindOfClass: [NSString class]] || ![identifier length])
+		return nil;
+	return _isAccounts ? OBPStoreAccountKey(identifier, [object[@"bank_id"] description]) : identifier;
+}
+#pragma mark -
+- (NSUInteger)indexOfFirstPostedAtOrAfter:(double)t
+{
+	NSUInteger lo = 0, hi = [_models count], mid;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (OBPStorePostedKey(_models[mid]) < t)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+- (NSUInteger)indexOfFirstPostedAfter:(double)t
+{
+	NSUInteger lo = 0, hi = [_models count], mid;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (OBPStorePostedKey(_models[mid]) <= t)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+- (NSRange)rangeFrom:(NSTimeInterval)from to:(NSTimeInterval)to
+{
+	NSUInteger lo, hi;
+	if (isnan(from) && isnan(to))
+		return NSMakeRange(0, [_models count]);
+	lo = isnan(from) ? [self indexOfFirstPostedAfter: -INFINITY] : [self indexOfFirstPostedAtOrAfter: from];
+	hi = isnan(to) ? [_models count] : [self indexOfFirstPostedAtOrAfter: to];
+	return NSMakeRange(lo, hi > lo ? hi - lo : 0);
+}
+#pragma mark -
+- (BOOL)applyObject:(NSDictionary*)object key:(NSString*)key fingerprint:(uint64_t)fingerprint
+{
+	// Decode and put in place of any earlier version; NO if it could not be decoded
+	id			model = [_modelClass modelWithJSONObject: object decoder: _decoder];
+	id			old = _byKey[key];
+	NSUInteger	i;
+
+	if (!model)
+		return NO;
+	if (old)
+	{
+		if (_isAccounts)
+			i = [_models indexOfObjectIdenticalTo: old];
+		else
+			for (i = [self indexOfFirstPostedAtOrAfter: OBPStorePostedKey(old)]; i < [_models count] && _models[i] != old; i++)
+				;
+		if (i < [_models count])
+			[_models removeObjectAtIndex: i];
+	}
+	if (_isAccounts || ![_models count] || OBPStorePostedKey([_models lastObject]) <= OBPStorePostedKey(model))
+		[_models addObject: model];
+	else
+		[_models insertObject: model atIndex: [self indexOfFirstPostedAfter: OBPStorePostedKey(model)]];
+	_byKey[key] = model;
+	_fingerprints[key] = @(fingerprint);
+	return YES;
+}
+- (void)load
+{
+	if (_loaded)
+		return;
+	_loaded = YES;
+
+	NSData*					data = [NSData dataWithContentsOfFile: _path options: NSDataReadingMappedIfSafe error: NULL];
+	const uint8_t*			bytes = [data bytes];
+	NSUInteger				length = [data length];
+	NSUInteger				start, end;
+	const uint8_t*			nl;
+	NSDictionary*			object;
+	NSString*				key;
+
+	for (start = 0; start < length; start = end + 1)
+	{
+		nl = memchr(bytes + start, '\n', length - start);
+		end = nl ? (NSUInteger)(nl - bytes) : length;
+		object = [NSJSONSerialization JSONObjectWithData: [data subdataWithRange: NSMakeRange(start, end - start)] options: 0 error: NULL];
+		if (!nl || !(key = [self keyForObject: object]))
+		{
+			// A torn last record, from an interrupted write: keep what went before
+			OBP_LOG(@"[OBPStoreLedger load] truncating %@ at unreadable record at offset %@", _path, @(start));
+			[self truncateFileAtOffset: start];
+			length = start;
+			break;
+		}
+		if ([self applyObject: object key: key fingerprint: OBPStoreFingerprint(object)])
+			_ranges[key] = [NSValue valueWithRange: NSMakeRange(start, end + 1 - start)];
+		_lineCount++;
+	}
+	_fileLength = length;
+}
+- (void)truncateFileAtOffset:(NSUInteger)offset
+{
+	NSFileHandle* fh = [NSFileHandle fileHandleForWritingAtPath: _path];
+	@try {
+		[fh truncateFileAtOffset: offset];
+	}
+	@catch (NSException* exception) {
+		OBP_LOG(@"[OBPStoreLedger truncateFileAtOffset:] failed for %@ (%@)", _path, exception);
+	}
+	[fh closeFile];
+}
+#pragma mark -
+- (void)mergeObjects:(NSArray<NSDictionary*>*)objects added:(NSUInteger*)addedAt changed:(NSUInteger*)changedAt seen:(NSMutableSet<NSString*>*)seen
+{
+	NSMutableData*		lines = [NSMutableData data];
+	NSMutableArray*		appended = [NSMutableArray array];		// @[key, start, length] within lines
+	NSDictionary*		object;
+	NSString*			key;
+	NSData*				line;
+	uint64_t			fingerprint;
+	BOOL				existed;
+
+	[self load];
+	for (object in objects)
+	{
+		if (nil == (key = [self keyForObject: object]))
+			continue;
+		[seen addObject: key];
+		fingerprint = OBPStoreFingerprint(object);
+		if ([_fingerprints[key] unsignedLongLongValue] == fingerprint && _byKey[key])
+			continue;
+		line = [NSJSONSerialization dataWithJSONObject: object options: 0 error: NULL];
+		existed = _byKey[key] != nil;
+		if (!line || ![self applyObject: object key: key fingerprint: fingerprint])
+			continue;
+		[appended addObject: @[key, @([lines length]), @([line length] + 1)]];
+		[lines appendData: line];
+		[lines appendBytes: "\n" length: 1];
+		if (existed)
+			(*changedAt)++;
+		else
+			(*addedAt)++;
+	}
+	if (![lines length])
+		return;
+
+	// Append, then note where each record now lies so that compaction can find it
+	if (![self appendData: lines])
+		return;
+	for (NSArray* item in appended)
+		_ranges[item[0]] = [NSValue valueWithRange: NSMakeRange((NSUInteger)_fileLength + [item[1] unsignedIntegerValue], [item[2] unsignedIntegerValue])];
+	_fileLength += [lines length];
+	_lineCount += [appended count];
+
+	if (_lineCount > 2 * [_byKey count] + kOBPStoreCompactionSlack)
+		[self compact];
+}
+- (BOOL)appendData:(NSData*)data
+{
+	NSFileManager*		fm = [NSFileManager defaultManager];
+	NSDictionary*		attributes = nil;
+	NSFileHandle*		fh;
+	BOOL				ok = YES;
+
+	if (![fm fileExistsAtPath: _path])
+	{
+#if TARGET_OS_IPHONE
+		attributes = @{NSFileProtectionKey : NSFileProtectionComplete};
+#endif
+		OBPStoreCreateDirectory([_path stringByDeletingLastPathComponent]);
+		[fm createFileAtPath: _path contents: nil attributes: attributes];
+	}
+	fh = [NSFileHandle fileHandleForWritingAtPath: _path];
+	@try {
+		[fh seekToFileOffset: _fileLength];
+		[fh writeData: data];
+	}
+	@catch (NSException* exception) {
+		OBP_LOG(@"[OBPStoreLedger appendData:] failed for %@ (%@)", _path, exception);
+		ok = NO;
+	}
+	[fh closeFile];
+	return ok && fh != nil;
+}
+- (void)compact
+{
+	// Copy the latest line of each record, in order of posting, to a new file that then replaces the old
+	NSData*				data = [NSData dataWithContentsOfFile: _path options: NSDataReadingMappedIfSafe error: NULL];
+	NSMutableData*		md = [NSMutableData dataWithCapacity: [data length] / 2];
+	NSMutableDictionary<NSString*,NSValue*>*
+						ranges = [NSMutableDictionary dictionaryWithCapacity: [_byKey count]];
+	NSString*			tmpPath = [_path stringByAppendingPathExtension: @"tmp"];
+	NSString*			key;
+	NSRange				r;
+	id					model;
+
+	if (!data)
+		return;
+	for (model in _models)
+	{
+		key = _isAccounts ? OBPStoreAccountKey([model accountID], [model bankID]) : [model transactionID];
+		r = [_ranges[key] rangeValue];
+		if (!r.length || NSMaxRange(r) > [data length])
+			continue;
+		ranges[key] = [NSValue valueWithRange: NSMakeRange([md length], r.length)];
+		[md appendBytes: (const uint8_t*)[data bytes] + r.location length: r.length];
+	}
+	if (![md writeToFile: tmpPath options: kOBPStoreWritingOptions error: NULL]
+	 || 0 != rename([tmpPath fileSystemRepresentation], [_path fileSystemRepresentation]))
+	{
+		OBP_LOG(@"[OBPStoreLedger compact] could not replace %@", _path);
+		[[NSFileManager defaultManager] removeItemAtPath: tmpPath error: NULL];
+		return;
+	}
+	_ranges = ranges;
+	_fileLength = [md length];
+	_lineCount = [ranges count];
+}
+- (NSUInteger)removeRecordsPostedFrom:(NSTimeInterval)from to:(NSTimeInterval)to notIn:(NSSet<NSString*>*)keep
+{
+	// Drop the records in the range that the server no longer lists, then compact, so that they are gone from the file too
+	NSRange				range;
+	NSIndexSet*			indexes;
+	NSArray*			removed;
+	NSString*			key;
+
+	[self load];
+	range = [self rangeFrom: from to: to];
+	indexes = [[NSIndexSet indexSetWithIndexesInRange: range] indexesPassingTest:
+		^BOOL(NSUInteger i, BOOL* stop) {
+			return ![keep containsObject: [self->_models[i] transactionID]];
+		}];
+	if (![indexes count])
+		return 0;
+	removed = [_models objectsAtIndexes: indexes];
+	[_models removeObjectsAtIndexes: indexes];
+	for (OBPTransaction* transaction in removed)
+	{
+		key = transaction.transactionID;
+		[_byKey removeObjectForKey: key];
+		[_fingerprints removeObjectForKey: key];
+		[_ranges removeObjectForKey: key];
+	}
+	[self compact];
+	return [removed count];
+}
+@end
+
+
+
+#pragma mark -
+@implementation OBPTransactionStore
+{
+	dispatch_queue_t								_queue;			// serialises all state below
+	OBPStoreLedger*									_accounts;
+	NSMutableDictionary<NSString*,OBPStoreLedger*>*	_transactions;	// by account key
+	NSMutableDictionary<NSString*,NSDate*>*			_lastSync;		// by account key
+	NSString*										_syncStatePath;
+	NSTimeInterval									_syncOverlap;
+	NSUInteger										_generation;	// incremented when all records are removed, so that syncs begun before are discarded
+}
+static NSMutableDictionary<NSString*,OBPTransactionStore*>* sStores = nil;
++ (instancetype)storeForServerInfo:(OBPServerInfo*)serverInfo
+{
+	NSString*				key = serverInfo.key;
+	OBPTransactionStore*	store;
+
+	if (![key length])
+		return nil;
+	@synchronized (self) {
+		if (!sStores)
+			sStores = [NSMutableDictionary dictionary];
+		if (nil == (store = sStores[key]))
+			sStores[key] = store = [[self alloc] initWithIdentifier: key directoryPath: nil];
+	}
+	return store;
+}
++ (void)removeStoreForServerInfo:(OBPServerInfo*)serverInfo
+{
+	NSString*				key = serverInfo.key;
+	OBPTransactionStore*	store;
+
+	if (![key length])
+		return;
+	@synchronized (self) {
+		store = sStores[key];
+	}
+	if (store)
+		[store removeAllRecords];
+	else
+		[[NSFileManager defaultManager] removeItemAtPath: OBPStoreDefaultDirectoryPath(key) error: NULL];
+}
+- (instancetype)initWithIdentifier:(NSString*)identifier directoryPath:(NSString*)directoryPath
+{
+	if (![identifier length])
+		{self = nil; return nil;}
+	if (nil == (self = [super init]))
+		return nil;
+	_identifier = [identifier copy];
+	_directoryPath = [directoryPath copy] ?: OBPStoreDefaultDirectoryPath(_identifier);
+	_queue = dispatch_queue_create("com.tesobe.OBPKit.OBPTransactionStore", DISPATCH_QUEUE_SERIAL);
+	_syncOverlap = kOBPTransactionStoreDefaultSyncOverlap;
+	_transactions = [NSMutableDictionary dictionary];
+	_syncStatePath = [_directoryPath stringByAppendingPathComponent: @"sync.plist"];
+	_accounts = [[OBPStoreLedger alloc] initWithPath: [_directoryPath stringByAppendingPathComponent: @"accounts.jsonl"] accounts: YES];
+	_lastSync = [([NSDictionary dictionaryWithContentsOfFile: _syncStatePath] ?: @{}) mutableCopy];
+	return self;
+}
+- (NSTimeInterval)syncOverlap
+{
+	@synchronized (self) {
+		return _syncOverlap;
+	}
+}
+- (void)setSyncOverlap:(NSTimeInterval)syncOverlap
+{
+	@synchronized (self) {
+		_syncOverlap = MAX(0, syncOverlap);
+	}
+}
+- (OBPStoreLedger*)ledgerForAccountKey:(NSString*)key // called on _queue
+{
+	OBPStoreLedger* ledger = _transactions[key];
+	if (!ledger)
+	{
+		NSString* path = [_directoryPath stringByAppendingPathComponent: [OBPStoreHexDigestOfString(key) stringByAppendingPathExtension: @"jsonl"]];
+		_transactions[key] = ledger = [[OBPStoreLedger alloc] initWithPath: path accounts: NO];
+	}
+	[ledger load];
+	return ledger;
+}
+- (void)saveSyncState // called on _queue
+{
+	NSData* data = [NSPropertyListSerialization dataWithPropertyList: _lastSync format: NSPropertyListBinaryFormat_v1_0 options: 0 error: NULL];
+	OBPStoreCreateDirectory(_directoryPath);
+	if (![data writeToFile: _syncStatePath options: kOBPStoreWritingOptions error: NULL])
+		OBP_LOG(@"[OBPTransactionStore saveSyncState] could not write %@", _syncStatePath);
+}
+#pragma mark -
+- (BOOL)syncAccountsAtAPIPath:(NSString*)path withMarshal:(OBPMarshal*)marshal options:(NSDictionary*)options completion:(HandleOBPTransactionStoreSync)completion
+{
+	NSMutableDictionary*	md = [(options ?: @{}) mutableCopy];
+
+	if (![path length] || !marshal || !completion)
+		return NO;
+	[md removeObjectForKey: OBPMarshalOptionModelClass]; // ...records are kept as received
+	md[OBPMarshalOptionResultQueue] = dispatch_get_main_queue();
+	md[OBPMarshalOptionExpectClass] = [NSNull null]; // ...a list, or an object holding one
+	md[OBPMarshalOptionOmitResponseBody] = @YES;
+
+	return [marshal getResourceAtAPIPath: path withOptions: md
+						forResultHandler:
+							^(id deserializedObject, NSString* responseBody) {
+								NSArray* objects = [deserializedObject isKindOfClass: [NSArray class]] ? deserializedObject
+												 : [deserializedObject isKindOfClass: [NSDictionary class]] ? deserializedObject[@"accounts"]
+												 : nil;
+								if (![objects isKindOfClass: [NSArray class]])
+								{
+									completion(0, 0, [NSError errorWithDomain: OBPMarshalErrorDomain code: OBPMarshalErrorUnexpectedResourceKind userInfo: @{NSLocalizedDescriptionKey : @"Unexpected response data type."}]);
+									return;
+								}
+								dispatch_async(self->_queue, ^{
+									NSUInteger added = 0, changed = 0;
+									[self->_accounts mergeObjects: objects added: &added changed: &changed seen: nil];
+									dispatch_async(dispatch_get_main_queue(), ^{completion(added, changed, nil);});
+								});
+							}
+						  orErrorHandler:
+							^(NSError* error, NSString* path) {
+								completion(0, 0, error);
+							}];
+}
+- (BOOL)syncTransactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID viewID:(NSString*)viewID withMarshal:(OBPMarshal*)marshal options:(NSDictionary*)options completion:(HandleOBPTransactionStoreSync)completion
+{
+	if (![accountID length] || ![bankID length] || ![viewID length] || !marshal || !completion)
+		return NO;
+
+	NSString*				key = OBPStoreAccountKey(accountID, bankID);
+	NSString*				path = [NSString stringWithFormat: @"banks/%@/accounts/%@/%@/transactions", bankID, accountID, viewID];
+	NSDate*					started = [NSDate date];
+	NSDate*					last = [self lastSyncOfAccountID: accountID bankID: bankID];
+	NSDate*					from = last ? [last dateByAddingTimeInterval: -self.syncOverlap] : nil;
+	NSMutableDictionary*	md = [(options ?: @{}) mutableCopy];
+	NSMutableDictionary*	headers;
+	NSMutableSet*			seen = [NSMutableSet set];	// ...on _queue
+	__block NSUInteger		generation;
+	id						obj;
+	__block NSUInteger		added = 0;
+	__block NSUInteger		changed = 0;
+
+	dispatch_sync(_queue, ^{generation = self->_generation;});
+
+	// Only what was posted since the last sync, less the overlap, and in a stable order for paging
+	obj = options[OBPMarshalOptionExtraHeaders];
+	headers = [obj isKindOfClass: [NSDictionary class]] ? [obj mutableCopy] : [NSMutableDictionary dictionary];
+	if (from)
+		headers[@"obp_from_date"] = from;
+	headers[@"obp_to_date"] = started;
+	headers[@"obp_sort_direction"] = @"ASC";
+	md[OBPMarshalOptionExtraHeaders] = headers;
+	[md removeObjectForKey: OBPMarshalOptionModelClass]; // ...records are kept as received
+	[md removeObjectForKey: OBPMarshalOptionCacheMaxAge];
+
+	OBPPager* pager =
+		[marshal pageResourcesAtAPIPath: path elementsKey: @"transactions" withOptions: md
+						 forPageHandler:
+							^(NSArray* elements, NSUInteger offset, BOOL* stop) {
+								dispatch_async(self->_queue, ^{
+									if (generation == self->_generation) // ...else removed meanwhile, e.g. at logout
+										[[self ledgerForAccountKey: key] mergeObjects: elements added: &added changed: &changed seen: seen];
+								});
+							}
+							 completion:
+							^(NSUInteger elementCount, NSError* error) {
+								dispatch_async(self->_queue, ^{
+									if (!error && generation == self->_generation)
+									{
+										// Every transaction in the range was listed, so any held in it but not listed has been deleted on the server
+										changed += [[self ledgerForAccountKey: key] removeRecordsPostedFrom: from ? [from timeIntervalSinceReferenceDate] : NAN
+																										 to: from ? [started timeIntervalSinceReferenceDate] : NAN
+																									  notIn: seen];
+										self->_lastSync[key] = started;
+										[self saveSyncState];
+									}
+									NSUInteger a = added, c = changed;
+									OBP_LOG_IF(error, @"[OBPTransactionStore sync] %@ failed after %@ new and %@ changed transactions: %@", path, @(a), @(c), error);
+									dispatch_async(dispatch_get_main_queue(), ^{completion(a, c, error);});
+								});
+							}];
+	return pager != nil;
+}
+- (NSDate*)lastSyncOfAccountID:(NSString*)accountID bankID:(NSString*)bankID
+{
+	__block NSDate* date;
+	dispatch_sync(_queue, ^{date = self->_lastSync[OBPStoreAccountKey(accountID, bankID)];});
+	return date;
+}
+#pragma mark -
+- (void)mergeAccountJSONObjects:(NSArray<NSDictionary*>*)objects added:(NSUInteger*)addedAt changed:(NSUInteger*)changedAt
+{
+	__block NSUInteger added = 0, changed = 0;
+	dispatch_sync(_queue, ^{[self->_accounts mergeObjects: objects added: &added changed: &changed seen: nil];});
+	if (addedAt)
+		*addedAt = added;
+	if (changedAt)
+		*changedAt = changed;
+}
+- (void)mergeTransactionJSONObjects:(NSArray<NSDictionary*>*)objects ofAccountID:(NSString*)accountID bankID:(NSString*)bankID added:(NSUInteger*)addedAt changed:(NSUInteger*)changedAt
+{
+	__block NSUInteger added = 0, changed = 0;
+	dispatch_sync(_queue, ^{[[self ledgerForAccountKey: OBPStoreAccountKey(accountID, bankID)] mergeObjects: objects added: &added changed: &changed seen: nil];});
+	if (addedAt)
+		*addedAt = added;
+	if (changedAt)
+		*changedAt = changed;
+}
+#pragma mark -
+- (NSArray<OBPAccount*>*)accounts
+{
+	__block NSArray* accounts;
+	dispatch_sync(_queue, ^{
+		[self->_accounts load];
+		accounts = [self->_accounts->_models copy];
+	});
+	return accounts;
+}
+- (OBPAccount*)accountWithID:(NSString*)accountID bankID:(NSString*)bankID
+{
+	__block OBPAccount* account;
+	dispatch_sync(_queue, ^{
+		[self->_accounts load];
+		account = self->_accounts->_byKey[OBPStoreAccountKey(accountID, bankID)];
+	});
+	return account;
+}
+- (void)enumerateTransactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID from:(NSTimeInterval)from to:(NSTimeInterval)to matching:(OBPTransactionStoreFilter)filter usingBlock:(void(^)(OBPTransaction* transaction))block
+{
+	// The range is found by binary search and copied out, so that the filter runs without holding up other users of the store
+	__block NSArray<OBPTransaction*>* range;
+	dispatch_sync(_queue, ^{
+		OBPStoreLedger* ledger = [self ledgerForAccountKey: OBPStoreAccountKey(accountID, bankID)];
+		range = [ledger->_models subarrayWithRange: [ledger rangeFrom: from to: to]];
+	});
+	for (OBPTransaction* transaction in range)
+		if (!filter || filter(transaction))
+			block(transaction);
+}
+- (NSArray<OBPTransaction*>*)transactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID from:(NSTimeInterval)from to:(NSTimeInterval)to matching:(OBPTransactionStoreFilter)filter
+{
+	NSMutableArray* transactions = [NSMutableArray array];
+	[self enumerateTransactionsOfAccountID: accountID bankID: bankID from: from to: to matching: filter usingBlock:
+		^(OBPTransaction* transaction) {
+			[transactions addObject: transaction];
+		}];
+	return transactions;
+}
+- (NSUInteger)countOfTransactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID from:(NSTimeInterval)from to:(NSTimeInterval)to matching:(OBPTransactionStoreFilter)filter
+{
+	__block NSUInteger count = 0;
+	[self enumerateTransactionsOfAccountID: accountID bankID: bankID from: from to: to matching: filter usingBlock:
+		^(OBPTransaction* transaction) {
+			count++;
+		}];
+	return count;
+}
+- (OBPAmount)sumOfTransactionsOfAccountID:(NSString*)accountID bankID:(NSString*)bankID from:(NSTimeInterval)from to:(NSTimeInterval)to matching:(OBPTransactionStoreFilter)filter
+{
+	__block OBPAmount sum = {0, 0};
+	[self enumerateTransactionsOfAccountID: accountID bankID: bankID from: from to: to matching: filter usingBlock:
+		^(OBPTransaction* transaction) {
+			if (!OBPAmountAddTo(&sum, transaction.amount))
+				OBP_LOG(@"[OBPTransactionStore sum] overflow adding transaction %@", transaction.transactionID);
+		}];
+	return sum;
+}
+#pragma mark -
+- (void)removeAllRecords
+{
+	dispatch_sync(_queue, ^{
+		[[NSFileManager defaultManager] removeItemAtPath: self->_directoryPath error: NULL];
+		self->_generation++;
+		self->_accounts = [[OBPStoreLedger alloc] initWithPath: self->_accounts->_path accounts: YES];
+		[self->_transactions removeAllObjects];
+		[self->_lastSync removeAllObjects];
+	});
+}
+@end
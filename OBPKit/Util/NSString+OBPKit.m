@@ -9,63 +9,47 @@
 #import "NSString+OBPKit.h"
 // sdk
 // prj
-#import "OBPLogging.h"
+#import "OBPURLCodec.h"
 
 
 
 @implementation NSString (OBPKit)
 - (NSString*)stringByAddingPercentEncodingForAllRFC3986ReservedCharachters
 {
-	static NSCharacterSet* sAllowedSet = nil;
-	static dispatch_once_t onceToken;
-	dispatch_once(&onceToken, ^{
-		sAllowedSet = [NSCharacterSet characterSetWithCharactersInString:
-			@"-._~0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"];
-			// ...the Unreserved Characters in RFC 3986, Section 2.3. (Unfortunately the NSURLUtilities category on NSCharacterSet provides allowed sets for Host, User, Password, Path, Query and Fragment, but not the Unreserved set.)
-	});
-	return [self stringByAddingPercentEncodingWithAllowedCharacters: sAllowedSet];
+	// Encodes all but the Unreserved Characters in RFC 3986, Section 2.3, working on the UTF-8 bytes; see OBPURLCodec.h
+	return OBPURLPercentEncodedString(self);
 }
 - (NSString*)stringByAppendingURLQueryParams:(NSDictionary*)dictionary
 {
-    NSMutableString*	str = [self mutableCopy];
-	const char*			sep = [str rangeOfString:@"?"].length ? "&" : "?";
-    
-    for (id key in dictionary)
+	// The query is built as UTF-8 bytes in one buffer, with names and values encoded straight into it
+	NSMutableData*	md = [NSMutableData dataWithCapacity: 3 * [self length] + 64 * [dictionary count]];
+	uint8_t			sep;
+	id				key;
+
+	OBPURLAppendUTF8String(md, self);
+	sep = memchr([md bytes], '?', [md length]) ? '&' : '?';
+	for (key in dictionary)
 	{
-        NSString *keyString = [key description];
-        NSString *valString = [dictionary[key] description];
-		keyString = [keyString stringByAddingPercentEncodingForAllRFC3986ReservedCharachters];
-		valString = [valString stringByAddingPercentEncodingForAllRFC3986ReservedCharachters];
-		[str appendFormat: @"%s%@=%@", sep, keyString, valString];
-		sep = "&";
-    }
+		[md appendBytes: &sep length: 1];
+		OBPURLAppendPercentEncodedString(md, [key description]);
+		[md appendBytes: "=" length: 1];
+		OBPURLAppendPercentEncodedString(md, [dictionary[key] description]);
+		sep = '&';
+	}
 
-    return [str copy];
+	return [[NSString alloc] initWithData: md encoding: NSUTF8StringEncoding];
 }
 
 -(NSDictionary *)extractURLQueryParams
 {
-    NSMutableDictionary	*params = [NSMutableDictionary dictionary];
-    NSArray				*pairs, *elements;
-	NSString			*pair, *key, *val;
-
-	pairs = [self componentsSeparatedByString: @"&"];
-
-    for (pair in pairs)
-	{
-        elements = [pair componentsSeparatedByString: @"="];
-		OBP_LOG_IF(2 != [elements count], @"-extractQueryParams\nNot an element pair: %@\nQuery string: %@", pair, self);
-		if ([elements count] != 2)
-			continue;
-		key = elements[0];
-		val = elements[1];
-        key = [key stringByRemovingPercentEncoding];
-        val = [val stringByRemovingPercentEncoding];
-        
-        params[key] = val;
-    }
+	uint8_t				buffer[512];
+	uint8_t*			allocated;
+	size_t				length;
+	const uint8_t*		utf8 = OBPURLGetUTF8Bytes(self, buffer, sizeof(buffer), &length, &allocated);
+	NSDictionary*		params = utf8 ? OBPURLQueryParse(utf8, length) : @{};
 
-    return [params copy];
+	free(allocated);
+	return params;
 }
 
 - (NSString*)stringForURLByAppendingPath:(NSString*)path
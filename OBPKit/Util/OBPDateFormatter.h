@@ -10,8 +10,11 @@
 
 
 
-/// OBPDateFormatter deals only with the date formats used by the OBP API, which are a subset of the ISO 8601 format possibilities.
+/// OBPDateFormatter deals only with the date formats used by the OBP API, which are a subset of the ISO 8601 format possibilities. The class methods convert the fixed formats yyyy-MM-dd'T'HH:mm:ss'Z' and yyyy-MM-dd'T'HH:mm:ss.SSS'Z' directly, without locale or calendar machinery, and fall back to NSDateFormatter only for inputs they do not recognise; they are safe to call from any thread.
 @interface OBPDateFormatter : NSDateFormatter
 + (NSString*)stringFromDate:(NSDate*)date;
 + (NSDate*)dateFromString:(NSString*)string;
++ (NSTimeInterval)timeIntervalFromString:(NSString*)string; ///< Return the date in string as seconds since the NSDate reference date, without creating an NSDate, or NAN if string is not recognised.
++ (NSArray*)datesFromStrings:(NSArray*)strings; ///< Convert an array of strings in one call, e.g. a column of timestamps from a decoded response. \returns an array of the same length, holding an NSDate for each recognised string and NSNull for anything else.
++ (id)JSONObject:(id)object byConvertingDatesForKeys:(NSSet<NSString*>*)keys; ///< Return a copy of the deserialized JSON object in which every string value held under one of keys, in any dictionary at any depth, is replaced by an NSDate, e.g. keys @"posted" and @"completed" in a transactions response. Values that are not recognised dates are left unchanged. Containers with nothing to convert are returned as they are, not copied.
 @end
@@ -11,6 +11,95 @@
 
 
 
+#define kOBPDateMaxLength			32				// longest string the fast path will look at
+
+
+
+// Days since 1970-01-01 of a proleptic Gregorian date (after Howard Hinnant's days_from_civil)
+static int64_t OBPDaysFromCivil(int64_t y, unsigned m, unsigned d)
+{
+	int64_t		era;
+	unsigned	yoe, doy, doe;
+
+	y -= m <= 2;
+	era = (y >= 0 ? y : y - 399) / 400;
+	yoe = (unsigned)(y - era * 400);
+	doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void OBPCivilFromDays(int64_t z, int64_t* yAt, unsigned* mAt, unsigned* dAt)
+{
+	int64_t		era;
+	unsigned	doe, yoe, doy, mp;
+
+	z += 719468;
+	era = (z >= 0 ? z : z - 146096) / 146097;
+	doe = (unsigned)(z - era * 146097);
+	yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	mp = (5 * doy + 2) / 153;
+	*dAt = doy - (153 * mp + 2) / 5 + 1;
+	*mAt = mp < 10 ? mp + 3 : mp - 9;
+	*yAt = (int64_t)yoe + era * 400 + (*mAt <= 2);
+}
+
+static BOOL OBPReadDigits(const char* p, int n, unsigned* valueAt)
+{
+	unsigned v = 0;
+	while (n--)
+	{
+		if (*p < '0' || *p > '9')
+			return NO;
+		v = v * 10 + (unsigned)(*p++ - '0');
+	}
+	*valueAt = v;
+	return YES;
+}
+
+// Parse yyyy-MM-ddTHH:mm:ss[.f...]Z exactly; anything else is left to the fallback formatters
+static BOOL OBPParseISO8601(const char* s, size_t len, NSTimeInterval* timeAt)
+{
+	static const uint8_t	daysInMonth[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	unsigned				year, month, day, hour, minute, second;
+	uint64_t				fraction = 0, scale = 1;
+	size_t					i;
+
+	if (len < 20 || s[len - 1] != 'Z'
+	 || s[4] != '-' || s[7] != '-' || s[10] != 'T' || s[13] != ':' || s[16] != ':'
+	 || !OBPReadDigits(s, 4, &year) || !OBPReadDigits(s + 5, 2, &month) || !OBPReadDigits(s + 8, 2, &day)
+	 || !OBPReadDigits(s + 11, 2, &hour) || !OBPReadDigits(s + 14, 2, &minute) || !OBPReadDigits(s + 17, 2, &second))
+		return NO;
+	if (len > 20)
+	{
+		if (s[19] != '.' || len == 21)
+			return NO;
+		for (i = 20; i < len - 1; i++, scale *= 10)
+		{
+			if (s[i] < '0' || s[i] > '9')
+				return NO;
+			fraction = fraction * 10 + (uint64_t)(s[i] - '0');
+		}
+	}
+	if (month < 1 || month > 12 || day < 1 || day > daysInMonth[month - 1] || hour > 23 || minute > 59 || second > 59)
+		return NO;
+	if (month == 2 && day == 29 && (year % 4 || (year % 100 == 0 && year % 400)))
+		return NO;
+
+	*timeAt = (double)(OBPDaysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second) - NSTimeIntervalSince1970 + (double)fraction / scale;
+	return YES;
+}
+
+static void OBPWriteDigits(char* p, unsigned value, int n)
+{
+	while (n--)
+		p[n] = (char)('0' + value % 10), value /= 10;
+}
+
+
+
+#pragma mark -
 @implementation OBPDateFormatter
 static OBPDateFormatter* sInstA = nil;
 static OBPDateFormatter* sInstB = nil;
@@ -23,13 +112,126 @@ static OBPDateFormatter* sInstB = nil;
 }
 + (NSString*)stringFromDate:(NSDate*)date
 {
-	return [sInstA stringFromDate: date];
+	NSTimeInterval		t = [date timeIntervalSinceReferenceDate] + NSTimeIntervalSince1970;
+	int64_t				seconds, days, year;
+	unsigned			month, day, secondOfDay;
+	char				buf[20];
+
+	if (date == nil || !isfinite(t))
+		return nil;
+	seconds = (int64_t)floor(t);
+	days = (seconds >= 0 ? seconds : seconds - 86399) / 86400;
+	secondOfDay = (unsigned)(seconds - days * 86400);
+	OBPCivilFromDays(days, &year, &month, &day);
+	if (year < 0 || year > 9999)
+	{
+		@synchronized (sInstA) {
+			return [sInstA stringFromDate: date];
+		}
+	}
+
+	OBPWriteDigits(buf, (unsigned)year, 4), buf[4] = '-';
+	OBPWriteDigits(buf + 5, month, 2), buf[7] = '-';
+	OBPWriteDigits(buf + 8, day, 2), buf[10] = 'T';
+	OBPWriteDigits(buf + 11, secondOfDay / 3600, 2), buf[13] = ':';
+	OBPWriteDigits(buf + 14, secondOfDay / 60 % 60, 2), buf[16] = ':';
+	OBPWriteDigits(buf + 17, secondOfDay % 60, 2), buf[19] = 'Z';
+	return [[NSString alloc] initWithBytes: buf length: sizeof(buf) encoding: NSASCIIStringEncoding];
 }
 + (NSDate*)dateFromString:(NSString*)string
 {
-	NSDate* date = [sInstA dateFromString: string] ?: [sInstB dateFromString: string];
-	OBP_LOG_IF([string length] && !date, @"[%@ dateFromString: %@] • string format not recognised •", self, string);
-	return date;
+	NSTimeInterval t = [self timeIntervalFromString: string];
+	return isnan(t) ? nil : [NSDate dateWithTimeIntervalSinceReferenceDate: t];
+}
++ (NSTimeInterval)timeIntervalFromString:(NSString*)string
+{
+	char			buf[kOBPDateMaxLength + 1];
+	const char*		s;
+	NSUInteger		len = [string length];
+	NSTimeInterval	t;
+	NSDate*			date;
+
+	if (!len)
+		return NAN;
+	if (len <= kOBPDateMaxLength)
+	{
+		s = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingASCII);
+		if (s == NULL && [string getCString: buf maxLength: sizeof(buf) encoding: NSASCIIStringEncoding])
+			s = buf;
+		if (s != NULL && OBPParseISO8601(s, len, &t))
+			return t;
+	}
+
+	// Unusual input: let the formatters decide, one thread at a time
+	@synchronized (sInstA) {
+		date = [sInstA dateFromString: string] ?: [sInstB dateFromString: string];
+	}
+	OBP_LOG_IF(!date, @"[%@ timeIntervalFromString: %@] • string format not recognised •", self, string);
+	return date ? [date timeIntervalSinceReferenceDate] : NAN;
+}
++ (NSArray*)datesFromStrings:(NSArray*)strings
+{
+	NSMutableArray*		dates = [NSMutableArray arrayWithCapacity: [strings count]];
+	NSNull*				null = [NSNull null];
+	NSTimeInterval		t;
+
+	for (id s in strings)
+	{
+		t = [s isKindOfClass: [NSString class]] ? [self timeIntervalFromString: s] : NAN;
+		[dates addObject: isnan(t) ? null : [NSDate dateWithTimeIntervalSinceReferenceDate: t]];
+	}
+	return [dates copy];
+}
++ (id)JSONObject:(id)object byConvertingDatesForKeys:(NSSet<NSString*>*)keys
+{
+	if ([object isKindOfClass: [NSDictionary class]])
+	{
+		NSMutableDictionary*	converted = nil;
+		NSTimeInterval			t;
+		id						value, newValue;
+
+		for (NSString* key in object)
+		{
+			value = object[key];
+			newValue = value;
+			if ([value isKindOfClass: [NSString class]])
+			{
+				if ([keys containsObject: key] && !isnan(t = [self timeIntervalFromString: value]))
+					newValue = [NSDate dateWithTimeIntervalSinceReferenceDate: t];
+			}
+			else
+				newValue = [self JSONObject: value byConvertingDatesForKeys: keys];
+			if (newValue != value)
+			{
+				if (converted == nil)
+					converted = [object mutableCopy];
+				converted[key] = newValue;
+			}
+		}
+		return converted ?: object;
+	}
+
+	if ([object isKindOfClass: [NSArray class]])
+	{
+		NSMutableArray*			converted = nil;
+		NSUInteger				i = 0;
+		id						newValue;
+
+		for (id value in object)
+		{
+			newValue = [self JSONObject: value byConvertingDatesForKeys: keys];
+			if (newValue != value)
+			{
+				if (converted == nil)
+					converted = [object mutableCopy];
+				converted[i] = newValue;
+			}
+			i++;
+		}
+		return converted ?: object;
+	}
+
+	return object;
 }
 - (instancetype)initWithSubseconds:(BOOL)subsecs
 {
@@ -59,4 +59,84 @@
 #define OBP_LOG_IF(test, fmt, ...) do{if(test)OBP_LOG(fmt, ##__VA_ARGS__);}while(0)
 #define OBP_ASSERT(test) do{if(!(test)){OBP_LOG(@"Assert %s failed (%s:%d)", #test, __PRETTY_FUNCTION__, __LINE__);OBP_BREAK;}}while(0)
 
+
+/*	Tracing: a low overhead alternative to logging, for diagnostics that can stay on under production load.
+
+	Each event is a fixed-size binary record, written without locking into a ring buffer belonging to the recording thread, and moved from there to a file by a background drain. When a thread's ring is full, or all rings are taken by other live threads when it first records, its events are dropped and counted rather than waiting. Requests are sampled as they start: events of a request not sampled are not recorded, except errors if OBPTraceOptionAlwaysErrors was given. Names, such as path templates and error domains, are recorded once each and referred to by identifier.
+
+	Decode a trace file with the TraceDecode tool, e.g. `TraceDecode trace.obptrace`.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint16_t OBPTraceKind;
+enum
+{
+	OBPTraceKindName = 1,		/* value: name id, detail: byte length; followed by the UTF-8 bytes, padded to a whole number of events */
+	OBPTraceKindRequestStart,	/* value: verb (0 GET, 1 PUT, 2 POST, 3 DELETE), detail: name id of path template */
+	OBPTraceKindAuth,			/* value: 0, detail: nanoseconds spent signing */
+	OBPTraceKindResponse,		/* value: HTTP status, or 0 if none, detail: body bytes */
+	OBPTraceKindDecode,			/* value: bytes decoded, or elements if streamed, detail: nanoseconds spent decoding */
+	OBPTraceKindRetry,			/* value: attempt, detail: nanoseconds of delay before it */
+	OBPTraceKindError,			/* value: error code, detail: name id of error domain */
+	OBPTraceKindRequestEnd,		/* value: 0 on success, else error code, detail: nanoseconds since start */
+	OBPTraceKindDropped,		/* value: events dropped by the thread since last reported, detail: 0; thread is OBPTraceThreadNoRing for the events of threads that could not be given a ring */
+	OBPTraceKind_count
+};
+
+typedef struct OBPTraceEvent
+{
+	uint64_t		time;		/* mach_absolute_time() units; see OBPTraceFileHeader for the timebase */
+	uint32_t		requestID;	/* identifies the request, or 0 */
+	OBPTraceKind	kind;
+	uint16_t		thread;		/* index of the recording thread's ring, or OBPTraceThreadNoRing */
+	int64_t			value;
+	uint64_t		detail;
+} OBPTraceEvent; /* 32 bytes */
+
+enum
+{
+	OBPTraceThreadNoRing = 0xFFFF,	/* OBPTraceEvent.thread of drops by threads started once all rings were taken */
+};
+
+typedef struct OBPTraceFileHeader
+{
+	char			magic[8];	/* "OBPTRACE" */
+	uint32_t		version;	/* 1 */
+	uint32_t		eventSize;	/* sizeof(OBPTraceEvent) */
+	uint32_t		timebaseNumer, timebaseDenom; /* nanoseconds = time * numer / denom */
+	uint64_t		startTime;	/* mach_absolute_time() at start */
+	double			startDate;	/* seconds since 1970 at start */
+} OBPTraceFileHeader; /* followed by events */
+
+enum
+{
+	OBPTraceOptionAlwaysErrors = 1 << 0,	/* record errors of requests that were not sampled, with requestID 0 */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern volatile bool gOBPTraceEnabled;	/* read without synchronisation by OBP_TRACE; set by OBPTraceStart/Stop */
+extern volatile bool gOBPTraceAlwaysErrors;
+bool OBPTraceStart(const char* path, double sampleRate, uint32_t options); /* start recording to a new file at path, sampling the given fraction (0...1) of requests; returns false if already started or the file cannot be created */
+void OBPTraceStop(void); /* stop recording, drain what is buffered, and close the file */
+void OBPTraceFlush(void); /* drain what is buffered now, and wait until written */
+void OBPTraceSetSampleRate(double sampleRate);
+uint64_t OBPTraceDroppedCount(void); /* total events dropped since start */
+uint32_t OBPTraceBeginRequest(void); /* return an identifier for a new request if it is sampled, else 0 */
+uint64_t OBPTraceNameID(const char* name); /* return the identifier of name, recording it the first time it is seen */
+void OBPTraceRecord(OBPTraceKind kind, uint32_t requestID, int64_t value, uint64_t detail);
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef OBP_NO_TRACING
+	#define OBP_TRACE(kind, requestID, value, detail) do{if(gOBPTraceEnabled && (requestID))OBPTraceRecord(kind, requestID, (int64_t)(value), (uint64_t)(detail));}while(0)
+	#define OBP_TRACE_ERROR(requestID, code, domain) do{if(gOBPTraceEnabled && ((requestID) || gOBPTraceAlwaysErrors))OBPTraceRecord(OBPTraceKindError, requestID, (int64_t)(code), OBPTraceNameID(domain));}while(0)
+#else
+	#define OBP_TRACE(kind, requestID, value, detail)
+	#define OBP_TRACE_ERROR(requestID, code, domain)
+#endif
+
 #endif /* OBPLogging_h */
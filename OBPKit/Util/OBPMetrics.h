@@ -0,0 +1,114 @@
+//
+//  OBPMetrics.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+typedef NS_ENUM(uint8_t, OBPMetric)
+{
+	OBPMetricQueueWait,			///< Seconds a request waited in its transport for a free slot.
+	OBPMetricTimeToFirstByte,	///< Seconds from sending a request to receiving its response headers, which includes connection set-up and the server's own time.
+	OBPMetricTransfer,			///< Seconds from receiving the response headers to receiving the last byte of the body.
+	OBPMetricSigning,			///< Seconds spent adding the authorisation header.
+	OBPMetricDecode,			///< Seconds spent deserializing and decoding the response body.
+	OBPMetricBodyBytes,			///< Size of the response body in bytes.
+
+	OBPMetric_count
+};
+
+NSString* NSStringFromOBPMetric(OBPMetric metric); ///< Return a short name for the metric, e.g. @"queueWait", as used in dictionary representations.
+NSTimeInterval OBPMonotonicTime(void); ///< Return the time in seconds from an arbitrary origin, using a clock that is unaffected by changes to the system time; for measuring intervals.
+
+
+
+/// An OBPRequestMetrics instance records the measurements for one request. Measurements that were not made, e.g. the decode time of a request that failed, are NAN.
+@interface OBPRequestMetrics : NSObject
+- (instancetype)initWithServer:(NSString*)server method:(NSString*)method pathTemplate:(NSString*)pathTemplate; ///< Designated initialiser.
+@property (nonatomic, copy, readonly) NSString* server; ///< The API base of the server.
+@property (nonatomic, copy, readonly) NSString* method;
+@property (nonatomic, copy, readonly) NSString* pathTemplate; ///< The request path with identifiers replaced by *. \sa +[OBPMetrics pathTemplateForPath:]
+@property (nonatomic) NSInteger statusCode; ///< The HTTP status of the response, or zero if there was none.
+@property (nonatomic, strong, nullable) NSError* error;
+@property (nonatomic) NSTimeInterval queueWait;
+@property (nonatomic) NSTimeInterval timeToFirstByte;
+@property (nonatomic) NSTimeInterval transfer;
+@property (nonatomic) NSTimeInterval signing;
+@property (nonatomic) NSTimeInterval decode;
+@property (nonatomic) NSUInteger bodyBytes;
+- (double)valueForMetric:(OBPMetric)metric; ///< Return the measurement for metric, or NAN if not made.
+- (NSDictionary<NSString*,id>*)dictionaryRepresentation; ///< Return the record as a dictionary that can be serialized as JSON, omitting measurements not made.
+@end
+
+
+
+/// An OBPMetricsHistogram instance summarises the distribution of one metric, in buckets of half an octave each, so that percentiles are accurate to within about 20%.
+@interface OBPMetricsHistogram : NSObject <NSCopying>
+@property (nonatomic, readonly) NSUInteger count;
+@property (nonatomic, readonly) double sum;
+@property (nonatomic, readonly) double min; ///< Zero when count is zero.
+@property (nonatomic, readonly) double max;
+@property (nonatomic, readonly) double mean;
+- (double)valueAtPercentile:(double)percentile; ///< Return an estimate of the value below which percentile percent of values fall, e.g. 95 for the 95th percentile.
+- (NSDictionary<NSString*,NSNumber*>*)dictionaryRepresentation; ///< Return count, mean, min, max, p50, p90 and p99.
+@end
+
+
+
+/// An OBPMetricsAggregate instance summarises the requests to one server, or to one path template.
+@interface OBPMetricsAggregate : NSObject <NSCopying>
+@property (nonatomic, readonly) NSUInteger requestCount;
+@property (nonatomic, readonly) NSUInteger errorCount; ///< Number of requests that failed for any reason, including an unexpected status.
+@property (nonatomic, readonly) NSDictionary<NSNumber*,NSNumber*>* statusCounts; ///< Number of responses by HTTP status; zero counts requests that had no response.
+- (OBPMetricsHistogram*)histogramForMetric:(OBPMetric)metric;
+- (NSDictionary<NSString*,id>*)dictionaryRepresentation;
+@end
+
+
+
+/// An OBPMetricsSnapshot instance holds the aggregates collected over an interval.
+@interface OBPMetricsSnapshot : NSObject
+@property (nonatomic, strong, readonly) NSDate* since; ///< When collection of these aggregates began, i.e. at first use or the last reset.
+@property (nonatomic, strong, readonly) NSDate* until;
+@property (nonatomic, copy, readonly) NSDictionary<NSString*,OBPMetricsAggregate*>* servers; ///< Aggregates by server API base.
+@property (nonatomic, copy, readonly) NSDictionary<NSString*,OBPMetricsAggregate*>* pathTemplates; ///< Aggregates by method and path template, e.g. @"GET /obp/v2.1.0/banks/*/accounts/*/*/transactions", across all servers.
+- (NSDictionary<NSString*,id>*)dictionaryRepresentation; ///< Return the snapshot as a dictionary that can be serialized as JSON.
+@end
+
+
+
+typedef void(^HandleOBPRequestMetrics)(OBPRequestMetrics* metrics); // (metrics)
+
+
+
+/**	OBPMetrics collects the measurements of the requests made by OBPMarshal, which separate the time a request spends waiting, on the network and server, and being signed and decoded on the client, so that you can see where the time goes.
+
+	Measurements are aggregated into histograms per server and per path template on a private serial queue, so recording a request costs the calling thread no more than an asynchronous dispatch. Take a snapshot of the aggregates at any time, and reset them to start a new interval. To export individual requests as they complete, e.g. to your own analytics, set an exportHandler.
+
+	Collection is enabled by default; set enabled to NO to turn it off.
+*/
+@interface OBPMetrics : NSObject
++ (OBPMetrics*)sharedMetrics; ///< The instance to which OBPMarshal reports.
++ (NSString*)pathTemplateForPath:(NSString*)path; ///< Return path without its query, and with each identifier replaced by *, i.e. each path component following one of the OBP collection names (banks, accounts, transactions, other_accounts, etc.), and the view that follows an account identifier. Pass OBPMarshalOptionMetricsPathTemplate to OBPMarshal to use your own template for a request.
+
+@property (atomic) BOOL enabled; ///< Get/set whether requests are measured and recorded. Default YES.
+@property (atomic, copy, nullable) HandleOBPRequestMetrics exportHandler; ///< Get/set a block to be called with each request recorded, on a private serial queue.
+
+- (void)recordRequest:(OBPRequestMetrics*)metrics; ///< Add the measurements for a request to the aggregates, and pass them to the exportHandler. Has no effect when not enabled.
+- (OBPMetricsSnapshot*)snapshot; ///< Return the aggregates collected since first use or the last reset.
+- (OBPMetricsSnapshot*)snapshotAndReset; ///< Return the aggregates collected so far, and start new ones, in one step so that no request is missed or counted twice.
+- (void)reset; ///< Discard the aggregates collected so far.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
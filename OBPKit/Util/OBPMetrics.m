@@ -0,0 +1,424 @@
+//
+//  OBPMetrics.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPMetrics.h"
+// sdk
+#include <mach/mach_time.h>
+#include <math.h>
+
+
+
+#define kOBPHistogramBuckets	97 // ...zero, then two per octave from 1 to 2^48 units
+
+
+
+NSString* NSStringFromOBPMetric(OBPMetric metric)
+{
+	switch (metric)
+	{
+		case OBPMetricQueueWait:		return @"queueWait";
+		case OBPMetricTimeToFirstByte:	return @"timeToFirstByte";
+		case OBPMetricTransfer:			return @"transfer";
+		case OBPMetricSigning:			return @"signing";
+		case OBPMetricDecode:			return @"decode";
+		case OBPMetricBodyBytes:		return @"bodyBytes";
+		default:						return @"unknown";
+	}
+}
+
+NSTimeInterval OBPMonotonicTime(void)
+{
+	static mach_timebase_info_data_t	timebase;
+	static dispatch_once_t				once;
+	dispatch_once(&once, ^{mach_timebase_info(&timebase);});
+	return (double)mach_absolute_time() * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+
+
+#pragma mark -
+@implementation OBPRequestMetrics
+- (instancetype)initWithServer:(NSString*)server method:(NSString*)method pathTemplate:(NSString*)pathTemplate
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_server = [server copy] ?: @"";
+	_method = [method copy] ?: @"";
+	_pathTemplate = [pathTemplate copy] ?: @"";
+	_queueWait = _timeToFirstByte = _transfer = _signing = _decode = NAN;
+	return self;
+}
+- (double)valueForMetric:(OBPMetric)metric
+{
+	switch (metric)
+	{
+		case OBPMetricQueueWait:		return _queueWait;
+		case OBPMetricTimeToFirstByte:	return _timeToFirstByte;
+		case OBPMetricTransfer:			return _transfer;
+		case OBPMetricSigning:			return _signing;
+		case OBPMetricDecode:			return _decode;
+		case OBPMetricBodyBytes:		return isnan(_timeToFirstByte) ? NAN : _bodyBytes;
+		default:						return NAN;
+	}
+}
+- (NSDictionary<NSString*,id>*)dictionaryRepresentation
+{
+	NSMutableDictionary*	md = [NSMutableDictionary dictionary];
+	OBPMetric				metric;
+	double					value;
+
+	md[@"server"] = _server;
+	md[@"method"] = _method;
+	md[@"pathTemplate"] = _pathTemplate;
+	md[@"status"] = @(_statusCode);
+	if (_error)
+		md[@"error"] = [NSString stringWithFormat: @"%@ %ld", _error.domain, (long)_error.code];
+	for (metric = 0; metric < OBPMetric_count; metric++)
+		if (!isnan(value = [self valueForMetric: metric]))
+			md[NSStringFromOBPMetric(metric)] = @(value);
+	return [md copy];
+}
+- (NSString*)description
+{
+	return [NSString stringWithFormat: @"<%@ %@ %@ %@>", NSStringFromClass([self class]), _method, _pathTemplate, [self dictionaryRepresentation]];
+}
+@end
+
+
+
+#pragma mark -
+@interface OBPMetricsHistogram ()
+- (instancetype)initWithScale:(double)scale;
+- (void)addValue:(double)value;
+@end
+
+@implementation OBPMetricsHistogram
+{
+	double			_scale;		// values are bucketed in units of 1/scale, i.e. microseconds for times
+	uint32_t		_buckets[kOBPHistogramBuckets];
+}
+- (instancetype)initWithScale:(double)scale
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_scale = scale;
+	return self;
+}
+- (id)copyWithZone:(NSZone*)zone
+{
+	OBPMetricsHistogram* copy = [[[self class] alloc] initWithScale: _scale];
+	copy->_count = _count;
+	copy->_sum = _sum;
+	copy->_min = _min;
+	copy->_max = _max;
+	memcpy(copy->_buckets, _buckets, sizeof(_buckets));
+	return copy;
+}
+static NSUInteger OBPHistogramBucket(double units)
+{
+	int			e;
+	NSUInteger	i;
+	if (!(units >= 1))
+		return 0;
+	e = ilogb(units);
+	i = 1 + 2 * (NSUInteger)e + (units >= 1.5 * ldexp(1, e));
+	return MIN(i, kOBPHistogramBuckets - 1);
+}
+static double OBPHistogramBucketFloor(NSUInteger i)
+{
+	return i == 0 ? 0 : ldexp(1 + 0.5 * ((i - 1) & 1), (int)((i - 1) / 2));
+}
+- (void)addValue:(double)value
+{
+	if (isnan(value))
+		return;
+	value = MAX(0, value);
+	_min = _count ? MIN(_min, value) : value;
+	_max = _count ? MAX(_max, value) : value;
+	_count++;
+	_sum += value;
+	_buckets[OBPHistogramBucket(value * _scale)]++;
+}
+- (double)mean
+{
+	return _count ? _sum / _count : 0;
+}
+- (double)valueAtPercentile:(double)percentile
+{
+	NSUInteger		rank, seen = 0, i;
+	double			lo, hi;
+
+	if (!_count)
+		return 0;
+	rank = (NSUInteger)ceil(MAX(0, MIN(100, percentile)) / 100 * _count);
+	rank = MAX(1, rank);
+	for (i = 0; i < kOBPHistogramBuckets; i++)
+		if ((seen += _buckets[i]) >= rank)
+			break;
+	// Take the middle of the bucket, but never beyond the extremes actually seen
+	lo = OBPHistogramBucketFloor(i) / _scale;
+	hi = (i + 1 < kOBPHistogramBuckets ? OBPHistogramBucketFloor(i + 1) : OBPHistogramBucketFloor(i) * 1.5) / _scale;
+	return MAX(_min, MIN(_max, (lo + hi) / 2));
+}
+- (NSDictionary<NSString*,NSNumber*>*)dictionaryRepresentation
+{
+	return @{
+		@"count"	: @(_count),
+		@"mean"		: @(self.mean),
+		@"min"		: @(_min),
+		@"max"		: @(_max),
+		@"p50"		: @([self valueAtPercentile: 50]),
+		@"p90"		: @([self valueAtPercentile: 90]),
+		@"p99"		: @([self valueAtPercentile: 99]),
+	};
+}
+@end
+
+
+
+#pragma mark -
+@interface OBPMetricsAggregate ()
+- (void)addRequest:(OBPRequestMetrics*)metrics;
+@end
+
+@implementation OBPMetricsAggregate
+{
+	OBPMetricsHistogram*	_histograms[OBPMetric_count];
+	NSCountedSet*			_statuses;
+}
+- (instancetype)init
+{
+	if (nil == (self = [super init]))
+		return nil;
+	for (OBPMetric metric = 0; metric < OBPMetric_count; metric++)
+		_histograms[metric] = [[OBPMetricsHistogram alloc] initWithScale: metric == OBPMetricBodyBytes ? 1 : 1e6];
+	_statuses = [NSCountedSet set];
+	return self;
+}
+- (id)copyWithZone:(NSZone*)zone
+{
+	OBPMetricsAggregate* copy = [[[self class] alloc] init];
+	copy->_requestCount = _requestCount;
+	copy->_errorCount = _errorCount;
+	for (OBPMetric metric = 0; metric < OBPMetric_count; metric++)
+		copy->_histograms[metric] = [_histograms[metric] copy];
+	copy->_statuses = [_statuses mutableCopy];
+	return copy;
+}
+- (void)addRequest:(OBPRequestMetrics*)metrics
+{
+	_requestCount++;
+	if (metrics.error)
+		_errorCount++;
+	[_statuses addObject: @(metrics.statusCode)];
+	for (OBPMetric metric = 0; metric < OBPMetric_count; metric++)
+		[_histograms[metric] addValue: [metrics valueForMetric: metric]];
+}
+- (NSDictionary<NSNumber*,NSNumber*>*)statusCounts
+{
+	NSMutableDictionary*	md = [NSMutableDictionary dictionary];
+	for (NSNumber* status in _statuses)
+		md[status] = @([_statuses countForObject: status]);
+	return [md copy];
+}
+- (OBPMetricsHistogram*)histogramForMetric:(OBPMetric)metric
+{
+	return metric < OBPMetric_count ? _histograms[metric] : [[OBPMetricsHistogram alloc] initWithScale: 1];
+}
+- (NSDictionary<NSString*,id>*)dictionaryRepresentation
+{
+	NSMutableDictionary*	md = [NSMutableDictionary dictionary];
+	NSMutableDictionary*	statuses = [NSMutableDictionary dictionary];
+
+	md[@"requests"] = @(_requestCount);
+	md[@"errors"] = @(_errorCount);
+	for (NSNumber* status in _statuses)
+		statuses[[status stringValue]] = @([_statuses countForObject: status]);
+	md[@"status"] = statuses;
+	for (OBPMetric metric = 0; metric < OBPMetric_count; metric++)
+		if (_histograms[metric].count)
+			md[NSStringFromOBPMetric(metric)] = [_histograms[metric] dictionaryRepresentation];
+	return [md copy];
+}
+@end
+
+
+
+#pragma mark -
+@interface OBPMetricsSnapshot ()
+- (instancetype)initWithSince:(NSDate*)since servers:(NSDictionary*)servers pathTemplates:(NSDictionary*)pathTemplates;
+@end
+
+@implementation OBPMetricsSnapshot
+- (instancetype)initWithSince:(NSDate*)since servers:(NSDictionary*)servers pathTemplates:(NSDictionary*)pathTemplates
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_since = since;
+	_until = [NSDate date];
+	_servers = servers;
+	_pathTemplates = pathTemplates;
+	return self;
+}
+- (NSDictionary<NSString*,id>*)dictionaryRepresentation
+{
+	NSMutableDictionary*	servers = [NSMutableDictionary dictionary];
+	NSMutableDictionary*	pathTemplates = [NSMutableDictionary dictionary];
+	NSString*				key;
+
+	for (key in _servers)
+		servers[key] = [_servers[key] dictionaryRepresentation];
+	for (key in _pathTemplates)
+		pathTemplates[key] = [_pathTemplates[key] dictionaryRepresentation];
+	return @{
+		@"since"			: @([_since timeIntervalSince1970]),
+		@"until"			: @([_until timeIntervalSince1970]),
+		@"servers"			: servers,
+		@"pathTemplates"	: pathTemplates,
+	};
+}
+@end
+
+
+
+#pragma mark -
+@implementation OBPMetrics
+{
+	dispatch_queue_t										_queue;		// serialises the aggregates
+	NSDate*													_since;
+	NSMutableDictionary<NSString*,OBPMetricsAggregate*>*	_servers;
+	NSMutableDictionary<NSString*,OBPMetricsAggregate*>*	_pathTemplates;
+}
++ (OBPMetrics*)sharedMetrics
+{
+	static OBPMetrics*		sMetrics;
+	static dispatch_once_t	once;
+	dispatch_once(&once, ^{sMetrics = [[OBPMetrics alloc] init];});
+	return sMetrics;
+}
++ (NSString*)pathTemplateForPath:(NSString*)path
+{
+	static NSSet<NSString*>*	sCollections;
+	static NSSet<NSString*>*	sNotIdentifiers;
+	static dispatch_once_t		once;
+	dispatch_once(&once, ^{
+		sCollections = [NSSet setWithArray: @[@"banks", @"accounts", @"transactions", @"other_accounts", @"counterparties", @"customers", @"users", @"views", @"cards", @"branches", @"atms", @"products", @"comments", @"tags", @"images", @"transaction-request-types", @"transaction-requests", @"challenge", @"permissions", @"entitlements"]];
+		sNotIdentifiers = [NSSet setWithArray: @[@"private", @"public"]];
+	});
+
+	NSRange						r = [path rangeOfString: @"?"];
+	NSMutableArray<NSString*>*	components;
+	NSString*					component;
+	NSUInteger					i, n;
+	BOOL						afterCollection = NO;
+	BOOL						afterAccountID = NO;
+
+	if (r.length)
+		path = [path substringToIndex: r.location];
+	components = [[path componentsSeparatedByString: @"/"] mutableCopy];
+	for (i = 0, n = [components count]; i < n; i++)
+	{
+		component = components[i];
+		if (![component length])
+			continue;
+		if (afterCollection && ![sNotIdentifiers containsObject: component])
+		{
+			afterAccountID = [components[i - 1] isEqualToString: @"accounts"];
+			afterCollection = NO;
+			components[i] = @"*";
+			continue;
+		}
+		if (afterAccountID && i + 1 < n && ![sCollections containsObject: component])
+		{
+			// .../accounts/ACCOUNT_ID/VIEW_ID/...
+			afterAccountID = NO;
+			components[i] = @"*";
+			continue;
+		}
+		afterAccountID = NO;
+		afterCollection = [sCollections containsObject: component];
+	}
+	return [components componentsJoinedByString: @"/"];
+}
+- (instancetype)init
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_queue = dispatch_queue_create("com.tesobe.OBPKit.OBPMetrics", DISPATCH_QUEUE_SERIAL);
+	_since = [NSDate date];
+	_servers = [NSMutableDictionary dictionary];
+	_pathTemplates = [NSMutableDictionary dictionary];
+	_enabled = YES;
+	return self;
+}
+- (void)recordRequest:(OBPRequestMetrics*)metrics
+{
+	if (!metrics || !self.enabled)
+		return;
+	HandleOBPRequestMetrics exportHandler = self.exportHandler;
+	dispatch_async(_queue, ^{
+		NSString*				key;
+		OBPMetricsAggregate*	aggregate;
+
+		key = metrics.server;
+		if (nil == (aggregate = self->_servers[key]))
+			self->_servers[key] = aggregate = [[OBPMetricsAggregate alloc] init];
+		[aggregate addRequest: metrics];
+
+		key = [NSString stringWithFormat: @"%@ %@", metrics.method, metrics.pathTemplate];
+		if (nil == (aggregate = self->_pathTemplates[key]))
+			self->_pathTemplates[key] = aggregate = [[OBPMetricsAggregate alloc] init];
+		[aggregate addRequest: metrics];
+
+		if (exportHandler)
+			exportHandler(metrics);
+	});
+}
+- (OBPMetricsSnapshot*)snapshotResetting:(BOOL)reset
+{
+	__block OBPMetricsSnapshot* snapshot;
+	dispatch_sync(_queue, ^{
+		NSMutableDictionary*	servers = [NSMutableDictionary dictionary];
+		NSMutableDictionary*	pathTemplates = [NSMutableDictionary dictionary];
+		NSString*				key;
+		if (reset)
+		{
+			// ...the aggregates are handed over rather than copied
+			[servers setDictionary: self->_servers];
+			[pathTemplates setDictionary: self->_pathTemplates];
+		}
+		else
+		{
+			for (key in self->_servers)
+				servers[key] = [self->_servers[key] copy];
+			for (key in self->_pathTemplates)
+				pathTemplates[key] = [self->_pathTemplates[key] copy];
+		}
+		snapshot = [[OBPMetricsSnapshot alloc] initWithSince: self->_since servers: servers pathTemplates: pathTemplates];
+		if (reset)
+		{
+			self->_since = snapshot.until;
+			self->_servers = [NSMutableDictionary dictionary];
+			self->_pathTemplates = [NSMutableDictionary dictionary];
+		}
+	});
+	return snapshot;
+}
+- (OBPMetricsSnapshot*)snapshot
+{
+	return [self snapshotResetting: NO];
+}
+- (OBPMetricsSnapshot*)snapshotAndReset
+{
+	return [self snapshotResetting: YES];
+}
+- (void)reset
+{
+	[self snapshotResetting: YES];
+}
+@end
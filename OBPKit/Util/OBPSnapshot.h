@@ -0,0 +1,29 @@
+//
+//  OBPSnapshot.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+/**	An OBPSnapshot instance holds an immutable value, such as a registry array, that many threads read and few change.
+
+	Readers take the current value and use it as long as they like, without waiting on writers, as a value is never changed once published. Writers pass a block that derives the next value from the current one; writers are serialised among themselves, so that no change is lost, and the next value is published whole once made.
+*/
+@interface OBPSnapshot<ObjectType> : NSObject
+- (instancetype)initWithValue:(ObjectType)value; ///< Designated initialiser. \param value should be immutable.
+@property (atomic, strong, readonly) ObjectType value; ///< Get the current value.
+- (ObjectType)update:(ObjectType(NS_NOESCAPE ^)(ObjectType current))makeNext; ///< Publish the value returned by makeNext, which is passed the current value, and return it; makeNext should return its argument to make no change, and must not itself update the receiver.
+@end
+
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,42 @@
+//
+//  OBPSnapshot.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPSnapshot.h"
+
+
+
+@interface OBPSnapshot ()
+@property (atomic, strong, readwrite) id value;
+@end
+
+
+
+@implementation OBPSnapshot
+{
+	NSObject*		_writeLock;
+}
+- (instancetype)initWithValue:(id)value
+{
+	if (nil == (self = [super init]))
+		return nil;
+	_value = value;
+	_writeLock = [[NSObject alloc] init];
+	return self;
+}
+- (id)update:(id(NS_NOESCAPE ^)(id current))makeNext
+{
+	// Readers go through the atomic accessor only, so never wait for a writer to make its next value
+	@synchronized (_writeLock) {
+		id current = self.value;
+		id next = makeNext(current);
+		if (next != current)
+			self.value = next;
+		return next;
+	}
+}
+@end
@@ -0,0 +1,388 @@
+//
+//  OBPTrace.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPLogging.h"
+// sdk
+#include <mach/mach_time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <errno.h>
+
+
+
+#define kOBPTraceRingCapacity		2048	// events per thread; a power of two
+#define kOBPTraceMaxRings			256
+#define kOBPTraceNameSlots			1024	// a power of two
+#define kOBPTraceNameProbes			8
+#define kOBPTraceDrainInterval		0.5		// seconds
+#define kOBPTraceNoRing				((void*)&sNoRingMark)	// thread specific value of a thread that found all rings taken
+
+
+
+/// One thread's events. Only the owning thread advances head, and only the drain advances tail, so neither needs a lock.
+typedef struct OBPTraceRing
+{
+	_Atomic uint64_t	head;
+	_Atomic uint64_t	tail;
+	_Atomic uint64_t	dropped;
+	uint64_t			droppedReported;	// drain only
+	_Atomic bool		owned;				// while a live thread records into it
+	uint16_t			index;
+	OBPTraceEvent		events[kOBPTraceRingCapacity];
+} OBPTraceRing;
+
+/// A name waiting to be written by the drain.
+typedef struct OBPTraceName
+{
+	struct OBPTraceName*	next;
+	uint64_t				nameID;
+	size_t					length;
+	char					bytes[];
+} OBPTraceName;
+
+
+
+volatile bool					gOBPTraceEnabled = false;
+volatile bool					gOBPTraceAlwaysErrors = false;
+
+static _Atomic(OBPTraceRing*)	sRings[kOBPTraceMaxRings];
+static _Atomic uint32_t			sRingCount;
+static pthread_key_t			sRingKey;
+static _Atomic uint64_t			sNameSeen[kOBPTraceNameSlots];
+static OBPTraceName*			sNamesPending;				// newest first, under sNamesLock
+static pthread_mutex_t			sNamesLock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic uint32_t			sNextRequestID;
+static _Atomic uint64_t			sSampleThreshold;			// sampled if mixed request id < threshold; 2^32 samples all
+static _Atomic uint64_t			sDroppedTotal;
+static _Atomic uint64_t			sDroppedNoRing;				// by threads marked kOBPTraceNoRing
+static uint64_t					sDroppedNoRingReported;		// on sDrainQueue
+static char						sNoRingMark;
+static dispatch_queue_t			sDrainQueue;
+static dispatch_source_t		sDrainTimer;				// on sDrainQueue
+static int						sFD = -1;					// on sDrainQueue
+
+
+
+#pragma mark -
+static void OBPTraceReleaseRing(void* ring)
+{
+	// The thread has exited: what it recorded is still drained, and the ring can be taken by a new thread
+	if (ring == kOBPTraceNoRing)
+		return;
+	atomic_store_explicit(&((OBPTraceRing*)ring)->owned, false, memory_order_release);
+}
+
+static void OBPTraceInitialise(void)
+{
+	pthread_key_create(&sRingKey, OBPTraceReleaseRing);
+	sDrainQueue = dispatch_queue_create("com.tesobe.OBPKit.OBPTrace", DISPATCH_QUEUE_SERIAL);
+	dispatch_set_target_queue(sDrainQueue, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+}
+
+static OBPTraceRing* OBPTraceThreadRing(void)
+{
+	OBPTraceRing*	ring = pthread_getspecific(sRingKey);
+	uint32_t		count, i;
+	bool			unowned;
+
+	if (ring)
+		return ring;
+
+	// Reuse the ring of a thread that has exited, or else add one
+	count = atomic_load_explicit(&sRingCount, memory_order_acquire);
+	for (i = 0; i < count && i < kOBPTraceMaxRings; i++)
+	{
+		ring = atomic_load_explicit(&sRings[i], memory_order_acquire);
+		unowned = false;
+		if (ring && atomic_compare_exchange_strong(&ring->owned, &unowned, true))
+			break;
+		ring = NULL;
+	}
+	if (!ring)
+	{
+		// ...claiming a slot only while one is left, so that the count cannot run past the table
+		while (count < kOBPTraceMaxRings && !atomic_compare_exchange_weak(&sRingCount, &count, count + 1))
+			;
+		if (count >= kOBPTraceMaxRings || NULL == (ring = calloc(1, sizeof(OBPTraceRing))))
+		{
+			// None to be had: mark the thread, so that its later events are counted as dropped without searching again
+			pthread_setspecific(sRingKey, kOBPTraceNoRing);
+			return kOBPTraceNoRing;
+		}
+		i = count;
+		ring->index = (uint16_t)i;
+		atomic_store(&ring->owned, true);
+		atomic_store_explicit(&sRings[i], ring, memory_order_release);
+	}
+	pthread_setspecific(sRingKey, ring);
+	return ring;
+}
+
+static uint64_t OBPTraceHash(const char* s)
+{
+	uint64_t h = 14695981039346656037ULL;
+	for (; *s; s++)
+		h = (h ^ (uint8_t)*s) * 1099511628211ULL;
+	return h ?: 1; // ...0 marks an empty slot
+}
+
+
+
+#pragma mark -
+void OBPTraceRecord(OBPTraceKind kind, uint32_t requestID, int64_t value, uint64_t detail)
+{
+	OBPTraceRing*	ring;
+	OBPTraceEvent*	event;
+	uint64_t		head, tail;
+
+	if (!gOBPTraceEnabled)
+		return;
+	if (kOBPTraceNoRing == (ring = OBPTraceThreadRing()))
+	{
+		atomic_fetch_add_explicit(&sDroppedNoRing, 1, memory_order_relaxed);
+		return;
+	}
+	head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	if (head - tail >= kOBPTraceRingCapacity)
+	{
+		atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+		return;
+	}
+	event = &ring->events[head & (kOBPTraceRingCapacity - 1)];
+	event->time = mach_absolute_time();
+	event->requestID = requestID;
+	event->kind = kind;
+	event->thread = ring->index;
+	event->value = value;
+	event->detail = detail;
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+uint32_t OBPTraceBeginRequest(void)
+{
+	uint32_t	requestID;
+	uint32_t	mixed;
+
+	if (!gOBPTraceEnabled)
+		return 0;
+	while (0 == (requestID = atomic_fetch_add_explicit(&sNextRequestID, 1, memory_order_relaxed) + 1))
+		;
+	mixed = requestID * 2654435761u; // ...so that sampling does not follow any pattern in request order
+	return mixed < atomic_load_explicit(&sSampleThreshold, memory_order_relaxed) ? requestID : 0;
+}
+
+uint64_t OBPTraceNameID(const char* name)
+{
+	uint64_t		nameID = OBPTraceHash(name ?: "");
+	uint64_t		seen;
+	uint32_t		i, slot;
+	OBPTraceName*	pending;
+	size_t			length;
+
+	// Only the first use of a name takes the lock, to queue it for the drain; later uses find it in the table
+	for (i = 0; i < kOBPTraceNameProbes; i++)
+	{
+		slot = (uint32_t)(nameID + i) & (kOBPTraceNameSlots - 1);
+		seen = atomic_load_explicit(&sNameSeen[slot], memory_order_relaxed);
+		if (seen == nameID)
+			return nameID;
+		if (seen == 0 && atomic_compare_exchange_strong(&sNameSeen[slot], &seen, nameID))
+			break;
+		if (seen == nameID)
+			return nameID;
+	}
+	if (i == kOBPTraceNameProbes)
+		return nameID; // ...table full: the decoder shows the identifier instead
+	length = strlen(name ?: "");
+	if (NULL == (pending = malloc(sizeof(OBPTraceName) + length)))
+		return nameID;
+	pending->nameID = nameID;
+	pending->length = length;
+	memcpy(pending->bytes, name ?: "", length);
+	pthread_mutex_lock(&sNamesLock);
+	pending->next = sNamesPending;
+	sNamesPending = pending;
+	pthread_mutex_unlock(&sNamesLock);
+	return nameID;
+}
+
+
+
+#pragma mark -
+static void OBPTraceWrite(const void* bytes, size_t length) // called on sDrainQueue
+{
+	const uint8_t*	p = bytes;
+	ssize_t			n;
+	while (length && sFD >= 0)
+	{
+		if ((n = write(sFD, p, length)) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			OBP_LOG(@"[OBPTrace] write failed (errno %d); tracing stopped", errno);
+			gOBPTraceEnabled = false;
+			return;
+		}
+		p += n, length -= (size_t)n;
+	}
+}
+
+static void OBPTraceDrain(void) // called on sDrainQueue
+{
+	OBPTraceName	*names, *name, *reversed = NULL;
+	OBPTraceRing*	ring;
+	OBPTraceEvent	event;
+	uint64_t		head, tail, dropped, first, count;
+	uint32_t		i, ringCount;
+	uint8_t			padding[sizeof(OBPTraceEvent)] = {0};
+
+	if (sFD < 0)
+		return;
+
+	// Names first, oldest first, so that a decoder meets each before the events that use it
+	pthread_mutex_lock(&sNamesLock);
+	names = sNamesPending;
+	sNamesPending = NULL;
+	pthread_mutex_unlock(&sNamesLock);
+	for (; names; names = name)
+		name = names->next, names->next = reversed, reversed = names;
+	for (; reversed; reversed = name)
+	{
+		name = reversed->next;
+		event = (OBPTraceEvent){.time = mach_absolute_time(), .kind = OBPTraceKindName, .value = (int64_t)reversed->nameID, .detail = reversed->length};
+		OBPTraceWrite(&event, sizeof(event));
+		OBPTraceWrite(reversed->bytes, reversed->length);
+		if (reversed->length % sizeof(OBPTraceEvent))
+			OBPTraceWrite(padding, sizeof(OBPTraceEvent) - reversed->length % sizeof(OBPTraceEvent));
+		free(reversed);
+	}
+
+	// Then each ring's events, in at most two runs as the ring wraps
+	ringCount = MIN(atomic_load_explicit(&sRingCount, memory_order_acquire), kOBPTraceMaxRings);
+	for (i = 0; i < ringCount; i++)
+	{
+		if (NULL == (ring = atomic_load_explicit(&sRings[i], memory_order_acquire)))
+			continue;
+		tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+		head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		while (tail < head)
+		{
+			first = tail & (kOBPTraceRingCapacity - 1);
+			count = MIN(head - tail, kOBPTraceRingCapacity - first);
+			OBPTraceWrite(&ring->events[first], (size_t)count * sizeof(OBPTraceEvent));
+			tail += count;
+		}
+		atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+		dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+		if (dropped != ring->droppedReported)
+		{
+			event = (OBPTraceEvent){.time = mach_absolute_time(), .kind = OBPTraceKindDropped, .thread = ring->index, .value = (int64_t)(dropped - ring->droppedReported)};
+			OBPTraceWrite(&event, sizeof(event));
+			atomic_fetch_add(&sDroppedTotal, dropped - ring->droppedReported);
+			ring->droppedReported = dropped;
+		}
+	}
+	dropped = atomic_load_explicit(&sDroppedNoRing, memory_order_relaxed);
+	if (dropped != sDroppedNoRingReported)
+	{
+		event = (OBPTraceEvent){.time = mach_absolute_time(), .kind = OBPTraceKindDropped, .thread = OBPTraceThreadNoRing, .value = (int64_t)(dropped - sDroppedNoRingReported)};
+		OBPTraceWrite(&event, sizeof(event));
+		atomic_fetch_add(&sDroppedTotal, dropped - sDroppedNoRingReported);
+		sDroppedNoRingReported = dropped;
+	}
+}
+
+
+
+#pragma mark -
+bool OBPTraceStart(const char* path, double sampleRate, uint32_t options)
+{
+	static pthread_once_t	once = PTHREAD_ONCE_INIT;
+	__block bool			started = false;
+
+	pthread_once(&once, OBPTraceInitialise);
+	if (!path)
+		return false;
+	dispatch_sync(sDrainQueue, ^{
+		OBPTraceFileHeader		header = {{'O','B','P','T','R','A','C','E'}, 1, sizeof(OBPTraceEvent)};
+		mach_timebase_info_data_t	timebase;
+		struct timeval			tv;
+
+		if (sFD >= 0 || 0 > (sFD = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644)))
+			return;
+		mach_timebase_info(&timebase);
+		gettimeofday(&tv, NULL);
+		header.timebaseNumer = timebase.numer;
+		header.timebaseDenom = timebase.denom;
+		header.startTime = mach_absolute_time();
+		header.startDate = tv.tv_sec + tv.tv_usec / 1e6;
+		OBPTraceWrite(&header, sizeof(header));
+
+		// Rings left from an earlier trace are emptied rather than written to the new file
+		for (uint32_t i = 0; i < MIN(atomic_load(&sRingCount), kOBPTraceMaxRings); i++)
+		{
+			OBPTraceRing* ring = atomic_load(&sRings[i]);
+			if (ring)
+				atomic_store(&ring->tail, atomic_load(&ring->head)), ring->droppedReported = atomic_load(&ring->dropped);
+		}
+		sDroppedNoRingReported = atomic_load(&sDroppedNoRing);
+		atomic_store(&sDroppedTotal, 0);
+		for (uint32_t i = 0; i < kOBPTraceNameSlots; i++)
+			atomic_store(&sNameSeen[i], 0); // ...so that each file defines the names it uses
+
+		sDrainTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, sDrainQueue);
+		dispatch_source_set_timer(sDrainTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kOBPTraceDrainInterval * NSEC_PER_SEC)), (uint64_t)(kOBPTraceDrainInterval * NSEC_PER_SEC), (uint64_t)(0.1 * NSEC_PER_SEC));
+		dispatch_source_set_event_handler(sDrainTimer, ^{OBPTraceDrain();});
+		dispatch_resume(sDrainTimer);
+		started = true;
+	});
+	if (!started)
+		return false;
+	OBPTraceSetSampleRate(sampleRate);
+	gOBPTraceAlwaysErrors = 0 != (options & OBPTraceOptionAlwaysErrors);
+	gOBPTraceEnabled = true;
+	return true;
+}
+
+void OBPTraceStop(void)
+{
+	if (!sDrainQueue)
+		return;
+	gOBPTraceEnabled = false;
+	dispatch_sync(sDrainQueue, ^{
+		if (sFD < 0)
+			return;
+		OBPTraceDrain();
+		dispatch_source_cancel(sDrainTimer);
+		sDrainTimer = nil;
+		close(sFD);
+		sFD = -1;
+	});
+}
+
+void OBPTraceFlush(void)
+{
+	if (sDrainQueue)
+		dispatch_sync(sDrainQueue, ^{OBPTraceDrain();});
+}
+
+void OBPTraceSetSampleRate(double sampleRate)
+{
+	sampleRate = sampleRate > 0 ? sampleRate < 1 ? sampleRate : 1 : 0;
+	atomic_store(&sSampleThreshold, (uint64_t)(sampleRate * 4294967296.0));
+}
+
+uint64_t OBPTraceDroppedCount(void)
+{
+	return atomic_load(&sDroppedTotal);
+}
@@ -0,0 +1,36 @@
+//
+//  OBPURLCodec.h
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+
+/*	Percent encoding and decoding as in RFC 3986, and query parsing, working directly on UTF-8 bytes, each in a single pass. Runs of unreserved characters (ALPHA / DIGIT / "-" / "." / "_" / "~"), which make up most of the text of tokens, identifiers and signatures, are found sixteen bytes at a time and copied whole, and escapes are found with memchr.
+
+	These back the URL helpers of NSString (OBPKit) and the OAuth 1 signer.
+*/
+
+size_t OBPURLUnreservedSpan(const uint8_t* bytes, size_t length); ///< Return the length of the run of unreserved characters at the start of bytes.
+size_t OBPURLPercentEncode(uint8_t* dst, const uint8_t* src, size_t length); ///< Percent-encode all but the unreserved characters of src into dst, which must have room for 3 × length bytes, and return the number of bytes written. Escapes use upper case hex digits.
+void OBPURLAppendPercentEncoded(NSMutableData* data, const void* bytes, size_t length); ///< Append the percent encoding of bytes to data.
+const uint8_t* _Nullable OBPURLGetUTF8Bytes(NSString* _Nullable string, uint8_t* buffer, size_t capacity, size_t* lengthAt, uint8_t* _Nullable * _Nonnull allocatedAt); ///< Return the UTF-8 bytes of string, with U+0000 kept as a zero byte, in buffer if they cannot need more than capacity bytes, or else in memory to which *allocatedAt is set, and which the caller must free; *lengthAt is set to their number. \returns NULL if string is nil or not valid Unicode.
+BOOL OBPURLAppendUTF8String(NSMutableData* data, NSString* _Nullable string); ///< Append the UTF-8 bytes of string to data, with U+0000 kept as a zero byte. \returns NO, appending nothing, if string is nil or not valid Unicode.
+BOOL OBPURLAppendPercentEncodedString(NSMutableData* data, NSString* _Nullable string); ///< Append the percent encoding of the UTF-8 bytes of string to data, so that U+0000 becomes %00. \returns NO, appending nothing, if string is nil or not valid Unicode.
+NSInteger OBPURLPercentDecode(uint8_t* dst, const uint8_t* src, size_t length); ///< Replace each percent escape of src by the byte it encodes, writing to dst, which must have room for length bytes and may be src itself, and return the number of bytes written, or -1 if an escape is malformed. A "+" is left as it is.
+
+NSString* _Nullable OBPURLPercentEncodedString(NSString* string); ///< Return string with all but its unreserved characters percent-encoded, an unchanged copy if it has none, or nil if it is not valid Unicode.
+NSString* _Nullable OBPURLPercentDecodedString(const uint8_t* bytes, size_t length); ///< Return the string whose UTF-8 encoding is given by bytes after decoding percent escapes, or nil if an escape is malformed or the result is not UTF-8.
+NSDictionary<NSString*,NSString*>* OBPURLQueryParse(const uint8_t* bytes, size_t length); ///< Return the decoded name-value pairs of a query, i.e. pairs of the form name=value separated by "&". Pairs without exactly one "=", or that do not decode, are skipped; a later value for a name replaces an earlier one.
+
+
+
+NS_ASSUME_NONNULL_END
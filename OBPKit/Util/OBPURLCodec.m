@@ -0,0 +1,296 @@
+//
+//  OBPURLCodec.m
+//  OBPKit
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import "OBPURLCodec.h"
+// prj
+#import "OBPLogging.h"
+
+
+
+#define kOBPURLCodecStackBufferSize		512
+
+
+
+// Vectors of sixteen bytes, which clang maps to SSE or NEON registers, and lane masks produced by comparing them
+typedef uint8_t		OBPURLBytes16	__attribute__((vector_size(16)));
+typedef int8_t		OBPURLMask16	__attribute__((vector_size(16)));
+
+
+
+static const uint8_t kOBPURLUnreserved[256] = {
+	['-'] = 1, ['.'] = 1, ['_'] = 1, ['~'] = 1,
+	['0' ... '9'] = 1, ['A' ... 'Z'] = 1, ['a' ... 'z'] = 1,
+};
+static const char kOBPURLHexDigits[] = "0123456789ABCDEF";
+
+
+
+static inline OBPURLBytes16 OBPURLSplat(uint8_t c)
+{
+	return (OBPURLBytes16){c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
+}
+
+static inline int OBPURLHexValue(uint8_t c)
+{
+	if ((unsigned)(c - '0') < 10)
+		return c - '0';
+	c |= 0x20;
+	if ((unsigned)(c - 'a') < 6)
+		return c - 'a' + 10;
+	return -1;
+}
+
+
+
+size_t OBPURLUnreservedSpan(const uint8_t* bytes, size_t length)
+{
+	// Each lane of the mask is all ones where the byte is unreserved; the first zero lane ends the run
+	const OBPURLBytes16	a = OBPURLSplat('a'), zero = OBPURLSplat('0'), caseBit = OBPURLSplat(0x20);
+	const OBPURLBytes16	letters = OBPURLSplat(26), digits = OBPURLSplat(10);
+	const OBPURLBytes16	hyphen = OBPURLSplat('-'), dot = OBPURLSplat('.'), underscore = OBPURLSplat('_'), tilde = OBPURLSplat('~');
+	OBPURLBytes16		v;
+	OBPURLMask16		m;
+	uint64_t			halves[2];
+	size_t				i;
+
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		memcpy(&v, bytes + i, 16);
+		m = (OBPURLMask16)(((v | caseBit) - a) < letters)
+		  | (OBPURLMask16)((v - zero) < digits)
+		  | (OBPURLMask16)(v == hyphen) | (OBPURLMask16)(v == dot)
+		  | (OBPURLMask16)(v == underscore) | (OBPURLMask16)(v == tilde);
+		memcpy(halves, &m, 16);
+		if (~halves[0])
+			return i + (size_t)__builtin_ctzll(~halves[0]) / 8; // ...lanes are in memory order, as all our platforms are little endian
+		if (~halves[1])
+			return i + 8 + (size_t)__builtin_ctzll(~halves[1]) / 8;
+	}
+	for (; i < length && kOBPURLUnreserved[bytes[i]]; i++)
+		;
+	return i;
+}
+
+size_t OBPURLPercentEncode(uint8_t* dst, const uint8_t* src, size_t length)
+{
+	uint8_t*	out = dst;
+	size_t		run;
+
+	while (length)
+	{
+		run = OBPURLUnreservedSpan(src, length);
+		memcpy(out, src, run);
+		out += run, src += run, length -= run;
+		for (; length && !kOBPURLUnreserved[*src]; src++, length--)
+		{
+			*out++ = '%';
+			*out++ = (uint8_t)kOBPURLHexDigits[*src >> 4];
+			*out++ = (uint8_t)kOBPURLHexDigits[*src & 15];
+		}
+	}
+	return (size_t)(out - dst);
+}
+
+void OBPURLAppendPercentEncoded(NSMutableData* data, const void* bytes, size_t length)
+{
+	// Unreserved runs are appended in place; escapes are gathered and appended in groups
+	const uint8_t*	p = bytes;
+	uint8_t			escapes[96];
+	size_t			run, n;
+
+	while (length)
+	{
+		run = OBPURLUnreservedSpan(p, length);
+		if (run)
+			[data appendBytes: p length: run];
+		p += run, length -= run;
+		for (n = 0; length && n + 3 <= sizeof(escapes) && !kOBPURLUnreserved[*p]; p++, length--)
+		{
+			escapes[n++] = '%';
+			escapes[n++] = (uint8_t)kOBPURLHexDigits[*p >> 4];
+			escapes[n++] = (uint8_t)kOBPURLHexDigits[*p & 15];
+		}
+		if (n)
+			[data appendBytes: escapes length: n];
+	}
+}
+
+const uint8_t* OBPURLGetUTF8Bytes(NSString* string, uint8_t* buffer, size_t capacity, size_t* lengthAt, uint8_t** allocatedAt)
+{
+	// Converted with -getBytes:..., so that U+0000 is kept as a zero byte, where -UTF8String would end the string
+	NSUInteger		length = [string length], used = 0;
+	size_t			maxLength = 3 * length;	// ...UTF-8 bytes for each UTF-16 unit, at most
+	uint8_t*		bytes = buffer;
+	NSRange			remaining = {0, 0};
+
+	*allocatedAt = NULL;
+	*lengthAt = 0;
+	if (!string)
+		return NULL;
+	if (maxLength > capacity && NULL == (bytes = *allocatedAt = malloc(maxLength)))
+		return NULL;
+	if (length
+	 && (![string getBytes: bytes maxLength: maxLength usedLength: &used encoding: NSUTF8StringEncoding options: 0 range: NSMakeRange(0, length) remainingRange: &remaining]
+	  || remaining.length))
+	{
+		free(*allocatedAt), *allocatedAt = NULL;
+		return NULL;
+	}
+	*lengthAt = used;
+	return bytes;
+}
+
+BOOL OBPURLAppendUTF8String(NSMutableData* data, NSString* string)
+{
+	// Converted straight into the data's own bytes
+	NSUInteger		length = [string length], start = [data length], used = 0;
+	NSRange			remaining = {0, 0};
+	BOOL			ok;
+
+	if (!length)
+		return string != nil;
+	[data setLength: start + 3 * length];
+	ok = [string getBytes: (uint8_t*)[data mutableBytes] + start maxLength: 3 * length usedLength: &used encoding: NSUTF8StringEncoding options: 0 range: NSMakeRange(0, length) remainingRange: &remaining]
+	  && !remaining.length;
+	[data setLength: start + (ok ? used : 0)];
+	return ok;
+}
+
+BOOL OBPURLAppendPercentEncodedString(NSMutableData* data, NSString* string)
+{
+	uint8_t			buffer[kOBPURLCodecStackBufferSize];
+	uint8_t*		allocated;
+	size_t			length;
+	const uint8_t*	utf8 = OBPURLGetUTF8Bytes(string, buffer, sizeof(buffer), &length, &allocated);
+
+	if (utf8)
+		OBPURLAppendPercentEncoded(data, utf8, length);
+	free(allocated);
+	return utf8 != NULL;
+}
+
+NSInteger OBPURLPercentDecode(uint8_t* dst, const uint8_t* src, size_t length)
+{
+	const uint8_t*	end = src + length;
+	const uint8_t*	escape;
+	uint8_t*		out = dst;
+	int				hi, lo;
+
+	while (src < end)
+	{
+		if (NULL == (escape = memchr(src, '%', (size_t)(end - src))))
+			escape = end;
+		if (out != src)
+			memmove(out, src, (size_t)(escape - src));
+		out += escape - src;
+		src = escape;
+		if (src == end)
+			break;
+		if (end - src < 3 || (hi = OBPURLHexValue(src[1])) < 0 || (lo = OBPURLHexValue(src[2])) < 0)
+			return -1;
+		*out++ = (uint8_t)(hi << 4 | lo);
+		src += 3;
+	}
+	return out - dst;
+}
+
+#pragma mark -
+
+NSString* OBPURLPercentEncodedString(NSString* string)
+{
+	uint8_t			utf8Buffer[kOBPURLCodecStackBufferSize];
+	uint8_t*		utf8Allocated;
+	size_t			length;
+	const uint8_t*	utf8 = OBPURLGetUTF8Bytes(string, utf8Buffer, sizeof(utf8Buffer), &length, &utf8Allocated);
+	uint8_t			stackBuffer[kOBPURLCodecStackBufferSize];
+	uint8_t*		buffer = stackBuffer;
+	NSString*		encoded = nil;
+
+	if (!utf8)
+		return nil;
+	if (OBPURLUnreservedSpan(utf8, length) == length)
+		encoded = [string copy];
+	else
+	if (3 * length <= sizeof(stackBuffer) || NULL != (buffer = malloc(3 * length)))
+	{
+		encoded = [[NSString alloc] initWithBytes: buffer length: OBPURLPercentEncode(buffer, utf8, length) encoding: NSASCIIStringEncoding];
+		if (buffer != stackBuffer)
+			free(buffer);
+	}
+	free(utf8Allocated);
+	return encoded;
+}
+
+static NSString* OBPURLDecodedStringUsingBuffer(const uint8_t* bytes, size_t length, uint8_t* buffer)
+{
+	// Bytes without escapes are used as they are
+	NSInteger decodedLength;
+	if (!memchr(bytes, '%', length))
+		return [[NSString alloc] initWithBytes: bytes length: length encoding: NSUTF8StringEncoding];
+	if (0 > (decodedLength = OBPURLPercentDecode(buffer, bytes, length)))
+		return nil;
+	return [[NSString alloc] initWithBytes: buffer length: (NSUInteger)decodedLength encoding: NSUTF8StringEncoding];
+}
+
+NSString* OBPURLPercentDecodedString(const uint8_t* bytes, size_t length)
+{
+	uint8_t			stackBuffer[kOBPURLCodecStackBufferSize];
+	uint8_t*		buffer = stackBuffer;
+	NSString*		decoded;
+
+	if (length > sizeof(stackBuffer) && NULL == (buffer = malloc(length)))
+		return nil;
+	decoded = OBPURLDecodedStringUsingBuffer(bytes, length, buffer);
+	if (buffer != stackBuffer)
+		free(buffer);
+	return decoded;
+}
+
+static void OBPURLQueryAddPair(NSMutableDictionary* params, const uint8_t* pair, const uint8_t* pairEnd, uint8_t* buffer)
+{
+	const uint8_t*	equals = memchr(pair, '=', (size_t)(pairEnd - pair));
+	NSString		*key, *value;
+
+	if (!equals || memchr(equals + 1, '=', (size_t)(pairEnd - equals - 1)))
+	{
+		OBP_LOG(@"OBPURLQueryParse: not a name-value pair: %@", [[NSString alloc] initWithBytes: pair length: (NSUInteger)(pairEnd - pair) encoding: NSUTF8StringEncoding]);
+		return;
+	}
+	key = OBPURLDecodedStringUsingBuffer(pair, (size_t)(equals - pair), buffer);
+	value = OBPURLDecodedStringUsingBuffer(equals + 1, (size_t)(pairEnd - equals - 1), buffer);
+	OBP_LOG_IF(!key || !value, @"OBPURLQueryParse: pair does not decode: %@", [[NSString alloc] initWithBytes: pair length: (NSUInteger)(pairEnd - pair) encoding: NSUTF8StringEncoding]);
+	if (key && value)
+		params[key] = value;
+}
+
+NSDictionary<NSString*,NSString*>* OBPURLQueryParse(const uint8_t* bytes, size_t length)
+{
+	NSMutableDictionary*	params = [NSMutableDictionary dictionary];
+	const uint8_t*			end = bytes + length;
+	const uint8_t*			pair;
+	const uint8_t*			pairEnd;
+	uint8_t					stackBuffer[kOBPURLCodecStackBufferSize];
+	uint8_t*				buffer = stackBuffer;
+
+	// One buffer, big enough for the whole query, serves to decode every name and value
+	if (length > sizeof(stackBuffer) && NULL == (buffer = malloc(length)))
+		return @{};
+
+	for (pair = bytes; ; pair = pairEnd + 1)
+	{
+		if (NULL == (pairEnd = memchr(pair, '&', (size_t)(end - pair))))
+			pairEnd = end;
+		OBPURLQueryAddPair(params, pair, pairEnd, buffer);
+		if (pairEnd == end)
+			break;
+	}
+
+	if (buffer != stackBuffer)
+		free(buffer);
+	return [params copy];
+}
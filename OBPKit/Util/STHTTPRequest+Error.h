@@ -10,6 +10,10 @@
 
 
 
+NSError* OBPErrorByAddingServerSideDescription(NSError* inError, NSDictionary* headers, NSData* data); ///< Given an error for a response with the supplied headers and body data, check if the body holds a server-side description of the error, and if so return a new error with the server-side error description added.
+
+
+
 @interface STHTTPRequest (Error)
 - (NSError*)errorByAddingServerSideDescriptionToError:(NSError*)inError; ///< Given an error just generated by an STHTTPRequest instance, check if the request already received a server-side description of the error, and if so create a new error with the server-side error description added.
 @end
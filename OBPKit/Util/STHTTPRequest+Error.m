@@ -21,12 +21,17 @@
 	 || ![inError.domain isEqualToString: NSStringFromClass([self class])])
 		return inError;
 
-	NSData*			data = self.responseData;
+	return OBPErrorByAddingServerSideDescription(inError, self.responseHeaders, self.responseData);
+}
+@end
+
 
+
+NSError* OBPErrorByAddingServerSideDescription(NSError* inError, NSDictionary* headers, NSData* data)
+{
 	if (!data || ![data length])
 		return inError;
 
-	NSDictionary*	headers = self.responseHeaders;
 	NSError*		error = nil;
 	NSString*		errorDescription = inError.localizedDescription;
 	NSString*		serverSideDescription = nil;
@@ -76,4 +81,3 @@
 
 	return error;
 }
-@end
@@ -0,0 +1,201 @@
+//
+//  main.m
+//  TraceDecode
+//
+//  Created by agent on 17/10/2026.
+//  Copyright (c) 2016-2026 TESOBE Ltd. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <OBPKit/OBPLogging.h>
+
+
+
+/** TraceDecode
+
+Utility to print a trace file recorded with OBPTraceStart, as text, one event per line in order of time:
+
+	TraceDecode [-s] trace.obptrace
+
+Each line gives milliseconds since the trace started, the recording thread, the request and the event. With -s, prints instead a summary per path template of the requests traced, their errors and durations, and the number of events dropped.
+*/
+
+
+
+static const char* const kKindNames[OBPTraceKind_count] = {
+	"?", "name", "start", "auth", "response", "decode", "retry", "error", "end", "dropped",
+};
+static const char* const kVerbNames[] = {"GET", "PUT", "POST", "DELETE"};
+
+
+
+typedef struct TraceRequestSummary
+{
+	uint64_t	count;
+	uint64_t	errors;
+	double		totalMS;
+	double		maxMS;
+} TraceRequestSummary;
+
+
+
+static int CompareEventTimes(const void* a, const void* b)
+{
+	uint64_t x = ((const OBPTraceEvent*)a)->time, y = ((const OBPTraceEvent*)b)->time;
+	return x < y ? -1 : x > y;
+}
+
+static NSString* NameForID(NSDictionary<NSNumber*,NSString*>* names, uint64_t nameID)
+{
+	return names[@(nameID)] ?: [NSString stringWithFormat: @"#%016llx", nameID];
+}
+
+static int DecodeTraceFile(NSString* path, BOOL summarise)
+{
+	NSData*					data = [NSData dataWithContentsOfFile: path];
+	const uint8_t*			bytes = [data bytes];
+	NSUInteger				length = [data length];
+	OBPTraceFileHeader		header;
+	NSMutableDictionary<NSNumber*,NSString*>*
+							names = [NSMutableDictionary dictionary];
+	NSMutableData*			eventData = [NSMutableData data];
+	OBPTraceEvent*			events;
+	OBPTraceEvent			event;
+	NSUInteger				offset, count, i, padded;
+	double					ticksToMS;
+	uint64_t				dropped = 0;
+
+	if (length < sizeof(header))
+		return fprintf(stderr, "%s: not a trace file\n", [path UTF8String]), 1;
+	memcpy(&header, bytes, sizeof(header));
+	if (memcmp(header.magic, "OBPTRACE", 8) || header.version != 1 || header.eventSize != sizeof(OBPTraceEvent) || !header.timebaseDenom)
+		return fprintf(stderr, "%s: not a trace file, or an unsupported version\n", [path UTF8String]), 1;
+	ticksToMS = (double)header.timebaseNumer / header.timebaseDenom / 1e6;
+
+	// Gather names and events; names are followed by their bytes, padded to whole events
+	for (offset = sizeof(header); offset + sizeof(event) <= length; offset += sizeof(event))
+	{
+		memcpy(&event, bytes + offset, sizeof(event));
+		if (event.kind != OBPTraceKindName)
+		{
+			[eventData appendBytes: &event length: sizeof(event)];
+			continue;
+		}
+		padded = (NSUInteger)((event.detail + sizeof(event) - 1) / sizeof(event) * sizeof(event));
+		if (offset + sizeof(event) + padded > length)
+			break;
+		names[@((uint64_t)event.value)] = [[NSString alloc] initWithBytes: bytes + offset + sizeof(event) length: (NSUInteger)event.detail encoding: NSUTF8StringEncoding] ?: @"?";
+		offset += padded;
+	}
+	if (offset < length)
+		fprintf(stderr, "%s: %lu bytes at end ignored (torn write?)\n", [path UTF8String], (unsigned long)(length - offset));
+
+	// Rings are drained one after another, so events are only in order of time within a thread
+	events = [eventData mutableBytes];
+	count = [eventData length] / sizeof(OBPTraceEvent);
+	qsort(events, count, sizeof(OBPTraceEvent), CompareEventTimes);
+
+	if (summarise)
+	{
+		NSMutableDictionary<NSNumber*,NSNumber*>*	templateOfRequest = [NSMutableDictionary dictionary];
+		NSMutableDictionary<NSNumber*,NSValue*>*	summaries = [NSMutableDictionary dictionary];
+		NSNumber*									templateID;
+		TraceRequestSummary							summary;
+		double										ms;
+
+		for (i = 0; i < count; i++)
+		{
+			event = events[i];
+			if (event.kind == OBPTraceKindDropped)
+				dropped += (uint64_t)event.value;
+			else
+			if (event.kind == OBPTraceKindRequestStart)
+				templateOfRequest[@(event.requestID)] = @(event.detail);
+			else
+			if (event.kind == OBPTraceKindRequestEnd && nil != (templateID = templateOfRequest[@(event.requestID)]))
+			{
+				summary = (TraceRequestSummary){0};
+				[summaries[templateID] getValue: &summary];
+				ms = event.detail / 1e6;
+				summary.count++;
+				summary.errors += event.value != 0;
+				summary.totalMS += ms;
+				summary.maxMS = MAX(summary.maxMS, ms);
+				summaries[templateID] = [NSValue valueWithBytes: &summary objCType: @encode(TraceRequestSummary)];
+			}
+		}
+		printf("%8s %8s %10s %10s  %s\n", "requests", "errors", "mean ms", "max ms", "path template");
+		for (templateID in [summaries keysSortedByValueUsingComparator: ^NSComparisonResult(NSValue* a, NSValue* b) {
+				TraceRequestSummary x, y;
+				[a getValue: &x], [b getValue: &y];
+				return x.totalMS > y.totalMS ? NSOrderedAscending : x.totalMS < y.totalMS ? NSOrderedDescending : NSOrderedSame;
+			}])
+		{
+			[summaries[templateID] getValue: &summary];
+			printf("%8llu %8llu %10.3f %10.3f  %s\n", summary.count, summary.errors, summary.totalMS / summary.count, summary.maxMS, [NameForID(names, [templateID unsignedLongLongValue]) UTF8String]);
+		}
+		printf("%llu events dropped\n", dropped);
+		return 0;
+	}
+
+	printf("# %s, started %s\n", [path UTF8String], [[[NSDate dateWithTimeIntervalSince1970: header.startDate] description] UTF8String]);
+	for (i = 0; i < count; i++)
+	{
+		event = events[i];
+		printf("%12.3f  t%-3u r%-8u %-8s ", ((double)event.time - (double)header.startTime) * ticksToMS, event.thread, event.requestID, event.kind < OBPTraceKind_count ? kKindNames[event.kind] : "?");
+		switch (event.kind)
+		{
+			case OBPTraceKindRequestStart:
+				printf("%s %s\n", event.value >= 0 && event.value < 4 ? kVerbNames[event.value] : "?", [NameForID(names, event.detail) UTF8String]);
+				break;
+			case OBPTraceKindAuth:
+				printf("%.3fms\n", event.detail / 1e6);
+				break;
+			case OBPTraceKindResponse:
+				printf("status %lld, %llu bytes\n", event.value, event.detail);
+				break;
+			case OBPTraceKindDecode:
+				printf("%lld, %.3fms\n", event.value, event.detail / 1e6);
+				break;
+			case OBPTraceKindRetry:
+				printf("attempt %lld after %.3fms\n", event.value, event.detail / 1e6);
+				break;
+			case OBPTraceKindError:
+				printf("%s %lld\n", [NameForID(names, event.detail) UTF8String], event.value);
+				break;
+			case OBPTraceKindRequestEnd:
+				printf("%s after %.3fms\n", event.value ? "failed" : "ok", event.detail / 1e6);
+				break;
+			case OBPTraceKindDropped:
+				printf("%lld events\n", event.value);
+				break;
+			default:
+				printf("%lld %llu\n", event.value, event.detail);
+				break;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, const char * argv[])
+{
+	@autoreleasepool
+	{
+		BOOL	summarise = NO;
+		int		i, result = 0;
+
+		for (i = 1; i < argc && argv[i][0] == '-'; i++)
+		if (0 == strcmp(argv[i], "-s"))
+			summarise = YES;
+		else
+			break;
+		if (i == argc)
+		{
+			fprintf(stderr, "usage: TraceDecode [-s] file ...\n");
+			return 2;
+		}
+		for (; i < argc; i++)
+			result |= DecodeTraceFile([NSString stringWithUTF8String: argv[i]], summarise);
+		return result;
+	}
+}